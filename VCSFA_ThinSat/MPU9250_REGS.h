@@ -26,6 +26,9 @@
 #define     MAG_MAX_BYTE_VALUE          0x7FF8  ///< Max register for scaling
 #define     MAG_MAX_VALUE_FLOAT         4912    ///< in units of uT for scaling
 
+#define     MPU9250_BURST_LENGTH        14      ///< ACCEL_XOUT_MSB through GYRO_ZOUT_LSB
+#define     MAG_BURST_LENGTH            7       ///< X_DATA_LSB through STATUS_2
+
 
 
 enum MPU9250_TEMP_REGISTER_t
@@ -96,7 +99,7 @@ enum MPU9250_MAG_CONTROL_t
     MPU9250_PASSTHROUGH_OFF             = 0x00, ///< & with current register
     MAG_MODE_SINGLE_MEAS                = 0b0001, ///< Single Measurement Mode
     MAG_MODE_CONTINUOUS_8HZ             = 0b0010, ///< Continuous register update mode (8 Hz)
-    MAG_MODE_CONTINUOUS_100HZ           = 0b0011, ///< Continuous register update mode (100 Hz)
+    MAG_MODE_CONTINUOUS_100HZ           = 0b0110, ///< Continuous register update mode (100 Hz)
     MAG_MODE_POWER_DOWN                 = 0b0000, ///< Low power standby mode
     MAG_MODE_SELF_TEST                  = 0b1000, ///< Perform a self test with internal magnetic field generator
     MAG_MODE_BITMASK                    = 0x0F, ///< bit mask for mode-setting register
@@ -10,6 +10,8 @@
  /* 2018 Counts Engineering */
 
 #include "TSLPB.h"
+#include "TSLPB_Profiler.h"
+#include "TSLPB_I2CTrace.h"
 
 
 /*!
@@ -39,6 +41,9 @@ void TSLPB::begin()
     InitTSLDigitalSensors();
     pinMode(TSL_SERIAL_STATUS_PIN, INPUT);
     
+    metTicks      = 0;
+    metRemainder  = 0;
+    metLastMillis = millis();
     }
 
 
@@ -79,12 +84,17 @@ void TSLPB::InitTSLAnalogSensors()
  */
 uint16_t TSLPB::readAnalogSensor(TSLPB_AnalogSensor_t sensorName)
 {
+    TSL_PROFILE_BEGIN(ProfileAnalogRead);
+    
     digitalWrite(TSL_MUX_A, (sensorName >> 2) & 0x1);
     digitalWrite(TSL_MUX_B, (sensorName >> 1) & 0x1);
     digitalWrite(TSL_MUX_C, sensorName & 0x1);
     delay(TSL_MUX_RESPONSE_TIME);
     
-    return(analogRead(TSL_ADC));
+    uint16_t adcValue = analogRead(TSL_ADC);
+    
+    TSL_PROFILE_END(ProfileAnalogRead);
+    return adcValue;
 }
 
 /*!
@@ -197,6 +207,133 @@ uint16_t TSLPB::readDigitalSensorRaw(TSLPB_DigitalSensor_t sensorName)
 
 }
 
+/*!
+ * @brief This API reads the MPU-9250 accelerometer, temperature and gyroscope
+ * output registers in one I2C transaction, so all seven values come from the
+ * same sample.
+ *
+ * @param[out]  sample  TSLPB_ImuSample_t filled with raw counts
+ *
+ * @return      true if all MPU9250_BURST_LENGTH bytes were received
+ */
+bool TSLPB::readImuBurst(TSLPB_ImuSample_t& sample)
+{
+    uint8_t buffer[MPU9250_BURST_LENGTH];
+    
+    if (!readRegisters(IMU_ADDRESS, MPU9250_ACCEL_XOUT_MSB, buffer, MPU9250_BURST_LENGTH)) {
+        return false;
+    }
+    
+    // Big endian, in register order
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        sample.accel[axis] = (int16_t)((buffer[2 * axis] << 8) | buffer[2 * axis + 1]);
+        sample.gyro[axis]  = (int16_t)((buffer[8 + 2 * axis] << 8) | buffer[8 + 2 * axis + 1]);
+    }
+    sample.temperature = (int16_t)((buffer[6] << 8) | buffer[7]);
+    return true;
+}
+
+/*!
+ * @brief This API reads a new magnetometer result, if there is one, in one
+ * I2C transaction from X_DATA_LSB through STATUS_2. Reading STATUS_2 releases
+ * the result registers for the next measurement.
+ *
+ * @param[out]  field   Raw x, y, z counts in the AK8963 axes
+ * @param[in]   wait    Wait up to TSL_SENSOR_READY_TIMEOUT for a result, as
+ *                      readDigitalSensorRaw(Magnetometer_x) does. Otherwise
+ *                      return at once if there is none.
+ *
+ * @return      true if a result was read and did not overflow. Sets
+ *              isMagnetometerOverflow.
+ */
+bool TSLPB::readMagnetometerBurst(int16_t field[3], bool wait)
+{
+    if (wait) {
+        if (!waitForMagReady()) {
+            return false;
+        }
+    } else if (!(read8bitRegister(MAG_ADDRESS, MPU9250_MAG_REG_STATUS_1) & MAG_MASK_DATA_READY)) {
+        return false;
+    }
+    
+    uint8_t buffer[MAG_BURST_LENGTH];
+    if (!readRegisters(MAG_ADDRESS, MPU9250_MAG_REG_X_DATA_LSB, buffer, MAG_BURST_LENGTH)) {
+        return false;
+    }
+    
+    // Little endian, in register order
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        field[axis] = (int16_t)(buffer[2 * axis] | (buffer[2 * axis + 1] << 8));
+    }
+    isMagnetometerOverflow = (buffer[MAG_BURST_LENGTH - 1] & MAG_MASK_DATA_OVERFLOW) != 0;
+    return !isMagnetometerOverflow;
+}
+
+/*!
+ * @brief This API reads one LM75A temperature sensor. Unlike
+ * readDigitalSensorRaw(DT1), it reports a failed read and sign-extends the
+ * result.
+ *
+ * @param[in]   sensor  DT1 - DT6
+ * @param[out]  counts  Temperature in LMA_TEMP_REG_DEGREES_PER_LSB steps
+ *
+ * @return      true if the sensor answered
+ */
+bool TSLPB::readTemperature(TSLPB_DigitalSensor_t sensor, int16_t& counts)
+{
+    uint16_t response;
+    
+    if (sensor > DT6 || !read16bitRegister(getDeviceAddress(sensor), LM75A_TEMPERATURE, response)) {
+        return false;
+    }
+    
+    // Left-justified two's complement: an arithmetic shift keeps the sign
+    counts = (int16_t)response >> LMA_TEMP_REG_UNUSED_LSBS;
+    return true;
+}
+
+/*!
+ * @brief This API changes the AK8963 measurement mode, keeping 16-bit output.
+ * The AK8963 passes through power-down first, as its datasheet requires
+ * between modes. begin() selects MAG_MODE_CONTINUOUS_8HZ.
+ *
+ * @param[in]   mode    MAG_MODE_CONTINUOUS_8HZ, MAG_MODE_CONTINUOUS_100HZ, ...
+ *
+ * @return      true if both writes were sent
+ */
+bool TSLPB::setMagnetometerMode(uint8_t mode)
+{
+    bool result = write8bitRegister(MAG_ADDRESS, MPU9250_MAG_REG_CONTROL, MAG_MODE_16_BIT | MAG_MODE_POWER_DOWN);
+    
+    delayMicroseconds(100);
+    result &= write8bitRegister(MAG_ADDRESS, MPU9250_MAG_REG_CONTROL, MAG_MODE_16_BIT | (mode & MAG_MODE_BITMASK));
+    return result;
+}
+
+/*!
+ * @brief This API sets the hard- and soft-iron correction applied by
+ * readDigitalSensor(Magnetometer_*) and correctMagnetometer()
+ *
+ * @param[in]   calibration Offsets in raw counts and Q14 gains, AK8963 axes
+ */
+void TSLPB::setMagCalibration(const TSLPB_MagCalibration_t& calibration)
+{
+    magCalibration = calibration;
+}
+
+/*!
+ * @brief This API applies the magnetometer calibration to raw counts in place.
+ * The result is in raw counts, saturated to the int16_t range.
+ *
+ * @param[in,out]   field   x, y, z counts in the AK8963 axes
+ */
+void TSLPB::correctMagnetometer(int16_t field[3])
+{
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        field[axis] = correctMagnetometerAxis(axis, field[axis]);
+    }
+}
+
 /*!
  * @brief This API returns the process from the specified sensor as a
  * double-precision floating point value in the appropriate units for the
@@ -216,6 +353,7 @@ double  TSLPB::readDigitalSensor(TSLPB_DigitalSensor_t sensorName)
         case Magnetometer_x:
         case Magnetometer_y:
         case Magnetometer_z:
+            regContents = correctMagnetometerAxis(sensorName - Magnetometer_x, (int16_t)regContents);
             return (double)((int16_t)regContents)*MAG_MAX_VALUE_FLOAT/MAG_MAX_BYTE_VALUE;
             break;
             
@@ -238,8 +376,8 @@ double  TSLPB::readDigitalSensor(TSLPB_DigitalSensor_t sensorName)
             break;
     }
     
-    
-    
+    // Not a digital sensor
+    return 0;
 }
 
 /*!
@@ -282,7 +420,7 @@ TSLPB_I2CAddress_t TSLPB::getDeviceAddress(TSLPB_DigitalSensor_t sensorName) {
             return DT6_ADDRESS;
         default:
             // Bad address passed. Return a dummy value
-            return 0;
+            return (TSLPB_I2CAddress_t)0;
             break;
     }
 }
@@ -292,6 +430,8 @@ bool TSLPB::write8bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg,
 {
     bool result;
     
+    TSL_I2C_TRACE(i2cAddress, reg, TSL_I2C_TRACE_WRITE, 1);
+    
     Wire.beginTransmission(i2cAddress);
     result =  Wire.write(reg);
     result &= Wire.write(data);
@@ -312,6 +452,8 @@ bool TSLPB::write8bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg,
 uint8_t TSLPB::read8bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg)
 {
     uint8_t regContents;
+    
+    TSL_I2C_TRACE(i2cAddress, reg, TSL_I2C_TRACE_READ, 1);
 
     Wire.beginTransmission(i2cAddress);
     Wire.write(reg);
@@ -335,15 +477,13 @@ uint8_t TSLPB::read8bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg
  */
 bool TSLPB::read16bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg, uint16_t& response)
 {
-    uint8_t result;
+    TSL_I2C_TRACE(i2cAddress, reg, TSL_I2C_TRACE_READ, 2);
     
     Wire.beginTransmission(i2cAddress); // Start with address
-    Wire.write(reg);                // Set temperature register
-    //    Wire.endTransmission();   // Discard succeed/fail status
+    Wire.write(reg);                    // Set register pointer
+    Wire.endTransmission();             // Pointer must be written before the read
     
-    uint8_t bytesRead = Wire.requestFrom(i2cAddress, 2);
-
-    Wire.endTransmission();
+    Wire.requestFrom(i2cAddress, 2);
     
     uint8_t part1 = Wire.read();
     uint8_t part2 = Wire.read();
@@ -353,6 +493,56 @@ bool TSLPB::read16bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg,
 }
 
 
+/*!
+ * @brief This private method applies the magnetometer calibration to one axis
+ */
+int16_t TSLPB::correctMagnetometerAxis(uint8_t axis, int16_t raw)
+{
+    // Clamped so the product fits an int32_t for any gain
+    int32_t corrected = (int32_t)raw - magCalibration.offset[axis];
+    corrected = corrected > INT16_MAX ? INT16_MAX : (corrected < -INT16_MAX ? -INT16_MAX : corrected);
+    
+    corrected = (corrected * magCalibration.scale[axis] + TSL_MAG_SCALE_ONE / 2) >> 14;
+    if (corrected > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (corrected < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)corrected;
+}
+
+/*!
+ * @brief This private method reads length consecutive registers starting at
+ * reg in a single transaction
+ *
+ * @param[in]   i2cAddress  TSLPB Digital Sensor Address Enum (a uint8_t I2C address)
+ * @param[in]   reg         First register
+ * @param[out]  buffer      length bytes of register contents
+ * @param[in]   length      Number of registers, at most the Wire buffer size
+ *
+ * @return      true if the device returned all length bytes
+ */
+bool TSLPB::readRegisters(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg, uint8_t* buffer, uint8_t length)
+{
+    TSL_I2C_TRACE(i2cAddress, reg, TSL_I2C_TRACE_READ, length);
+    
+    Wire.beginTransmission(i2cAddress);
+    Wire.write(reg);
+    if (Wire.endTransmission() != 0) {
+        return false;
+    }
+    
+    if (Wire.requestFrom((uint8_t)i2cAddress, length) != length) {
+        return false;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = Wire.read();
+    }
+    return true;
+}
+
+
 void TSLPB::sleepUntilClearToSend() { 
     
 }
@@ -376,16 +566,21 @@ void TSLPB::sleepWithWakeOnSerialReady() {
 
 
 
-void TSLPB::waitForMagReady()
+bool TSLPB::waitForMagReady()
 {
+    TSL_PROFILE_BEGIN(ProfileMagWait);
+    
     uint32_t startTime = millis();
     byte dataReady = false;
     while (millis() - startTime < TSL_SENSOR_READY_TIMEOUT) { // Timeout value hardcoded
         dataReady = read8bitRegister(MAG_ADDRESS, MPU9250_MAG_REG_STATUS_1);
-        dataReady = (dataReady & MAG_MASK_DATA_READY) > 1;
+        dataReady = (dataReady & MAG_MASK_DATA_READY) != 0;
         if (dataReady)
-            return;
+            break;
     }
+    
+    TSL_PROFILE_END(ProfileMagWait);
+    return dataReady;
 }
 
 void TSLPB::wakeOnSerialReady() { };
@@ -398,15 +593,28 @@ void TSLPB::wakeOnSerialReady() { };
  *
  * @param[in]   data    A ThinsatPacket_t union.
  *
+ * @note    The sampleAge field is set to the number of MET ticks since the
+ *          packet was stamped with stampAcquisitionTime().
+ *
  * @return      nominal transmission: true or false
  */
 bool TSLPB::pushDataToNSL(ThinsatPacket_t data) {
     
     char header[] = NSL_PACKET_HEADER;
-    strcpy(data.payloadData.header, header);
+    memcpy(data.payloadData.header, header, NSL_PACKET_HEADER_LENGTH);
+    
+    // Science frames carry their age. Larger values mark other frame types.
+    if (data.payloadData.sampleAge <= TSL_SAMPLE_AGE_MAX) {
+        uint32_t age = (getMissionElapsedTime() - data.payloadData.met) & TSL_MET_MASK;
+        data.payloadData.sampleAge = (age > TSL_SAMPLE_AGE_MAX) ? TSL_SAMPLE_AGE_MAX : age;
+    }
+    
+    TSL_PROFILE_BEGIN(ProfileSerialTx);
     
     int bytesWritten;
     bytesWritten = Serial.write( (char*)data.NSLPacket, sizeof(data.payloadData) );
+    
+    TSL_PROFILE_END(ProfileSerialTx);
     if (bytesWritten == sizeof(data.NSLPacket)) {
         return true;
     } else {
@@ -416,6 +624,47 @@ bool TSLPB::pushDataToNSL(ThinsatPacket_t data) {
 
 
 
+/*!
+ * @brief This function returns the mission elapsed time (MET) in
+ * TSL_MET_TICK_MS ticks since begin().
+ *
+ * The clock is advanced from the difference between millis() readings, and
+ * milliseconds that do not make a full tick are carried to the next call, so
+ * the MET does not drift no matter how often or irregularly it is read.
+ * millis() rollover is handled by the unsigned subtraction.
+ *
+ * @note    Call this at least once every 49 days. Only the lower 24 bits
+ *          (TSL_MET_MASK) are downlinked.
+ *
+ * @return      uint32_t MET in ticks
+ */
+uint32_t TSLPB::getMissionElapsedTime()
+{
+    uint32_t now     = millis();
+    uint32_t elapsed = (now - metLastMillis) + metRemainder;
+    
+    metLastMillis = now;
+    metTicks     += elapsed / TSL_MET_TICK_MS;
+    metRemainder  = elapsed % TSL_MET_TICK_MS;
+    
+    return metTicks;
+}
+
+/*!
+ * @brief This function stamps a packet with the current MET. Call it when
+ * acquisition of the packet's data starts, not when it is sent. It clears the
+ * refreshed mask, whose bits the caller sets for the channels it reads.
+ *
+ * @param[out]  data    The ThinsatPacket_t to stamp
+ */
+void TSLPB::stampAcquisitionTime(ThinsatPacket_t& data)
+{
+    data.payloadData.met       = getMissionElapsedTime() & TSL_MET_MASK;
+    data.payloadData.sampleAge = 0;
+    data.payloadData.refreshed = 0;
+}
+
+
 /*!
  * @brief This function returns true if the NSL Mothership is ready to receive
  * data over the serial line.
@@ -105,6 +105,33 @@ typedef enum
 } TSLPB_DigitalSensor_t;
 
 
+/*!
+ * @brief   One coherent MPU-9250 sample from a single burst read, in raw
+ *          counts at the ranges set by TSLPB::begin()
+ *          (GYRO_FULL_SCALE_1000_DPS, ACC_FULL_SCALE_16_G)
+ */
+typedef struct
+{
+    int16_t     accel[3];           ///< Accelerometer x, y, z
+    int16_t     temperature;        ///< Die temperature
+    int16_t     gyro[3];            ///< Gyroscope x, y, z
+} TSLPB_ImuSample_t;
+
+
+/*!
+ * @brief   Hard- and soft-iron correction of the AK8963, applied per axis as
+ *          (raw - offset) * scale / TSL_MAG_SCALE_ONE. The default is no
+ *          correction.
+ */
+typedef struct
+{
+    int16_t     offset[3];          ///< Hard-iron offset x, y, z (raw counts)
+    uint16_t    scale[3];           ///< Soft-iron gain x, y, z (Q14)
+} TSLPB_MagCalibration_t;
+
+#define TSL_MAG_SCALE_ONE   16384   ///< Soft-iron gain of 1.0
+
+
 /*!
  * @brief TSLPB Digital Temperature Sensor (LMA75A) Macros
  */
@@ -143,11 +170,22 @@ public:
     
     double   readDigitalSensor(TSLPB_DigitalSensor_t sensor);
     uint16_t readDigitalSensorRaw(TSLPB_DigitalSensor_t sensor);
+    bool     readImuBurst(TSLPB_ImuSample_t& sample);
+    bool     readMagnetometerBurst(int16_t field[3], bool wait = false);
+    bool     readTemperature(TSLPB_DigitalSensor_t sensor, int16_t& counts);
+    bool     setMagnetometerMode(uint8_t mode);
+    
+    void     setMagCalibration(const TSLPB_MagCalibration_t& calibration);
+    const TSLPB_MagCalibration_t& getMagCalibration() { return magCalibration; }
+    void     correctMagnetometer(int16_t field[3]);
     
     void    sleepUntilClearToSend();   // NOT IMPLEMENTED
     bool    isClearToSend();
     bool    pushDataToNSL(ThinsatPacket_t data);
     
+    uint32_t getMissionElapsedTime();
+    void    stampAcquisitionTime(ThinsatPacket_t& data);
+    
     uint8_t read8bitRegister (TSLPB_I2CAddress_t i2cAddress, const uint8_t reg);
     
     bool    isMagnetometerOverflow = false; ///< Overflow status of magnetometer registers
@@ -155,15 +193,23 @@ public:
 private:
     
     bool    read16bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg, uint16_t& response);
+    bool    readRegisters(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg, uint8_t* buffer, uint8_t length);
     bool    write8bitRegister(TSLPB_I2CAddress_t i2cAddress, const uint8_t reg, uint8_t data);
     void    InitTSLAnalogSensors();
     void    InitTSLDigitalSensors();
     void    wakeOnSerialReady();
     void    sleepWithWakeOnSerialReady();
-    void    waitForMagReady();
+    bool    waitForMagReady();
+    int16_t correctMagnetometerAxis(uint8_t axis, int16_t raw);
     
     TSLPB_I2CAddress_t getDeviceAddress(TSLPB_DigitalSensor_t sensorName);
     
+    uint32_t metTicks       = 0;    ///< Mission elapsed time in TSL_MET_TICK_MS ticks
+    uint32_t metLastMillis  = 0;    ///< millis() at the last MET update
+    uint16_t metRemainder   = 0;    ///< Milliseconds not yet counted as a full tick
+    
+    TSLPB_MagCalibration_t magCalibration = { { 0, 0, 0 }, { TSL_MAG_SCALE_ONE, TSL_MAG_SCALE_ONE, TSL_MAG_SCALE_ONE } };
+    
 };
 
 
@@ -0,0 +1,178 @@
+/**
+ *  @file   TSLPB_AdaptiveRate.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the TSLPB adaptive sample rate controller
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_AdaptiveRate.h"
+
+
+/*!
+ * @brief Sets the bounds and activity threshold of a channel and resets it.
+ * The channel starts at its slowest period and is due immediately.
+ *
+ * @param[in] channel   TSLPB_RateChannel_t channel to configure
+ * @param[in] minPeriod Fastest allowed sample period in milliseconds
+ * @param[in] maxPeriod Slowest allowed sample period in milliseconds
+ * @param[in] threshold Rate of change, in counts per second, at which the
+ *                      channel is considered active. Set minPeriod equal to
+ *                      maxPeriod for a fixed rate channel.
+ */
+void TSLPB_AdaptiveRate::configure(TSLPB_RateChannel_t channel, uint16_t minPeriod, uint16_t maxPeriod, uint16_t threshold)
+{
+    TSLPB_RateChannelState_t& state = channels[channel];
+    
+    state.minPeriod         = minPeriod;
+    state.maxPeriod         = (maxPeriod < minPeriod) ? minPeriod : maxPeriod;
+    state.period            = state.maxPeriod;
+    state.threshold         = threshold;
+    state.lastValue         = 0;
+    state.lastSampleTime    = 0;
+    state.primed            = false;
+}
+
+/*!
+ * @brief Returns true if the channel's sample period has elapsed (or the
+ * channel has never been sampled).
+ *
+ * @param[in] channel   TSLPB_RateChannel_t channel
+ * @param[in] now       Current time from millis()
+ */
+bool TSLPB_AdaptiveRate::isDue(TSLPB_RateChannel_t channel, uint32_t now)
+{
+    TSLPB_RateChannelState_t& state = channels[channel];
+    
+    if (!state.primed) {
+        return true;
+    }
+    return (now - state.lastSampleTime) >= state.period;
+}
+
+/*!
+ * @brief Records a scalar sample. The absolute change since the previous
+ * sample is used as the channel's activity.
+ *
+ * @param[in] channel   TSLPB_RateChannel_t channel
+ * @param[in] value     The new sample (raw counts)
+ * @param[in] now       Time of the sample from millis()
+ */
+void TSLPB_AdaptiveRate::sample(TSLPB_RateChannel_t channel, int16_t value, uint32_t now)
+{
+    TSLPB_RateChannelState_t& state = channels[channel];
+    int32_t change = (int32_t)value - state.lastValue;
+    
+    if (change < 0) {
+        change = -change;
+    }
+    
+    state.lastValue = value;
+    sampleDelta(channel, (uint16_t)change, now);
+}
+
+/*!
+ * @brief Records a sample whose change since the previous sample was
+ * computed by the caller. The change is converted to counts per second.
+ *
+ * @param[in] channel   TSLPB_RateChannel_t channel
+ * @param[in] delta     Magnitude of the change since the previous sample
+ * @param[in] now       Time of the sample from millis()
+ */
+void TSLPB_AdaptiveRate::sampleDelta(TSLPB_RateChannel_t channel, uint16_t delta, uint32_t now)
+{
+    TSLPB_RateChannelState_t& state = channels[channel];
+    uint32_t elapsed = now - state.lastSampleTime;
+    
+    if (!state.primed) {
+        // No previous sample to compare against
+        state.primed         = true;
+        state.lastSampleTime = now;
+        return;
+    }
+    
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    
+    adaptPeriod(state, ((uint32_t)delta * 1000) / elapsed);
+    state.lastSampleTime = now;
+}
+
+/*!
+ * @brief Records a sample that already is a rate (counts per second), such
+ * as the magnitude of the gyroscope vector.
+ *
+ * @param[in] channel   TSLPB_RateChannel_t channel
+ * @param[in] activity  Activity of the channel in counts per second
+ * @param[in] now       Time of the sample from millis()
+ */
+void TSLPB_AdaptiveRate::sampleActivity(TSLPB_RateChannel_t channel, uint32_t activity, uint32_t now)
+{
+    TSLPB_RateChannelState_t& state = channels[channel];
+    
+    state.primed = true;
+    adaptPeriod(state, activity);
+    state.lastSampleTime = now;
+}
+
+/*!
+ * @brief Returns the current sample period of a channel in milliseconds
+ */
+uint16_t TSLPB_AdaptiveRate::getPeriod(TSLPB_RateChannel_t channel)
+{
+    return channels[channel].period;
+}
+
+/*!
+ * @brief Returns the number of milliseconds until the next channel becomes
+ * due. Returns 0 if any channel is already due.
+ *
+ * @param[in] now   Current time from millis()
+ */
+uint32_t TSLPB_AdaptiveRate::msUntilNextDue(uint32_t now)
+{
+    uint32_t shortestWait = 0xFFFFFFFF;
+    
+    for (uint8_t i = 0; i < TSL_RATE_CHANNEL_COUNT; i++) {
+        TSLPB_RateChannelState_t& state = channels[i];
+        uint32_t elapsed = now - state.lastSampleTime;
+        
+        if (!state.primed || elapsed >= state.period) {
+            return 0;
+        }
+        if (state.period - elapsed < shortestWait) {
+            shortestWait = state.period - elapsed;
+        }
+    }
+    
+    return shortestWait;
+}
+
+/*!
+ * @brief Halves the period of an active channel (fast attack) and grows the
+ * period of a quiet channel by a quarter (slow decay), within the channel's
+ * configured bounds. Activity between the quiet level and the threshold
+ * leaves the period unchanged.
+ */
+void TSLPB_AdaptiveRate::adaptPeriod(TSLPB_RateChannelState_t& state, uint32_t activity)
+{
+    uint32_t period = state.period;
+    
+    if (activity >= state.threshold) {
+        period = period / 2;
+    } else if (activity < state.threshold / TSL_RATE_QUIET_DIVISOR) {
+        period = period + period / TSL_RATE_DECAY_DIVISOR + 1;
+    }
+    
+    if (period < state.minPeriod) {
+        period = state.minPeriod;
+    }
+    if (period > state.maxPeriod) {
+        period = state.maxPeriod;
+    }
+    
+    state.period = (uint16_t)period;
+}
@@ -0,0 +1,114 @@
+/**
+ *  @file   TSLPB_AdaptiveRate.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Adaptive, event-driven sample rate controller for the TSLPB.
+ *
+ *          Each monitored channel keeps its own sample period. The period is
+ *          shortened while the channel is changing quickly and relaxed back
+ *          toward its upper bound while the channel is quiet, so bus time and
+ *          downlink bytes are spent where the signal is moving.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_AdaptiveRate_h
+#define TSLPB_AdaptiveRate_h
+
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+
+#define TSL_RATE_DECAY_DIVISOR      4   ///< Quiet channels grow their period by period/4 per sample
+#define TSL_RATE_QUIET_DIVISOR      4   ///< A channel is quiet below threshold/4
+
+
+/*!
+ * @brief   Channels watched by the adaptive rate controller. Each channel owns
+ *          an independent sample period.
+ */
+typedef enum
+{
+    RateGyro            = 0,        ///< Attitude: BNO055 data, gated by TSLPB gyro magnitude
+    RateSolar           = 1,        ///< TSLPB Solar sensor
+    RateCurrent         = 2,        ///< TSLPB Current and Voltage sensors
+    RateMagnetometer    = 3,        ///< TSLPB AK8963 magnetometer
+    RateHousekeeping    = 4,        ///< Slow channels (BMP280, TempExt). Usually fixed rate
+    TSL_RATE_CHANNEL_COUNT          ///< Number of rate channels. Not a valid channel
+} TSLPB_RateChannel_t;
+
+
+/*!
+ * @brief   Per-channel state of the adaptive rate controller.
+ */
+typedef struct
+{
+    uint16_t    minPeriod;          ///< Fastest allowed sample period (ms)
+    uint16_t    maxPeriod;          ///< Slowest allowed sample period (ms)
+    uint16_t    period;             ///< Current sample period (ms)
+    uint16_t    threshold;          ///< Rate of change (counts per second) that counts as "active"
+    int16_t     lastValue;          ///< Last scalar sample, used by sample()
+    uint32_t    lastSampleTime;     ///< millis() of the last sample
+    bool        primed;             ///< false until the first sample is taken
+} TSLPB_RateChannelState_t;
+
+
+/*!
+ * @brief   Adaptive sample rate controller. Call isDue() to decide whether a
+ *          channel should be read, then feed the reading back so the
+ *          channel's period can be adjusted:
+ *          - sample() for scalar channels (the controller tracks the change)
+ *          - sampleDelta() when the caller computes the change itself, e.g.
+ *            the L1 distance between two magnetometer vectors
+ *          - sampleActivity() when the reading already is a rate, e.g. the
+ *            gyroscope magnitude
+ *
+ * @note    A channel that has not been configured has a period of 0 and is
+ *          always due.
+ *
+ * @code
+ *  TSLPB_AdaptiveRate rateControl;
+ *
+ *  void setup() {
+ *      rateControl.configure(RateSolar, 1000, 30000, 50);
+ *  }
+ *
+ *  void loop() {
+ *      uint32_t now = millis();
+ *      if (rateControl.isDue(RateSolar, now)) {
+ *          rateControl.sample(RateSolar, tslpb.readAnalogSensor(Solar), now);
+ *      }
+ *      delay(rateControl.msUntilNextDue(millis()));
+ *  }
+ * @endcode
+ */
+class TSLPB_AdaptiveRate
+{
+
+public:
+    void     configure(TSLPB_RateChannel_t channel, uint16_t minPeriod, uint16_t maxPeriod, uint16_t threshold);
+
+    bool     isDue(TSLPB_RateChannel_t channel, uint32_t now);
+    void     sample(TSLPB_RateChannel_t channel, int16_t value, uint32_t now);
+    void     sampleDelta(TSLPB_RateChannel_t channel, uint16_t delta, uint32_t now);
+    void     sampleActivity(TSLPB_RateChannel_t channel, uint32_t activity, uint32_t now);
+
+    uint16_t getPeriod(TSLPB_RateChannel_t channel);
+    uint32_t msUntilNextDue(uint32_t now);
+
+private:
+
+    void     adaptPeriod(TSLPB_RateChannelState_t& state, uint32_t activity);
+
+    TSLPB_RateChannelState_t channels[TSL_RATE_CHANNEL_COUNT];
+
+};
+
+
+#endif /* TSLPB_AdaptiveRate_h */
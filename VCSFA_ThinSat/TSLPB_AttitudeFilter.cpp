@@ -0,0 +1,366 @@
+/**
+ *  @file   TSLPB_AttitudeFilter.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the fixed-point Mahony attitude filter
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_AttitudeFilter.h"
+#include "TSLPB_Profiler.h"
+#include "TSLPB_Quaternion.h"
+
+#ifdef TSL_ENABLE_ATTITUDE_FILTER
+
+
+TSLPB_AttitudeFilter tslAttitude;
+
+
+#define TSL_ATTITUDE_HALF           (TSL_ATTITUDE_ONE / 2)
+#define TSL_ATTITUDE_ACCEL_MIN      (3UL * TSL_ATTITUDE_ACCEL_1G / 8)   ///< 0.75 g, halved
+#define TSL_ATTITUDE_ACCEL_MAX      (5UL * TSL_ATTITUDE_ACCEL_1G / 8)   ///< 1.25 g, halved
+#define TSL_ATTITUDE_US_TO_Q16      4295        ///< us * 4295 >> 16 = seconds in Q16
+#define TSL_ATTITUDE_STATE_ROUND    (1L << (TSL_ATTITUDE_STATE_SHIFT - 1))
+
+
+/*!
+ * @brief Q14 product of two Q14 values
+ */
+static inline int16_t mul14(int16_t a, int16_t b)
+{
+    return (int16_t)(((int32_t)a * b + (1L << 13)) >> 14);
+}
+
+/*!
+ * @brief Integer square root, rounded down
+ */
+static uint16_t isqrt32(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit  = 1UL << 30;
+    
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root   = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+/*!
+ * @brief Scales a raw vector to a Q14 unit vector. The vector is first
+ * shifted so its largest component is in [2^13, 2^14), which keeps the
+ * square root exact to 14 bits whatever the sensor range.
+ *
+ * @return false for a zero vector
+ */
+static bool normalize(const int16_t in[3], int16_t out[3])
+{
+    int32_t v[3] = { in[0], in[1], in[2] };
+    int32_t largest = 0;
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        int32_t magnitude = v[i] < 0 ? -v[i] : v[i];
+        largest = magnitude > largest ? magnitude : largest;
+    }
+    if (largest == 0) {
+        return false;
+    }
+    
+    uint8_t down = 0;
+    uint8_t up   = 0;
+    while ((largest >> down) >= TSL_ATTITUDE_ONE) {
+        down++;
+    }
+    while ((largest << up) < TSL_ATTITUDE_HALF) {
+        up++;
+    }
+    
+    uint32_t squared = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        v[i]     = (v[i] >> down) * (1L << up);
+        squared += (uint32_t)(v[i] * v[i]);
+    }
+    
+    // |v[i]| <= norm, so v[i] * inverse stays below 2^28
+    int32_t inverse = (int32_t)((1UL << 28) / isqrt32(squared));
+    for (uint8_t i = 0; i < 3; i++) {
+        out[i] = (int16_t)((v[i] * inverse) >> 14);
+    }
+    return true;
+}
+
+
+/*!
+ * @brief Starts the filter at the identity attitude. Call after
+ * TSLPB::begin().
+ *
+ * @param[in] tslpb     The TSLPB whose IMU update() reads
+ */
+void TSLPB_AttitudeFilter::begin(TSLPB& tslpb)
+{
+    board       = &tslpb;
+    q[0]        = TSL_ATTITUDE_STATE_ONE;
+    q[1]        = q[2] = q[3] = 0;
+    integral[0] = integral[1] = integral[2] = 0;
+    remainder[0] = remainder[1] = remainder[2] = 0;
+    lastUpdate  = micros();
+    updates     = 0;
+    fieldFresh  = false;
+}
+
+/*!
+ * @brief Reads the IMU and, if a new result is ready, the magnetometer, and
+ * fuses them over the time since the last update.
+ *
+ * @return false if the IMU could not be read. The attitude is unchanged.
+ */
+bool TSLPB_AttitudeFilter::update()
+{
+    if (board == NULL) {
+        return false;
+    }
+    
+    TSLPB_ImuSample_t imu;
+    if (!board->readImuBurst(imu)) {
+        return false;
+    }
+    
+    // AK8963 axes are the MPU-9250's with x and y swapped and z inverted
+    int16_t raw[3];
+    int16_t field[3];
+    bool    fieldReady = board->readMagnetometerBurst(raw);
+    if (fieldReady) {
+        for (uint8_t i = 0; i < 3; i++) {
+            lastField[i] = raw[i];
+        }
+        fieldFresh = true;
+        
+        board->correctMagnetometer(raw);
+        field[0] = raw[1];
+        field[1] = raw[0];
+        field[2] = (raw[2] == INT16_MIN) ? INT16_MAX : -raw[2];
+    }
+    
+    uint32_t now = micros();
+    
+    TSL_PROFILE_BEGIN(ProfileAttitude);
+    fuse(imu.gyro, imu.accel, fieldReady ? field : NULL, now - lastUpdate);
+    TSL_PROFILE_END(ProfileAttitude);
+    
+    lastUpdate = now;
+    return true;
+}
+
+/*!
+ * @brief One Mahony update: the error between the measured reference
+ * vectors and the ones the attitude predicts is fed back into the gyro rate,
+ * which is then integrated over elapsedUs.
+ *
+ * @param[in] gyro      Raw gyroscope counts
+ * @param[in] accel     Raw accelerometer counts, or NULL
+ * @param[in] field     Raw magnetometer counts in the MPU-9250 axes, or NULL
+ * @param[in] elapsedUs Time since the last update
+ */
+void TSLPB_AttitudeFilter::fuse(const int16_t gyro[3], const int16_t* accel, const int16_t* field, uint32_t elapsedUs)
+{
+    int32_t rate[3];
+    int32_t error[3] = { 0, 0, 0 };     // Half the rotation error (Q14)
+    bool    corrected = false;
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        rate[i] = ((int32_t)gyro[i] * TSL_ATTITUDE_GYRO_MUL + (1L << (TSL_ATTITUDE_GYRO_SHIFT - 1))) >> TSL_ATTITUDE_GYRO_SHIFT;
+    }
+    
+    int32_t w, x, y, z;
+    getWorkingQuaternion(w, x, y, z);
+    
+    int16_t q0q0 = mul14(w, w), q0q1 = mul14(w, x), q0q2 = mul14(w, y);
+    int16_t q0q3 = mul14(w, z), q1q1 = mul14(x, x), q1q2 = mul14(x, y);
+    int16_t q1q3 = mul14(x, z), q2q2 = mul14(y, y), q2q3 = mul14(y, z);
+    int16_t q3q3 = mul14(z, z);
+    
+    // Gravity, only when the accelerometer reads about 1 g
+    if (accel) {
+        uint32_t squared = 0;
+        for (uint8_t i = 0; i < 3; i++) {
+            int32_t half = accel[i] >> 1;
+            squared += (uint32_t)(half * half);
+        }
+        if (squared >= TSL_ATTITUDE_ACCEL_MIN * TSL_ATTITUDE_ACCEL_MIN &&
+            squared <= TSL_ATTITUDE_ACCEL_MAX * TSL_ATTITUDE_ACCEL_MAX) {
+            int16_t a[3];
+            normalize(accel, a);
+            
+            int16_t vx = q1q3 - q0q2;
+            int16_t vy = q0q1 + q2q3;
+            int16_t vz = q0q0 - TSL_ATTITUDE_HALF + q3q3;
+            
+            error[0] += ((int32_t)a[1] * vz - (int32_t)a[2] * vy) >> 14;
+            error[1] += ((int32_t)a[2] * vx - (int32_t)a[0] * vz) >> 14;
+            error[2] += ((int32_t)a[0] * vy - (int32_t)a[1] * vx) >> 14;
+            corrected = true;
+        }
+    }
+    
+    // Magnetic field, with its reference direction taken from the
+    // measurement rotated into the filter frame
+    int16_t m[3];
+    if (field && normalize(field, m)) {
+        int32_t hx = ((int32_t)m[0] * (TSL_ATTITUDE_HALF - q2q2 - q3q3) + (int32_t)m[1] * (q1q2 - q0q3) +
+                      (int32_t)m[2] * (q1q3 + q0q2)) >> 13;
+        int32_t hy = ((int32_t)m[0] * (q1q2 + q0q3) + (int32_t)m[1] * (TSL_ATTITUDE_HALF - q1q1 - q3q3) +
+                      (int32_t)m[2] * (q2q3 - q0q1)) >> 13;
+        int16_t bz = (int16_t)(((int32_t)m[0] * (q1q3 - q0q2) + (int32_t)m[1] * (q2q3 + q0q1) +
+                                (int32_t)m[2] * (TSL_ATTITUDE_HALF - q1q1 - q2q2)) >> 13);
+        int16_t bx = (int16_t)isqrt32((uint32_t)(hx * hx + hy * hy));
+        
+        int16_t wx = mul14(bx, TSL_ATTITUDE_HALF - q2q2 - q3q3) + mul14(bz, q1q3 - q0q2);
+        int16_t wy = mul14(bx, q1q2 - q0q3) + mul14(bz, q0q1 + q2q3);
+        int16_t wz = mul14(bx, q0q2 + q1q3) + mul14(bz, TSL_ATTITUDE_HALF - q1q1 - q2q2);
+        
+        error[0] += ((int32_t)m[1] * wz - (int32_t)m[2] * wy) >> 14;
+        error[1] += ((int32_t)m[2] * wx - (int32_t)m[0] * wz) >> 14;
+        error[2] += ((int32_t)m[0] * wy - (int32_t)m[1] * wx) >> 14;
+        corrected = true;
+    }
+    
+    if (corrected) {
+#if TSL_ATTITUDE_TWO_KI > 0
+        uint32_t step = elapsedUs < TSL_ATTITUDE_MAX_STEP_US ? elapsedUs : TSL_ATTITUDE_MAX_STEP_US;
+        int32_t  dt   = (int32_t)((step * TSL_ATTITUDE_US_TO_Q16 + 0x8000) >> 16);
+#endif
+        
+        for (uint8_t i = 0; i < 3; i++) {
+#if TSL_ATTITUDE_TWO_KI > 0
+            integral[i] += ((((int32_t)TSL_ATTITUDE_TWO_KI * error[i]) >> 8) * dt) >> 16;
+            rate[i]     += integral[i];
+#endif
+            rate[i] += ((int32_t)TSL_ATTITUDE_TWO_KP * error[i]) >> 8;
+        }
+    }
+    
+    // Gaps longer than one step reuse the rate
+    while (elapsedUs > TSL_ATTITUDE_MAX_STEP_US) {
+        integrate(rate, TSL_ATTITUDE_MAX_STEP_US);
+        elapsedUs -= TSL_ATTITUDE_MAX_STEP_US;
+    }
+    integrate(rate, elapsedUs);
+    updates++;
+}
+
+/*!
+ * @brief Rotates the attitude by rate (Q14 rad/s) for elapsedUs, at most
+ * TSL_ATTITUDE_MAX_STEP_US, and renormalizes it.
+ *
+ * @note    With the step bounded, half the rotation angle stays below
+ *          0.45 rad at the full 1000 dps range and fits an int16_t in Q16.
+ */
+void TSLPB_AttitudeFilter::integrate(const int32_t rate[3], uint32_t elapsedUs)
+{
+    int32_t dt = (int32_t)((elapsedUs * TSL_ATTITUDE_US_TO_Q16 + 0x8000) >> 16);
+    int32_t h[3];
+    
+    // The rounding remainder is carried to the next step: at a steady rate
+    // it would otherwise bias the integrated angle by up to half an LSB per
+    // update
+    for (uint8_t i = 0; i < 3; i++) {
+        int32_t angle = rate[i] * dt + remainder[i];
+        h[i] = (angle + (1L << 14)) >> 15;
+        if (h[i] > INT16_MAX || h[i] < -INT16_MAX) {
+            h[i] = h[i] > 0 ? INT16_MAX : -INT16_MAX;
+            remainder[i] = 0;
+        } else {
+            remainder[i] = (int16_t)(angle - (h[i] << 15));
+        }
+    }
+    
+    int32_t qw, qx, qy, qz;
+    getWorkingQuaternion(qw, qx, qy, qz);
+    
+    // Q14 * Q16 is Q30, one bit above the state
+    q[0] += (-qx * h[0] - qy * h[1] - qz * h[2]) >> 1;
+    q[1] += ( qw * h[0] + qy * h[2] - qz * h[1]) >> 1;
+    q[2] += ( qw * h[1] - qx * h[2] + qz * h[0]) >> 1;
+    q[3] += ( qw * h[2] + qx * h[1] - qy * h[0]) >> 1;
+    
+    // One Newton step toward unit length: q += q * (1 - |q|^2) / 2. Scaling
+    // every component alike leaves the rotation unchanged, so Q14 is enough.
+    getWorkingQuaternion(qw, qx, qy, qz);
+    int32_t squared    = qw * qw + qx * qx + qy * qy + qz * qz;
+    int32_t correction = ((int32_t)TSL_ATTITUDE_ONE * TSL_ATTITUDE_ONE - squared) >> 15;
+    
+    for (uint8_t i = 0; i < 4; i++) {
+        q[i] += (q[i] >> 14) * correction;
+    }
+}
+
+/*!
+ * @brief Rounds the state quaternion to Q14 for the filter arithmetic
+ */
+void TSLPB_AttitudeFilter::getWorkingQuaternion(int32_t& w, int32_t& x, int32_t& y, int32_t& z)
+{
+    w = (q[0] + TSL_ATTITUDE_STATE_ROUND) >> TSL_ATTITUDE_STATE_SHIFT;
+    x = (q[1] + TSL_ATTITUDE_STATE_ROUND) >> TSL_ATTITUDE_STATE_SHIFT;
+    y = (q[2] + TSL_ATTITUDE_STATE_ROUND) >> TSL_ATTITUDE_STATE_SHIFT;
+    z = (q[3] + TSL_ATTITUDE_STATE_ROUND) >> TSL_ATTITUDE_STATE_SHIFT;
+}
+
+/*!
+ * @brief Returns the attitude, body to reference frame, as w, x, y, z in Q14
+ * (TSL_QUAT_ONE = 1.0), the scale tslPackQuaternion() takes
+ */
+void TSLPB_AttitudeFilter::getQuaternion(int16_t quaternion[4])
+{
+    int32_t w, x, y, z;
+    getWorkingQuaternion(w, x, y, z);
+    
+    quaternion[0] = (int16_t)w;
+    quaternion[1] = (int16_t)x;
+    quaternion[2] = (int16_t)y;
+    quaternion[3] = (int16_t)z;
+}
+
+/*!
+ * @brief Hands on the last magnetometer result update() read, once
+ *
+ * @param[out] field    Raw x, y, z counts in the AK8963 axes, as
+ *                      TSLPB::readMagnetometerBurst() gives them
+ *
+ * @return true if update() has read a result since the last call. field is
+ *         unchanged otherwise.
+ */
+bool TSLPB_AttitudeFilter::takeMagnetometer(int16_t field[3])
+{
+    if (!fieldFresh) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        field[i] = lastField[i];
+    }
+    fieldFresh = false;
+    return true;
+}
+
+/*!
+ * @brief Writes the attitude into a science frame's quat
+ */
+void TSLPB_AttitudeFilter::fillFrame(ThinsatPacket_t& frame)
+{
+    int16_t quaternion[4];
+    getQuaternion(quaternion);
+    
+    frame.payloadData.quat = tslPackQuaternion(quaternion);
+}
+
+
+#endif /* TSL_ENABLE_ATTITUDE_FILTER */
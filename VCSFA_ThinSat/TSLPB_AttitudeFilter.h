@@ -0,0 +1,124 @@
+/**
+ *  @file   TSLPB_AttitudeFilter.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Fixed-point Mahony attitude filter fusing the TSLPB MPU-9250
+ *          gyroscope, accelerometer and AK8963 magnetometer, so the payload
+ *          has an attitude when the BNO055 is lost.
+ *
+ *          Everything is integer arithmetic: the filter works on Q14
+ *          (TSL_ATTITUDE_ONE = 1.0) int16_t unit vectors and quaternion
+ *          components, products are formed in int32_t, and the quaternion is
+ *          renormalized with one Newton step instead of a square root and a
+ *          division. Only the quaternion state is kept in Q29 int32_t. An
+ *          update costs three integer square roots and two 32-bit divisions
+ *          when it has both reference vectors, two and one with only the
+ *          magnetometer, and none with the gyroscope alone.
+ *
+ *          The filter is compiled out unless TSL_ENABLE_ATTITUDE_FILTER is
+ *          defined. With TSL_ENABLE_PROFILER, every update's arithmetic is
+ *          timed as ProfileAttitude, so the cycle count on the Pro Mini
+ *          (8 cycles per us) comes down in the profiler reports.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_AttitudeFilter_h
+#define TSLPB_AttitudeFilter_h
+
+
+//#define TSL_ENABLE_ATTITUDE_FILTER    ///< Uncomment to build the attitude filter
+
+
+#include "TSLPB.h"
+
+
+#define TSL_ATTITUDE_PERIOD_MS      20          ///< Update period. The gyro low pass filter is at 5 Hz
+#define TSL_ATTITUDE_CYCLE_BUDGET   8000        ///< Cycles per update allowed for the arithmetic (1 ms at 8 MHz)
+
+#define TSL_ATTITUDE_ONE            16384       ///< 1.0 in Q14
+#define TSL_ATTITUDE_STATE_SHIFT    15          ///< The quaternion is kept in Q29, so small rotations are not rounded away
+#define TSL_ATTITUDE_STATE_ONE      (1L << 29)  ///< 1.0 in Q29
+#define TSL_ATTITUDE_MAX_STEP_US    50000UL     ///< Longer intervals are integrated in steps of this size
+
+#define TSL_ATTITUDE_GYRO_MUL       17872       ///< Gyro counts to Q14 rad/s: counts * MUL >> SHIFT
+#define TSL_ATTITUDE_GYRO_SHIFT     11          ///< (1000 dps / 32768) * (pi / 180) * 16384 = 17872 / 2048
+#define TSL_ATTITUDE_ACCEL_1G       2048        ///< Accelerometer counts per g at ACC_FULL_SCALE_16_G
+
+#define TSL_ATTITUDE_TWO_KP         256         ///< Proportional gain 2 * Kp in Q8 (1.0)
+#define TSL_ATTITUDE_TWO_KI         0           ///< Integral gain 2 * Ki in Q8. 0 disables gyro bias estimation
+
+    /*
+     * The accelerometer is a reference only while it reads between 0.75 g
+     * and 1.25 g: on the ground and on the launch pad. In orbit it reads
+     * zero. The magnetometer then only corrects heading, the rotation about
+     * the filter frame's z axis, and tilt is integrated from the gyroscope
+     * alone.
+     */
+
+
+#ifdef TSL_ENABLE_ATTITUDE_FILTER
+
+/*!
+ * @brief   Attitude filter. Use the global tslAttitude instance.
+ *
+ *          update() burst reads the MPU-9250 and, when the AK8963 has a new
+ *          result, the magnetometer, then fuses them over the time since the
+ *          last update. fuse() runs the filter on samples the caller already
+ *          has.
+ *
+ *          Reading a result clears the AK8963's data-ready bit, so update()
+ *          keeps each result until takeMagnetometer() hands it on. Other
+ *          readers of the magnetometer take it from there instead of waiting
+ *          for the next result.
+ *
+ * @code
+ *  void setup() {
+ *      tslpb.begin();
+ *      tslAttitude.begin(tslpb);
+ *  }
+ *
+ *  void loop() {
+ *      tslAttitude.update();
+ *      tslAttitude.fillFrame(missionData);     // packed quat
+ *      delay(TSL_ATTITUDE_PERIOD_MS);
+ *  }
+ * @endcode
+ */
+class TSLPB_AttitudeFilter
+{
+    
+public:
+    void     begin(TSLPB& tslpb);
+    bool     update();
+    void     fuse(const int16_t gyro[3], const int16_t* accel, const int16_t* field, uint32_t elapsedUs);
+    
+    void     getQuaternion(int16_t quaternion[4]);
+    bool     takeMagnetometer(int16_t field[3]);
+    void     fillFrame(ThinsatPacket_t& frame);
+    uint32_t getUpdateCount()   { return updates; }
+    
+private:
+    
+    void     integrate(const int32_t rate[3], uint32_t elapsedUs);
+    void     getWorkingQuaternion(int32_t& w, int32_t& x, int32_t& y, int32_t& z);
+    
+    TSLPB*   board          = NULL;         ///< Board whose IMU is read by update()
+    int32_t  q[4]           = { TSL_ATTITUDE_STATE_ONE, 0, 0, 0 };  ///< w, x, y, z in Q29
+    int32_t  integral[3]    = { 0, 0, 0 };  ///< Integral feedback (Q14 rad/s)
+    int16_t  remainder[3]   = { 0, 0, 0 };  ///< Rotation rounded off the last step (Q31 rad)
+    uint32_t lastUpdate     = 0;            ///< micros() of the last update
+    int16_t  lastField[3]   = { 0, 0, 0 };  ///< Last AK8963 result update() read, raw in the AK8963 axes
+    bool     fieldFresh     = false;        ///< lastField not yet taken by takeMagnetometer()
+    uint32_t updates        = 0;            ///< Updates since begin()
+    
+};
+
+extern TSLPB_AttitudeFilter tslAttitude;
+
+#endif /* TSL_ENABLE_ATTITUDE_FILTER */
+
+
+#endif /* TSLPB_AttitudeFilter_h */
@@ -0,0 +1,231 @@
+/**
+ *  @file   TSLPB_ChannelStats.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the channel statistics
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_ChannelStats.h"
+
+#ifdef TSL_ENABLE_CHANNEL_STATS
+
+
+TSLPB_ChannelStats tslChannelStats;
+
+
+/*!
+ * @brief Mean of count samples summing to sum, in Q8, rounded to nearest
+ */
+static int32_t meanQ8(int32_t sum, uint16_t count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    
+    int64_t scaled = (int64_t)sum << TSL_STATS_Q;
+    int64_t half   = count / 2;
+    return (int32_t)((scaled >= 0 ? scaled + half : scaled - half) / count);
+}
+
+
+/*!
+ * @brief Starts the statistics with an empty interval. Call after
+ * TSLPB::begin().
+ *
+ * @param[in] tslpb     The TSLPB whose sensors are sampled
+ */
+void TSLPB_ChannelStats::begin(TSLPB& tslpb)
+{
+    board      = &tslpb;
+    lastSample = millis() - TSL_STATS_PERIOD_MS;
+    reset();
+}
+
+/*!
+ * @brief Samples every channel if TSL_STATS_PERIOD_MS has passed since the
+ * last sample
+ *
+ * @return  ms until the next sample is due
+ */
+uint32_t TSLPB_ChannelStats::update()
+{
+    if (board == NULL) {
+        return TSL_STATS_PERIOD_MS;
+    }
+    
+    if (millis() - lastSample >= TSL_STATS_PERIOD_MS) {
+        lastSample = millis();
+        sampleAll();
+    }
+    
+    uint32_t elapsed = millis() - lastSample;
+    return elapsed >= TSL_STATS_PERIOD_MS ? 0 : TSL_STATS_PERIOD_MS - elapsed;
+}
+
+/*!
+ * @brief Adds one sample to a channel
+ *
+ * @param[in] channel   TSLPB_StatsChannel_t channel
+ * @param[in] value     Sample in the channel's units
+ */
+void TSLPB_ChannelStats::add(TSLPB_StatsChannel_t channel, int16_t value)
+{
+    TSLPB_StatsAccumulator_t& s = stats[channel];
+    
+    if (s.count == UINT16_MAX) {
+        return;
+    }
+    
+    // Welford: m2 += (x - mean before) * (x - mean after), both exact to Q8
+    int32_t x      = (int32_t)value << TSL_STATS_Q;
+    int32_t before = x - meanQ8(s.sum, s.count);
+    
+    s.sum += value;
+    s.count++;
+    
+    int32_t after = x - meanQ8(s.sum, s.count);
+    int64_t term  = ((int64_t)before * after) >> TSL_STATS_Q;
+    
+    // The exact term is never negative; rounding can make it a count below
+    if (term > 0) {
+        s.m2 = (s.m2 + (uint64_t)term < s.m2) ? UINT64_MAX : s.m2 + (uint64_t)term;
+    }
+    
+    if (value < s.minimum) {
+        s.minimum = value;
+    }
+    if (value > s.maximum) {
+        s.maximum = value;
+    }
+}
+
+/*!
+ * @brief Empties every channel and starts a new report interval
+ */
+void TSLPB_ChannelStats::reset()
+{
+    for (uint8_t i = 0; i < TSL_STATS_CHANNEL_COUNT; i++) {
+        stats[i].count   = 0;
+        stats[i].minimum = INT16_MAX;
+        stats[i].maximum = INT16_MIN;
+        stats[i].sum     = 0;
+        stats[i].m2      = 0;
+    }
+    intervalStart = millis();
+}
+
+/*!
+ * @brief Mean of a channel in Q8, 0 without samples
+ */
+int32_t TSLPB_ChannelStats::getMean(TSLPB_StatsChannel_t channel)
+{
+    return meanQ8(stats[channel].sum, stats[channel].count);
+}
+
+/*!
+ * @brief Sample variance of a channel in Q8, 0 with fewer than two samples.
+ * Saturates at UINT32_MAX.
+ */
+uint32_t TSLPB_ChannelStats::getVariance(TSLPB_StatsChannel_t channel)
+{
+    const TSLPB_StatsAccumulator_t& s = stats[channel];
+    
+    if (s.count < 2) {
+        return 0;
+    }
+    
+    uint64_t variance = s.m2 / (s.count - 1);
+    return variance > UINT32_MAX ? UINT32_MAX : (uint32_t)variance;
+}
+
+/*!
+ * @brief Populates the statistics fields of a frame with two channels,
+ * firstChannel and the next. The caller sets met.
+ *
+ * @param[out] frame        Frame to fill
+ * @param[in]  firstChannel Even TSLPB_StatsChannel_t
+ */
+void TSLPB_ChannelStats::fillFrame(ThinsatPacket_t& frame, uint8_t firstChannel)
+{
+    frame.statsData.frameType    = TSL_FRAME_TYPE_STATS;
+    frame.statsData.firstChannel = firstChannel;
+    
+    for (uint8_t i = 0; i < 2; i++) {
+        TSLPB_StatsChannel_t channel = (TSLPB_StatsChannel_t)(firstChannel + i);
+        bool                 valid   = firstChannel + i < TSL_STATS_CHANNEL_COUNT && stats[channel].count > 0;
+        
+        frame.statsData.count[i]    = valid ? stats[channel].count   : 0;
+        frame.statsData.minimum[i]  = valid ? stats[channel].minimum : 0;
+        frame.statsData.maximum[i]  = valid ? stats[channel].maximum : 0;
+        frame.statsData.mean[i]     = valid ? getMean(channel)       : 0;
+        frame.statsData.variance[i] = valid ? getVariance(channel)   : 0;
+    }
+    
+    uint32_t seconds = (millis() - intervalStart) / 1000;
+    frame.statsData.seconds = seconds > UINT16_MAX ? UINT16_MAX : (uint16_t)seconds;
+}
+
+/*!
+ * @brief Sends the statistics of the report interval in one frame per pair
+ * of channels, waiting for clear to send before each frame, then starts a new
+ * interval.
+ *
+ * @return  the number of frames sent
+ */
+uint8_t TSLPB_ChannelStats::pushReport()
+{
+    ThinsatPacket_t frame;
+    uint8_t framesSent = 0;
+    
+    if (board == NULL) {
+        return 0;
+    }
+    
+    for (uint8_t channel = 0; channel < TSL_STATS_CHANNEL_COUNT; channel += 2) {
+        board->stampAcquisitionTime(frame);
+        fillFrame(frame, channel);
+        
+        while (!board->isClearToSend()) {
+            delay(100);
+        }
+        if (board->pushDataToNSL(frame)) {
+            framesSent++;
+        }
+    }
+    
+    reset();
+    return framesSent;
+}
+
+/*!
+ * @brief Reads every channel once. A sensor that does not answer adds no
+ * sample.
+ */
+void TSLPB_ChannelStats::sampleAll()
+{
+    add(StatsCurrent, board->readAnalogSensor(Current));
+    add(StatsVoltage, board->readAnalogSensor(Voltage));
+    add(StatsSolar,   board->readAnalogSensor(Solar));
+    
+    TSLPB_ImuSample_t imu;
+    if (board->readImuBurst(imu)) {
+        uint32_t l1 = 0;
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            l1 += (uint32_t)abs((int32_t)imu.gyro[axis]);
+        }
+        add(StatsGyro, (int16_t)((l1 * TSL_STATS_GYRO_MUL) >> TSL_STATS_GYRO_SHIFT));
+    }
+    
+    for (uint8_t sensor = DT1; sensor <= DT6; sensor++) {
+        int16_t counts;
+        if (board->readTemperature((TSLPB_DigitalSensor_t)sensor, counts)) {
+            add((TSLPB_StatsChannel_t)(StatsDT1 + sensor - DT1), counts);
+        }
+    }
+}
+
+
+#endif /* TSL_ENABLE_CHANNEL_STATS */
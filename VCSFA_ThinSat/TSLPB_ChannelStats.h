@@ -0,0 +1,131 @@
+/**
+ *  @file   TSLPB_ChannelStats.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Running count, minimum, maximum, mean and variance of selected
+ *          channels between reports.
+ *
+ *          The science frame carries one instantaneous value per channel,
+ *          sent every few seconds. The channel statistics sample the payload
+ *          current and voltage, the solar sensor, the gyro magnitude and the
+ *          six LM75A temperatures once every TSL_STATS_PERIOD_MS, including
+ *          while the sketch sleeps, and summarize each report interval in
+ *          five frames.
+ *
+ *          Each channel keeps an exact integer sum, so the mean is exact,
+ *          and its squared deviations in Q8 with Welford's update against
+ *          those exact means, so the variance does not suffer the
+ *          cancellation of sum-of-squares formulas. A channel costs 18 bytes
+ *          of RAM on the AVR, which does not pad the accumulator.
+ *
+ *          The statistics are compiled out unless TSL_ENABLE_CHANNEL_STATS
+ *          is defined. With TSL_ENABLE_ENERGY_LEDGER, samples taken while the
+ *          sketch sleeps are charged to EnergySleep.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_ChannelStats_h
+#define TSLPB_ChannelStats_h
+
+
+//#define TSL_ENABLE_CHANNEL_STATS      ///< Uncomment to build the channel statistics
+
+
+#include "TSLPB.h"
+
+
+#define TSL_STATS_PERIOD_MS         1000        ///< Time between samples of every channel
+#define TSL_STATS_Q                 8           ///< Fractional bits of the mean and variance
+#define TSL_STATS_GYRO_MUL          625         ///< L1 gyro counts to 0.1 deg/s: counts * MUL >> SHIFT
+#define TSL_STATS_GYRO_SHIFT        11          ///< (1000 dps / 32768) * 10 = 625 / 2048
+
+
+/*!
+ * @brief   Channels summarized by TSLPB_ChannelStats. Frames carry two
+ *          consecutive channels, starting with an even one.
+ */
+typedef enum
+{
+    StatsCurrent        = 0,        ///< Payload current (ADC counts)
+    StatsVoltage        = 1,        ///< Payload voltage (ADC counts)
+    StatsSolar          = 2,        ///< Solar sensor (ADC counts)
+    StatsGyro           = 3,        ///< L1 magnitude of the MPU-9250 gyro vector (0.1 deg/s)
+    StatsDT1            = 4,        ///< LM75A DT1 (LMA_TEMP_REG_DEGREES_PER_LSB)
+    StatsDT2            = 5,        ///< LM75A DT2
+    StatsDT3            = 6,        ///< LM75A DT3
+    StatsDT4            = 7,        ///< LM75A DT4
+    StatsDT5            = 8,        ///< LM75A DT5
+    StatsDT6            = 9,        ///< LM75A DT6
+    TSL_STATS_CHANNEL_COUNT         ///< Number of channels. Not a valid channel
+} TSLPB_StatsChannel_t;
+
+
+/*!
+ * @brief   Running statistics of one channel. count saturates; once it does,
+ *          further samples are dropped.
+ */
+typedef struct
+{
+    uint16_t    count;              ///< Number of samples
+    int16_t     minimum;            ///< Smallest sample
+    int16_t     maximum;            ///< Largest sample
+    int32_t     sum;                ///< Sum of the samples, exact
+    uint64_t    m2;                 ///< Sum of squared deviations from the mean (Q8), saturating
+} TSLPB_StatsAccumulator_t;
+
+
+#ifdef TSL_ENABLE_CHANNEL_STATS
+
+/*!
+ * @brief   Channel statistics. Use the global tslChannelStats instance.
+ *
+ * @code
+ *  void setup() {
+ *      tslpb.begin();
+ *      tslChannelStats.begin(tslpb);
+ *  }
+ *
+ *  void loop() {
+ *      delay(tslChannelStats.update());    // samples when the period is up
+ *      if (reportDue) {
+ *          tslChannelStats.pushReport();   // five frames, then a new interval
+ *      }
+ *  }
+ * @endcode
+ */
+class TSLPB_ChannelStats
+{
+    
+public:
+    void     begin(TSLPB& tslpb);
+    uint32_t update();
+    void     add(TSLPB_StatsChannel_t channel, int16_t value);
+    void     reset();
+    
+    const TSLPB_StatsAccumulator_t& getAccumulator(TSLPB_StatsChannel_t channel) { return stats[channel]; }
+    int32_t  getMean(TSLPB_StatsChannel_t channel);
+    uint32_t getVariance(TSLPB_StatsChannel_t channel);
+    
+    void     fillFrame(ThinsatPacket_t& frame, uint8_t firstChannel);
+    uint8_t  pushReport();
+    
+private:
+    
+    void     sampleAll();
+    
+    TSLPB*   board          = NULL;         ///< Board whose sensors are sampled
+    uint32_t lastSample     = 0;            ///< millis() of the last sample
+    uint32_t intervalStart  = 0;            ///< millis() at the start of the report interval
+    TSLPB_StatsAccumulator_t stats[TSL_STATS_CHANNEL_COUNT];
+    
+};
+
+extern TSLPB_ChannelStats tslChannelStats;
+
+#endif /* TSL_ENABLE_CHANNEL_STATS */
+
+
+#endif /* TSLPB_ChannelStats_h */
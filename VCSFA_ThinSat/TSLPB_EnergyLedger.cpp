@@ -0,0 +1,184 @@
+/**
+ *  @file   TSLPB_EnergyLedger.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the per-phase energy ledger
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_EnergyLedger.h"
+
+#ifdef TSL_ENABLE_ENERGY_LEDGER
+
+
+TSLPB_EnergyLedger tslEnergyLedger;
+
+
+/*!
+ * @brief Starts the ledger. Call after TSLPB::begin(). The first orbit starts
+ * now, in the EnergyAcquisition phase.
+ *
+ * @param[in] tslpb     The TSLPB whose Current sensor is sampled
+ */
+void TSLPB_EnergyLedger::begin(TSLPB& tslpb)
+{
+    board = &tslpb;
+    
+    memset(charge, 0, sizeof(charge));
+    memset(lastOrbitCharge, 0, sizeof(lastOrbitCharge));
+    
+    phase           = EnergyAcquisition;
+    lastCurrent     = board->readAnalogSensor(Current);
+    lastBoundary    = millis();
+    orbitStart      = lastBoundary;
+    orbitNumber     = 0;
+    lastOrbitLength = 0;
+    orbitComplete   = false;
+}
+
+/*!
+ * @brief Ends the phase in progress and starts a new one. Reads the Current
+ * sensor (one mux settle time) and closes the orbit if TSL_ORBIT_PERIOD_MS
+ * has elapsed.
+ *
+ * @param[in] nextPhase TSLPB_EnergyPhase_t phase that starts now
+ */
+void TSLPB_EnergyLedger::enterPhase(TSLPB_EnergyPhase_t nextPhase)
+{
+    if (board == NULL) {
+        return;
+    }
+    
+    uint32_t sampleStart = millis();
+    uint16_t current     = board->readAnalogSensor(Current);
+    uint32_t sampleEnd   = millis();
+    
+    // Trapezoid over the phase that just ended, then the sample itself
+    addCharge(phase, ((uint32_t)lastCurrent + current) / 2, sampleStart - lastBoundary);
+    addCharge(EnergyMuxSettle, current, sampleEnd - sampleStart);
+    
+    lastCurrent  = current;
+    lastBoundary = sampleEnd;
+    phase        = nextPhase;
+    
+    if (sampleEnd - orbitStart >= TSL_ORBIT_PERIOD_MS) {
+        closeOrbit(sampleEnd);
+    }
+}
+
+/*!
+ * @brief Returns true once an orbit has closed and its report has not been
+ * sent with pushReport()
+ */
+bool TSLPB_EnergyLedger::isOrbitComplete()
+{
+    return orbitComplete;
+}
+
+/*!
+ * @brief Returns the charge used by a phase during the last complete orbit
+ *
+ * @return  charge in mAs
+ */
+uint32_t TSLPB_EnergyLedger::getPhaseCharge(TSLPB_EnergyPhase_t phase)
+{
+    return lastOrbitCharge[phase];
+}
+
+/*!
+ * @brief Returns the total charge used during the last complete orbit
+ *
+ * @return  charge in mAs, saturating at UINT32_MAX
+ */
+uint32_t TSLPB_EnergyLedger::getOrbitCharge()
+{
+    uint64_t total = 0;
+    
+    for (uint8_t i = 0; i < TSL_ENERGY_PHASE_COUNT; i++) {
+        total += lastOrbitCharge[i];
+    }
+    return total < UINT32_MAX ? (uint32_t)total : UINT32_MAX;
+}
+
+/*!
+ * @brief Fills a diagnostic frame (TSL_FRAME_TYPE_ENERGY) with the ledger of
+ * the last complete orbit. The header, MET and busVolts are not touched.
+ *
+ * @param[out]  frame   The ThinsatPacket_t to fill
+ */
+void TSLPB_EnergyLedger::fillFrame(ThinsatPacket_t& frame)
+{
+    frame.energyData.frameType    = TSL_FRAME_TYPE_ENERGY;
+    frame.energyData.orbit        = orbitNumber - 1;
+    frame.energyData.orbitSeconds = lastOrbitLength;
+    
+    for (uint8_t i = 0; i < TSL_ENERGY_PHASE_COUNT; i++) {
+        frame.energyData.phaseCharge[i] = lastOrbitCharge[i];
+    }
+    frame.energyData.orbitCharge = getOrbitCharge();
+    memset(frame.energyData.reserved, 0, sizeof(frame.energyData.reserved));
+}
+
+/*!
+ * @brief Sends the ledger of the last complete orbit to the NSL Mothership,
+ * waiting for clear to send. The Voltage sensor is read for the report.
+ *
+ * @return  true if the frame was sent
+ */
+bool TSLPB_EnergyLedger::pushReport()
+{
+    ThinsatPacket_t frame;
+    
+    if (board == NULL) {
+        return false;
+    }
+    
+    board->stampAcquisitionTime(frame);
+    fillFrame(frame);
+    frame.energyData.busVolts = board->readAnalogSensor(Voltage);
+    
+    while (!board->isClearToSend()) {
+        delay(100);
+    }
+    
+    orbitComplete = false;
+    return board->pushDataToNSL(frame);
+}
+
+/*!
+ * @brief Adds current * time to a phase
+ *
+ * @param[in] phase     TSLPB_EnergyPhase_t phase to charge
+ * @param[in] current   Mean current over the interval (ADC counts)
+ * @param[in] elapsed   Length of the interval (ms)
+ */
+void TSLPB_EnergyLedger::addCharge(TSLPB_EnergyPhase_t phase, uint32_t current, uint32_t elapsed)
+{
+    charge[phase] += (uint64_t)current * elapsed;
+}
+
+/*!
+ * @brief Converts the running orbit to mAs, stores it as the last complete
+ * orbit and starts a new orbit
+ *
+ * @param[in] now   millis() at which the orbit closes
+ */
+void TSLPB_EnergyLedger::closeOrbit(uint32_t now)
+{
+    for (uint8_t i = 0; i < TSL_ENERGY_PHASE_COUNT; i++) {
+        // count * ms * (uA / count) / 1000000 = mAs, rounded; saturates rather than wraps
+        uint64_t milliampSeconds = (charge[i] * TSL_CURRENT_UA_PER_COUNT + 500000) / 1000000;
+        lastOrbitCharge[i] = milliampSeconds < UINT32_MAX ? (uint32_t)milliampSeconds : UINT32_MAX;
+        charge[i] = 0;
+    }
+    
+    lastOrbitLength = (now - orbitStart) / 1000;
+    orbitStart      = now;
+    orbitNumber++;
+    orbitComplete   = true;
+}
+
+
+#endif /* TSL_ENABLE_ENERGY_LEDGER */
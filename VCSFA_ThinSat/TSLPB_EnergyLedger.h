@@ -0,0 +1,126 @@
+/**
+ *  @file   TSLPB_EnergyLedger.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Energy accounting per firmware phase. Samples the TSLPB Current
+ *          sensor at phase boundaries and integrates the charge used by each
+ *          phase, per orbit.
+ *
+ *          The ledger is compiled out unless TSL_ENABLE_ENERGY_LEDGER is
+ *          defined. When compiled out TSL_ENERGY_PHASE() expands to nothing.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_EnergyLedger_h
+#define TSLPB_EnergyLedger_h
+
+
+//#define TSL_ENABLE_ENERGY_LEDGER  ///< Uncomment to build the energy ledger
+
+
+#include "TSLPB.h"
+
+
+#define TSL_ORBIT_PERIOD_MS         5520000UL   ///< Ledger period: one 92 minute LEO orbit
+#define TSL_CURRENT_UA_PER_COUNT    1000        ///< Current sensor scale (uA per ADC count), uncalibrated
+
+    /*
+     * TSL_CURRENT_UA_PER_COUNT = 1000 is an uncalibrated placeholder, not a
+     * measured scale. Replace it with the bench calibration of the TSLPB
+     * current sensor before trusting absolute charges. Relative values between
+     * phases are valid either way.
+     */
+
+
+/*!
+ * @brief   Firmware phases tracked by the energy ledger
+ */
+typedef enum
+{
+    EnergyAcquisition   = 0,        ///< I2C sensor acquisition
+    EnergyMuxSettle     = 1,        ///< Analog mux settling and ADC reads, including the ledger's own samples
+    EnergySerialTx      = 2,        ///< Waiting for clear to send and transmitting to the NSL
+    EnergySleep         = 3,        ///< Idle between samples
+    TSL_ENERGY_PHASE_COUNT          ///< Number of phases. Not a valid phase
+} TSLPB_EnergyPhase_t;
+
+
+#ifdef TSL_ENABLE_ENERGY_LEDGER
+
+/*!
+ * @brief   Marks a phase boundary: the previous phase ends and phase begins.
+ */
+#define TSL_ENERGY_PHASE(phase)     tslEnergyLedger.enterPhase(phase)
+
+
+/*!
+ * @brief   Energy ledger. Use the global tslEnergyLedger instance.
+ *
+ *          Each call to enterPhase() reads the Current sensor. The charge of the
+ *          phase that just ended is the mean of the currents at its two
+ *          boundaries times its duration (trapezoid rule). The time spent
+ *          reading the sensor is charged to EnergyMuxSettle.
+ *
+ * @code
+ *  void setup() {
+ *      tslpb.begin();
+ *      tslEnergyLedger.begin(tslpb);
+ *  }
+ *
+ *  void loop() {
+ *      TSL_ENERGY_PHASE(EnergyAcquisition);
+ *      // ... read sensors, send data ...
+ *      if (tslEnergyLedger.isOrbitComplete()) {
+ *          tslEnergyLedger.pushReport();
+ *      }
+ *      TSL_ENERGY_PHASE(EnergySleep);
+ *      delay(5000);
+ *  }
+ * @endcode
+ */
+class TSLPB_EnergyLedger
+{
+
+public:
+    void     begin(TSLPB& tslpb);
+    void     enterPhase(TSLPB_EnergyPhase_t phase);
+    
+    bool     isOrbitComplete();
+    uint32_t getPhaseCharge(TSLPB_EnergyPhase_t phase);
+    uint32_t getOrbitCharge();
+    
+    void     fillFrame(ThinsatPacket_t& frame);
+    bool     pushReport();
+    
+private:
+    
+    void     addCharge(TSLPB_EnergyPhase_t phase, uint32_t current, uint32_t elapsed);
+    void     closeOrbit(uint32_t now);
+    
+    TSLPB*              board           = NULL;                 ///< Board used for current samples and reports
+    TSLPB_EnergyPhase_t phase           = EnergySleep;          ///< Phase in progress
+    uint16_t            lastCurrent     = 0;                    ///< Current at the last boundary (ADC counts)
+    uint32_t            lastBoundary    = 0;                    ///< millis() of the last boundary
+    uint32_t            orbitStart      = 0;                    ///< millis() when the current orbit started
+    uint16_t            orbitNumber     = 0;                    ///< Number of the current orbit
+    uint16_t            lastOrbitLength = 0;                    ///< Duration of the last complete orbit (s)
+    bool                orbitComplete   = false;                ///< Set when an orbit closes, cleared by pushReport()
+    
+    uint64_t            charge[TSL_ENERGY_PHASE_COUNT];         ///< Current orbit (ADC count * ms)
+    uint32_t            lastOrbitCharge[TSL_ENERGY_PHASE_COUNT];///< Last complete orbit (mAs)
+    
+};
+
+extern TSLPB_EnergyLedger tslEnergyLedger;
+
+#else
+
+#define TSL_ENERGY_PHASE(phase)
+
+#endif /* TSL_ENABLE_ENERGY_LEDGER */
+
+
+#endif /* TSLPB_EnergyLedger_h */
@@ -0,0 +1,139 @@
+/**
+ *  @file   TSLPB_I2CTrace.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the I2C transaction tracer
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_I2CTrace.h"
+
+#ifdef TSL_ENABLE_I2C_TRACE
+
+
+TSLPB_I2CTrace tslI2CTrace;
+
+
+/*!
+ * @brief Records one register access, overwriting the oldest entry when the
+ * ring is full
+ *
+ * @param[in] address   I2C address of the device
+ * @param[in] reg       First register accessed
+ * @param[in] info      TSL_I2C_TRACE_READ or TSL_I2C_TRACE_WRITE | byte count
+ */
+void TSLPB_I2CTrace::record(uint8_t address, uint8_t reg, uint8_t info)
+{
+    TSLPB_I2CTraceEntry_t& entry = entries[next];
+    
+    entry.time    = micros();
+    entry.address = address;
+    entry.reg     = reg;
+    entry.info    = info;
+    
+    next = (next + 1) % TSL_I2C_TRACE_LENGTH;
+    if (count < TSL_I2C_TRACE_LENGTH) {
+        count++;
+    }
+    sequence++;
+    
+    if (sink) {
+        sink(entry);
+    }
+}
+
+/*!
+ * @brief Empties the ring buffer. The sequence number keeps counting so that
+ * entries lost between reports can be detected on the ground.
+ */
+void TSLPB_I2CTrace::reset()
+{
+    next  = 0;
+    count = 0;
+}
+
+/*!
+ * @brief Sets a function to be called with every entry, or NULL for none
+ */
+void TSLPB_I2CTrace::setSink(TSLPB_I2CTraceSink_t traceSink)
+{
+    sink = traceSink;
+}
+
+/*!
+ * @brief Returns the number of entries in the ring buffer
+ */
+uint8_t TSLPB_I2CTrace::getCount()
+{
+    return count;
+}
+
+/*!
+ * @brief Returns an entry of the ring buffer. Index 0 is the oldest entry.
+ */
+const TSLPB_I2CTraceEntry_t& TSLPB_I2CTrace::getEntry(uint8_t index)
+{
+    uint8_t oldest = (next + TSL_I2C_TRACE_LENGTH - count) % TSL_I2C_TRACE_LENGTH;
+    return entries[(oldest + index) % TSL_I2C_TRACE_LENGTH];
+}
+
+/*!
+ * @brief Fills a diagnostic frame (TSL_FRAME_TYPE_I2C_TRACE) with up to
+ * TSL_I2C_TRACE_PER_FRAME entries. The header and MET are not touched.
+ *
+ * @param[in]   first   Index of the first entry (0 is the oldest)
+ * @param[out]  frame   The ThinsatPacket_t to fill
+ *
+ * @return  the number of entries in the frame
+ */
+uint8_t TSLPB_I2CTrace::fillFrame(uint8_t first, ThinsatPacket_t& frame)
+{
+    uint8_t framed = 0;
+    
+    memset(frame.traceData.entries, 0, sizeof(frame.traceData.entries));
+    
+    while (framed < TSL_I2C_TRACE_PER_FRAME && first + framed < count) {
+        memcpy(&frame.traceData.entries[framed * sizeof(TSLPB_I2CTraceEntry_t)],
+               &getEntry(first + framed), sizeof(TSLPB_I2CTraceEntry_t));
+        framed++;
+    }
+    
+    frame.traceData.frameType = TSL_FRAME_TYPE_I2C_TRACE;
+    frame.traceData.sequence  = sequence - count + first;
+    frame.traceData.count     = framed;
+    return framed;
+}
+
+/*!
+ * @brief Sends the ring buffer, oldest entry first, waiting for clear to send
+ * before each frame, then empties it.
+ *
+ * @param[in] tslpb     The TSLPB used to send the frames
+ *
+ * @return  the number of frames sent
+ */
+uint8_t TSLPB_I2CTrace::pushReport(TSLPB& tslpb)
+{
+    ThinsatPacket_t frame;
+    uint8_t framesSent = 0;
+    
+    for (uint8_t first = 0; first < count; first += TSL_I2C_TRACE_PER_FRAME) {
+        tslpb.stampAcquisitionTime(frame);
+        fillFrame(first, frame);
+        
+        while (!tslpb.isClearToSend()) {
+            delay(100);
+        }
+        if (tslpb.pushDataToNSL(frame)) {
+            framesSent++;
+        }
+    }
+    
+    reset();
+    return framesSent;
+}
+
+
+#endif /* TSL_ENABLE_I2C_TRACE */
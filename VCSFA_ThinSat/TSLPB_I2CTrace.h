@@ -0,0 +1,105 @@
+/**
+ *  @file   TSLPB_I2CTrace.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  I2C transaction tracer. Records every register access made through
+ *          the TSLPB I2C helpers into a small RAM ring buffer that can be sent
+ *          to the ground in diagnostic frames.
+ *
+ *          The tracer is compiled out unless TSL_ENABLE_I2C_TRACE is defined.
+ *          When compiled out TSL_I2C_TRACE() expands to nothing.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_I2CTrace_h
+#define TSLPB_I2CTrace_h
+
+
+//#define TSL_ENABLE_I2C_TRACE      ///< Uncomment to build the I2C transaction tracer
+
+
+#include "TSLPB.h"
+
+
+#define TSL_I2C_TRACE_LENGTH        32      ///< Entries kept in the ring buffer (7 bytes each)
+#define TSL_I2C_TRACE_PER_FRAME     4       ///< Entries per TSL_FRAME_TYPE_I2C_TRACE frame
+#define TSL_I2C_TRACE_WRITE         0x00    ///< info: register write
+#define TSL_I2C_TRACE_READ          0x80    ///< info: register read (pointer write, then read)
+#define TSL_I2C_TRACE_COUNT_MASK    0x7F    ///< info: number of data bytes
+
+
+/*!
+ * @brief   One traced register access. An access made by read8bitRegister()
+ *          or read16bitRegister() is one entry, although it takes a pointer
+ *          write and a read transaction on the bus.
+ */
+typedef struct __attribute__((__packed__))
+{
+    uint32_t    time;               ///< micros() when the access started
+    uint8_t     address;            ///< TSLPB_I2CAddress_t of the device
+    uint8_t     reg;                ///< First register accessed
+    uint8_t     info;               ///< TSL_I2C_TRACE_READ/WRITE | data byte count
+} TSLPB_I2CTraceEntry_t;
+
+
+/*!
+ * @brief   Optional function called with every entry as it is recorded. Used by
+ *          host tools to keep a complete trace.
+ */
+typedef void (*TSLPB_I2CTraceSink_t)(const TSLPB_I2CTraceEntry_t& entry);
+
+
+#ifdef TSL_ENABLE_I2C_TRACE
+
+/*!
+ * @brief   Records one register access
+ */
+#define TSL_I2C_TRACE(address, reg, direction, count) \
+    tslI2CTrace.record(address, reg, (direction) | ((count) & TSL_I2C_TRACE_COUNT_MASK))
+
+
+/*!
+ * @brief   I2C transaction tracer. TSLPB records into the global tslI2CTrace
+ *          instance; the sketch only needs to send the report.
+ *
+ * @code
+ *  tslI2CTrace.pushReport(tslpb);  // the last TSL_I2C_TRACE_LENGTH accesses
+ * @endcode
+ */
+class TSLPB_I2CTrace
+{
+
+public:
+    void     record(uint8_t address, uint8_t reg, uint8_t info);
+    void     reset();
+    void     setSink(TSLPB_I2CTraceSink_t sink);
+    
+    uint8_t  getCount();
+    const TSLPB_I2CTraceEntry_t& getEntry(uint8_t index);
+    
+    uint8_t  fillFrame(uint8_t first, ThinsatPacket_t& frame);
+    uint8_t  pushReport(TSLPB& tslpb);
+    
+private:
+    
+    TSLPB_I2CTraceEntry_t   entries[TSL_I2C_TRACE_LENGTH];
+    uint8_t                 next        = 0;    ///< Ring index of the next entry
+    uint8_t                 count       = 0;    ///< Entries in the ring
+    uint16_t                sequence    = 0;    ///< Entries recorded since power-up, modulo 2^16
+    TSLPB_I2CTraceSink_t    sink        = NULL;
+    
+};
+
+extern TSLPB_I2CTrace tslI2CTrace;
+
+#else
+
+#define TSL_I2C_TRACE(address, reg, direction, count)
+
+#endif /* TSL_ENABLE_I2C_TRACE */
+
+
+#endif /* TSLPB_I2CTrace_h */
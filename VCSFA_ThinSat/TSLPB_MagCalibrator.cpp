@@ -0,0 +1,408 @@
+/**
+ *  @file   TSLPB_MagCalibrator.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the streaming magnetometer calibrator
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_MagCalibrator.h"
+
+#ifdef TSL_ENABLE_MAG_CALIBRATION
+
+#include <stddef.h>
+#include <string.h>
+#include "EEPROM.h"
+
+
+TSLPB_MagCalibrator tslMagCalibrator;
+
+
+/*!
+ * @brief Checksum of a record, over every byte before the checksum field
+ */
+static uint8_t recordChecksum(const TSLPB_MagCalibrationRecord_t& record)
+{
+    const uint8_t* bytes = (const uint8_t*)&record;
+    uint8_t        sum   = 0;
+    
+    for (uint8_t i = 0; i < offsetof(TSLPB_MagCalibrationRecord_t, checksum); i++) {
+        sum += bytes[i];
+    }
+    return (uint8_t)(0 - sum);
+}
+
+/*!
+ * @brief Squared length of a field corrected by calibration, in counts
+ */
+static float correctedLengthSquared(const int16_t field[3], const TSLPB_MagCalibration_t& calibration)
+{
+    float sum = 0;
+    
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        float corrected = ((float)field[axis] - calibration.offset[axis]) * calibration.scale[axis] / TSL_MAG_SCALE_ONE;
+        sum += corrected * corrected;
+    }
+    return sum;
+}
+
+/*!
+ * @brief Coverage bits of the directions an offset-free field lies along
+ */
+static uint8_t alignedDirections(const int32_t field[3])
+{
+    uint8_t directions = 0;
+    
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        int32_t across = abs(field[(axis + 1) % 3]) + abs(field[(axis + 2) % 3]);
+        if (abs(field[axis]) >= TSL_MAG_CAL_ALIGN_RATIO * across) {
+            directions |= 1 << (2 * axis + (field[axis] < 0 ? 1 : 0));
+        }
+    }
+    return directions;
+}
+
+/*!
+ * @brief Least-squares residual of a quadratic in time
+ *
+ * @param time    sums of t^0 .. t^4
+ * @param moments sums of y, t y, t^2 y and y^2
+ * @return sum of squared residuals
+ */
+static float trendResidual(const float time[5], const float moments[4])
+{
+    // Normal equations M b = v, solved by Cramer's rule
+    float m00 = time[0], m01 = time[1], m02 = time[2];
+    float m11 = time[2], m12 = time[3], m22 = time[4];
+    float c00 = m11 * m22 - m12 * m12;
+    float c01 = m02 * m12 - m01 * m22;
+    float c02 = m01 * m12 - m02 * m11;
+    float c11 = m00 * m22 - m02 * m02;
+    float c12 = m01 * m02 - m00 * m12;
+    float c22 = m00 * m11 - m01 * m01;
+    float determinant = m00 * c00 + m01 * c01 + m02 * c02;
+    if (determinant == 0) {
+        return 0;
+    }
+    
+    const float* v = moments;
+    float b0 = (c00 * v[0] + c01 * v[1] + c02 * v[2]) / determinant;
+    float b1 = (c01 * v[0] + c11 * v[1] + c12 * v[2]) / determinant;
+    float b2 = (c02 * v[0] + c12 * v[1] + c22 * v[2]) / determinant;
+    float residual = moments[3] - (b0 * v[0] + b1 * v[1] + b2 * v[2]);
+    return residual > 0 ? residual : 0;
+}
+
+/*!
+ * @brief True if two calibrations differ by more than TSL_MAG_CAL_SAVE_THRESHOLD
+ */
+static bool isFarFrom(const TSLPB_MagCalibration_t& a, const TSLPB_MagCalibration_t& b)
+{
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        if (abs((int32_t)a.offset[axis] - b.offset[axis]) > TSL_MAG_CAL_SAVE_THRESHOLD ||
+            abs((int32_t)a.scale[axis] - b.scale[axis]) > TSL_MAG_CAL_SAVE_THRESHOLD * 256) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*!
+ * @brief Starts the calibrator with an empty envelope and applies the
+ * calibration stored in EEPROM, if there is a valid one. Call after
+ * TSLPB::begin().
+ *
+ * @param[in] tslpb     The TSLPB whose magnetometer read path is corrected
+ *
+ * @return true if a stored calibration was applied
+ */
+bool TSLPB_MagCalibrator::begin(TSLPB& tslpb)
+{
+    board      = &tslpb;
+    current    = board->getMagCalibration();
+    calibrated = false;
+    reset();
+    
+    TSLPB_MagCalibrationRecord_t record;
+    EEPROM.get(TSL_MAG_CAL_EEPROM_ADDRESS, record);
+    
+    haveSaved = record.magic == TSL_MAG_CAL_MAGIC && record.checksum == recordChecksum(record);
+    lastSave  = millis();
+    if (!haveSaved) {
+        return false;
+    }
+    
+    saved      = record.calibration;
+    current    = saved;
+    calibrated = true;
+    board->setMagCalibration(current);
+    return true;
+}
+
+/*!
+ * @brief Empties the envelope and the coverage and drops a running trial. The
+ * applied calibration is kept until a new envelope gives a better one.
+ */
+void TSLPB_MagCalibrator::reset()
+{
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        minimum[axis]     = INT16_MAX;
+        maximum[axis]     = INT16_MIN;
+        coverCenter[axis] = 0;
+    }
+    samples    = 0;
+    lastDecay  = millis();
+    coverage   = 0;
+    trialing   = false;
+}
+
+/*!
+ * @brief Adds one raw magnetometer result to the envelope and, once the
+ * envelope spans enough of the field sphere, refits and trials the
+ * calibration. A fit that passes its trial is applied, and saved to EEPROM if
+ * there is none stored yet, or if it moved far enough and the save interval
+ * has passed.
+ *
+ * @param[in] field     Raw x, y, z counts in the AK8963 axes, without overflow
+ */
+void TSLPB_MagCalibrator::sample(const int16_t field[3])
+{
+    if (board == NULL || isOutlier(field)) {
+        return;
+    }
+    
+    bool changed = false;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        if (field[axis] < minimum[axis]) {
+            minimum[axis] = field[axis];
+            changed = true;
+        }
+        if (field[axis] > maximum[axis]) {
+            maximum[axis] = field[axis];
+            changed = true;
+        }
+    }
+    if (samples < UINT16_MAX) {
+        samples++;
+    }
+    trackCoverage(field);
+    
+    // Shrink slowly so extremes must keep being revisited
+    if (millis() - lastDecay >= TSL_MAG_CAL_DECAY_MS) {
+        lastDecay = millis();
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            if ((int32_t)maximum[axis] - minimum[axis] > TSL_MAG_CAL_MIN_SPAN) {
+                maximum[axis]--;
+                minimum[axis]++;
+                changed = true;
+            }
+        }
+    }
+    
+    if (trialing) {
+        if (!runTrial(field)) {
+            return;
+        }
+        
+        current    = trial;
+        calibrated = true;
+        board->setMagCalibration(current);
+        
+        // The first calibration is saved at once, later ones at most once per interval
+        if (isSaveWorthy(current) && (!haveSaved || millis() - lastSave >= TSL_MAG_CAL_SAVE_INTERVAL_MS)) {
+            save();
+        }
+        return;
+    }
+    
+    TSLPB_MagCalibration_t calibration;
+    if (changed && fit(calibration) && isFarFrom(calibration, current)) {
+        startTrial(calibration);
+    }
+}
+
+/*!
+ * @brief Writes the applied calibration to EEPROM now, regardless of the
+ * save interval
+ *
+ * @return false if there is no calibration to save
+ */
+bool TSLPB_MagCalibrator::save()
+{
+    if (!calibrated) {
+        return false;
+    }
+    
+    TSLPB_MagCalibrationRecord_t record;
+    memset(&record, 0, sizeof(record));
+    record.magic       = TSL_MAG_CAL_MAGIC;
+    record.calibration = current;
+    record.checksum    = recordChecksum(record);
+    EEPROM.put(TSL_MAG_CAL_EEPROM_ADDRESS, record);
+    
+    saved     = current;
+    haveSaved = true;
+    lastSave  = millis();
+    return true;
+}
+
+/*!
+ * @brief Marks the directions, around the envelope's center, that the sample
+ * lies along. Starts over when the center has moved, since the earlier
+ * samples were judged around the wrong point.
+ */
+void TSLPB_MagCalibrator::trackCoverage(const int16_t field[3])
+{
+    if (samples < TSL_MAG_CAL_MIN_SAMPLES) {
+        return;
+    }
+    
+    int32_t offCenter[3];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        int16_t center = (int16_t)(((int32_t)maximum[axis] + minimum[axis]) / 2);
+        if (abs((int32_t)center - coverCenter[axis]) > TSL_MAG_CAL_COVER_SLACK) {
+            for (uint8_t i = 0; i < 3; i++) {
+                coverCenter[i] = (int16_t)(((int32_t)maximum[i] + minimum[i]) / 2);
+            }
+            coverage = 0;
+            return;
+        }
+        offCenter[axis] = (int32_t)field[axis] - coverCenter[axis];
+    }
+    coverage |= alignedDirections(offCenter);
+}
+
+/*!
+ * @brief Fits offsets to the envelope and, once the field has been seen along
+ * every direction, diagonal gains. Until then the gains are 1.
+ *
+ * @return false if the envelope is too small or gives gains out of range
+ */
+bool TSLPB_MagCalibrator::fit(TSLPB_MagCalibration_t& calibration)
+{
+    if (samples < TSL_MAG_CAL_MIN_SAMPLES) {
+        return false;
+    }
+    
+    int32_t radius[3];
+    int32_t meanRadius = 0;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        int32_t span = (int32_t)maximum[axis] - minimum[axis];
+        if (span < TSL_MAG_CAL_MIN_SPAN) {
+            return false;
+        }
+        calibration.offset[axis] = (int16_t)(((int32_t)maximum[axis] + minimum[axis]) / 2);
+        radius[axis]             = span / 2;
+        meanRadius              += radius[axis];
+    }
+    meanRadius /= 3;
+    
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        if (coverage != TSL_MAG_CAL_COVERED) {
+            calibration.scale[axis] = TSL_MAG_SCALE_ONE;
+            continue;
+        }
+        int32_t scale = (meanRadius * TSL_MAG_SCALE_ONE + radius[axis] / 2) / radius[axis];
+        if (scale < TSL_MAG_CAL_MIN_SCALE || scale > TSL_MAG_CAL_MAX_SCALE) {
+            return false;
+        }
+        calibration.scale[axis] = (uint16_t)scale;
+    }
+    return true;
+}
+
+/*!
+ * @brief Starts comparing a fit with the applied calibration
+ */
+void TSLPB_MagCalibrator::startTrial(const TSLPB_MagCalibration_t& calibration)
+{
+    trial         = calibration;
+    trialing      = true;
+    trialSamples  = 0;
+    memset(trialMoments, 0, sizeof(trialMoments));
+    memset(trialTime, 0, sizeof(trialTime));
+}
+
+/*!
+ * @brief Adds one sample to the running trial
+ *
+ * @return true when the trial has ended and the fit is better than the
+ *         applied calibration
+ */
+bool TSLPB_MagCalibrator::runTrial(const int16_t field[3])
+{
+    const TSLPB_MagCalibration_t* calibrations[2] = { &current, &trial };
+    
+    float t     = (float)trialSamples / TSL_MAG_CAL_TRIAL_SAMPLES;
+    float power = 1;
+    for (uint8_t k = 0; k < 5; k++) {
+        trialTime[k] += power;
+        power        *= t;
+    }
+    
+    // Sums around the first sample, so the float sums keep their precision
+    for (uint8_t i = 0; i < 2; i++) {
+        float lengthSquared = correctedLengthSquared(field, *calibrations[i]);
+        if (trialSamples == 0) {
+            trialShift[i] = lengthSquared;
+        }
+        float y = lengthSquared - trialShift[i];
+        trialMoments[i][0] += y;
+        trialMoments[i][1] += t * y;
+        trialMoments[i][2] += t * t * y;
+        trialMoments[i][3] += y * y;
+    }
+    if (++trialSamples < TSL_MAG_CAL_TRIAL_SAMPLES) {
+        return false;
+    }
+    trialing = false;
+    
+    // Ripple about the trend, relative to the mean squared magnitude squared
+    float ripple[2];
+    for (uint8_t i = 0; i < 2; i++) {
+        float level = trialShift[i] + trialMoments[i][0] / trialSamples;
+        ripple[i]   = level > 0 ? trendResidual(trialTime, trialMoments[i]) / (level * level) : 0;
+    }
+    return ripple[1] * 100 < ripple[0] * TSL_MAG_CAL_ACCEPT_PERCENT;
+}
+
+/*!
+ * @brief Once the envelope has a fit, rejects samples whose corrected field
+ * is far longer than the mean radius: bus glitches and nearby transients, not
+ * the Earth's field
+ */
+bool TSLPB_MagCalibrator::isOutlier(const int16_t field[3])
+{
+    if (!calibrated || samples < TSL_MAG_CAL_MIN_SAMPLES) {
+        return false;
+    }
+    
+    int16_t  corrected[3] = { field[0], field[1], field[2] };
+    uint32_t length       = 0;
+    uint32_t radii        = 0;
+    
+    board->correctMagnetometer(corrected);
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        length += (uint32_t)abs((int32_t)corrected[axis]);
+        radii  += (uint32_t)((int32_t)maximum[axis] - minimum[axis]) / 2;
+    }
+    
+    // The L1 length is up to sqrt(3) times the Euclidean one, so this bound
+    // sits between TSL_MAG_CAL_OUTLIER_RATIO and twice that many mean radii
+    return 3 * length > TSL_MAG_CAL_OUTLIER_RATIO * 2 * radii;
+}
+
+/*!
+ * @brief True if calibration differs from the one in EEPROM by more than
+ * TSL_MAG_CAL_SAVE_THRESHOLD
+ */
+bool TSLPB_MagCalibrator::isSaveWorthy(const TSLPB_MagCalibration_t& calibration)
+{
+    return !haveSaved || isFarFrom(calibration, saved);
+}
+
+
+#endif /* TSL_ENABLE_MAG_CALIBRATION */
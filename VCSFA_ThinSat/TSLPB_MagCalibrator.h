@@ -0,0 +1,161 @@
+/**
+ *  @file   TSLPB_MagCalibrator.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Streaming hard- and soft-iron calibration of the AK8963
+ *          magnetometer, persisted in EEPROM.
+ *
+ *          As the payload turns, the raw field traces an ellipsoid whose
+ *          center is the hard-iron offset and whose semi-axes differ by the
+ *          soft-iron gains. The calibrator tracks the per-axis envelope of the
+ *          raw samples in constant memory: the offset is the envelope's
+ *          center and each axis is scaled to the mean of the three radii
+ *          (a diagonal soft-iron model). The envelope shrinks by one count
+ *          every TSL_MAG_CAL_DECAY_MS so a glitch ages out, slowly enough
+ *          that the extremes, which in orbit recur about once per orbit,
+ *          are kept.
+ *
+ *          In orbit the field strength varies by almost a factor of two, so
+ *          the envelope is set by the strongest field seen along each axis.
+ *          A tumble that keeps an axis away from the strong field biases
+ *          that axis' gain, and to a lesser degree its offset. Two gates keep
+ *          such a fit from making a good sensor worse:
+ *          - Coverage. The gains are fitted only once the field has been
+ *            seen within 27 degrees of both directions of every axis; until
+ *            then a fit corrects the offsets only.
+ *          - Trial. A fit that differs from the applied calibration is first
+ *            run alongside it for TSL_MAG_CAL_TRIAL_SAMPLES samples. For
+ *            each, the squared corrected magnitude is fitted with a
+ *            quadratic in time, which follows the slow change in true field
+ *            strength; what is left is the ripple a calibration error causes
+ *            as the board turns. The fit replaces the applied calibration
+ *            only if its ripple is below TSL_MAG_CAL_ACCEPT_PERCENT of the
+ *            applied one's, so an undistorted sensor keeps the identity.
+ *
+ *          Once every axis has spanned TSL_MAG_CAL_MIN_SPAN and a fit has
+ *          passed its trial, it is handed to TSLPB::setMagCalibration() and
+ *          applied by the magnetometer read path. It is written to EEPROM
+ *          when it has moved by more than TSL_MAG_CAL_SAVE_THRESHOLD, at most
+ *          once per TSL_MAG_CAL_SAVE_INTERVAL_MS, and restored by begin()
+ *          after a reset.
+ *
+ *          The calibrator is compiled out unless TSL_ENABLE_MAG_CALIBRATION
+ *          is defined.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_MagCalibrator_h
+#define TSLPB_MagCalibrator_h
+
+
+//#define TSL_ENABLE_MAG_CALIBRATION    ///< Uncomment to build the magnetometer calibrator
+
+
+#include "TSLPB.h"
+
+
+#define TSL_MAG_CAL_EEPROM_ADDRESS      0x000       ///< EEPROM offset of the stored calibration
+#define TSL_MAG_CAL_MAGIC               0x4D43      ///< "MC", marks a stored calibration
+#define TSL_MAG_CAL_MIN_SAMPLES         32          ///< Samples before a calibration is trusted
+#define TSL_MAG_CAL_MIN_SPAN            200         ///< Counts each axis must span (30 uT at 16 bits)
+#define TSL_MAG_CAL_MIN_SCALE           8192        ///< Soft-iron gains outside 0.5 ..
+#define TSL_MAG_CAL_MAX_SCALE           32768       ///< .. 2.0 are rejected as a bad fit
+#define TSL_MAG_CAL_ALIGN_RATIO         2           ///< Along an axis: that component 2x the sum of the others (27 deg)
+#define TSL_MAG_CAL_COVER_SLACK         32          ///< Center move (counts) that restarts the coverage
+#define TSL_MAG_CAL_COVERED             0x3F        ///< Coverage bits of both directions of all three axes
+#define TSL_MAG_CAL_TRIAL_SAMPLES       1024        ///< Samples a new fit is compared over (2 min at 8 Hz)
+#define TSL_MAG_CAL_ACCEPT_PERCENT      50          ///< Largest magnitude variance of an accepted fit, % of the applied
+#define TSL_MAG_CAL_DECAY_MS            512000UL    ///< Time per one-count shrink of the envelope
+#define TSL_MAG_CAL_OUTLIER_RATIO       2           ///< Samples this many mean radii from the offset are ignored
+#define TSL_MAG_CAL_SAVE_THRESHOLD      8           ///< Change in any offset (counts) or gain (Q14 / 256) worth saving
+#define TSL_MAG_CAL_SAVE_INTERVAL_MS    3600000UL   ///< Shortest time between EEPROM writes
+
+    /*
+     * At TSL_MAG_CAL_SAVE_INTERVAL_MS the 100,000 cycle endurance of the
+     * ATmega328P EEPROM lasts over eleven years, and EEPROM.put() only
+     * programs the bytes that changed.
+     */
+
+
+/*!
+ * @brief   Calibration as stored in EEPROM
+ */
+typedef struct
+{
+    uint16_t                magic;          ///< TSL_MAG_CAL_MAGIC
+    TSLPB_MagCalibration_t  calibration;
+    uint8_t                 checksum;       ///< Two's complement of the sum of the bytes above
+} TSLPB_MagCalibrationRecord_t;
+
+
+#ifdef TSL_ENABLE_MAG_CALIBRATION
+
+/*!
+ * @brief   Magnetometer calibrator. Use the global tslMagCalibrator instance.
+ *
+ * @code
+ *  void setup() {
+ *      tslpb.begin();
+ *      tslMagCalibrator.begin(tslpb);      // restores the EEPROM calibration
+ *  }
+ *
+ *  void loop() {
+ *      int16_t field[3];
+ *      // With the attitude filter, tslAttitude.takeMagnetometer(field)
+ *      if (tslpb.readMagnetometerBurst(field, true)) {
+ *          tslMagCalibrator.sample(field); // raw counts
+ *          tslpb.correctMagnetometer(field);
+ *      }
+ *  }
+ * @endcode
+ */
+class TSLPB_MagCalibrator
+{
+    
+public:
+    bool    begin(TSLPB& tslpb);
+    void    sample(const int16_t field[3]);
+    void    reset();
+    
+    bool    isCalibrated()      { return calibrated; }
+    bool    save();
+    
+private:
+    
+    void    trackCoverage(const int16_t field[3]);
+    bool    fit(TSLPB_MagCalibration_t& calibration);
+    void    startTrial(const TSLPB_MagCalibration_t& calibration);
+    bool    runTrial(const int16_t field[3]);
+    bool    isOutlier(const int16_t field[3]);
+    bool    isSaveWorthy(const TSLPB_MagCalibration_t& calibration);
+    
+    TSLPB*                  board           = NULL;     ///< Board whose read path is corrected
+    int16_t                 minimum[3];                 ///< Envelope of the raw samples
+    int16_t                 maximum[3];
+    uint16_t                samples         = 0;        ///< Samples in the envelope, saturating
+    uint32_t                lastDecay       = 0;        ///< millis() when the envelope last shrank
+    uint8_t                 coverage        = 0;        ///< Bit 2 * axis (+) and 2 * axis + 1 (-): field seen along it
+    int16_t                 coverCenter[3];             ///< Envelope center the coverage was judged around
+    bool                    trialing        = false;    ///< trial is being compared with current
+    uint16_t                trialSamples    = 0;        ///< Samples of the running trial
+    TSLPB_MagCalibration_t  trial;                      ///< Fit on trial
+    float                   trialShift[2];              ///< First squared magnitude of current [0] and trial [1]
+    float                   trialMoments[2][4];         ///< Sums of y, t y, t^2 y and y^2, y the squared magnitude less the shift
+    float                   trialTime[5];               ///< Sums of t^0 .. t^4, t in TSL_MAG_CAL_TRIAL_SAMPLES
+    bool                    calibrated      = false;    ///< A calibration is applied
+    TSLPB_MagCalibration_t  current;                    ///< Calibration applied to the board
+    TSLPB_MagCalibration_t  saved;                      ///< Calibration in EEPROM
+    bool                    haveSaved       = false;    ///< saved is valid
+    uint32_t                lastSave        = 0;        ///< millis() of the last EEPROM write
+    
+};
+
+extern TSLPB_MagCalibrator tslMagCalibrator;
+
+#endif /* TSL_ENABLE_MAG_CALIBRATION */
+
+
+#endif /* TSLPB_MagCalibrator_h */
@@ -0,0 +1,131 @@
+/**
+ *  @file   TSLPB_Profiler.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the loop-phase profiler
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_Profiler.h"
+
+#ifdef TSL_ENABLE_PROFILER
+
+
+TSLPB_Profiler tslProfiler;
+
+
+/*!
+ * @brief Records one sample of a phase
+ *
+ * @param[in] phase     TSLPB_ProfilePhase_t phase that ended
+ * @param[in] elapsed   Duration of the phase in microseconds
+ */
+void TSLPB_Profiler::record(TSLPB_ProfilePhase_t phase, uint32_t elapsed)
+{
+    TSLPB_ProfileStats_t& phaseStats = stats[phase];
+    uint8_t bin = 0;
+    
+    if (phaseStats.count == 0) {
+        phaseStats.minTime = elapsed;
+        phaseStats.maxTime = elapsed;
+    }
+    if (phaseStats.count < 0xFFFF) {
+        phaseStats.count++;
+    }
+    if (elapsed < phaseStats.minTime) {
+        phaseStats.minTime = elapsed;
+    }
+    if (elapsed > phaseStats.maxTime) {
+        phaseStats.maxTime = elapsed;
+    }
+    if (phaseStats.totalTime + elapsed < phaseStats.totalTime) {
+        phaseStats.totalTime = 0xFFFFFFFF;
+    } else {
+        phaseStats.totalTime += elapsed;
+    }
+    
+    // Bin index is the bit length of elapsed, offset by TSL_PROFILE_HIST_SHIFT
+    for (uint32_t remaining = elapsed >> TSL_PROFILE_HIST_SHIFT; remaining != 0; remaining >>= 1) {
+        bin++;
+    }
+    if (bin >= TSL_PROFILE_HIST_BINS) {
+        bin = TSL_PROFILE_HIST_BINS - 1;
+    }
+    if (phaseStats.histogram[bin] < 0xFF) {
+        phaseStats.histogram[bin]++;
+    }
+}
+
+/*!
+ * @brief Clears the statistics of every phase
+ */
+void TSLPB_Profiler::reset()
+{
+    memset(stats, 0, sizeof(stats));
+}
+
+/*!
+ * @brief Returns the statistics of a phase
+ */
+const TSLPB_ProfileStats_t& TSLPB_Profiler::getStats(TSLPB_ProfilePhase_t phase)
+{
+    return stats[phase];
+}
+
+/*!
+ * @brief Fills a diagnostic frame (TSL_FRAME_TYPE_PROFILE) with the
+ * statistics of one phase. The header and MET are not touched.
+ *
+ * @param[in]   phase   TSLPB_ProfilePhase_t phase to report
+ * @param[out]  frame   The ThinsatPacket_t to fill
+ */
+void TSLPB_Profiler::fillFrame(TSLPB_ProfilePhase_t phase, ThinsatPacket_t& frame)
+{
+    TSLPB_ProfileStats_t& phaseStats = stats[phase];
+    
+    frame.profileData.frameType = TSL_FRAME_TYPE_PROFILE;
+    frame.profileData.phase     = phase;
+    frame.profileData.count     = phaseStats.count;
+    frame.profileData.minTime   = phaseStats.minTime;
+    frame.profileData.maxTime   = phaseStats.maxTime;
+    frame.profileData.meanTime  = phaseStats.count ? phaseStats.totalTime / phaseStats.count : 0;
+    memcpy(frame.profileData.histogram, phaseStats.histogram, TSL_PROFILE_HIST_BINS);
+}
+
+/*!
+ * @brief Sends one diagnostic frame for every phase that has samples, waiting
+ * for clear to send before each frame, then clears the statistics.
+ *
+ * @param[in] tslpb     The TSLPB used to send the frames
+ *
+ * @return  the number of frames sent
+ */
+uint8_t TSLPB_Profiler::pushReport(TSLPB& tslpb)
+{
+    ThinsatPacket_t frame;
+    uint8_t framesSent = 0;
+    
+    for (uint8_t phase = 0; phase < TSL_PROFILE_PHASE_COUNT; phase++) {
+        if (stats[phase].count == 0) {
+            continue;
+        }
+        
+        tslpb.stampAcquisitionTime(frame);
+        fillFrame((TSLPB_ProfilePhase_t)phase, frame);
+        
+        while (!tslpb.isClearToSend()) {
+            delay(100);
+        }
+        if (tslpb.pushDataToNSL(frame)) {
+            framesSent++;
+        }
+    }
+    
+    reset();
+    return framesSent;
+}
+
+
+#endif /* TSL_ENABLE_PROFILER */
@@ -0,0 +1,118 @@
+/**
+ *  @file   TSLPB_Profiler.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Loop-phase profiler. Brackets named phases of the flight software
+ *          with micros() and keeps per-phase latency statistics in a fixed
+ *          RAM table.
+ *
+ *          The profiler is compiled out unless TSL_ENABLE_PROFILER is defined.
+ *          When compiled out the TSL_PROFILE_BEGIN() / TSL_PROFILE_END()
+ *          macros expand to nothing and the profiler uses no RAM or flash.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_Profiler_h
+#define TSLPB_Profiler_h
+
+
+//#define TSL_ENABLE_PROFILER       ///< Uncomment to build the loop-phase profiler
+
+
+#include "TSLPB.h"
+
+
+#define TSL_PROFILE_HIST_BINS   16  ///< Number of log2 latency histogram bins
+#define TSL_PROFILE_HIST_SHIFT  7   ///< Bin 0 holds phases shorter than 2^7 us
+
+
+/*!
+ * @brief   Named phases of the flight software loop
+ */
+typedef enum
+{
+    ProfileLoop         = 0,        ///< One pass of loop(), excluding the final sleep
+    ProfileBnoRead      = 1,        ///< BNO055 quaternion, magnetometer and calibration reads
+    ProfileBmeRead      = 2,        ///< BMP280 pressure and temperature reads
+    ProfileGyroRead     = 3,        ///< TSLPB MPU-9250 gyroscope reads
+    ProfileAnalogRead   = 4,        ///< TSLPB::readAnalogSensor(), including mux settle delay
+    ProfileMagWait      = 5,        ///< TSLPB::waitForMagReady() polling
+    ProfileCtsWait      = 6,        ///< Waiting for the NSL Mothership clear to send
+    ProfileSerialTx     = 7,        ///< TSLPB::pushDataToNSL()
+    ProfileAttitude     = 8,        ///< TSLPB_AttitudeFilter arithmetic, excluding the I2C reads
+    TSL_PROFILE_PHASE_COUNT         ///< Number of phases. Not a valid phase
+} TSLPB_ProfilePhase_t;
+
+
+/*!
+ * @brief   Latency statistics of a single phase. Counters saturate instead of
+ *          wrapping.
+ */
+typedef struct
+{
+    uint16_t    count;                              ///< Number of samples
+    uint32_t    minTime;                            ///< Shortest sample (us)
+    uint32_t    maxTime;                            ///< Longest sample (us)
+    uint32_t    totalTime;                          ///< Sum of all samples (us)
+    uint8_t     histogram[TSL_PROFILE_HIST_BINS];   ///< log2 bins, see TSL_PROFILE_HIST_SHIFT
+} TSLPB_ProfileStats_t;
+
+
+#ifdef TSL_ENABLE_PROFILER
+
+/*!
+ * @brief   Marks the start of a phase. Must be matched by TSL_PROFILE_END() with
+ *          the same phase in the same scope.
+ */
+#define TSL_PROFILE_BEGIN(phase)    uint32_t tslProfileStart_##phase = micros()
+
+/*!
+ * @brief   Marks the end of a phase and records its duration.
+ */
+#define TSL_PROFILE_END(phase)      tslProfiler.record(phase, micros() - tslProfileStart_##phase)
+
+
+/*!
+ * @brief   Loop-phase profiler. Use the global tslProfiler instance through the
+ *          TSL_PROFILE_BEGIN() and TSL_PROFILE_END() macros.
+ *
+ * @code
+ *  TSL_PROFILE_BEGIN(ProfileBmeRead);
+ *  float pressure = bme.readPressure();
+ *  TSL_PROFILE_END(ProfileBmeRead);
+ *
+ *  tslProfiler.pushReport(tslpb);  // one diagnostic frame per phase
+ * @endcode
+ */
+class TSLPB_Profiler
+{
+
+public:
+    void    record(TSLPB_ProfilePhase_t phase, uint32_t elapsed);
+    void    reset();
+    
+    const TSLPB_ProfileStats_t& getStats(TSLPB_ProfilePhase_t phase);
+    
+    void    fillFrame(TSLPB_ProfilePhase_t phase, ThinsatPacket_t& frame);
+    uint8_t pushReport(TSLPB& tslpb);
+    
+private:
+    
+    TSLPB_ProfileStats_t stats[TSL_PROFILE_PHASE_COUNT];
+    
+};
+
+extern TSLPB_Profiler tslProfiler;
+
+#else
+
+#define TSL_PROFILE_BEGIN(phase)
+#define TSL_PROFILE_END(phase)
+
+#endif /* TSL_ENABLE_PROFILER */
+
+
+#endif /* TSLPB_Profiler_h */
@@ -0,0 +1,108 @@
+/**
+ *  @file   TSLPB_Quaternion.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the smallest-three quaternion packing
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdlib.h>
+
+#include "TSLPB_Quaternion.h"
+
+
+/*!
+ * @brief Integer square root, rounded to nearest
+ */
+static uint16_t isqrtRounded(uint32_t value)
+{
+    uint32_t remainder = value;
+    uint32_t root      = 0;
+    uint32_t bit       = 1UL << 30;
+    
+    while (bit > remainder) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (remainder >= root + bit) {
+            remainder -= root + bit;
+            root       = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    // value - root^2 > root means value is past (root + 0.5)^2
+    return (uint16_t)(remainder > root ? root + 1 : root);
+}
+
+
+/*!
+ * @brief Packs a quaternion into 32 bits, dropping its largest component
+ *
+ * @param[in] quaternion    w, x, y, z in Q14 (TSL_QUAT_ONE = 1.0). Should be
+ *                          of unit length; components beyond 1/sqrt(2) that
+ *                          are not the largest are clamped.
+ *
+ * @return the packed quaternion, see TSLPB_Quaternion.h
+ */
+uint32_t tslPackQuaternion(const int16_t quaternion[4])
+{
+    uint8_t largest = 0;
+    for (uint8_t i = 1; i < 4; i++) {
+        if (abs(quaternion[i]) > abs(quaternion[largest])) {
+            largest = i;
+        }
+    }
+    
+    int32_t  sign   = quaternion[largest] < 0 ? -1 : 1;
+    uint32_t packed = (uint32_t)largest << TSL_QUAT_INDEX_SHIFT;
+    uint8_t  shift  = TSL_QUAT_INDEX_SHIFT;
+    
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i == largest) {
+            continue;
+        }
+        int32_t code = (sign * quaternion[i] * TSL_QUAT_ENCODE_MUL + TSL_QUAT_ENCODE_OFFSET) >> 16;
+        if (code < 0) {
+            code = 0;
+        } else if (code > 2 * TSL_QUAT_CODE_ZERO) {
+            code = 2 * TSL_QUAT_CODE_ZERO;
+        }
+        shift  -= TSL_QUAT_BITS;
+        packed |= (uint32_t)code << shift;
+    }
+    return packed;
+}
+
+/*!
+ * @brief Unpacks a quaternion packed by tslPackQuaternion(). Every value of
+ * packed gives a result; the dropped component is 0 if the other three are
+ * longer than 1.
+ *
+ * @param[in]  packed       Packed quaternion
+ * @param[out] quaternion   w, x, y, z in Q14, the dropped one non-negative
+ */
+void tslUnpackQuaternion(uint32_t packed, int16_t quaternion[4])
+{
+    uint8_t  largest = packed >> TSL_QUAT_INDEX_SHIFT;
+    uint8_t  shift   = TSL_QUAT_INDEX_SHIFT;
+    uint32_t squares = 0;
+    
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i == largest) {
+            continue;
+        }
+        shift -= TSL_QUAT_BITS;
+        int32_t code = (packed >> shift) & TSL_QUAT_CODE_MAX;
+        
+        quaternion[i] = (int16_t)(((code - TSL_QUAT_CODE_ZERO) * TSL_QUAT_DECODE_MUL + (1L << 15)) >> 16);
+        squares      += (uint32_t)((int32_t)quaternion[i] * quaternion[i]);
+    }
+    
+    uint32_t one = (uint32_t)TSL_QUAT_ONE * TSL_QUAT_ONE;
+    quaternion[largest] = (int16_t)isqrtRounded(squares < one ? one - squares : 0);
+}
@@ -0,0 +1,64 @@
+/**
+ *  @file   TSLPB_Quaternion.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Smallest-three packing of unit quaternions into the 32-bit
+ *          UserDataStruct_t quat field.
+ *
+ *          A unit quaternion has three degrees of freedom. The component
+ *          with the largest magnitude is dropped and its index stored in
+ *          the top two bits; q and -q are the same rotation, so the
+ *          quaternion is first negated if needed to make that component
+ *          positive. The other three are at most 1/sqrt(2) in magnitude and
+ *          are quantized to 10 bits each, in w, x, y, z order, on a grid
+ *          symmetric about zero: code 511 is exactly 0 and codes 0 and 1022
+ *          are -1/sqrt(2) and 1/sqrt(2), so the identity and rotations about
+ *          one axis come back with exact zeros. Code 1023 is never packed.
+ *
+ *          The step s is 1 / (511 * sqrt(2)) = 0.00138, so each stored
+ *          component is off by at most s/2 = 0.00069, less than the 0.001
+ *          the truncating * 1000 int16_t fields lost. The rebuilt component
+ *          adds the others' errors weighted by their size over its own,
+ *          which is worst with all four at 1/2: an error vector of length
+ *          sqrt(3 + 9) * s/2 normal to q, for an angle error of at most
+ *          2 * sqrt(12) * s/2 = 0.275 degrees, 0.28 with the Q14 rounding.
+ *          The * 1000 fields' worst case was 0.23 degrees in twice the
+ *          space; over random rotations the mean error is about 10 percent
+ *          above theirs.
+
+ *          Unpacking is integer arithmetic only, with the dropped component
+ *          rebuilt by a rounded integer square root, so the ground decoder
+ *          reproduces it exactly. Components are Q14 (TSL_QUAT_ONE = 1.0),
+ *          the BNO055's own quaternion scale.
+ *
+ *          bits 31 - 30    index of the dropped component (0 = w .. 3 = z)
+ *          bits 29 - 20    first remaining component
+ *          bits 19 - 10    second remaining component
+ *          bits  9 -  0    third remaining component
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_Quaternion_h
+#define TSLPB_Quaternion_h
+
+#include <stdint.h>
+
+
+#define TSL_QUAT_ONE            16384       ///< 1.0 in Q14
+#define TSL_QUAT_BITS           10          ///< Bits per stored component
+#define TSL_QUAT_CODE_MAX       1023        ///< Component code mask
+#define TSL_QUAT_CODE_ZERO      511         ///< Code of a zero component
+#define TSL_QUAT_INDEX_SHIFT    30          ///< Position of the dropped component's index
+#define TSL_QUAT_DECODE_MUL     1485812L    ///< Q14 = ((code - 511) * MUL + 2^15) >> 16; 16384 / (511 * sqrt(2)) * 2^16
+#define TSL_QUAT_ENCODE_MUL     2891L       ///< code = (Q14 * MUL + OFFSET) >> 16; 511 * sqrt(2) / 16384 * 2^16
+#define TSL_QUAT_ENCODE_OFFSET  ((511L << 16) + (1L << 15))    ///< 511 codes plus a half for rounding, in 2^-16 codes
+
+
+uint32_t tslPackQuaternion(const int16_t quaternion[4]);
+void     tslUnpackQuaternion(uint32_t packed, int16_t quaternion[4]);
+
+
+#endif /* TSLPB_Quaternion_h */
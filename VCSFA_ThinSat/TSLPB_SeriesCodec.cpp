@@ -0,0 +1,502 @@
+/**
+ *  @file   TSLPB_SeriesCodec.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Implementation of the series encoder and the high-rate capture
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "TSLPB_SeriesCodec.h"
+
+
+static_assert(TSL_SERIES_ORDER_BITS + TSL_SERIES_RAW_SAMPLES * TSL_SERIES_AXES * 16 <= 8 * TSL_SERIES_FRAME_BYTES,
+              "raw frame does not fit the bitstream");
+static_assert(TSL_SERIES_RAW_SAMPLES <= TSL_SERIES_ORDER_MAX + 1,
+              "raw recoding takes the frame's samples from the predictor history");
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                     Encoder                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief Smallest k with count << k >= sum, at most TSL_SERIES_K_MAX
+ */
+static uint8_t riceParameter(const TSLPB_SeriesAxis_t& axis)
+{
+    uint8_t k = 0;
+    
+    while (k < TSL_SERIES_K_MAX && ((uint32_t)axis.riceCount << k) < axis.riceSum) {
+        k++;
+    }
+    return k;
+}
+
+/*!
+ * @brief Polynomial prediction of the next sample, clamped to int16_t
+ *
+ * @param[in] history   Last samples, newest first
+ * @param[in] order     1 - TSL_SERIES_ORDER_MAX
+ */
+static int16_t predict(const int16_t history[TSL_SERIES_ORDER_MAX], uint8_t order)
+{
+    int32_t prediction;
+    
+    switch (order) {
+        case 1:
+            prediction = history[0];
+            break;
+        case 2:
+            prediction = 2 * (int32_t)history[0] - history[1];
+            break;
+        default:
+            prediction = 3 * ((int32_t)history[0] - history[1]) + history[2];
+            break;
+    }
+    
+    if (prediction > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (prediction < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)prediction;
+}
+
+/*!
+ * @brief Maps a residual to a non-negative code: 0, -1, 1, -2 .. to 0, 1, 2, 3 ..
+ */
+static uint32_t zigzag(int32_t residual)
+{
+    return residual >= 0 ? (uint32_t)residual << 1 : ((uint32_t)-residual << 1) - 1;
+}
+
+/*!
+ * @brief Bits of the Rice code of m with parameter k
+ */
+static uint8_t codeLength(uint32_t m, uint8_t k)
+{
+    uint32_t quotient = m >> k;
+    return quotient < TSL_SERIES_ESCAPE ? quotient + 1 + k : TSL_SERIES_ESCAPE + TSL_SERIES_RAW_BITS;
+}
+
+
+/*!
+ * @brief Starts a new series. The first frame uses order 1 and
+ * TSL_SERIES_K_START on every axis.
+ */
+void TSLPB_SeriesEncoder::reset()
+{
+    for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+        TSLPB_SeriesAxis_t& axis = axes[i];
+        
+        for (uint8_t j = 0; j < TSL_SERIES_ORDER_MAX; j++) {
+            axis.history[j] = 0;
+            axis.cost[j]    = 0;
+        }
+        axis.order     = 1;
+        axis.riceCount = TSL_SERIES_RICE_COUNT_START;
+        axis.riceSum   = (uint32_t)TSL_SERIES_RICE_COUNT_START << TSL_SERIES_K_START;
+    }
+    bitCount      = 0;
+    seriesSamples = 0;
+    costSamples   = 0;
+    raw           = false;
+}
+
+/*!
+ * @brief Starts a frame: clears the bitstream and writes each axis' predictor
+ * order and starting Rice parameter
+ *
+ * @param[out] frame    Frame to code into
+ */
+void TSLPB_SeriesEncoder::openFrame(ThinsatPacket_t& frame)
+{
+    memset(frame.seriesData.bits, 0, sizeof(frame.seriesData.bits));
+    frame.seriesData.frameType = TSL_FRAME_TYPE_SERIES;
+    frame.seriesData.count     = 0;
+    bitCount                   = 0;
+    raw                        = false;
+    
+    for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+        TSLPB_SeriesAxis_t& axis = axes[i];
+        
+        // The order that did best over the last frame; ties and no history give the lower
+        uint8_t order = 1;
+        for (uint8_t candidate = 2; candidate <= TSL_SERIES_ORDER_MAX; candidate++) {
+            if (axis.cost[candidate - 1] < axis.cost[order - 1]) {
+                order = candidate;
+            }
+        }
+        
+        // Where the Rice state left off, or lower if that order's residuals
+        // over the last frame call for it. The state carries a frame's
+        // starting k as a prior as heavy as four samples, so a frame of a
+        // few samples at a high k (after a burst of noise, or a raw frame,
+        // which codes no residuals) could never bring it down.
+        uint8_t k = riceParameter(axis);
+        if (costSamples > 0) {
+            axis.riceCount = costSamples;
+            axis.riceSum   = axis.cost[order - 1];
+            uint8_t lower  = riceParameter(axis);
+            if (lower < k) {
+                k = lower;
+            }
+        }
+        
+        axis.order     = order;
+        axis.riceCount = TSL_SERIES_RICE_COUNT_START;
+        axis.riceSum   = (uint32_t)TSL_SERIES_RICE_COUNT_START << k;
+        for (uint8_t j = 0; j < TSL_SERIES_ORDER_MAX; j++) {
+            axis.cost[j] = 0;
+        }
+        
+        writeBits(frame, order, TSL_SERIES_ORDER_BITS);
+        writeBits(frame, k, TSL_SERIES_K_BITS);
+    }
+    costSamples = 0;
+}
+
+/*!
+ * @brief Codes one sample into the open frame
+ *
+ * @param[in,out] frame     Frame opened by openFrame()
+ * @param[in]     sample    x, y, z
+ *
+ * @return  false if the frame is full; the frame and the encoder are then
+ *          unchanged. The first sample of a frame always fits, and so does
+ *          every sample up to TSL_SERIES_RAW_SAMPLES.
+ */
+bool TSLPB_SeriesEncoder::add(ThinsatPacket_t& frame, const int16_t sample[TSL_SERIES_AXES])
+{
+    uint8_t index = frame.seriesData.count;
+    
+    if (index >= TSL_SERIES_SAMPLES_MAX || (raw && index >= TSL_SERIES_RAW_SAMPLES)) {
+        return false;
+    }
+    
+    if (index == 0 || raw) {
+        for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+            writeBits(frame, (uint16_t)sample[i], 16);
+        }
+    } else {
+        uint32_t m[TSL_SERIES_AXES];
+        uint8_t  k[TSL_SERIES_AXES];
+        uint16_t length = 0;
+        
+        // Early samples of a frame have less history than the order needs
+        for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+            uint8_t order = axes[i].order < index ? axes[i].order : index;
+            
+            m[i]    = zigzag((int32_t)sample[i] - predict(axes[i].history, order));
+            k[i]    = riceParameter(axes[i]);
+            length += codeLength(m[i], k[i]);
+        }
+        if (bitCount + length > 8 * TSL_SERIES_FRAME_BYTES) {
+            if (index >= TSL_SERIES_RAW_SAMPLES) {
+                return false;
+            }
+            
+            // Coded, the frame would hold less than raw does
+            recodeRaw(frame);
+            for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+                writeBits(frame, (uint16_t)sample[i], 16);
+            }
+        } else {
+            for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+                TSLPB_SeriesAxis_t& axis     = axes[i];
+                uint32_t            quotient = m[i] >> k[i];
+                
+                if (quotient < TSL_SERIES_ESCAPE) {
+                    writeBits(frame, ((1UL << quotient) - 1) << 1, quotient + 1);
+                    writeBits(frame, m[i] & ((1UL << k[i]) - 1), k[i]);
+                } else {
+                    writeBits(frame, (1UL << TSL_SERIES_ESCAPE) - 1, TSL_SERIES_ESCAPE);
+                    writeBits(frame, m[i], TSL_SERIES_RAW_BITS);
+                }
+                
+                axis.riceSum += m[i];
+                if (++axis.riceCount >= TSL_SERIES_RICE_COUNT_MAX) {
+                    axis.riceSum   >>= 1;
+                    axis.riceCount >>= 1;
+                }
+            }
+        }
+    }
+    
+    for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+        TSLPB_SeriesAxis_t& axis = axes[i];
+        
+        // What each order would have cost, for the next frame's choice
+        if (seriesSamples >= TSL_SERIES_ORDER_MAX) {
+            for (uint8_t order = 1; order <= TSL_SERIES_ORDER_MAX; order++) {
+                axis.cost[order - 1] += zigzag((int32_t)sample[i] - predict(axis.history, order));
+            }
+        }
+        for (uint8_t j = TSL_SERIES_ORDER_MAX - 1; j > 0; j--) {
+            axis.history[j] = axis.history[j - 1];
+        }
+        axis.history[0] = sample[i];
+    }
+    if (seriesSamples < TSL_SERIES_ORDER_MAX) {
+        seriesSamples++;
+    } else {
+        costSamples++;
+    }
+    
+    frame.seriesData.count++;
+    return true;
+}
+
+/*!
+ * @brief Rewrites the open frame raw: the raw order and the frame's samples
+ * verbatim, taken from the predictor history
+ */
+void TSLPB_SeriesEncoder::recodeRaw(ThinsatPacket_t& frame)
+{
+    uint8_t count = frame.seriesData.count;
+    
+    memset(frame.seriesData.bits, 0, sizeof(frame.seriesData.bits));
+    bitCount = 0;
+    raw      = true;
+    
+    writeBits(frame, TSL_SERIES_RAW_ORDER, TSL_SERIES_ORDER_BITS);
+    for (uint8_t j = count; j > 0; j--) {
+        for (uint8_t i = 0; i < TSL_SERIES_AXES; i++) {
+            writeBits(frame, (uint16_t)axes[i].history[j - 1], 16);
+        }
+    }
+}
+
+/*!
+ * @brief Appends the low bits of value to the bitstream, most significant
+ * first. The bitstream must have been cleared by openFrame().
+ */
+void TSLPB_SeriesEncoder::writeBits(ThinsatPacket_t& frame, uint32_t value, uint8_t bits)
+{
+    while (bits > 0) {
+        uint8_t space = 8 - (bitCount & 7);
+        uint8_t take  = bits < space ? bits : space;
+        uint8_t chunk = (value >> (bits - take)) & ((1 << take) - 1);
+        
+        frame.seriesData.bits[bitCount >> 3] |= chunk << (space - take);
+        bitCount += take;
+        bits     -= take;
+    }
+}
+
+
+#ifdef TSL_ENABLE_SERIES_CAPTURE
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                     Capture                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+TSLPB_SeriesCapture tslSeriesCapture;
+
+
+/*!
+ * @brief Sets the board whose sensors are captured. Call after
+ * TSLPB::begin().
+ */
+void TSLPB_SeriesCapture::begin(TSLPB& tslpb)
+{
+    board    = &tslpb;
+    first    = 0;
+    buffered = 0;
+}
+
+/*!
+ * @brief Samples one sensor at a fixed period and codes the samples into
+ * frames, sending finished frames when clear to send. Blocks until done.
+ *
+ * The AK8963 is switched to MAG_MODE_CONTINUOUS_100HZ for the capture and
+ * back to MAG_MODE_CONTINUOUS_8HZ after it; its period is at least
+ * TSL_SERIES_MAG_PERIOD_MS. A failed read is skipped; the next frame starts
+ * after it.
+ *
+ * @param[in] source    Sensor to sample
+ * @param[in] samples   Samples to take
+ * @param[in] periodMs  Time between samples
+ *
+ * @return  the number of samples coded. Fewer than samples if the frame
+ *          buffer filled up.
+ */
+uint16_t TSLPB_SeriesCapture::capture(TSLPB_SeriesSource_t source, uint16_t samples, uint8_t periodMs)
+{
+    if (board == NULL || source >= TSL_SERIES_SOURCE_COUNT || periodMs == 0 ||
+        buffered >= TSL_SERIES_BUFFERED_FRAMES) {
+        return 0;
+    }
+    
+    if (source == SeriesMagnetometer) {
+        periodMs = periodMs > TSL_SERIES_MAG_PERIOD_MS ? periodMs : TSL_SERIES_MAG_PERIOD_MS;
+        board->setMagnetometerMode(MAG_MODE_CONTINUOUS_100HZ);
+    }
+    
+    uint8_t  tag   = source | (captures << TSL_SERIES_CAPTURE_SHIFT);
+    uint16_t taken = 0;
+    bool     open  = false;
+    uint32_t next  = micros();
+    
+    encoder.reset();
+    
+    for (uint16_t i = 0; i < samples; i++) {
+        int32_t wait = (int32_t)(next - micros());
+        if (wait > 0) {
+            delay(wait / 1000);
+            delayMicroseconds(wait % 1000);
+        }
+        next += periodMs * 1000UL;
+        
+        int16_t sample[TSL_SERIES_AXES];
+        if (!readSample(source, sample)) {
+            if (open) {
+                open = false;
+                if (!closeFrame()) {
+                    break;
+                }
+            }
+            encoder.reset();
+            continue;
+        }
+        
+        if (!open) {
+            openFrame(tag, periodMs, i);
+            open = true;
+        }
+        if (!encoder.add(getOpenFrame(), sample)) {
+            if (!closeFrame()) {
+                // No room for another frame: the capture ends here
+                open = false;
+                break;
+            }
+            openFrame(tag, periodMs, i);
+            encoder.add(getOpenFrame(), sample);
+        }
+        if (sink) {
+            sink(sample);
+        }
+        taken++;
+        
+        // At most one frame between samples, which the UART buffer takes at once
+        if (buffered > 0 && board->isClearToSend()) {
+            pushOldest(false);
+        }
+    }
+    
+    if (open) {
+        closeFrame();
+    }
+    if (source == SeriesMagnetometer) {
+        board->setMagnetometerMode(MAG_MODE_CONTINUOUS_8HZ);
+    }
+    captures++;
+    return taken;
+}
+
+/*!
+ * @brief Sends the frames left from the last capture, waiting for clear to
+ * send before each
+ *
+ * @return  the number of frames sent
+ */
+uint8_t TSLPB_SeriesCapture::pushReport()
+{
+    uint8_t framesSent = 0;
+    
+    while (buffered > 0) {
+        if (pushOldest(true)) {
+            framesSent++;
+        }
+    }
+    return framesSent;
+}
+
+/*!
+ * @brief Sets a function to be called with every sample as it is coded, or
+ * NULL for none
+ */
+void TSLPB_SeriesCapture::setSink(TSLPB_SeriesSink_t seriesSink)
+{
+    sink = seriesSink;
+}
+
+/*!
+ * @brief Reads one sample of a source
+ *
+ * @return  true if the sensor answered (and the AK8963 did not overflow)
+ */
+bool TSLPB_SeriesCapture::readSample(TSLPB_SeriesSource_t source, int16_t sample[TSL_SERIES_AXES])
+{
+    if (source == SeriesMagnetometer) {
+        if (!board->readMagnetometerBurst(sample, true)) {
+            return false;
+        }
+        board->correctMagnetometer(sample);
+        return true;
+    }
+    
+    TSLPB_ImuSample_t imu;
+    if (!board->readImuBurst(imu)) {
+        return false;
+    }
+    for (uint8_t axis = 0; axis < TSL_SERIES_AXES; axis++) {
+        sample[axis] = source == SeriesAccelerometer ? imu.accel[axis] : imu.gyro[axis];
+    }
+    return true;
+}
+
+/*!
+ * @brief Starts a frame in the free ring slot, stamped with the current MET
+ */
+void TSLPB_SeriesCapture::openFrame(uint8_t tag, uint8_t periodMs, uint16_t sequence)
+{
+    ThinsatPacket_t& frame = getOpenFrame();
+    
+    board->stampAcquisitionTime(frame);
+    encoder.openFrame(frame);
+    frame.seriesData.source   = tag;
+    frame.seriesData.period   = periodMs;
+    frame.seriesData.sequence = sequence;
+}
+
+/*!
+ * @brief Queues the open frame for sending
+ *
+ * @return  true if there is a free slot for the next frame
+ */
+bool TSLPB_SeriesCapture::closeFrame()
+{
+    buffered++;
+    return buffered < TSL_SERIES_BUFFERED_FRAMES;
+}
+
+/*!
+ * @brief Sends the oldest finished frame
+ *
+ * @param[in] wait  Wait for clear to send first
+ *
+ * @return  true if the frame was sent in full
+ */
+bool TSLPB_SeriesCapture::pushOldest(bool wait)
+{
+    if (buffered == 0) {
+        return false;
+    }
+    
+    while (wait && !board->isClearToSend()) {
+        delay(100);
+    }
+    bool sent = board->pushDataToNSL(frames[first]);
+    
+    first = (first + 1) % TSL_SERIES_BUFFERED_FRAMES;
+    buffered--;
+    return sent;
+}
+
+
+#endif /* TSL_ENABLE_SERIES_CAPTURE */
@@ -0,0 +1,210 @@
+/**
+ *  @file   TSLPB_SeriesCodec.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Lossless coding of high-rate AK8963 and MPU-9250 captures into
+ *          TSL_FRAME_TYPE_SERIES frames.
+ *
+ *          A capture samples the three axes of one sensor at a fixed period.
+ *          Each axis is predicted from its last samples by a fixed
+ *          polynomial predictor of order 1 to 3 and the residual is Rice
+ *          coded, with the Rice parameter adapted sample by sample from the
+ *          running mean of the residuals (as in LOCO-I). Every frame can be
+ *          decoded on its own, so a frame lost in the downlink costs only its
+ *          own samples.
+ *
+ *          Each frame starts with, per axis, the predictor order and the
+ *          starting Rice parameter (6 bits), then the first sample of each
+ *          axis verbatim. The encoder picks the order of the next frame as
+ *          the one with the smallest residuals over the frame just coded,
+ *          and starts the Rice parameter where the last frame left it, or
+ *          lower if that order's mean residual over the frame calls for it.
+ *          After that the axes' residuals follow sample by sample in x, y,
+ *          z order. The first samples of a frame use the highest order
+ *          their history allows.
+ *
+ *          bitstream, MSB first:
+ *              3 x ( order : 2, k : 4 )
+ *              3 x   first sample : 16
+ *              (count - 1) x 3 x Rice code
+ *
+ *          A frame that would hold fewer than TSL_SERIES_RAW_SAMPLES samples
+ *          coded, as white noise does, is recoded raw, so a capture never
+ *          takes more frames than its int16_t samples would:
+ *              order : 2 = TSL_SERIES_RAW_ORDER
+ *              count x 3 x sample : 16             count <= TSL_SERIES_RAW_SAMPLES
+ *
+ *          Rice code of residual e, with m = 2e for e >= 0, -2e - 1 below:
+ *              m >> k < TSL_SERIES_ESCAPE      m >> k ones, a zero, the k low bits of m
+ *              otherwise                       TSL_SERIES_ESCAPE ones, m in TSL_SERIES_RAW_BITS bits
+ *
+ *          Rice state: after each residual sum += m and count++; when count
+ *          reaches TSL_SERIES_RICE_COUNT_MAX both are halved. k is the
+ *          smallest value with count << k >= sum, at most TSL_SERIES_K_MAX.
+ *          A frame starts each axis at count = TSL_SERIES_RICE_COUNT_START,
+ *          sum = count << k. Predictions are clamped to the int16_t range.
+ *
+ *          The capture is compiled out unless TSL_ENABLE_SERIES_CAPTURE is
+ *          defined. It holds TSL_SERIES_BUFFERED_FRAMES frames and the
+ *          encoder state, about 310 bytes of RAM.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TSLPB_SeriesCodec_h
+#define TSLPB_SeriesCodec_h
+
+
+//#define TSL_ENABLE_SERIES_CAPTURE     ///< Uncomment to build the high-rate capture
+
+
+#include "TSLPB.h"
+
+
+#define TSL_SERIES_AXES             3           ///< Channels per sample
+#define TSL_SERIES_FRAME_BYTES      26          ///< Bitstream bytes per frame
+#define TSL_SERIES_SAMPLES_MAX      48          ///< The first sample and 47 more of at least 3 bits
+#define TSL_SERIES_ORDER_BITS       2           ///< Bits of each axis' predictor order
+#define TSL_SERIES_ORDER_MAX        3           ///< Highest predictor order
+#define TSL_SERIES_RAW_ORDER        0           ///< First axis' order that marks a raw frame
+#define TSL_SERIES_RAW_SAMPLES      4           ///< Samples a raw frame holds verbatim
+#define TSL_SERIES_K_BITS           4           ///< Bits of each axis' starting Rice parameter
+#define TSL_SERIES_K_MAX            15          ///< Largest Rice parameter
+#define TSL_SERIES_K_START          4           ///< Rice parameter at the start of a capture
+#define TSL_SERIES_ESCAPE           16          ///< Quotient at which m is sent raw
+#define TSL_SERIES_RAW_BITS         17          ///< Bits of a raw m; residuals are within +-65535
+#define TSL_SERIES_RICE_COUNT_START 4           ///< Rice count at the start of a frame
+#define TSL_SERIES_RICE_COUNT_MAX   16          ///< Rice count at which the state is halved
+#define TSL_SERIES_BUFFERED_FRAMES  6           ///< Frames held while the Mothership is not clear to send
+#define TSL_SERIES_MAG_PERIOD_MS    10          ///< AK8963 result period in MAG_MODE_CONTINUOUS_100HZ
+#define TSL_SERIES_SOURCE_MASK      0x0F        ///< source byte: TSLPB_SeriesSource_t
+#define TSL_SERIES_CAPTURE_SHIFT    4           ///< source byte: capture number modulo 16 in the high bits
+
+
+/*!
+ * @brief   Sensors a capture can sample
+ */
+typedef enum
+{
+    SeriesMagnetometer  = 0,        ///< AK8963 x, y, z, corrected as by TSLPB::correctMagnetometer()
+    SeriesAccelerometer = 1,        ///< MPU-9250 accelerometer x, y, z
+    SeriesGyroscope     = 2,        ///< MPU-9250 gyroscope x, y, z
+    TSL_SERIES_SOURCE_COUNT         ///< Number of sources. Not a valid source
+} TSLPB_SeriesSource_t;
+
+
+/*!
+ * @brief   Encoder state of one axis
+ */
+typedef struct
+{
+    int16_t     history[TSL_SERIES_ORDER_MAX];  ///< Last samples, newest first
+    uint8_t     order;                          ///< Predictor order of the open frame
+    uint8_t     riceCount;                      ///< Residuals in riceSum
+    uint32_t    riceSum;                        ///< Sum of recent m
+    uint32_t    cost[TSL_SERIES_ORDER_MAX];     ///< Sum of m of each order over the open frame
+} TSLPB_SeriesAxis_t;
+
+
+/*!
+ * @brief   Optional function called with every sample as it is encoded. Used
+ *          by host tools to check the decoder.
+ */
+typedef void (*TSLPB_SeriesSink_t)(const int16_t sample[TSL_SERIES_AXES]);
+
+
+/*!
+ * @brief   Encodes one series into TSL_FRAME_TYPE_SERIES frames. Only the
+ *          bitstream, frameType and count are written; the caller fills the
+ *          other fields.
+ *
+ * @code
+ *  encoder.reset();
+ *  encoder.openFrame(frame);
+ *  while (capturing) {
+ *      if (!encoder.add(frame, sample)) {
+ *          send(frame);
+ *          encoder.openFrame(frame);
+ *          encoder.add(frame, sample);     // always fits an empty frame
+ *      }
+ *  }
+ * @endcode
+ */
+class TSLPB_SeriesEncoder
+{
+    
+public:
+    void     reset();
+    void     openFrame(ThinsatPacket_t& frame);
+    bool     add(ThinsatPacket_t& frame, const int16_t sample[TSL_SERIES_AXES]);
+    
+    uint8_t  getBitCount()      { return bitCount; }
+    
+private:
+    
+    void     writeBits(ThinsatPacket_t& frame, uint32_t value, uint8_t bits);
+    void     recodeRaw(ThinsatPacket_t& frame);
+    
+    TSLPB_SeriesAxis_t  axes[TSL_SERIES_AXES];
+    uint8_t             bitCount        = 0;    ///< Bits written to the open frame
+    bool                raw             = false;///< The open frame holds samples verbatim
+    uint8_t             seriesSamples   = 0;    ///< Samples since reset(), saturating at TSL_SERIES_ORDER_MAX
+    uint8_t             costSamples     = 0;    ///< Samples in each cost of the open frame
+    
+};
+
+
+#ifdef TSL_ENABLE_SERIES_CAPTURE
+
+/*!
+ * @brief   High-rate capture. Use the global tslSeriesCapture instance.
+ *
+ *          capture() blocks while it samples. Finished frames are sent
+ *          between samples whenever the Mothership is clear to send; if
+ *          TSL_SERIES_BUFFERED_FRAMES are waiting, the capture ends early.
+ *          pushReport() sends what is left.
+ *
+ * @code
+ *  tslSeriesCapture.begin(tslpb);
+ *  tslSeriesCapture.capture(SeriesMagnetometer, 200, 10);  // 2 s at 100 Hz
+ *  tslSeriesCapture.pushReport();
+ * @endcode
+ */
+class TSLPB_SeriesCapture
+{
+    
+public:
+    void     begin(TSLPB& tslpb);
+    uint16_t capture(TSLPB_SeriesSource_t source, uint16_t samples, uint8_t periodMs);
+    uint8_t  pushReport();
+    void     setSink(TSLPB_SeriesSink_t sink);
+    
+    uint8_t  getBufferedFrames()    { return buffered; }
+    
+private:
+    
+    bool     readSample(TSLPB_SeriesSource_t source, int16_t sample[TSL_SERIES_AXES]);
+    void     openFrame(uint8_t tag, uint8_t periodMs, uint16_t sequence);
+    bool     closeFrame();
+    bool     pushOldest(bool wait);
+    
+    ThinsatPacket_t& getOpenFrame() { return frames[(first + buffered) % TSL_SERIES_BUFFERED_FRAMES]; }
+    
+    TSLPB*              board           = NULL;     ///< Board whose sensors are sampled
+    TSLPB_SeriesEncoder encoder;
+    ThinsatPacket_t     frames[TSL_SERIES_BUFFERED_FRAMES];
+    uint8_t             first           = 0;        ///< Ring index of the oldest finished frame
+    uint8_t             buffered        = 0;        ///< Finished frames not yet sent
+    uint8_t             captures        = 0;        ///< Captures since begin()
+    TSLPB_SeriesSink_t  sink            = NULL;
+    
+};
+
+extern TSLPB_SeriesCapture tslSeriesCapture;
+
+#endif /* TSL_ENABLE_SERIES_CAPTURE */
+
+
+#endif /* TSLPB_SeriesCodec_h */
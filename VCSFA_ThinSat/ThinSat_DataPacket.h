@@ -15,6 +15,23 @@
 #define ThinSat_DataPacket_h
 
 
+#define TSL_MET_TICK_MS         100         ///< Mission elapsed time resolution (ms per tick)
+#define TSL_MET_MASK            0xFFFFFF    ///< MET is 24 bits. Rolls over every 2^24 ticks (19.4 days)
+#define TSL_SAMPLE_AGE_MAX      0xEF        ///< sampleAge saturates here (23.9 s)
+
+    /*
+     * sampleAge values above TSL_SAMPLE_AGE_MAX are reserved. They mark
+     * frames that are not UserDataStruct_t science frames. Every frame type
+     * shares the header, met and sampleAge/frameType bytes.
+     */
+
+#define TSL_FRAME_TYPE_PROFILE  0xF0        ///< Loop-phase profiler report (ProfileDataStruct_t)
+#define TSL_FRAME_TYPE_ENERGY   0xF1        ///< Energy ledger report (EnergyDataStruct_t)
+#define TSL_FRAME_TYPE_I2C_TRACE 0xF2       ///< I2C transaction trace (I2CTraceDataStruct_t)
+#define TSL_FRAME_TYPE_STATS    0xF3        ///< Channel statistics report (StatsDataStruct_t)
+#define TSL_FRAME_TYPE_SERIES   0xF4        ///< Coded high-rate capture (SeriesDataStruct_t)
+
+
 /*!
  * @brief   A user-customizable structure to hold any data the user intends to
  *          send back to Earth.
@@ -27,30 +44,161 @@
  *          of any data being put into a field. This will ensure that you can
  *          translate the data later.
  *
+ * @note    The struct is packed and little-endian. bmePres is 24 bits wide and
+ *          the four 10-bit ADC fields share 5 bytes (tslTempExt in the lowest
+ *          bits). Byte numbers below count from the first byte after header.
+ *
+ * @note    quat is the attitude packed by tslPackQuaternion() (see
+ *          TSLPB_Quaternion.h). Of the four bytes it freed, refreshed takes
+ *          one and the other three are free for other science and sent as
+ *          zero.
+ *
+ * @note    met is the mission elapsed time (TSL_MET_TICK_MS ticks since
+ *          TSLPB::begin()) at which acquisition of the frame started.
+ *          sampleAge is the number of ticks between acquisition and
+ *          transmission. Sample time on the ground = met, unwrapped at
+ *          TSL_MET_MASK. TSLPB::stampAcquisitionTime() and
+ *          TSLPB::pushDataToNSL() fill both fields.
+ *
+ * @note    met dates only the channels refreshed in this frame. The sketch
+ *          reads a channel only when TSLPB_AdaptiveRate says it is due, and
+ *          the fields of the other channels keep the value of an earlier
+ *          frame, up to that channel's maximum period old. refreshed has bit
+ *          n set when TSLPB_RateChannel_t n was read for this frame; on the
+ *          ground a field whose bit is clear is dated by the met of the last
+ *          frame that had it set. TSLPB::stampAcquisitionTime() clears it.
+ *
  * @warning The struct must be NSL_PACKET_SIZE bytes in total size.
  *          The first member must always be called "header" and have a size of
  *          NSL_PACKET_HEADER_LENGTH
  *
  */
-typedef struct UserDataStruct_t{
+struct __attribute__((__packed__)) UserDataStruct_t{
+    char            header[NSL_PACKET_HEADER_LENGTH];
+    unsigned long   met        : 24; ///<  1 -  3 Mission elapsed time at acquisition of the refreshed channels (100 ms ticks)
+    uint8_t         sampleAge;  ///<  4      (0 to 239) Ticks from acquisition to transmission
+    uint32_t        quat;       ///<  5 -  8 Smallest-three w, x, y, z (unitless)
+    uint8_t         refreshed;  ///<  9      Bit per TSLPB_RateChannel_t read at met
+    uint8_t         spare[3];   ///< 10 - 12 Unused, zero
+    int16_t         bnomagx;    ///< 13 - 14 (value from -20480 to 20470) 2047.0 uT (from BNO)
+    int16_t         bnomagy;    ///< 15 - 16 (value from -20480 to 20470) 2047.0 uT
+    int16_t         bnomagz;    ///< 17 - 18 (value from -20480 to 20470) 2047.0 uT
+    uint8_t         bnoCal;     ///< 19      (sys, gyro, accel, mag) 01010101b
+    unsigned long   bmePres    : 24; ///< 20 - 22 (values from 0 to 1010000) 101000.0 Pa
+    int16_t         bmeTemp;    ///< 23 - 24 (values from -1000 to 1000) 100.0 C
+    uint16_t        tslTempExt : 10; ///< 25 - 29 bits  0 -  9 (0-1023) ADC Raw Counts
+    uint16_t        tslVolts   : 10; ///< 25 - 29 bits 10 - 19 (0-1023) ADC Raw Counts
+    uint16_t        tslCurrent : 10; ///< 25 - 29 bits 20 - 29 (0-1023) ADC Raw Counts
+    uint16_t        solar      : 10; ///< 25 - 29 bits 30 - 39 (0-1023) ADC Raw Counts
+    int16_t         tslMagXraw; ///< 30 - 31 Raw value (2's compliment form) -0x7FF8 to 0x7FF8, hard/soft-iron corrected once calibrated
+    int16_t         tslMagYraw; ///< 32 - 33 Raw value (2's compliment form) -0x7FF8 to 0x7FF8, hard/soft-iron corrected once calibrated
+    int16_t         tslMagZraw; ///< 34 - 35 Raw value (2's compliment form) -0x7FF8 to 0x7FF8, hard/soft-iron corrected once calibrated
+};
+
+
+/*!
+ * @brief   Diagnostic frame sent by TSLPB_Profiler::pushReport(). One frame
+ *          describes the latency of one loop phase.
+ *
+ * @note    Times are in microseconds. histogram[0] counts phases shorter than
+ *          128 us, histogram[k] counts phases of 2^(k+6) to 2^(k+7) us and
+ *          histogram[15] everything longer. Bins saturate at 255.
+ */
+struct __attribute__((__packed__)) ProfileDataStruct_t{
+    char            header[NSL_PACKET_HEADER_LENGTH];
+    unsigned long   met        : 24; ///<  1 -  3 Mission elapsed time of the report (100 ms ticks)
+    uint8_t         frameType;  ///<  4      TSL_FRAME_TYPE_PROFILE
+    uint8_t         phase;      ///<  5      TSLPB_ProfilePhase_t
+    uint16_t        count;      ///<  6 -  7 Number of samples since the last report
+    uint32_t        minTime;    ///<  8 - 11 Shortest sample (us)
+    uint32_t        maxTime;    ///< 12 - 15 Longest sample (us)
+    uint32_t        meanTime;   ///< 16 - 19 Mean sample (us)
+    uint8_t         histogram[16]; ///< 20 - 35 log2 latency histogram
+};
+
+
+/*!
+ * @brief   Diagnostic frame sent by TSLPB_EnergyLedger::pushReport(). One frame
+ *          holds the charge used by each firmware phase during one orbit.
+ *
+ * @note    Charges are in mAs, scaled by TSL_CURRENT_UA_PER_COUNT, which is
+ *          an uncalibrated placeholder. phaseCharge is indexed by
+ *          TSLPB_EnergyPhase_t: acquisition, mux settle, serial TX, sleep.
+ */
+struct __attribute__((__packed__)) EnergyDataStruct_t{
+    char            header[NSL_PACKET_HEADER_LENGTH];
+    unsigned long   met        : 24; ///<  1 -  3 Mission elapsed time of the report (100 ms ticks)
+    uint8_t         frameType;  ///<  4      TSL_FRAME_TYPE_ENERGY
+    uint16_t        orbit;      ///<  5 -  6 Orbit number since TSLPB_EnergyLedger::begin()
+    uint16_t        orbitSeconds; ///<  7 -  8 Duration of the orbit (s)
+    uint32_t        phaseCharge[4]; ///<  9 - 24 Charge per phase (mAs)
+    uint32_t        orbitCharge;  ///< 25 - 28 Total charge of the orbit (mAs)
+    uint16_t        busVolts;   ///< 29 - 30 (10 bits 0-1023) ADC Raw Counts at report time
+    uint8_t         reserved[5]; ///< 31 - 35 Always 0
+};
+
+
+/*!
+ * @brief   Diagnostic frame sent by TSLPB_I2CTrace::pushReport(). One frame
+ *          holds up to four traced register accesses.
+ *
+ * @note    Each entry is 7 bytes: time (uint32_t, micros()), address,
+ *          register, info (bit 7 set for reads, bits 0-6 data byte count).
+ *          sequence numbers the first entry; it increases by one per access
+ *          since power-up, so gaps show accesses that were not downlinked.
+ */
+struct __attribute__((__packed__)) I2CTraceDataStruct_t{
+    char            header[NSL_PACKET_HEADER_LENGTH];
+    unsigned long   met        : 24; ///<  1 -  3 Mission elapsed time of the report (100 ms ticks)
+    uint8_t         frameType;  ///<  4      TSL_FRAME_TYPE_I2C_TRACE
+    uint16_t        sequence;   ///<  5 -  6 Sequence number of the first entry
+    uint8_t         count;      ///<  7      Entries in this frame (0-4)
+    uint8_t         entries[28]; ///<  8 - 35 Four TSLPB_I2CTraceEntry_t
+};
+
+
+/*!
+ * @brief   Diagnostic frame sent by TSLPB_ChannelStats::pushReport(). One frame
+ *          summarizes two channels over one report interval.
+ *
+ * @note    Index 0 of each array is channel firstChannel, index 1 the next
+ *          TSLPB_StatsChannel_t. mean and variance are fixed point with 8
+ *          fractional bits (value * 256, value^2 * 256). variance is the
+ *          sample variance and saturates at 0xFFFFFFFF. A channel with no
+ *          samples has count 0 and the other fields 0.
+ */
+struct __attribute__((__packed__)) StatsDataStruct_t{
+    char            header[NSL_PACKET_HEADER_LENGTH];
+    unsigned long   met        : 24; ///<  1 -  3 Mission elapsed time of the report (100 ms ticks)
+    uint8_t         frameType;  ///<  4      TSL_FRAME_TYPE_STATS
+    uint8_t         firstChannel; ///<  5      TSLPB_StatsChannel_t of index 0
+    uint16_t        count[2];   ///<  6 -  9 Samples in the interval
+    int16_t         minimum[2]; ///< 10 - 13 Smallest sample
+    int16_t         maximum[2]; ///< 14 - 17 Largest sample
+    int32_t         mean[2];    ///< 18 - 25 Mean (Q8)
+    uint32_t        variance[2]; ///< 26 - 33 Sample variance (Q8)
+    uint16_t        seconds;    ///< 34 - 35 Length of the interval (s)
+};
+
+
+/*!
+ * @brief   Frame sent by TSLPB_SeriesCapture. One frame holds up to
+ *          TSL_SERIES_SAMPLES_MAX consecutive samples of the three axes of
+ *          one sensor, losslessly coded (see TSLPB_SeriesCodec.h).
+ *
+ * @note    Sample i of the frame is sample sequence + i of the capture, taken
+ *          i * period ms after the frame's first. A gap in sequence between
+ *          frames of one capture is a failed read or a lost frame.
+ */
+struct __attribute__((__packed__)) SeriesDataStruct_t{
     char            header[NSL_PACKET_HEADER_LENGTH];
-    int16_t         quatw;      ///<  1 -  2 (value from -4000 to 4000) 4.000 (unitless)
-    int16_t         quatx;      ///<  3 -  4 (value from -1000 to 1000) 1.000 (unitless)
-    int16_t         quaty;      ///<  5 -  6 (value from -1000 to 1000) 1.000 (unitless)
-    int16_t         quatz;      ///<  7 -  8 (value from -1000 to 1000) 1.000 (unitless)
-    int16_t         bnomagx;    ///<  9 - 10 (value from -20480 to 20470) 2047.0 uT (from BNO)
-    int16_t         bnomagy;    ///< 11 - 12 (value from -20480 to 20470) 2047.0 uT
-    int16_t         bnomagz;    ///< 13 - 14 (value from -20480 to 20470) 2047.0 uT
-    uint8_t         bnoCal;     ///< 15      (sys, gyro, accel, mag) 01010101b
-    unsigned long   bmePres;    ///< 16 - 19 (values from 0 to 1010000) 101000.0 Pa
-    int16_t         bmeTemp;    ///< 20 - 21 (values from -1000 to 1000) 100.0 C
-    uint16_t        tslTempExt; ///< 22 - 23 (10 bits 0-1023) ADC Raw Counts
-    uint16_t        tslVolts;   ///< 24 - 25 (10 bits 0-1023) ADC Raw Counts
-    uint16_t        tslCurrent; ///< 26 - 27 (10 bits 0-1023) ADC Raw Counts
-    int16_t         tslMagXraw; ///< 28 - 29 Raw value (2's compliment form) -0x7FF8 to 0x7FF8
-    int16_t         tslMagYraw; ///< 30 - 31 Raw value (2's compliment form) -0x7FF8 to 0x7FF8
-    int16_t         tslMagZraw; ///< 32 - 33 Raw value (2's compliment form) -0x7FF8 to 0x7FF8
-    uint16_t        solar;      ///< 34 - 35 (10 bits 0-1023) ADC Raw Counts
+    unsigned long   met        : 24; ///<  1 -  3 Mission elapsed time of the first sample (100 ms ticks)
+    uint8_t         frameType;  ///<  4      TSL_FRAME_TYPE_SERIES
+    uint8_t         source;     ///<  5      bits 0 - 3 TSLPB_SeriesSource_t, bits 4 - 7 capture number
+    uint8_t         period;     ///<  6      Sample period (ms)
+    uint16_t        sequence;   ///<  7 -  8 Index of the first sample in the capture
+    uint8_t         count;      ///<  9      Samples in this frame (1 - 48)
+    uint8_t         bits[26];   ///< 10 - 35 Coded samples, unused bits zero
 };
 
 
@@ -63,8 +211,13 @@ typedef struct UserDataStruct_t{
  *          TSLPB::pushDataToNSL(ThinsatPacket_t data) and changing this union
  *          may break that functionality.
  */
-typedef union ThinsatPacket_t {
+union ThinsatPacket_t {
     UserDataStruct_t payloadData;
+    ProfileDataStruct_t profileData;
+    EnergyDataStruct_t energyData;
+    I2CTraceDataStruct_t traceData;
+    StatsDataStruct_t statsData;
+    SeriesDataStruct_t seriesData;
     byte NSLPacket[sizeof(UserDataStruct_t)];
 };
 
@@ -52,6 +52,15 @@ extern HardwareSerial Serial;
  *  └──────────────────────────────────────────────────┘ */
 
 #include "TSLPB.h"
+#include "TSLPB_Quaternion.h"
+#include "TSLPB_AdaptiveRate.h"
+#include "TSLPB_Profiler.h"
+#include "TSLPB_EnergyLedger.h"
+#include "TSLPB_I2CTrace.h"
+#include "TSLPB_AttitudeFilter.h"
+#include "TSLPB_MagCalibrator.h"
+#include "TSLPB_ChannelStats.h"
+#include "TSLPB_SeriesCodec.h"
 
 /*  ┌──────────────────────────────────────────────────┐
  *  │          Include custom sensor libraries         │
@@ -81,6 +90,104 @@ extern HardwareSerial Serial;
 #define BMP_CS 10
 
 
+/*  ┌──────────────────────────────────────────────────┐
+ *  │        Adaptive Sample Rate Bounds (ms)          │
+ *  └──────────────────────────────────────────────────┘ */
+
+    /*
+     * Each channel is sampled between its MIN and MAX period. Thresholds are
+     * the rate of change (raw counts per second) that shortens the period.
+     * The gyro threshold is the L1 magnitude of the TSLPB gyro vector:
+     * 164 counts is about 5 deg/s at GYRO_FULL_SCALE_1000_DPS.
+     *
+     * Each bound can be overridden on the compiler command line, so host
+     * builds can compare sampling configurations.
+     */
+
+#ifndef RATE_GYRO_MIN_PERIOD
+#define RATE_GYRO_MIN_PERIOD            1000
+#endif
+#ifndef RATE_GYRO_MAX_PERIOD
+#define RATE_GYRO_MAX_PERIOD            30000
+#endif
+#ifndef RATE_GYRO_THRESHOLD
+#define RATE_GYRO_THRESHOLD             164
+#endif
+
+#ifndef RATE_SOLAR_MIN_PERIOD
+#define RATE_SOLAR_MIN_PERIOD           1000
+#endif
+#ifndef RATE_SOLAR_MAX_PERIOD
+#define RATE_SOLAR_MAX_PERIOD           30000
+#endif
+#ifndef RATE_SOLAR_THRESHOLD
+#define RATE_SOLAR_THRESHOLD            20
+#endif
+
+#ifndef RATE_CURRENT_MIN_PERIOD
+#define RATE_CURRENT_MIN_PERIOD         1000
+#endif
+#ifndef RATE_CURRENT_MAX_PERIOD
+#define RATE_CURRENT_MAX_PERIOD         30000
+#endif
+#ifndef RATE_CURRENT_THRESHOLD
+#define RATE_CURRENT_THRESHOLD          10
+#endif
+
+#ifndef RATE_MAG_MIN_PERIOD
+#define RATE_MAG_MIN_PERIOD             1000
+#endif
+#ifndef RATE_MAG_MAX_PERIOD
+#define RATE_MAG_MAX_PERIOD             30000
+#endif
+#ifndef RATE_MAG_THRESHOLD
+#define RATE_MAG_THRESHOLD              200
+#endif
+
+#ifndef RATE_HOUSEKEEPING_PERIOD
+#define RATE_HOUSEKEEPING_PERIOD        5000
+#endif
+
+#ifndef CTS_POLL_INTERVAL
+#define CTS_POLL_INTERVAL               100     ///< Wait between clear to send polls
+#endif
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │   Profiler Report Interval (TSL_ENABLE_PROFILER) │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define PROFILE_REPORT_INTERVAL         100     ///< Science frames between profiler reports
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │ I2C Trace Report Interval (TSL_ENABLE_I2C_TRACE) │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define I2C_TRACE_REPORT_INTERVAL       50      ///< Science frames between I2C trace reports
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │ Statistics Interval (TSL_ENABLE_CHANNEL_STATS)   │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define STATS_REPORT_INTERVAL           30      ///< Science frames between channel statistics reports
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │ High-Rate Captures (TSL_ENABLE_SERIES_CAPTURE)   │
+ *  └──────────────────────────────────────────────────┘ */
+
+    /*
+     * Each capture samples one sensor, taking the magnetometer,
+     * accelerometer and gyroscope in turn.
+     */
+
+#define SERIES_CAPTURE_INTERVAL         60      ///< Science frames between captures
+#define SERIES_CAPTURE_SAMPLES          200     ///< Samples per capture
+#define SERIES_CAPTURE_PERIOD           10      ///< Time between samples (ms), 100 Hz
+
+
 /*  ┌──────────────────────────────────────────────────┐
  *  │   Instantiate Controller Classes and Variables   │
  *  └──────────────────────────────────────────────────┘ */
@@ -90,9 +197,27 @@ Adafruit_BMP280 bme; // I2C Constructor
 Adafruit_BNO055 bno = Adafruit_BNO055();
 
 TSLPB tslpb;
+TSLPB_AdaptiveRate rateControl;
 
 ThinsatPacket_t missionData;
 
+#ifdef TSL_ENABLE_PROFILER
+uint16_t framesSinceProfileReport = 0;
+#endif
+
+#ifdef TSL_ENABLE_I2C_TRACE
+uint16_t framesSinceTraceReport = 0;
+#endif
+
+#ifdef TSL_ENABLE_CHANNEL_STATS
+uint16_t framesSinceStatsReport = 0;
+#endif
+
+#ifdef TSL_ENABLE_SERIES_CAPTURE
+uint16_t framesSinceCapture = 0;
+uint8_t  nextCaptureSource  = SeriesMagnetometer;
+#endif
+
 
 /*  ┌──────────────────────────────────────────────────┐
  *  │  Setup Function: Run any custom initializations  │
@@ -110,6 +235,31 @@ void setup()
     
     bme.begin();
     
+    rateControl.configure(RateGyro,         RATE_GYRO_MIN_PERIOD,    RATE_GYRO_MAX_PERIOD,    RATE_GYRO_THRESHOLD);
+    rateControl.configure(RateSolar,        RATE_SOLAR_MIN_PERIOD,   RATE_SOLAR_MAX_PERIOD,   RATE_SOLAR_THRESHOLD);
+    rateControl.configure(RateCurrent,      RATE_CURRENT_MIN_PERIOD, RATE_CURRENT_MAX_PERIOD, RATE_CURRENT_THRESHOLD);
+    rateControl.configure(RateMagnetometer, RATE_MAG_MIN_PERIOD,     RATE_MAG_MAX_PERIOD,     RATE_MAG_THRESHOLD);
+    rateControl.configure(RateHousekeeping, RATE_HOUSEKEEPING_PERIOD, RATE_HOUSEKEEPING_PERIOD, 0);
+    
+#ifdef TSL_ENABLE_ENERGY_LEDGER
+    tslEnergyLedger.begin(tslpb);
+#endif
+    
+#ifdef TSL_ENABLE_ATTITUDE_FILTER
+    tslAttitude.begin(tslpb);
+#endif
+    
+#ifdef TSL_ENABLE_MAG_CALIBRATION
+    tslMagCalibrator.begin(tslpb);
+#endif
+    
+#ifdef TSL_ENABLE_CHANNEL_STATS
+    tslChannelStats.begin(tslpb);
+#endif
+    
+#ifdef TSL_ENABLE_SERIES_CAPTURE
+    tslSeriesCapture.begin(tslpb);
+#endif
     
 }
 
@@ -119,94 +269,286 @@ void setup()
 
 void loop()
 {
+    TSL_PROFILE_BEGIN(ProfileLoop);
+    
+    TSL_ENERGY_PHASE(EnergyAcquisition);
+    
+    uint32_t now = millis();
+    bool     frameUpdated = false;
+    
+    // Timestamp the frame when acquisition starts, not when it is sent. The
+    // stamp dates only the channels refreshed below (see UserDataStruct_t).
+    tslpb.stampAcquisitionTime(missionData);
     
     /*  ┌──────────────────────────────────────────────────┐
      *  │       Poll Sensors and store in missionData      │
      *  └──────────────────────────────────────────────────┘ */
     
+            /*
+             * Only the channels that are due are read. Fields of channels
+             * that are not due keep their last value in missionData. Each
+             * channel read sets its bit in refreshed.
+             */
     
     /*  ┌──────────────────────────────────────────────────┐
      *  │          Get BNO Gyro/Mag Data and Store         │
      *  └──────────────────────────────────────────────────┘ */
     
-    imu::Quaternion tempQuat = bno.getQuat(); // returns double types
+    if (rateControl.isDue(RateGyro, now))
+    {
+        // Attitude activity is the L1 magnitude of the TSLPB gyro vector
+        TSL_PROFILE_BEGIN(ProfileGyroRead);
+        int16_t gyroX = tslpb.readDigitalSensorRaw(Gyroscope_x);
+        int16_t gyroY = tslpb.readDigitalSensorRaw(Gyroscope_y);
+        int16_t gyroZ = tslpb.readDigitalSensorRaw(Gyroscope_z);
+        TSL_PROFILE_END(ProfileGyroRead);
+        uint32_t gyroMagnitude = abs((int32_t)gyroX) + abs((int32_t)gyroY) + abs((int32_t)gyroZ);
+        rateControl.sampleActivity(RateGyro, gyroMagnitude, now);
+        
+        TSL_PROFILE_BEGIN(ProfileBnoRead);
+        
+        imu::Quaternion tempQuat = bno.getQuat(); // returns double types
+        
+        // getQuat() divides the BNO055's Q14 counts; this gets them back
+        int16_t quaternion[4] = { (int16_t)lround(tempQuat.w() * TSL_QUAT_ONE),
+                                  (int16_t)lround(tempQuat.x() * TSL_QUAT_ONE),
+                                  (int16_t)lround(tempQuat.y() * TSL_QUAT_ONE),
+                                  (int16_t)lround(tempQuat.z() * TSL_QUAT_ONE) };
+        missionData.payloadData.quat = tslPackQuaternion(quaternion); // 4 bytes, see TSLPB_Quaternion.h
+        
+#ifdef TSL_ENABLE_ATTITUDE_FILTER
+        // A BNO055 that stopped answering returns a zero quaternion
+        double quatNormSq = tempQuat.w() * tempQuat.w() + tempQuat.x() * tempQuat.x() +
+                            tempQuat.y() * tempQuat.y() + tempQuat.z() * tempQuat.z();
+        if (quatNormSq < 0.5 || quatNormSq > 1.5)
+        {
+            tslAttitude.fillFrame(missionData);
+        }
+#endif
+        
+        imu::Vector<3> magVect;
+        magVect = bno.getVector(bno.VECTOR_MAGNETOMETER);
+        
+        
+        missionData.payloadData.bnomagy = (int16_t)(magVect[0] * 10); // Stored as integer.
+        missionData.payloadData.bnomagz = (int16_t)(magVect[1] * 10); // Convert by dividing by
+        missionData.payloadData.bnomagx = (int16_t)(magVect[2] * 10); // 10 (one decimal place)
+        
+        uint8_t sysCal, gyroCal, accelCal, magCal;
+        bno.getCalibration(&sysCal, &gyroCal, &accelCal, &magCal);
+        missionData.payloadData.bnoCal =   ((sysCal & 0x3) << 6)   | ((gyroCal & 0x3) << 4) | ((accelCal & 0x3) << 2) | (magCal & 0x3);
+        
+        TSL_PROFILE_END(ProfileBnoRead);
+        
+        missionData.payloadData.refreshed |= 1 << RateGyro;
+        frameUpdated = true;
+    }
     
-    missionData.payloadData.quatw = (int16_t)(tempQuat.w() * 1000); // store as integer
-    missionData.payloadData.quatx = (int16_t)(tempQuat.x() * 1000); // convert by divide
-    missionData.payloadData.quaty = (int16_t)(tempQuat.y() * 1000); // by 1000
-    missionData.payloadData.quatz = (int16_t)(tempQuat.z() * 1000);
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │         Get BME280 Weather Data and Store        │
+     *  └──────────────────────────────────────────────────┘ */
     
-    imu::Vector<3> magVect;
-    magVect = bno.getVector(bno.VECTOR_MAGNETOMETER);
-
-
-    missionData.payloadData.bnomagy = (int16_t)(magVect[0] * 10); // Stored as integer.
-    missionData.payloadData.bnomagz = (int16_t)(magVect[1] * 10); // Convert by dividing by
-    missionData.payloadData.bnomagx = (int16_t)(magVect[2] * 10); // 10 (one decimal place)
+    bool housekeepingDue = rateControl.isDue(RateHousekeeping, now);
+    
+    if (housekeepingDue)
+    {
+        TSL_PROFILE_BEGIN(ProfileBmeRead);
+        missionData.payloadData.bmePres = (unsigned long)(bme.readPressure() * 10);
+        missionData.payloadData.bmeTemp = (int16_t)(bme.readTemperature() * 10);
+        TSL_PROFILE_END(ProfileBmeRead);
+    }
     
-    uint8_t sysCal, gyroCal, accelCal, magCal;
-    bno.getCalibration(&sysCal, &gyroCal, &accelCal, &magCal);
-    missionData.payloadData.bnoCal =   ((sysCal & 0x3) << 6)   | ((gyroCal & 0x3) << 4) | ((accelCal & 0x3) << 2) | (magCal & 0x3);
     
     /*  ┌──────────────────────────────────────────────────┐
-     *  │         Get BME280 Weather Data and Store        │
+     *  │        Get TSL Magnetometer Data and Store       │
      *  └──────────────────────────────────────────────────┘ */
     
-    missionData.payloadData.bmePres = (unsigned long)(bme.readPressure() * 10);
-    missionData.payloadData.bmeTemp = (int16_t)(bme.readTemperature() * 10);
+    int16_t magField[3];
+    if (rateControl.isDue(RateMagnetometer, now))
+    {
+#ifdef TSL_ENABLE_ATTITUDE_FILTER
+        // The filter reads every result while the sketch sleeps, so waiting
+        // for one here would wait for the next. Take the filter's, or one
+        // that has come in since.
+        bool magRead = tslAttitude.takeMagnetometer(magField) || tslpb.readMagnetometerBurst(magField);
+#else
+        bool magRead = tslpb.readMagnetometerBurst(magField, true);
+#endif
+        if (magRead)
+        {
+#ifdef TSL_ENABLE_MAG_CALIBRATION
+            tslMagCalibrator.sample(magField);
+#endif
+            // Identity unless a calibration has been set
+            tslpb.correctMagnetometer(magField);
+            
+            // Change of the field vector, so a rotating payload counts as active
+            uint32_t magDelta = abs((int32_t)magField[0] - missionData.payloadData.tslMagXraw)
+                              + abs((int32_t)magField[1] - missionData.payloadData.tslMagYraw)
+                              + abs((int32_t)magField[2] - missionData.payloadData.tslMagZraw);
+            rateControl.sampleDelta(RateMagnetometer, (uint16_t)min(magDelta, (uint32_t)0xFFFF), now);
+            
+            missionData.payloadData.tslMagXraw = magField[0];
+            missionData.payloadData.tslMagYraw = magField[1];
+            missionData.payloadData.tslMagZraw = magField[2];
+            missionData.payloadData.refreshed |= 1 << RateMagnetometer;
+            frameUpdated = true;
+        }
+        else
+        {
+            // No result (NACK, overflow, DRDY timeout, or none since the
+            // attitude filter's last). Count it as a quiet sample so the
+            // channel waits a period, backing off to RATE_MAG_MAX_PERIOD,
+            // instead of polling the AK8963 every pass.
+            rateControl.sampleDelta(RateMagnetometer, 0, now);
+        }
+    }
+    
+    
+            /*
+             * Analog channels are read after all I2C channels so the energy
+             * ledger sees one mux settle phase per loop.
+             */
     
+    TSL_ENERGY_PHASE(EnergyMuxSettle);
     
     /*  ┌──────────────────────────────────────────────────┐
-     *  │         Get Payload Health Data and Store        │
+     *  │      Get TSL External Temperature and Store      │
      *  └──────────────────────────────────────────────────┘ */
     
-    missionData.payloadData.tslVolts   = tslpb.readAnalogSensor(Voltage);
-    missionData.payloadData.tslCurrent = tslpb.readAnalogSensor(Current);
-    missionData.payloadData.tslTempExt = tslpb.readAnalogSensor(TempExt);
-
+    if (housekeepingDue)
+    {
+        missionData.payloadData.tslTempExt = tslpb.readAnalogSensor(TempExt);
+        
+        rateControl.sampleActivity(RateHousekeeping, 0, now);
+        missionData.payloadData.refreshed |= 1 << RateHousekeeping;
+        frameUpdated = true;
+    }
+    
     
     /*  ┌──────────────────────────────────────────────────┐
-     *  │        Get TSL Magnetometer Data and Store       │
+     *  │         Get Payload Health Data and Store        │
      *  └──────────────────────────────────────────────────┘ */
     
-    missionData.payloadData.tslMagXraw = tslpb.readDigitalSensorRaw(Magnetometer_x);
-    missionData.payloadData.tslMagYraw = tslpb.readDigitalSensorRaw(Magnetometer_y);
-    missionData.payloadData.tslMagZraw = tslpb.readDigitalSensorRaw(Magnetometer_z);
+    if (rateControl.isDue(RateCurrent, now))
+    {
+        missionData.payloadData.tslVolts   = tslpb.readAnalogSensor(Voltage);
+        missionData.payloadData.tslCurrent = tslpb.readAnalogSensor(Current);
+        
+        rateControl.sample(RateCurrent, missionData.payloadData.tslCurrent, now);
+        missionData.payloadData.refreshed |= 1 << RateCurrent;
+        frameUpdated = true;
+    }
     
     /*  ┌──────────────────────────────────────────────────┐
      *  │          Get the TSL Solar Sensor Value          │
      *  └──────────────────────────────────────────────────┘ */
     
-    missionData.payloadData.solar = tslpb.readAnalogSensor(Solar);
+    if (rateControl.isDue(RateSolar, now))
+    {
+        missionData.payloadData.solar = tslpb.readAnalogSensor(Solar);
+        
+        rateControl.sample(RateSolar, missionData.payloadData.solar, now);
+        missionData.payloadData.refreshed |= 1 << RateSolar;
+        frameUpdated = true;
+    }
    
     
-    /*  ┌──────────────────────────────────────────────────┐
-     *  │             Wait for Clear To Send?              │
-     *  └──────────────────────────────────────────────────┘ */
-    
-    while (!tslpb.isClearToSend())
+    if (frameUpdated)
     {
-        delay(100);
+        /*  ┌──────────────────────────────────────────────────┐
+         *  │             Wait for Clear To Send?              │
+         *  └──────────────────────────────────────────────────┘ */
+        
+        TSL_ENERGY_PHASE(EnergySerialTx);
+        TSL_PROFILE_BEGIN(ProfileCtsWait);
+        
+        while (!tslpb.isClearToSend())
+        {
+            delay(CTS_POLL_INTERVAL);
+        }
+        
+        TSL_PROFILE_END(ProfileCtsWait);
+        
+        /*  ┌──────────────────────────────────────────────────┐
+         *  │          Push Data to the NSL Mothership         │
+         *  └──────────────────────────────────────────────────┘ */
+        
+        tslpb.pushDataToNSL(missionData);
+        
+#ifdef TSL_ENABLE_PROFILER
+        if (++framesSinceProfileReport >= PROFILE_REPORT_INTERVAL)
+        {
+            tslProfiler.pushReport(tslpb);
+            framesSinceProfileReport = 0;
+        }
+#endif
+        
+#ifdef TSL_ENABLE_I2C_TRACE
+        if (++framesSinceTraceReport >= I2C_TRACE_REPORT_INTERVAL)
+        {
+            tslI2CTrace.pushReport(tslpb);
+            framesSinceTraceReport = 0;
+        }
+#endif
+        
+#ifdef TSL_ENABLE_CHANNEL_STATS
+        if (++framesSinceStatsReport >= STATS_REPORT_INTERVAL)
+        {
+            tslChannelStats.pushReport();
+            framesSinceStatsReport = 0;
+        }
+#endif
+        
+#ifdef TSL_ENABLE_SERIES_CAPTURE
+        if (++framesSinceCapture >= SERIES_CAPTURE_INTERVAL)
+        {
+            tslSeriesCapture.capture((TSLPB_SeriesSource_t)nextCaptureSource, SERIES_CAPTURE_SAMPLES, SERIES_CAPTURE_PERIOD);
+            tslSeriesCapture.pushReport();
+            nextCaptureSource  = (nextCaptureSource + 1) % TSL_SERIES_SOURCE_COUNT;
+            framesSinceCapture = 0;
+        }
+#endif
     }
     
-    /*  ┌──────────────────────────────────────────────────┐
-     *  │          Push Data to the NSL Mothership         │
-     *  └──────────────────────────────────────────────────┘ */
+#ifdef TSL_ENABLE_ENERGY_LEDGER
+    if (tslEnergyLedger.isOrbitComplete())
+    {
+        TSL_ENERGY_PHASE(EnergySerialTx);
+        tslEnergyLedger.pushReport();
+    }
+#endif
     
-    tslpb.pushDataToNSL(missionData);
+    TSL_PROFILE_END(ProfileLoop);
     
     
     /*  ┌──────────────────────────────────────────────────┐
-     *  │    Wait for some predetermined amount of time    │
+     *  │      Wait until the next channel becomes due     │
      *  └──────────────────────────────────────────────────┘ */
     
             /*
-             * We could have it wait some fixed amount of time
-             * or we could have it try on fixed intervals by
-             * looking at the internal timer...
+             * The adaptive rate controller tracks a period for every
+             * channel. Sleep until the soonest one expires.
              */
     
-    delay(5000);
+    TSL_ENERGY_PHASE(EnergySleep);
+#if defined(TSL_ENABLE_ATTITUDE_FILTER) || defined(TSL_ENABLE_CHANNEL_STATS)
+    // The attitude filter keeps integrating the gyro and the channel
+    // statistics keep sampling while the channels sleep
+    for (uint32_t wait = rateControl.msUntilNextDue(millis()); wait > 0; wait = rateControl.msUntilNextDue(millis()))
+    {
+#ifdef TSL_ENABLE_ATTITUDE_FILTER
+        tslAttitude.update();
+        wait = min(wait, (uint32_t)TSL_ATTITUDE_PERIOD_MS);
+#endif
+#ifdef TSL_ENABLE_CHANNEL_STATS
+        wait = min(wait, tslChannelStats.update());
+#endif
+        delay(wait);
+    }
+#else
+    delay(rateControl.msUntilNextDue(millis()));
+#endif
     
     
 }
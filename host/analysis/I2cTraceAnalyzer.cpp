@@ -0,0 +1,312 @@
+/**
+ *  @file   I2cTraceAnalyzer.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Redundancy analysis of TSLPB I2C traces
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "I2cTraceAnalyzer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+
+namespace analysis {
+
+
+namespace {
+
+// Bits on the bus, including start, address + ACK and stop
+const double pointerWriteBits   = 1 + 9 + 9 + 1;
+const double readOverheadBits   = 1 + 9 + 1;
+const double bitsPerByte        = 9;
+
+
+bool isRead(const TSLPB_I2CTraceEntry_t& entry)
+{
+    return (entry.info & TSL_I2C_TRACE_READ) != 0;
+}
+
+uint8_t byteCount(const TSLPB_I2CTraceEntry_t& entry)
+{
+    return entry.info & TSL_I2C_TRACE_COUNT_MASK;
+}
+
+/*!
+ * @brief LM75A register pointers do not advance when read
+ */
+bool hasAutoIncrement(uint8_t address)
+{
+    return address < DT4_ADDRESS || address > DT3_ADDRESS;
+}
+
+double entryBits(const TSLPB_I2CTraceEntry_t& entry)
+{
+    if (isRead(entry)) {
+        return pointerWriteBits + readOverheadBits + bitsPerByte * byteCount(entry);
+    }
+    return pointerWriteBits + bitsPerByte * byteCount(entry);
+}
+
+struct FindingTable
+{
+    std::map<std::tuple<int, uint8_t, uint8_t>, Finding> findings;
+    
+    void add(FindingKind kind, const TSLPB_I2CTraceEntry_t& entry, uint8_t lastReg,
+             uint64_t entries, double savedUs)
+    {
+        auto key = std::make_tuple((int)kind, entry.address, entry.reg);
+        auto found = findings.find(key);
+        
+        if (found == findings.end()) {
+            Finding finding;
+            finding.kind        = kind;
+            finding.address     = entry.address;
+            finding.reg         = entry.reg;
+            finding.lastReg     = lastReg;
+            finding.occurrences = 0;
+            finding.entries     = 0;
+            finding.savedUs     = 0;
+            finding.firstTime   = entry.time;
+            found = findings.insert(std::make_pair(key, finding)).first;
+        }
+        
+        Finding& finding = found->second;
+        finding.lastReg      = std::max(finding.lastReg, lastReg);
+        finding.occurrences += 1;
+        finding.entries     += entries;
+        finding.savedUs     += savedUs;
+    }
+};
+
+} /* namespace */
+
+
+/*!
+ * @brief Analyzes a trace in recording order
+ */
+AnalyzerReport analyzeTrace(const std::vector<TSLPB_I2CTraceEntry_t>& trace, const AnalyzerOptions& options)
+{
+    AnalyzerReport    report;
+    FindingTable      table;
+    std::vector<bool> claimed(trace.size(), false);
+    double            usPerBit = 1e6 / options.clockHz;
+    
+    report.entries      = trace.size();
+    report.transactions = 0;
+    report.busUs        = 0;
+    memset(report.savedUs, 0, sizeof(report.savedUs));
+    
+    for (const TSLPB_I2CTraceEntry_t& entry : trace) {
+        report.transactions += isRead(entry) ? 2 : 1;
+        report.busUs        += entryBits(entry) * usPerBit;
+    }
+    
+    // Polling storms: identical reads back to back
+    for (size_t i = 0; i < trace.size(); ) {
+        size_t run = 1;
+        while (i + run < trace.size() &&
+               isRead(trace[i]) &&
+               !memcmp(&trace[i + run].address, &trace[i].address, 3)) {
+            run++;
+        }
+        
+        if (isRead(trace[i]) && run >= options.pollThreshold) {
+            double saved = (run - 1) * entryBits(trace[i]) * usPerBit;
+            table.add(FindingPollingStorm, trace[i], trace[i].reg, run, saved);
+            report.savedUs[FindingPollingStorm] += saved;
+            std::fill(claimed.begin() + i, claimed.begin() + i + run, true);
+        }
+        i += run;
+    }
+    
+    // Mergeable bursts: nearby registers of one device, close in time
+    for (size_t i = 0; i < trace.size(); i++) {
+        const TSLPB_I2CTraceEntry_t& first = trace[i];
+        if (claimed[i] || !isRead(first) || !hasAutoIncrement(first.address)) {
+            continue;
+        }
+        
+        size_t  last    = i;
+        int     end     = first.reg + byteCount(first);
+        int     skipped = 0;
+        
+        while (last + 1 < trace.size()) {
+            const TSLPB_I2CTraceEntry_t& next = trace[last + 1];
+            int gap = next.reg - end;
+            
+            if (claimed[last + 1] || !isRead(next) || next.address != first.address ||
+                next.time - trace[last].time > options.mergeWindowUs ||
+                gap < 0 || gap > TRACE_MAX_MERGE_GAP) {
+                break;
+            }
+            skipped += gap;
+            end      = next.reg + byteCount(next);
+            last++;
+        }
+        
+        if (last > i) {
+            double saved = ((last - i) * (pointerWriteBits + readOverheadBits) - skipped * bitsPerByte) * usPerBit;
+            if (saved > 0) {
+                table.add(FindingMergeableBurst, first, end - 1, last - i + 1, saved);
+                report.savedUs[FindingMergeableBurst] += saved;
+                std::fill(claimed.begin() + i + 1, claimed.begin() + last + 1, true);
+            }
+            i = last;
+        }
+    }
+    
+    // Redundant pointer writes: the pointer already selects the register
+    int pointer[128];
+    std::fill(pointer, pointer + 128, -1);
+    
+    for (size_t i = 0; i < trace.size(); i++) {
+        const TSLPB_I2CTraceEntry_t& entry = trace[i];
+        uint8_t address = entry.address & 0x7F;
+        
+        if (!claimed[i] && isRead(entry) && pointer[address] == entry.reg) {
+            double saved = pointerWriteBits * usPerBit;
+            table.add(FindingRedundantPointer, entry, entry.reg, 1, saved);
+            report.savedUs[FindingRedundantPointer] += saved;
+        }
+        
+        pointer[address] = hasAutoIncrement(address) ? (entry.reg + byteCount(entry)) & 0xFF : entry.reg;
+    }
+    
+    for (auto& item : table.findings) {
+        report.findings.push_back(item.second);
+    }
+    std::sort(report.findings.begin(), report.findings.end(),
+              [](const Finding& a, const Finding& b) { return a.savedUs > b.savedUs; });
+    return report;
+}
+
+
+const char* findingKindName(FindingKind kind)
+{
+    switch (kind) {
+        case FindingPollingStorm:       return "polling storm";
+        case FindingMergeableBurst:     return "mergeable burst";
+        case FindingRedundantPointer:   return "redundant pointer write";
+        default:                        return "?";
+    }
+}
+
+/*!
+ * @brief Human-readable device and register, e.g. "AK8963 ST1 (0x02)"
+ */
+std::string registerName(uint8_t address, uint8_t reg)
+{
+    static const char* dtNames[] = { "DT4", "DT5", "DT1", "DT6", "DT2", "DT3" };  // 0x48 - 0x4D
+    const char* device = NULL;
+    const char* name   = NULL;
+    char        text[64];
+    
+    if (address >= DT4_ADDRESS && address <= DT3_ADDRESS) {
+        device = dtNames[address - DT4_ADDRESS];
+        switch (reg) {
+            case LM75A_TEMPERATURE:     name = "TEMP";  break;
+            case LM75A_CONFIGURATION:   name = "CONF";  break;
+            case LM75A_T_HYST:          name = "THYST"; break;
+            case LM75A_T_OS:            name = "TOS";   break;
+            case LM75A_PRODUCT_ID:      name = "ID";    break;
+        }
+    } else if (address == IMU_ADDRESS) {
+        static const char* outputs[] = { "ACCEL_XOUT", "ACCEL_YOUT", "ACCEL_ZOUT", "TEMP_OUT",
+                                         "GYRO_XOUT", "GYRO_YOUT", "GYRO_ZOUT" };
+        device = "MPU-9250";
+        if (reg >= MPU9250_ACCEL_XOUT_MSB && reg <= MPU9250_GYRO_ZOUT_LSB) {
+            name = outputs[(reg - MPU9250_ACCEL_XOUT_MSB) / 2];
+        } else if (reg == MPU9250_REG_INT_PIN_BYPASS) {
+            name = "INT_PIN_CFG";
+        }
+    } else if (address == MAG_ADDRESS) {
+        static const char* registers[] = { "WIA", "INFO", "ST1", "HXL", "HXH", "HYL", "HYH",
+                                           "HZL", "HZH", "ST2", "CNTL1" };
+        device = "AK8963";
+        if (reg <= MPU9250_MAG_REG_CONTROL) {
+            name = registers[reg];
+        }
+    }
+    
+    if (device) {
+        snprintf(text, sizeof(text), "%s %s (0x%02X)", device, name ? name : "reg", reg);
+    } else {
+        snprintf(text, sizeof(text), "0x%02X reg 0x%02X", address, reg);
+    }
+    return text;
+}
+
+void printReport(FILE* output, const AnalyzerReport& report, size_t maxFindings)
+{
+    double totalSaved = 0;
+    
+    fprintf(output, "trace entries       %llu\n", (unsigned long long)report.entries);
+    fprintf(output, "bus transactions    %llu\n", (unsigned long long)report.transactions);
+    fprintf(output, "bus time            %.3f ms\n", report.busUs / 1e3);
+    fprintf(output, "\nestimated savings\n");
+    
+    for (int kind = 0; kind < TRACE_FINDING_KIND_COUNT; kind++) {
+        totalSaved += report.savedUs[kind];
+        fprintf(output, "  %-24s %12.3f ms  %5.1f%%\n", findingKindName((FindingKind)kind),
+                report.savedUs[kind] / 1e3, report.busUs ? 100 * report.savedUs[kind] / report.busUs : 0);
+    }
+    fprintf(output, "  %-24s %12.3f ms  %5.1f%%\n", "total", totalSaved / 1e3,
+            report.busUs ? 100 * totalSaved / report.busUs : 0);
+    
+    if (report.findings.empty()) {
+        return;
+    }
+    
+    fprintf(output, "\n%-24s %-28s %10s %10s %12s\n", "finding", "register", "count", "entries", "saved (ms)");
+    for (size_t i = 0; i < report.findings.size() && i < maxFindings; i++) {
+        const Finding& finding = report.findings[i];
+        std::string    where   = registerName(finding.address, finding.reg);
+        
+        if (finding.lastReg != finding.reg) {
+            char range[16];
+            snprintf(range, sizeof(range), "-0x%02X", finding.lastReg);
+            where += range;
+        }
+        fprintf(output, "%-24s %-28s %10llu %10llu %12.3f\n", findingKindName(finding.kind), where.c_str(),
+                (unsigned long long)finding.occurrences, (unsigned long long)finding.entries,
+                finding.savedUs / 1e3);
+    }
+}
+
+/*!
+ * @brief Reads the entries of every TSL_FRAME_TYPE_I2C_TRACE frame in a file
+ * of downlinked NSL packets. Other frames are skipped.
+ *
+ * @return  the number of trace frames read
+ */
+size_t readTraceFrames(FILE* input, std::vector<TSLPB_I2CTraceEntry_t>& trace)
+{
+    const uint8_t   header[] = NSL_PACKET_HEADER;
+    ThinsatPacket_t frame;
+    size_t          frames   = 0;
+    
+    while (fread(frame.NSLPacket, 1, NSL_PACKET_SIZE, input) == NSL_PACKET_SIZE) {
+        if (memcmp(frame.NSLPacket, header, NSL_PACKET_HEADER_LENGTH) ||
+            frame.traceData.frameType != TSL_FRAME_TYPE_I2C_TRACE) {
+            continue;
+        }
+        
+        for (uint8_t i = 0; i < frame.traceData.count && i < TSL_I2C_TRACE_PER_FRAME; i++) {
+            TSLPB_I2CTraceEntry_t entry;
+            memcpy(&entry, &frame.traceData.entries[i * sizeof(entry)], sizeof(entry));
+            trace.push_back(entry);
+        }
+        frames++;
+    }
+    return frames;
+}
+
+
+} /* namespace analysis */
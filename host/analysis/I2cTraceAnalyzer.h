@@ -0,0 +1,103 @@
+/**
+ *  @file   I2cTraceAnalyzer.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Finds redundant I2C traffic in a TSLPB_I2CTrace trace and
+ *          estimates the bus time each finding would save.
+ *
+ *          Three kinds of finding are reported, each trace entry counting
+ *          toward at most one of them:
+ *          - Polling storms: the same register read many times in a row.
+ *            Saving: every poll but one.
+ *          - Mergeable bursts: reads of nearby registers of one device close
+ *            together in time that one burst read could replace. Saving: the
+ *            pointer write and read overhead of every read but the first,
+ *            less the cost of any skipped registers read in between.
+ *          - Redundant pointer writes: reads of the register the device's
+ *            pointer already selects. LM75A pointers stay put; MPU-9250 and
+ *            AK8963 pointers advance past the bytes read. Saving: the
+ *            pointer write transaction.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef I2cTraceAnalyzer_h
+#define I2cTraceAnalyzer_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "TSLPB_I2CTrace.h"
+
+
+namespace analysis {
+
+
+#define TRACE_DEFAULT_CLOCK_HZ          100000  ///< TWI clock the savings are computed for
+#define TRACE_DEFAULT_POLL_THRESHOLD    8       ///< Consecutive reads of one register that make a storm
+#define TRACE_DEFAULT_MERGE_WINDOW_US   2000    ///< Largest gap between reads merged into a burst
+#define TRACE_MAX_MERGE_GAP             3       ///< Skipped registers allowed inside a burst
+
+
+typedef enum
+{
+    FindingPollingStorm     = 0,
+    FindingMergeableBurst   = 1,
+    FindingRedundantPointer = 2,
+    TRACE_FINDING_KIND_COUNT
+} FindingKind;
+
+
+/*!
+ * @brief   Findings of one kind at one device register, summed over the trace
+ */
+typedef struct
+{
+    FindingKind kind;
+    uint8_t     address;
+    uint8_t     reg;                ///< First register of the finding
+    uint8_t     lastReg;            ///< Last register (bursts)
+    uint64_t    occurrences;        ///< Number of storms, bursts or pointer writes
+    uint64_t    entries;            ///< Trace entries involved
+    double      savedUs;            ///< Estimated bus time saved
+    uint32_t    firstTime;          ///< micros() of the first occurrence
+} Finding;
+
+
+typedef struct
+{
+    uint32_t    clockHz         = TRACE_DEFAULT_CLOCK_HZ;
+    uint32_t    pollThreshold   = TRACE_DEFAULT_POLL_THRESHOLD;
+    uint32_t    mergeWindowUs   = TRACE_DEFAULT_MERGE_WINDOW_US;
+} AnalyzerOptions;
+
+
+typedef struct
+{
+    uint64_t                entries;        ///< Trace entries analyzed
+    uint64_t                transactions;   ///< Bus transactions those entries made
+    double                  busUs;          ///< Bus time those entries took
+    double                  savedUs[TRACE_FINDING_KIND_COUNT];
+    std::vector<Finding>    findings;       ///< Sorted by savedUs, largest first
+} AnalyzerReport;
+
+
+AnalyzerReport  analyzeTrace(const std::vector<TSLPB_I2CTraceEntry_t>& trace,
+                             const AnalyzerOptions& options = AnalyzerOptions());
+void            printReport(FILE* output, const AnalyzerReport& report, size_t maxFindings);
+
+const char*     findingKindName(FindingKind kind);
+std::string     registerName(uint8_t address, uint8_t reg);
+
+size_t          readTraceFrames(FILE* input, std::vector<TSLPB_I2CTraceEntry_t>& trace);
+
+
+} /* namespace analysis */
+
+
+#endif /* I2cTraceAnalyzer_h */
@@ -0,0 +1,353 @@
+/**
+ *  @file   attitude_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Accuracy and cost of the fixed-point attitude filter against the
+ *          same Mahony filter in double precision.
+ *
+ *          Both filters are fed identical raw MPU-9250 and AK8963 counts at
+ *          TSL_ATTITUDE_PERIOD_MS, the magnetometer at its 8 Hz output rate,
+ *          from three scenarios: a payload at rest on the bench, the same
+ *          payload tumbling, and a tumble in orbit through SimOrbit, where
+ *          the accelerometer reads zero. Reported are the angle between the
+ *          two filters' attitudes (the fixed-point one as downlinked, * 1000),
+ *          the angle of each from the true attitude at the end of the ground
+ *          scenarios, and host time per update.
+ *
+ *          Cycles on the Pro Mini come from the ProfileAttitude phase of a
+ *          TSL_ENABLE_PROFILER build on the payload; host time only ranks
+ *          changes to the arithmetic.
+ *
+ *          usage: attitude_bench [--seconds N] [--seed N]
+ *
+ *          --seconds   simulated time per scenario (default 600)
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "TSLPB_AttitudeFilter.h"
+#include "SimOrbit.h"
+
+using sim::SimQuaternion;
+using sim::SimVector3;
+
+
+#define ATTITUDE_GYRO_COUNTS_PER_DPS    (32768.0 / 1000)
+#define ATTITUDE_MAG_COUNTS_PER_UT      (1 / 0.15)
+#define ATTITUDE_MAG_PERIOD_US          125000      ///< AK8963 continuous mode 2
+#define ATTITUDE_SETTLE_US              60000000ULL ///< Skipped before comparing, both filters start at identity
+
+
+/*!
+ * @brief   Raw sensor counts at one update, body (MPU-9250) axes
+ */
+typedef struct
+{
+    int16_t         gyro[3];
+    int16_t         accel[3];
+    int16_t         field[3];
+    bool            hasAccel;
+    bool            hasField;
+    SimQuaternion   truth;      ///< Body to reference
+} Sample;
+
+typedef std::function<void(uint64_t timeUs, Sample& sample)> Scenario;
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │          Double Precision Reference Filter       │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   Madgwick's MahonyAHRSupdate() with the fixed-point filter's gains,
+ *          accelerometer gate and step limit
+ */
+class ReferenceMahony
+{
+    
+public:
+    void fuse(const int16_t gyro[3], const int16_t* accel, const int16_t* field, uint32_t elapsedUs)
+    {
+        double g[3], e[3] = { 0, 0, 0 };
+        bool   corrected = false;
+        
+        for (int i = 0; i < 3; i++) {
+            g[i] = gyro[i] / ATTITUDE_GYRO_COUNTS_PER_DPS * M_PI / 180;
+        }
+        
+        double q0q0 = q[0] * q[0], q0q1 = q[0] * q[1], q0q2 = q[0] * q[2], q0q3 = q[0] * q[3];
+        double q1q1 = q[1] * q[1], q1q2 = q[1] * q[2], q1q3 = q[1] * q[3];
+        double q2q2 = q[2] * q[2], q2q3 = q[2] * q[3], q3q3 = q[3] * q[3];
+        
+        if (accel) {
+            double norm = sqrt((double)accel[0] * accel[0] + (double)accel[1] * accel[1] + (double)accel[2] * accel[2]);
+            double g1   = norm / TSL_ATTITUDE_ACCEL_1G;
+            if (g1 >= 0.75 && g1 <= 1.25) {
+                double ax = accel[0] / norm, ay = accel[1] / norm, az = accel[2] / norm;
+                double vx = q1q3 - q0q2, vy = q0q1 + q2q3, vz = q0q0 - 0.5 + q3q3;
+                e[0] += ay * vz - az * vy;
+                e[1] += az * vx - ax * vz;
+                e[2] += ax * vy - ay * vx;
+                corrected = true;
+            }
+        }
+        if (field && (field[0] || field[1] || field[2])) {
+            double norm = sqrt((double)field[0] * field[0] + (double)field[1] * field[1] + (double)field[2] * field[2]);
+            double mx = field[0] / norm, my = field[1] / norm, mz = field[2] / norm;
+            double hx = 2 * (mx * (0.5 - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            double hy = 2 * (mx * (q1q2 + q0q3) + my * (0.5 - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+            double bx = sqrt(hx * hx + hy * hy);
+            double bz = 2 * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5 - q1q1 - q2q2));
+            double wx = bx * (0.5 - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+            double wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+            double wz = bx * (q0q2 + q1q3) + bz * (0.5 - q1q1 - q2q2);
+            e[0] += my * wz - mz * wy;
+            e[1] += mz * wx - mx * wz;
+            e[2] += mx * wy - my * wx;
+            corrected = true;
+        }
+        if (corrected) {
+            double dt = std::min(elapsedUs, (uint32_t)TSL_ATTITUDE_MAX_STEP_US) * 1e-6;
+            for (int i = 0; i < 3; i++) {
+                integral[i] += TSL_ATTITUDE_TWO_KI / 256.0 * e[i] * dt;
+                g[i]        += integral[i] + TSL_ATTITUDE_TWO_KP / 256.0 * e[i];
+            }
+        }
+        
+        while (elapsedUs > TSL_ATTITUDE_MAX_STEP_US) {
+            integrate(g, TSL_ATTITUDE_MAX_STEP_US);
+            elapsedUs -= TSL_ATTITUDE_MAX_STEP_US;
+        }
+        integrate(g, elapsedUs);
+    }
+    
+    SimQuaternion attitude() { return { q[0], q[1], q[2], q[3] }; }
+    
+private:
+    
+    void integrate(const double g[3], uint32_t elapsedUs)
+    {
+        double h[3] = { g[0] * 0.5e-6 * elapsedUs, g[1] * 0.5e-6 * elapsedUs, g[2] * 0.5e-6 * elapsedUs };
+        double a = q[0], b = q[1], c = q[2];
+        
+        q[0] += -b * h[0] - c * h[1] - q[3] * h[2];
+        q[1] +=  a * h[0] + c * h[2] - q[3] * h[1];
+        q[2] +=  a * h[1] - b * h[2] + q[3] * h[0];
+        q[3] +=  a * h[2] + b * h[1] - c * h[0];
+        
+        double norm = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for (int i = 0; i < 4; i++) {
+            q[i] /= norm;
+        }
+    }
+    
+    double q[4]        = { 1, 0, 0, 0 };
+    double integral[3] = { 0, 0, 0 };
+    
+};
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                     Scenarios                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+static int16_t toCounts(double value)
+{
+    return (int16_t)std::max(-32768.0, std::min(32767.0, round(value)));
+}
+
+/*!
+ * @brief   Angle between two attitudes in degrees. Neither needs to be unit.
+ */
+static double angleDeg(const SimQuaternion& a, const SimQuaternion& b)
+{
+    double dot  = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    double norm = sqrt((a.w * a.w + a.x * a.x + a.y * a.y + a.z * a.z) * (b.w * b.w + b.x * b.x + b.y * b.y + b.z * b.z));
+    return 2 * acos(std::min(1.0, fabs(dot) / norm)) * 180 / M_PI;
+}
+
+/*!
+ * @brief   A payload on the bench, level with gravity along +z, turning at a
+ *          constant body rate from a random attitude. Sensor noise is white
+ *          with a few counts of sigma.
+ */
+static Scenario groundScenario(SimVector3 rateDps, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> unit(0, 1);
+    
+    SimQuaternion start = { unit(rng), unit(rng), unit(rng), unit(rng) };
+    double        norm  = sqrt(start.w * start.w + start.x * start.x + start.y * start.y + start.z * start.z);
+    start = { start.w / norm, start.x / norm, start.y / norm, start.z / norm };
+    
+    auto noise = std::make_shared<std::mt19937_64>(seed + 1);
+    
+    return [=](uint64_t timeUs, Sample& sample) {
+        std::normal_distribution<double> gaussian(0, 1);
+        
+        // q(t) = q(0) * exp(w t / 2) for a constant body rate
+        double w[3]  = { rateDps.x * M_PI / 180, rateDps.y * M_PI / 180, rateDps.z * M_PI / 180 };
+        double rate  = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+        double angle = rate * timeUs * 1e-6 / 2;
+        double s     = rate > 0 ? sin(angle) / rate : 0;
+        SimQuaternion turn = { cos(angle), w[0] * s, w[1] * s, w[2] * s };
+        
+        sample.truth = { start.w * turn.w - start.x * turn.x - start.y * turn.y - start.z * turn.z,
+                         start.w * turn.x + start.x * turn.w + start.y * turn.z - start.z * turn.y,
+                         start.w * turn.y - start.x * turn.z + start.y * turn.w + start.z * turn.x,
+                         start.w * turn.z + start.x * turn.y - start.y * turn.x + start.z * turn.w };
+        
+        SimVector3 up    = sim::simRotateInverse(sample.truth, { 0, 0, 1 });
+        SimVector3 field = sim::simRotateInverse(sample.truth, { 20, 0, -45 });    // uT, mid latitude
+        
+        sample.gyro[0]  = toCounts(rateDps.x * ATTITUDE_GYRO_COUNTS_PER_DPS + 2 * gaussian(*noise));
+        sample.gyro[1]  = toCounts(rateDps.y * ATTITUDE_GYRO_COUNTS_PER_DPS + 2 * gaussian(*noise));
+        sample.gyro[2]  = toCounts(rateDps.z * ATTITUDE_GYRO_COUNTS_PER_DPS + 2 * gaussian(*noise));
+        sample.accel[0] = toCounts(up.x * TSL_ATTITUDE_ACCEL_1G + 8 * gaussian(*noise));
+        sample.accel[1] = toCounts(up.y * TSL_ATTITUDE_ACCEL_1G + 8 * gaussian(*noise));
+        sample.accel[2] = toCounts(up.z * TSL_ATTITUDE_ACCEL_1G + 8 * gaussian(*noise));
+        sample.field[0] = toCounts(field.x * ATTITUDE_MAG_COUNTS_PER_UT + 3 * gaussian(*noise));
+        sample.field[1] = toCounts(field.y * ATTITUDE_MAG_COUNTS_PER_UT + 3 * gaussian(*noise));
+        sample.field[2] = toCounts(field.z * ATTITUDE_MAG_COUNTS_PER_UT + 3 * gaussian(*noise));
+        sample.hasAccel = true;
+    };
+}
+
+/*!
+ * @brief   A tumble through SimOrbit. There is no gravity reference, so only
+ *          the two filters are compared.
+ */
+static Scenario orbitScenario(SimVector3 rateDps)
+{
+    sim::SimOrbitConfig config = sim::simDefaultOrbitConfig;
+    config.bodyRateDps = rateDps;
+    auto orbit = std::make_shared<sim::SimOrbit>(config);
+    
+    return [=](uint64_t timeUs, Sample& sample) {
+        SimVector3 field = orbit->fieldBody(timeUs);
+        
+        sample.truth    = orbit->attitude(timeUs);
+        sample.gyro[0]  = toCounts(rateDps.x * ATTITUDE_GYRO_COUNTS_PER_DPS);
+        sample.gyro[1]  = toCounts(rateDps.y * ATTITUDE_GYRO_COUNTS_PER_DPS);
+        sample.gyro[2]  = toCounts(rateDps.z * ATTITUDE_GYRO_COUNTS_PER_DPS);
+        sample.accel[0] = sample.accel[1] = sample.accel[2] = 0;
+        sample.field[0] = toCounts(field.x * ATTITUDE_MAG_COUNTS_PER_UT);
+        sample.field[1] = toCounts(field.y * ATTITUDE_MAG_COUNTS_PER_UT);
+        sample.field[2] = toCounts(field.z * ATTITUDE_MAG_COUNTS_PER_UT);
+        sample.hasAccel = false;
+    };
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Harness                     │
+ *  └──────────────────────────────────────────────────┘ */
+
+static void run(const char* name, const Scenario& scenario, uint64_t durationUs, bool hasTruth)
+{
+    ReferenceMahony reference;
+    tslAttitude.begin(tslpb);
+    
+    uint64_t periodUs = TSL_ATTITUDE_PERIOD_MS * 1000;
+    uint64_t updates  = 0;
+    uint64_t compared = 0;
+    double   maxDeg   = 0;
+    double   sumDeg   = 0;
+    double   fixedNs  = 0;
+    double   doubleNs = 0;
+    uint64_t nextMag  = 0;
+    Sample   sample   = {};
+    int16_t  quaternion[4];
+    
+    for (uint64_t t = periodUs; t <= durationUs; t += periodUs) {
+        scenario(t, sample);
+        sample.hasField = t >= nextMag;
+        if (sample.hasField) {
+            nextMag += ATTITUDE_MAG_PERIOD_US;
+        }
+        const int16_t* accel = sample.hasAccel ? sample.accel : NULL;
+        const int16_t* field = sample.hasField ? sample.field : NULL;
+        
+        auto start = std::chrono::steady_clock::now();
+        tslAttitude.fuse(sample.gyro, accel, field, (uint32_t)periodUs);
+        auto middle = std::chrono::steady_clock::now();
+        reference.fuse(sample.gyro, accel, field, (uint32_t)periodUs);
+        auto end = std::chrono::steady_clock::now();
+        
+        fixedNs  += std::chrono::duration<double, std::nano>(middle - start).count();
+        doubleNs += std::chrono::duration<double, std::nano>(end - middle).count();
+        updates++;
+        
+        if (t >= ATTITUDE_SETTLE_US) {
+            tslAttitude.getQuaternion(quaternion);
+            double deg = angleDeg({ (double)quaternion[0], (double)quaternion[1], (double)quaternion[2], (double)quaternion[3] },
+                                  reference.attitude());
+            maxDeg = std::max(maxDeg, deg);
+            sumDeg += deg;
+            compared++;
+        }
+    }
+    
+    tslAttitude.getQuaternion(quaternion);
+    SimQuaternion fixed = { (double)quaternion[0], (double)quaternion[1], (double)quaternion[2], (double)quaternion[3] };
+    
+    printf("%-14s %9llu %9.3f %9.3f", name, (unsigned long long)updates, maxDeg, compared ? sumDeg / compared : 0.0);
+    if (hasTruth) {
+        printf(" %9.3f %9.3f", angleDeg(fixed, sample.truth), angleDeg(reference.attitude(), sample.truth));
+    } else {
+        printf(" %9s %9s", "-", "-");
+    }
+    printf(" %9.1f %9.1f\n", fixedNs / updates, doubleNs / updates);
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--seconds N] [--seed N]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seconds = 600;
+    uint64_t seed    = 1;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (seconds * 1000000 <= ATTITUDE_SETTLE_US) {
+        usage(argv[0]);
+    }
+    
+    hal::reset();
+    
+    uint64_t durationUs = seconds * 1000000;
+    
+    printf("%-14s %9s %9s %9s %9s %9s %9s %9s\n", "scenario", "updates", "max_deg", "mean_deg",
+           "fixed_err", "ref_err", "fixed_ns", "double_ns");
+    run("ground-rest",   groundScenario({ 0, 0, 0 }, seed),        durationUs, true);
+    run("ground-tumble", groundScenario({ 10, -20, 30 }, seed + 2), durationUs, true);
+    run("orbit-tumble",  orbitScenario({ 2, -3, 5 }),               durationUs, false);
+    
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ *  @file   column_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Compares the batch column decoder's scalar, SSE4.1 and AVX2 paths
+ *          with frame-at-a-time decoding into ScienceValues.
+ *
+ *          A synthetic archive of random science frames is decoded by each
+ *          path; the best of --repeat runs is reported. Every path's columns
+ *          are checked against the scalar path, and the program exits 1 if
+ *          any differ.
+ *
+ *          The gap between the paths depends on the archive size. By default
+ *          two sizes are run: COLUMN_CACHED_FRAMES, whose frames and columns
+ *          stay in the last-level cache, and COLUMN_ARCHIVE_FRAMES, which do
+ *          not. Quote the frame count with any result.
+ *
+ *          usage: column_bench [--frames N] [--repeat N] [--seed N]
+ *
+ *          --frames    run this one archive size instead
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatColumns.h"
+
+
+#define COLUMN_CACHED_FRAMES    100000      ///< 3.8 MB of frames
+#define COLUMN_ARCHIVE_FRAMES   4000000     ///< 152 MB of frames
+
+
+static std::vector<uint8_t> makeArchive(size_t frames, uint32_t seed)
+{
+    std::vector<uint8_t> archive(frames * NSL_PACKET_SIZE);
+    std::mt19937         rng(seed);
+    
+    for (size_t i = 0; i < frames; i++) {
+        uint8_t* f = &archive[i * NSL_PACKET_SIZE];
+        for (size_t b = 0; b < NSL_PACKET_SIZE; b++) {
+            f[b] = rng();
+        }
+        f[0] = f[1] = f[2] = GROUND_HEADER_BYTE;
+        f[GROUND_OFFSET_AGE] = rng() % (GROUND_SAMPLE_AGE_MAX + 1);
+    }
+    return archive;
+}
+
+static double bestSeconds(int repeat, const std::function<void()>& run)
+{
+    double best = 1e30;
+    
+    for (int i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = seconds < best ? seconds : best;
+    }
+    return best;
+}
+
+template <typename T>
+static bool sameColumn(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && !memcmp(a.data(), b.data(), a.size() * sizeof(T));
+}
+
+static bool sameColumns(const ground::ScienceColumns& a, const ground::ScienceColumns& b)
+{
+    bool same = sameColumn(a.met, b.met) && sameColumn(a.sampleAge, b.sampleAge) &&
+                sameColumn(a.bnoCal, b.bnoCal) && sameColumn(a.pressure, b.pressure) &&
+                sameColumn(a.temperature, b.temperature) && sameColumn(a.tslTempExt, b.tslTempExt) &&
+                sameColumn(a.tslVolts, b.tslVolts) && sameColumn(a.tslCurrent, b.tslCurrent) &&
+                sameColumn(a.solar, b.solar);
+    for (int k = 0; k < 4; k++) {
+        same = same && sameColumn(a.quat[k], b.quat[k]);
+    }
+    for (int k = 0; k < 3; k++) {
+        same = same && sameColumn(a.bnomag[k], b.bnomag[k]) && sameColumn(a.tslMag[k], b.tslMag[k]);
+    }
+    return same;
+}
+
+static void report(const char* name, double seconds, size_t frames, double baseline)
+{
+    printf("%-16s %8.2f ns/frame %9.1f MB/s %8.2fx\n", name, seconds * 1e9 / frames,
+           frames * NSL_PACKET_SIZE / seconds / 1e6, baseline / seconds);
+}
+
+/*!
+ * @brief Decodes one archive size by every path
+ *
+ * @return false if a path's columns differ from the scalar path's
+ */
+static bool runArchive(size_t frames, int repeat, uint32_t seed)
+{
+    std::vector<uint8_t> archive = makeArchive(frames, seed);
+    const uint8_t*       data    = archive.data();
+    
+    printf("frames           %zu (%.1f MB)\n", frames, archive.size() / 1e6);
+    
+    // Frame at a time into an array of structs
+    std::vector<ground::ScienceValues> rows(frames);
+    double rowSeconds = bestSeconds(repeat, [&]() {
+        ground::ScienceRecord record;
+        for (size_t i = 0; i < frames; i++) {
+            ground::decodeScience(&data[i * NSL_PACKET_SIZE], record);
+            ground::scaleScience(record, rows[i]);
+        }
+    });
+    report("records", rowSeconds, frames, rowSeconds);
+    
+    ground::ScienceColumns reference;
+    reference.resize(frames);
+    ground::decodeColumns(data, frames, reference, 0, ground::DecodeScalar);
+    
+    bool ok = true;
+    for (ground::DecodePath path : {ground::DecodeScalar, ground::DecodeSSE41, ground::DecodeAVX2}) {
+        if (path > ground::getBestDecodePath()) {
+            printf("%-16s not supported\n", ground::getDecodePathName(path));
+            continue;
+        }
+        
+        ground::ScienceColumns columns;
+        columns.resize(frames);
+        double seconds = bestSeconds(repeat, [&]() {
+            ground::decodeColumns(data, frames, columns, 0, path);
+        });
+        report(ground::getDecodePathName(path), seconds, frames, rowSeconds);
+        
+        if (!sameColumns(columns, reference)) {
+            printf("%-16s columns differ from the scalar path\n", ground::getDecodePathName(path));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    size_t   frames = 0;
+    int      repeat = 5;
+    uint32_t seed   = 1;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+            if (frames == 0) {
+                fprintf(stderr, "%s: --frames must be positive\n", argv[0]);
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--frames N] [--repeat N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (repeat < 1) {
+        fprintf(stderr, "%s: --repeat must be positive\n", argv[0]);
+        return 2;
+    }
+    
+    printf("best path        %s\n\n", ground::getDecodePathName(ground::getBestDecodePath()));
+    if (frames) {
+        return runArchive(frames, repeat, seed) ? 0 : 1;
+    }
+    
+    bool ok = runArchive(COLUMN_CACHED_FRAMES, repeat, seed);
+    printf("\n");
+    ok = runArchive(COLUMN_ARCHIVE_FRAMES, repeat, seed) && ok;
+    return ok ? 0 : 1;
+}
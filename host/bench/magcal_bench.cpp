@@ -0,0 +1,331 @@
+/**
+ *  @file   magcal_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Convergence of the streaming magnetometer calibrator on a
+ *          distorted AK8963.
+ *
+ *          The simulated board's AK8963 is given a random hard-iron offset
+ *          and soft-iron gains, and tumbles through SimOrbit. Every 8 Hz
+ *          result is read with TSLPB::readMagnetometerBurst() and fed to
+ *          tslMagCalibrator. Each reporting interval prints the angle between
+ *          the measured and the true field, raw and corrected, and the spread
+ *          of the field magnitude (standard deviation over mean). At the end
+ *          the calibrator is restarted as after a reset, to check that the
+ *          calibration comes back from EEPROM, and the EEPROM wear is
+ *          reported.
+ *
+ *          --sweep instead runs every rate of a fixed set, for three seeds,
+ *          once with an undistorted AK8963 and once with the --iron
+ *          distortion, and prints one row per pair: the mean angle error of
+ *          the last interval, raw and corrected, and the worst interval by
+ *          which the calibrator made the undistorted sensor worse. It exits
+ *          with 1 if that exceeds MAGCAL_DEGRADE_LIMIT_DEG.
+ *
+ *          usage: magcal_bench [--seconds N] [--report N] [--rate X Y Z]
+ *                              [--iron OFFSET GAIN] [--seed N] [--sweep]
+ *
+ *          --seconds   simulated time (default 11040, two orbits)
+ *          --report    seconds per printed interval (default 600)
+ *          --rate      body rate in deg/s (default 2 -3 5)
+ *          --iron      largest offset in uT and gain error of each axis
+ *                      (default 40 0.15); 0 0 for an undistorted AK8963
+ *          --sweep     run the rate and seed sweep
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "TSLPB_MagCalibrator.h"
+#include "SimOrbit.h"
+#include "SimTslpbBoard.h"
+
+using sim::SimVector3;
+
+
+#define MAGCAL_COUNTS_PER_UT        (1 / 0.15)  ///< AK8963 16-bit output
+#define MAGCAL_DEGRADE_LIMIT_DEG    0.05        ///< Largest tolerated loss on an undistorted AK8963
+#define MAGCAL_SWEEP_SEEDS          3           ///< Seeds per rate in --sweep
+
+
+/*!
+ * @brief   Running angle and magnitude statistics of one reporting interval
+ */
+typedef struct
+{
+    double      sumDeg;
+    double      maxDeg;
+    double      sumLength;
+    double      sumLengthSquared;
+    uint32_t    count;
+} Interval;
+
+/*!
+ * @brief   One simulated run
+ */
+typedef struct
+{
+    uint64_t    seconds;
+    uint64_t    report;
+    uint64_t    seed;
+    SimVector3  rate;           ///< Body rate, deg/s
+    double      maxIron;        ///< Largest hard-iron offset, uT
+    double      maxGain;        ///< Largest soft-iron gain error
+    bool        verbose;        ///< Print every interval and the fit
+} BenchRun;
+
+/*!
+ * @brief   Outcome of one run
+ */
+typedef struct
+{
+    double      rawDeg;         ///< Mean angle error of the last interval, uncorrected
+    double      calDeg;         ///< .. and corrected
+    double      worstLossDeg;   ///< Largest corrected less uncorrected interval mean
+    bool        calibrated;
+} BenchResult;
+
+static const SimVector3 sweepRates[] = {
+    {  2,   -3,   5   },
+    {  1,    1,   1   },
+    {  0.5, -0.2, 0.1 },
+    { 10,    0,   0   },
+    {  0,    0,   3   },
+    { -4,    1,   0.5 },
+};
+
+static double length(const double v[3])
+{
+    return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+static void accumulate(Interval& interval, const double measured[3], const double truth[3])
+{
+    double dot = measured[0] * truth[0] + measured[1] * truth[1] + measured[2] * truth[2];
+    double cosine = dot / (length(measured) * length(truth));
+    double deg = acos(fmax(-1.0, fmin(1.0, cosine))) * 180 / M_PI;
+    
+    interval.sumDeg           += deg;
+    interval.maxDeg            = fmax(interval.maxDeg, deg);
+    interval.sumLength        += length(measured);
+    interval.sumLengthSquared += length(measured) * length(measured);
+    interval.count++;
+}
+
+static void printInterval(double seconds, const Interval& raw, const Interval& corrected)
+{
+    const Interval* both[2] = { &raw, &corrected };
+    
+    printf("%9.0f %7u", seconds, corrected.count);
+    for (int i = 0; i < 2; i++) {
+        const Interval& s = *both[i];
+        double mean   = s.count ? s.sumLength / s.count : 0;
+        double spread = s.count ? sqrt(fmax(0.0, s.sumLengthSquared / s.count - mean * mean)) / mean : 0;
+        printf(" %9.2f %9.2f %9.4f", s.count ? s.sumDeg / s.count : 0.0, s.maxDeg, spread);
+    }
+    printf(" %4s\n", tslMagCalibrator.isCalibrated() ? "yes" : "no");
+}
+
+static double meanDeg(const Interval& interval)
+{
+    return interval.count ? interval.sumDeg / interval.count : 0.0;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--seconds N] [--report N] [--rate X Y Z] [--iron OFFSET GAIN] [--seed N] [--sweep]\n",
+            program);
+    exit(2);
+}
+
+/*!
+ * @brief Runs one distorted AK8963 through the orbit from a blank EEPROM
+ */
+static BenchResult runBench(const BenchRun& run)
+{
+    // By default a few tens of µT of board magnetism and up to 15 % gain error
+    std::mt19937_64 rng(run.seed);
+    std::uniform_real_distribution<double> offset(-run.maxIron, run.maxIron);
+    std::uniform_real_distribution<double> gain(1 - run.maxGain, 1 + run.maxGain);
+    SimVector3 ironOffset = { offset(rng), offset(rng), offset(rng) };
+    SimVector3 ironGain   = { gain(rng), gain(rng), gain(rng) };
+    
+    sim::SimOrbitConfig config = sim::simDefaultOrbitConfig;
+    config.bodyRateDps = run.rate;
+    
+    sim::SimTslpbBoard board;
+    sim::SimOrbit      orbit(config);
+    
+    TSLPB_MagCalibration_t identity = { { 0, 0, 0 }, { TSL_MAG_SCALE_ONE, TSL_MAG_SCALE_ONE, TSL_MAG_SCALE_ONE } };
+    
+    hal::reset();
+    hal::eraseEeprom();
+    board.attach();
+    orbit.attach(board, NULL, NULL);
+    board.mag.setIronDistortion(ironOffset, ironGain);
+    
+    tslpb.begin();
+    tslpb.setMagCalibration(identity);
+    tslMagCalibrator.begin(tslpb);
+    
+    if (run.verbose) {
+        printf("offset uT  %8.2f %8.2f %8.2f\n", ironOffset.x, ironOffset.y, ironOffset.z);
+        printf("gain       %8.4f %8.4f %8.4f\n", ironGain.x, ironGain.y, ironGain.z);
+        printf("%9s %7s %9s %9s %9s %9s %9s %9s %4s\n", "seconds", "samples",
+               "raw_deg", "raw_max", "raw_sprd", "cal_deg", "cal_max", "cal_sprd", "cal");
+    }
+    
+    BenchResult result = {};
+    uint64_t durationUs = run.seconds * 1000000;
+    uint64_t reportUs   = run.report * 1000000;
+    uint64_t nextReport = reportUs;
+    Interval raw        = {};
+    Interval corrected  = {};
+    
+    while (hal::now() < durationUs) {
+        int16_t field[3];
+        if (!tslpb.readMagnetometerBurst(field, true)) {
+            continue;
+        }
+        
+        // The result was just stored; the field at read time is close enough
+        SimVector3 truth    = orbit.fieldMagnetometer(hal::now());
+        double     t[3]     = { truth.x, truth.y, truth.z };
+        double     r[3]     = { (double)field[0], (double)field[1], (double)field[2] };
+        
+        tslMagCalibrator.sample(field);
+        tslpb.correctMagnetometer(field);
+        
+        double     c[3]     = { (double)field[0], (double)field[1], (double)field[2] };
+        accumulate(raw, r, t);
+        accumulate(corrected, c, t);
+        
+        if (hal::now() >= nextReport) {
+            if (run.verbose) {
+                printInterval(nextReport / 1e6, raw, corrected);
+            }
+            result.rawDeg       = meanDeg(raw);
+            result.calDeg       = meanDeg(corrected);
+            result.worstLossDeg = fmax(result.worstLossDeg, result.calDeg - result.rawDeg);
+            raw        = {};
+            corrected  = {};
+            nextReport += reportUs;
+        }
+    }
+    result.calibrated = tslMagCalibrator.isCalibrated();
+    if (!run.verbose) {
+        return result;
+    }
+    
+    // Truth in the calibrator's terms: offset in counts, gains relative to their mean
+    const TSLPB_MagCalibration_t& fitted = tslpb.getMagCalibration();
+    double meanGain = (ironGain.x + ironGain.y + ironGain.z) / 3;
+    double offsets[3] = { ironOffset.x, ironOffset.y, ironOffset.z };
+    double gains[3]   = { ironGain.x, ironGain.y, ironGain.z };
+    
+    printf("\n%-6s %10s %10s %10s %10s\n", "axis", "offset", "true", "scale", "true");
+    for (int axis = 0; axis < 3; axis++) {
+        printf("%-6c %10d %10.1f %10.4f %10.4f\n", 'x' + axis, fitted.offset[axis],
+               offsets[axis] * MAGCAL_COUNTS_PER_UT, (double)fitted.scale[axis] / TSL_MAG_SCALE_ONE,
+               meanGain / gains[axis]);
+    }
+    
+    // As after a reset: the read path starts uncorrected until begin() restores it
+    TSLPB_MagCalibration_t before = fitted;
+    tslpb.setMagCalibration(identity);
+    bool restored = tslMagCalibrator.begin(tslpb);
+    bool same     = restored && !memcmp(&tslpb.getMagCalibration(), &before, sizeof(before));
+    
+    hal::EepromStats& eeprom = hal::eepromStats();
+    printf("\nrestored from EEPROM: %s%s\n", restored ? "yes" : "no",
+           restored && !same ? " (older than the applied calibration)" : "");
+    printf("EEPROM bytes written %llu, busy %.1f ms\n",
+           (unsigned long long)eeprom.bytesWritten, eeprom.busyTimeUs / 1000.0);
+    
+    return result;
+}
+
+/*!
+ * @brief Runs every sweep rate and seed, undistorted and distorted
+ *
+ * @return false if the calibrator made an undistorted AK8963 worse
+ */
+static bool runSweep(BenchRun run)
+{
+    double worstLoss = 0;
+    
+    printf("%-18s %4s %9s %9s %9s %9s %9s %4s\n", "rate_dps", "seed",
+           "clean_raw", "clean_cal", "worst", "iron_raw", "iron_cal", "cal");
+    for (size_t i = 0; i < sizeof(sweepRates) / sizeof(sweepRates[0]); i++) {
+        for (uint64_t seed = 1; seed <= MAGCAL_SWEEP_SEEDS; seed++) {
+            BenchRun clean = run;
+            clean.rate    = sweepRates[i];
+            clean.seed    = seed;
+            clean.maxIron = 0;
+            clean.maxGain = 0;
+            BenchResult undistorted = runBench(clean);
+            
+            BenchRun iron = clean;
+            iron.maxIron  = run.maxIron;
+            iron.maxGain  = run.maxGain;
+            BenchResult distorted = runBench(iron);
+            
+            // Three %g of up to 13 characters each, two spaces and the NUL
+            char label[3 * 13 + 3];
+            snprintf(label, sizeof(label), "%g %g %g", sweepRates[i].x, sweepRates[i].y, sweepRates[i].z);
+            printf("%-18s %4llu %9.2f %9.2f %9.2f %9.2f %9.2f %4s\n", label, (unsigned long long)seed,
+                   undistorted.rawDeg, undistorted.calDeg, undistorted.worstLossDeg,
+                   distorted.rawDeg, distorted.calDeg, distorted.calibrated ? "yes" : "no");
+            worstLoss = fmax(worstLoss, undistorted.worstLossDeg);
+        }
+    }
+    
+    printf("\nworst loss on an undistorted AK8963: %.3f deg (limit %.2f)\n", worstLoss, MAGCAL_DEGRADE_LIMIT_DEG);
+    return worstLoss <= MAGCAL_DEGRADE_LIMIT_DEG;
+}
+
+int main(int argc, char** argv)
+{
+    BenchRun run = { 11040, 600, 1, { 2, -3, 5 }, 40, 0.15, true };
+    bool     sweep = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            run.seconds = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--report") && i + 1 < argc) {
+            run.report = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--rate") && i + 3 < argc) {
+            run.rate.x = atof(argv[++i]);
+            run.rate.y = atof(argv[++i]);
+            run.rate.z = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--iron") && i + 2 < argc) {
+            run.maxIron = atof(argv[++i]);
+            run.maxGain = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            run.seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--sweep")) {
+            sweep = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (run.seconds == 0 || run.report == 0 || run.maxIron < 0 || run.maxGain < 0 || run.maxGain >= 1) {
+        usage(argv[0]);
+    }
+    
+    if (sweep) {
+        run.verbose = false;
+        return runSweep(run) ? 0 : 1;
+    }
+    runBench(run);
+    return 0;
+}
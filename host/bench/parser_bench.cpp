@@ -0,0 +1,197 @@
+/**
+ *  @file   parser_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Throughput of the ground frame parsers on clean and adversarial
+ *          downlink streams.
+ *
+ *          Each stream is parsed by FrameScanner and FrameSynchronizer, both
+ *          in one call and in the pieces a read() loop hands them, and by
+ *          the scanner followed by decodeScience() and scaleScience() on
+ *          every science frame. The best of --repeat runs is reported in
+ *          MB/s of input, and every path's rate on each stream is compared
+ *          with its rate on clean frames so a slow path on pathological
+ *          input stands out.
+ *
+ *          usage: parser_bench [--frames N] [--repeat N] [--seed N] [--min-ratio R]
+ *
+ *          --frames    frames per stream (default 1000000)
+ *          --repeat    runs per measurement (default 3)
+ *          --min-ratio exit 1 if any path runs slower than R times its
+ *                      clean-stream rate on any stream (default: no check)
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatSync.h"
+#include "ThinSatFuzzStreams.h"
+
+
+#define PARSER_BENCH_PIECE      4096    ///< Bytes per call for the piecewise paths, a typical read()
+
+
+typedef struct
+{
+    std::string             name;
+    std::vector<uint8_t>    data;
+} Stream;
+
+typedef struct
+{
+    const char*     name;
+    std::function<uint64_t(uint8_t* data, size_t length)>  run;     ///< Returns the frames delivered
+} Path;
+
+
+static uint64_t scanAll(uint8_t* data, size_t length, size_t piece, bool decode)
+{
+    ground::FrameScanner  scanner;
+    ground::ScienceRecord record;
+    ground::ScienceValues values;
+    
+    auto handler = [&](const uint8_t* frame) {
+        if (decode && ground::getFrameKind(frame) == ground::FrameScience) {
+            ground::decodeScience(frame, record);
+            ground::scaleScience(record, values);
+        }
+    };
+    for (size_t pos = 0; pos < length; pos += piece) {
+        scanner.scan(&data[pos], std::min(piece, length - pos), handler);
+    }
+    scanner.finish(handler);
+    return scanner.getStats().frames;
+}
+
+/*!
+ * @brief   Synchronizes in place: each call sees the bytes the last one left
+ *          plus the next piece, as the synchronizer's ring does
+ */
+static uint64_t syncAll(uint8_t* data, size_t length, size_t piece)
+{
+    ground::FrameSynchronizer sync;
+    size_t                    start = 0;
+    
+    for (size_t end = std::min(piece, length); ; end = std::min(end + piece, length)) {
+        start += sync.process(&data[start], end - start, end == length, [](const uint8_t*) {});
+        if (end == length) {
+            break;
+        }
+    }
+    return sync.getStats().frames;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--frames N] [--repeat N] [--seed N] [--min-ratio R]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    size_t   frames   = 1000000;
+    int      repeat   = 3;
+    uint64_t seed     = 1;
+    double   minRatio = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--min-ratio") && i + 1 < argc) {
+            minRatio = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (frames == 0 || repeat < 1) {
+        usage(argv[0]);
+    }
+    
+    size_t               length = frames * NSL_PACKET_SIZE;
+    std::vector<uint8_t> clean  = fuzz::makeFrames(frames, seed);
+    
+    std::vector<Stream> streams = {
+        { "clean",          clean },
+        { "bitflip",        fuzz::corrupt(clean, fuzz::bitFlipCorruption, seed + 1) },
+        { "slip",           fuzz::corrupt(clean, fuzz::slipCorruption, seed + 2) },
+        { "preamble",       fuzz::corrupt(clean, fuzz::preambleCorruption, seed + 3) },
+        { "mixed",          fuzz::corrupt(clean, fuzz::mixedCorruption, seed + 4) },
+        { "noise",          fuzz::makeNoise(length, seed + 5) },
+        { "flood",          fuzz::makeHeaderFlood(length, 1) },
+        { "flood-short",    fuzz::makeHeaderFlood(length, NSL_PACKET_SIZE - 1) },
+        { "flood-long",     fuzz::makeHeaderFlood(length, NSL_PACKET_SIZE + 1) },
+    };
+    
+    std::vector<Path> paths = {
+        { "scan",       [](uint8_t* d, size_t n) { return scanAll(d, n, n, false); } },
+        { "scan-4k",    [](uint8_t* d, size_t n) { return scanAll(d, n, PARSER_BENCH_PIECE, false); } },
+        { "decode",     [](uint8_t* d, size_t n) { return scanAll(d, n, n, true); } },
+        { "sync",       [](uint8_t* d, size_t n) { return syncAll(d, n, n); } },
+        { "sync-4k",    [](uint8_t* d, size_t n) { return syncAll(d, n, PARSER_BENCH_PIECE); } },
+    };
+    
+    printf("frames           %zu per stream (%.1f MB)\n\n", frames, length / 1e6);
+    printf("%-14s %10s %10s", "stream", "scanned", "synced");
+    for (const Path& path : paths) {
+        printf(" %10s", path.name);
+    }
+    printf("   (MB/s)\n");
+    
+    std::vector<double>  cleanRate(paths.size());
+    std::vector<uint8_t> work;
+    int                  cliffs = 0;
+    
+    for (const Stream& stream : streams) {
+        std::vector<double>   rate(paths.size());
+        std::vector<uint64_t> found(paths.size());
+        
+        for (size_t p = 0; p < paths.size(); p++) {
+            double best = 1e30;
+            for (int r = 0; r < repeat; r++) {
+                // The synchronizer repairs headers in place
+                work = stream.data;
+                auto start = std::chrono::steady_clock::now();
+                found[p] = paths[p].run(work.data(), work.size());
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            rate[p] = stream.data.size() / best / 1e6;
+        }
+        if (stream.name == "clean") {
+            cleanRate = rate;
+        }
+        
+        printf("%-14s %10llu %10llu", stream.name.c_str(), (unsigned long long)found[0], (unsigned long long)found[3]);
+        for (size_t p = 0; p < paths.size(); p++) {
+            printf(" %10.1f", rate[p]);
+        }
+        printf("\n");
+        
+        for (size_t p = 0; p < paths.size(); p++) {
+            if (rate[p] < minRatio * cleanRate[p]) {
+                fprintf(stderr, "cliff     %-14s %-10s %.1f MB/s, %.2fx clean\n", stream.name.c_str(),
+                        paths[p].name, rate[p], rate[p] / cleanRate[p]);
+                cliffs++;
+            }
+        }
+    }
+    
+    if (cliffs) {
+        fprintf(stderr, "%d cliff%s below %.2fx clean\n", cliffs, cliffs == 1 ? "" : "s", minRatio);
+    }
+    return cliffs ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/**
+ *  @file   quat_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Precision and exactness of the smallest-three quaternion packing.
+ *
+ *          Random unit quaternions are rounded to the BNO055's Q14 counts,
+ *          packed by tslPackQuaternion() and unpacked by the ground decoder.
+ *          The angle to the original is compared with that of the old
+ *          int16_t * 1000 fields, and each unpacked quaternion is packed
+ *          again to count those that do not give back the same code (the
+ *          frames thinsat_replay cannot reproduce). Then the ground
+ *          decoder's unpackQuaternion() is checked against the firmware's
+ *          tslUnpackQuaternion(), over every 32-bit code with --exhaustive.
+ *
+ *          usage: quat_bench [--samples N] [--seed N] [--exhaustive]
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "TSLPB_Quaternion.h"
+
+
+/*!
+ * @brief   Angle error statistics of one encoding
+ */
+typedef struct
+{
+    double      sumDeg;
+    double      maxDeg;
+} Errors;
+
+static double angleDeg(const double a[4], const double b[4])
+{
+    double dot = 0, normA = 0, normB = 0;
+    for (int i = 0; i < 4; i++) {
+        dot   += a[i] * b[i];
+        normA += a[i] * a[i];
+        normB += b[i] * b[i];
+    }
+    return 2 * acos(std::min(1.0, fabs(dot) / sqrt(normA * normB))) * 180 / M_PI;
+}
+
+static void accumulate(Errors& errors, const double truth[4], const double decoded[4])
+{
+    double deg = angleDeg(truth, decoded);
+    errors.sumDeg += deg;
+    errors.maxDeg  = std::max(errors.maxDeg, deg);
+}
+
+/*!
+ * @brief   Compares the two unpackers over codes first, first + stride, ...
+ *          below last, and returns the number that differ
+ */
+static uint64_t compareRange(uint64_t first, uint64_t last, uint64_t stride)
+{
+    uint64_t differing = 0;
+    
+    for (uint64_t code = first; code < last; code += stride) {
+        int16_t firmware[4], ground[4];
+        tslUnpackQuaternion((uint32_t)code, firmware);
+        ground::unpackQuaternion((uint32_t)code, ground);
+        differing += memcmp(firmware, ground, sizeof(firmware)) != 0;
+    }
+    return differing;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--samples N] [--seed N] [--exhaustive]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t samples    = 1000000;
+    uint64_t seed       = 1;
+    bool     exhaustive = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+            samples = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--exhaustive")) {
+            exhaustive = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (samples == 0) {
+        usage(argv[0]);
+    }
+    
+    std::mt19937_64                  rng(seed);
+    std::normal_distribution<double> normal;
+    Errors                           packed      = {};
+    Errors                           legacy      = {};
+    uint64_t                         notRepeated = 0;
+    
+    for (uint64_t n = 0; n < samples; n++) {
+        double truth[4], length = 0;
+        for (int i = 0; i < 4; i++) {
+            truth[i] = normal(rng);
+            length  += truth[i] * truth[i];
+        }
+        
+        int16_t counts[4];
+        double  old[4];
+        for (int i = 0; i < 4; i++) {
+            truth[i] /= sqrt(length);
+            counts[i] = (int16_t)lround(truth[i] * TSL_QUAT_ONE);
+            old[i]    = (int16_t)(truth[i] * 1000) / 1000.0;    // The sketch's former encoding
+        }
+        
+        uint32_t code = tslPackQuaternion(counts);
+        int16_t  unpacked[4];
+        double   decoded[4];
+        ground::unpackQuaternion(code, unpacked);
+        for (int i = 0; i < 4; i++) {
+            decoded[i] = unpacked[i] / GROUND_QUAT_SCALE;
+        }
+        
+        accumulate(packed, truth, decoded);
+        accumulate(legacy, truth, old);
+        notRepeated += tslPackQuaternion(unpacked) != code;
+    }
+    
+    printf("%-22s %10s %10s %6s\n", "encoding", "mean_deg", "max_deg", "bytes");
+    printf("%-22s %10.4f %10.4f %6d\n", "int16_t * 1000", legacy.sumDeg / samples, legacy.maxDeg, 8);
+    printf("%-22s %10.4f %10.4f %6d\n", "smallest-three 2+3x10", packed.sumDeg / samples, packed.maxDeg, 4);
+    printf("\nrepacked differently  %llu of %llu\n", (unsigned long long)notRepeated, (unsigned long long)samples);
+    
+    // Firmware against ground unpacking
+    uint64_t total   = exhaustive ? (1ULL << 32) : samples;
+    uint64_t stride  = exhaustive ? 1 : (1ULL << 32) / samples | 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<uint64_t>    differing(0);
+    std::vector<std::thread> workers;
+    
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            uint64_t span  = (total + threads - 1) / threads;
+            uint64_t first = t * span;
+            uint64_t last  = std::min(total, first + span);
+            if (!exhaustive) {
+                first = first * stride;
+                last  = last * stride;
+            }
+            differing += compareRange(first, std::min<uint64_t>(last, 1ULL << 32), stride);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    
+    printf("unpack mismatches     %llu of %llu codes%s\n", (unsigned long long)differing.load(),
+           (unsigned long long)total, exhaustive ? "" : " (--exhaustive for all)");
+    
+    return differing.load() ? 1 : 0;
+}
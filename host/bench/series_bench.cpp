@@ -0,0 +1,358 @@
+/**
+ *  @file   series_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Compression and cost of the high-rate series codec, and a bit-exact
+ *          check of the ground decoder against the firmware encoder.
+ *
+ *          Each source is captured by tslSeriesCapture on the simulated board
+ *          in orbit (SimOrbit, --rate tumble) with sensor noise added to the
+ *          orbit's field, acceleration and rate, and the frames the Mothership
+ *          received are decoded with ground::decodeSeries() and compared
+ *          sample by sample with what the encoder was given. A white noise
+ *          series over the full int16_t range is coded directly to exercise
+ *          the escape codes.
+ *
+ *          Reported are the samples per frame, the ratio to raw int16_t
+ *          samples (6 bytes each in the same 26 bytes), the bits per axis
+ *          sample, and host time per sample to encode and to decode. Cycles
+ *          on the Pro Mini have to be measured on the payload; host time
+ *          only ranks changes to the arithmetic.
+ *
+ *          usage: series_bench [--samples N] [--period MS] [--rate DPS] [--repeat N] [--seed N]
+ *
+ *          --samples   samples per capture (default 2000)
+ *          --period    sample period in ms (default 10)
+ *          --rate      tumble rate about each body axis (default 3)
+ *
+ *          Exits 1 if any sample decodes differently or is missing.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "TSLPB_SeriesCodec.h"
+#include "SimOrbit.h"
+#include "SimMothership.h"
+#include "ThinSatDecoder.h"
+
+using sim::SimVector3;
+
+
+#define SERIES_MAG_NOISE_UT     0.3         ///< AK8963 noise, about 2 LSB
+#define SERIES_ACCEL_NOISE_G    0.003       ///< MPU-9250 300 ug/rtHz over 100 Hz
+#define SERIES_GYRO_NOISE_DPS   0.1         ///< MPU-9250 0.01 dps/rtHz over 100 Hz
+#define SERIES_RAW_SAMPLES      (TSL_SERIES_FRAME_BYTES / (2 * TSL_SERIES_AXES))
+#define SERIES_TIMED_SAMPLES    1000000     ///< Samples per timed run
+
+
+typedef struct
+{
+    int16_t     axis[TSL_SERIES_AXES];
+} Sample;
+
+typedef struct
+{
+    size_t      samples;        ///< Samples coded
+    size_t      frames;         ///< Frames sent
+    size_t      mismatches;     ///< Decoded samples that differ
+    size_t      missing;        ///< Coded samples not decoded
+} RoundTrip;
+
+static std::vector<Sample> sunk;   ///< Samples given to the encoder by the capture
+
+
+static void sinkSample(const int16_t sample[TSL_SERIES_AXES])
+{
+    Sample s;
+    memcpy(s.axis, sample, sizeof(s.axis));
+    sunk.push_back(s);
+}
+
+static double bestSeconds(int repeat, const std::function<void()>& run)
+{
+    double best = 1e30;
+    
+    for (int i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = seconds < best ? seconds : best;
+    }
+    return best;
+}
+
+/*!
+ * @brief   Decodes series frames and compares them with the coded samples,
+ *          indexed by sequence
+ */
+static void compare(const std::vector<const uint8_t*>& frames, const std::vector<Sample>& reference,
+                    RoundTrip& result)
+{
+    std::vector<bool> seen(reference.size(), false);
+    
+    for (const uint8_t* frame : frames) {
+        ground::SeriesRecord record;
+        
+        if (!ground::decodeSeries(frame, record)) {
+            result.mismatches++;
+        }
+        for (int i = 0; i < record.count; i++) {
+            size_t index = record.sequence + i;
+            if (index >= reference.size() || memcmp(record.samples[i], reference[index].axis, sizeof(Sample))) {
+                result.mismatches++;
+                continue;
+            }
+            seen[index] = true;
+        }
+    }
+    for (bool decoded : seen) {
+        result.missing += decoded ? 0 : 1;
+    }
+    result.samples = reference.size();
+    result.frames  = frames.size();
+}
+
+/*!
+ * @brief   Codes samples with a bare encoder, as the capture does, into
+ *          frames ready for the ground decoder
+ */
+static void encode(const std::vector<Sample>& samples, std::vector<ThinsatPacket_t>& frames)
+{
+    TSLPB_SeriesEncoder encoder;
+    ThinsatPacket_t     frame;
+    uint8_t             header[] = NSL_PACKET_HEADER;
+    size_t              first    = 0;
+    
+    frames.clear();
+    encoder.reset();
+    memset(&frame, 0, sizeof(frame));
+    encoder.openFrame(frame);
+    
+    for (size_t i = 0; i <= samples.size(); i++) {
+        if (i < samples.size() && encoder.add(frame, samples[i].axis)) {
+            continue;
+        }
+        memcpy(frame.seriesData.header, header, NSL_PACKET_HEADER_LENGTH);
+        frame.seriesData.sequence = first;
+        frames.push_back(frame);
+        if (i < samples.size()) {
+            first = i;
+            encoder.openFrame(frame);
+            encoder.add(frame, samples[i].axis);
+        }
+    }
+}
+
+/*!
+ * @brief   Best host time per sample to encode and to decode the samples
+ */
+static void timeCodec(const std::vector<Sample>& samples, int repeat, double& encodeNs, double& decodeNs)
+{
+    std::vector<ThinsatPacket_t> frames;
+    size_t passes = (SERIES_TIMED_SAMPLES + samples.size() - 1) / samples.size();
+    
+    double encodeSeconds = bestSeconds(repeat, [&]() {
+        for (size_t pass = 0; pass < passes; pass++) {
+            encode(samples, frames);
+        }
+    });
+    
+    volatile int checksum = 0;
+    double decodeSeconds  = bestSeconds(repeat, [&]() {
+        ground::SeriesRecord record;
+        for (size_t pass = 0; pass < passes; pass++) {
+            for (const ThinsatPacket_t& frame : frames) {
+                ground::decodeSeries(frame.NSLPacket, record);
+                checksum += record.samples[0][0];
+            }
+        }
+    });
+    
+    encodeNs = encodeSeconds * 1e9 / (passes * samples.size());
+    decodeNs = decodeSeconds * 1e9 / (passes * samples.size());
+}
+
+static void report(const char* name, const RoundTrip& result, double encodeNs, double decodeNs)
+{
+    double perFrame = result.frames ? (double)result.samples / result.frames : 0;
+    double bits     = result.samples ? 8.0 * TSL_SERIES_FRAME_BYTES * result.frames /
+                                       (TSL_SERIES_AXES * result.samples) : 0;
+    
+    printf("%-14s %8zu %7zu %9.2f %7.2fx %8.2f %9.1f %9.1f %8zu %8zu\n", name, result.samples, result.frames,
+           perFrame, perFrame / SERIES_RAW_SAMPLES, bits, encodeNs, decodeNs, result.mismatches, result.missing);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Sources                     │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   One capture through the firmware, the simulated board and the
+ *          Mothership
+ */
+static RoundTrip runCapture(TSLPB_SeriesSource_t source, uint16_t samples, uint8_t periodMs,
+                            double rateDps, uint32_t seed)
+{
+    sim::SimOrbitConfig config = sim::simDefaultOrbitConfig;
+    config.bodyRateDps = { rateDps, -rateDps, rateDps };
+    
+    sim::SimTslpbBoard  board;
+    sim::SimMothership  nsl;
+    sim::SimOrbit       orbit(config);
+    std::mt19937        rng(seed);
+    std::normal_distribution<double> gaussian(0, 1);
+    
+    hal::reset();
+    board.attach();
+    orbit.attach(board, NULL, NULL);
+    nsl.attach();
+    nsl.setAlwaysReady();
+    
+    board.mag.setFieldProvider([&](uint64_t t) {
+        SimVector3 field = orbit.fieldMagnetometer(t);
+        return SimVector3{ field.x + SERIES_MAG_NOISE_UT * gaussian(rng),
+                           field.y + SERIES_MAG_NOISE_UT * gaussian(rng),
+                           field.z + SERIES_MAG_NOISE_UT * gaussian(rng) };
+    });
+    board.imu.setAccelerationProvider([&](uint64_t) {
+        return SimVector3{ SERIES_ACCEL_NOISE_G * gaussian(rng),
+                           SERIES_ACCEL_NOISE_G * gaussian(rng),
+                           SERIES_ACCEL_NOISE_G * gaussian(rng) };
+    });
+    board.imu.setAngularRateProvider([&](uint64_t) {
+        SimVector3 rate = orbit.angularRate();
+        return SimVector3{ rate.x + SERIES_GYRO_NOISE_DPS * gaussian(rng),
+                           rate.y + SERIES_GYRO_NOISE_DPS * gaussian(rng),
+                           rate.z + SERIES_GYRO_NOISE_DPS * gaussian(rng) };
+    });
+    
+    sunk.clear();
+    Serial.begin(NSL_BAUD_RATE);
+    tslpb.begin();
+    tslSeriesCapture.begin(tslpb);
+    tslSeriesCapture.setSink(sinkSample);
+    tslSeriesCapture.capture(source, samples, periodMs);
+    tslSeriesCapture.pushReport();
+    tslSeriesCapture.setSink(NULL);
+    
+    std::vector<const uint8_t*> frames;
+    for (const sim::SimNslFrame& frame : nsl.getFrames()) {
+        if (ground::getFrameKind(frame.bytes) == ground::FrameSeries) {
+            frames.push_back(frame.bytes);
+        }
+    }
+    
+    RoundTrip result = {};
+    compare(frames, sunk, result);
+    
+    // A capture ended early by a full frame buffer leaves samples uncoded
+    result.missing += samples - sunk.size();
+    return result;
+}
+
+/*!
+ * @brief   Uniform samples over the full int16_t range, coded directly
+ */
+static std::vector<Sample> whiteNoise(size_t samples, uint32_t seed)
+{
+    std::vector<Sample> series(samples);
+    std::mt19937        rng(seed);
+    
+    for (Sample& sample : series) {
+        for (int axis = 0; axis < TSL_SERIES_AXES; axis++) {
+            sample.axis[axis] = (int16_t)rng();
+        }
+    }
+    return series;
+}
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--samples N] [--period MS] [--rate DPS] [--repeat N] [--seed N]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long samples  = 2000;
+    unsigned long periodMs = 10;
+    double        rateDps  = 3;
+    int           repeat   = 3;
+    uint32_t      seed     = 1;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+            samples = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--period") && i + 1 < argc) {
+            periodMs = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+            rateDps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (samples == 0 || samples > UINT16_MAX || periodMs == 0 || periodMs > UINT8_MAX || repeat < 1) {
+        usage(argv[0]);
+    }
+    
+    static const struct
+    {
+        const char*             name;
+        TSLPB_SeriesSource_t    source;
+    } sources[] = {
+        { "magnetometer",  SeriesMagnetometer },
+        { "accelerometer", SeriesAccelerometer },
+        { "gyroscope",     SeriesGyroscope },
+    };
+    
+    printf("%-14s %8s %7s %9s %8s %8s %9s %9s %8s %8s\n", "series", "samples", "frames", "per_frame",
+           "ratio", "bits", "enc_ns", "dec_ns", "mismatch", "missing");
+    
+    bool ok = true;
+    for (const auto& s : sources) {
+        RoundTrip result = runCapture(s.source, samples, periodMs, rateDps, seed);
+        std::vector<Sample> captured = sunk;
+        double encodeNs = 0, decodeNs = 0;
+        
+        if (!captured.empty()) {
+            timeCodec(captured, repeat, encodeNs, decodeNs);
+        }
+        report(s.name, result, encodeNs, decodeNs);
+        ok = ok && result.samples > 0 && result.mismatches == 0 && result.missing == 0;
+    }
+    
+    std::vector<Sample>          noise = whiteNoise(samples, seed);
+    std::vector<ThinsatPacket_t> coded;
+    std::vector<const uint8_t*>  frames;
+    RoundTrip                    result = {};
+    double                       encodeNs, decodeNs;
+    
+    encode(noise, coded);
+    for (const ThinsatPacket_t& frame : coded) {
+        frames.push_back(frame.NSLPacket);
+    }
+    compare(frames, noise, result);
+    timeCodec(noise, repeat, encodeNs, decodeNs);
+    report("white-noise", result, encodeNs, decodeNs);
+    ok = ok && result.mismatches == 0 && result.missing == 0;
+    
+    return ok ? 0 : 1;
+}
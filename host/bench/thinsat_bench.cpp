@@ -0,0 +1,402 @@
+/**
+ *  @file   thinsat_bench.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Benchmarks every TSLPB API and the VCSFA_ThinSat loop against the
+ *          simulated TSLPB, BNO055, BMP280 and NSL Mothership.
+ *
+ *          For each benchmark the per-call virtual time, I2C bus time,
+ *          blocking time (delays, sleep, and waits on the UART), I2C
+ *          transactions and bytes, serial bytes and host CPU time are
+ *          written as tab-separated values. Everything except host CPU time
+ *          is deterministic, so two result files can be diffed directly or
+ *          with --compare.
+ *
+ *          usage: thinsat_bench [--iterations N] [--loops N] [--output FILE]
+ *                               [--compare BASELINE] [--cpu-tolerance PCT]
+ *
+ *          --iterations    calls per API benchmark (default 200)
+ *          --loops         passes of loop() for the sketch benchmark (default 100)
+ *          --output        write results to FILE instead of stdout
+ *          --compare       compare with a previous result file; exits 1 if
+ *                          any deterministic metric got worse
+ *          --cpu-tolerance host CPU change reported as a warning (default 25)
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "SimTslpbBoard.h"
+#include "SimBNO055.h"
+#include "SimBMP280.h"
+#include "SimMothership.h"
+
+
+#define BENCH_FORMAT_VERSION    1
+#define BENCH_COLUMN_COUNT      9
+
+
+/*!
+ * @brief   Per-call results of one benchmark
+ */
+typedef struct
+{
+    std::string name;
+    uint64_t    calls;
+    double      values[BENCH_COLUMN_COUNT];
+} BenchResult;
+
+/*!
+ * @brief   Result columns. All but the last are deterministic.
+ */
+static const char* columnNames[BENCH_COLUMN_COUNT] = {
+    "virtual_us",           // Virtual time per call
+    "bus_us",               // I2C bus time per call
+    "blocking_us",          // delay(), sleep and UART waits per call
+    "i2c_transactions",     // I2C transactions per call
+    "i2c_bytes_written",    // I2C data bytes written per call
+    "i2c_bytes_read",       // I2C data bytes read per call
+    "i2c_nacks",            // NACKed transactions per call
+    "serial_bytes",         // Serial bytes written per call
+    "host_ns"               // Host CPU time per call
+};
+
+#define BENCH_HOST_NS_COLUMN    (BENCH_COLUMN_COUNT - 1)
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                 Benchmark Harness                │
+ *  └──────────────────────────────────────────────────┘ */
+
+static sim::SimTslpbBoard   board;
+static sim::SimBNO055*      bno = NULL;
+static sim::SimBMP280*      bmp = NULL;
+static sim::SimMothership*  nsl = NULL;
+
+/*!
+ * @brief Resets the HAL and attaches a fresh board, BNO055, BMP280 and
+ * mothership. The environment is fixed so that results only change when the
+ * code does.
+ */
+static void resetEnvironment()
+{
+    delete bno;
+    delete bmp;
+    delete nsl;
+    bno = new sim::SimBNO055();
+    bmp = new sim::SimBMP280();
+    nsl = new sim::SimMothership();
+    
+    hal::reset();
+    board.attach();
+    hal::attachI2cDevice(BNO055_ADDRESS_A, bno);
+    hal::attachI2cDevice(BMP280_ADDRESS, bmp);
+    nsl->attach();
+    
+    for (int i = 0; i < SIM_TSLPB_DT_COUNT; i++) {
+        board.dt[i].setTemperature(18.5 + i);
+    }
+    board.imu.setAngularRate(1.5, -2.25, 12);
+    board.imu.setAcceleration(0.01, -0.02, 0.98);
+    board.mag.setField(21.3, -4.8, 38.6);
+    board.setAnalogSensor(Solar,   612);
+    board.setAnalogSensor(IR,      240);
+    board.setAnalogSensor(TempInt, 410);
+    board.setAnalogSensor(TempExt, 395);
+    board.setAnalogSensor(Current, 143);
+    board.setAnalogSensor(Voltage, 702);
+    bno->setOrientation(0.9239, 0, 0.3827, 0);
+    bno->setField(21.3, -4.8, 38.6);
+    bno->setCalibrationStatus(0xFF);
+    bno->setTemperature(24);
+    bmp->setTemperature(21.5);
+    bmp->setPressure(101325);
+}
+
+/*!
+ * @brief Runs body once per iteration and records the per-call cost
+ */
+static BenchResult measure(const std::string& name, uint64_t iterations, std::function<void()> body)
+{
+    hal::I2cStats       i2c      = hal::i2cStats();
+    hal::SerialStats    serial   = hal::serialStats();
+    hal::BlockingStats  blocking = hal::blockingStats();
+    uint64_t            start    = hal::now();
+    
+    auto cpuStart = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        body();
+    }
+    auto cpuEnd = std::chrono::steady_clock::now();
+    
+    const hal::I2cStats&      i2cEnd      = hal::i2cStats();
+    const hal::SerialStats&   serialEnd   = hal::serialStats();
+    const hal::BlockingStats& blockingEnd = hal::blockingStats();
+    
+    uint64_t blockedUs = (blockingEnd.delayTimeUs - blocking.delayTimeUs)
+                       + (blockingEnd.sleepTimeUs - blocking.sleepTimeUs)
+                       + (serialEnd.txBlockedUs   - serial.txBlockedUs);
+    double   calls     = (double)iterations;
+    
+    BenchResult result;
+    result.name      = name;
+    result.calls     = iterations;
+    result.values[0] = (hal::now() - start) / calls;
+    result.values[1] = (i2cEnd.busTimeUs - i2c.busTimeUs) / calls;
+    result.values[2] = blockedUs / calls;
+    result.values[3] = (i2cEnd.transactions - i2c.transactions) / calls;
+    result.values[4] = (i2cEnd.bytesWritten - i2c.bytesWritten) / calls;
+    result.values[5] = (i2cEnd.bytesRead - i2c.bytesRead) / calls;
+    result.values[6] = (i2cEnd.nacks - i2c.nacks) / calls;
+    result.values[7] = (serialEnd.bytesWritten - serial.bytesWritten) / calls;
+    result.values[BENCH_HOST_NS_COLUMN] =
+        std::chrono::duration<double, std::nano>(cpuEnd - cpuStart).count() / calls;
+    return result;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Benchmarks                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+static const struct { TSLPB_AnalogSensor_t sensor; const char* name; } analogSensors[] = {
+    { Solar, "Solar" }, { IR, "IR" }, { TempInt, "TempInt" },
+    { TempExt, "TempExt" }, { Current, "Current" }, { Voltage, "Voltage" }
+};
+
+static const struct { TSLPB_DigitalSensor_t sensor; const char* name; } digitalSensors[] = {
+    { DT1, "DT1" }, { DT2, "DT2" }, { DT3, "DT3" }, { DT4, "DT4" }, { DT5, "DT5" }, { DT6, "DT6" },
+    { Accelerometer_x, "Accelerometer_x" }, { Accelerometer_y, "Accelerometer_y" },
+    { Accelerometer_z, "Accelerometer_z" }, { Gyroscope_x, "Gyroscope_x" },
+    { Gyroscope_y, "Gyroscope_y" }, { Gyroscope_z, "Gyroscope_z" },
+    { Magnetometer_x, "Magnetometer_x" }, { Magnetometer_y, "Magnetometer_y" },
+    { Magnetometer_z, "Magnetometer_z" }, { IMU_Internal_Temp, "IMU_Internal_Temp" }
+};
+
+static void runApiBenchmarks(std::vector<BenchResult>& results, uint64_t iterations)
+{
+    TSLPB tslpb;
+    
+    for (const auto& entry : analogSensors) {
+        resetEnvironment();
+        tslpb.begin();
+        results.push_back(measure(std::string("readAnalogSensor/") + entry.name, iterations,
+                                  [&] { tslpb.readAnalogSensor(entry.sensor); }));
+    }
+    
+    for (const auto& entry : digitalSensors) {
+        resetEnvironment();
+        tslpb.begin();
+        results.push_back(measure(std::string("readDigitalSensorRaw/") + entry.name, iterations,
+                                  [&] { tslpb.readDigitalSensorRaw(entry.sensor); }));
+    }
+    
+    for (const auto& entry : digitalSensors) {
+        resetEnvironment();
+        tslpb.begin();
+        results.push_back(measure(std::string("readDigitalSensor/") + entry.name, iterations,
+                                  [&] { tslpb.readDigitalSensor(entry.sensor); }));
+    }
+    
+    ThinsatPacket_t packet;
+    memset(&packet, 0, sizeof(packet));
+    
+    resetEnvironment();
+    Serial.begin(NSL_BAUD_RATE);
+    tslpb.begin();
+    results.push_back(measure("pushDataToNSL", iterations, [&] {
+        tslpb.stampAcquisitionTime(packet);
+        tslpb.pushDataToNSL(packet);
+    }));
+    
+    resetEnvironment();
+    tslpb.begin();
+    results.push_back(measure("isClearToSend", iterations, [&] { tslpb.isClearToSend(); }));
+    results.push_back(measure("getMissionElapsedTime", iterations, [&] { tslpb.getMissionElapsedTime(); }));
+}
+
+static void runLoopBenchmark(std::vector<BenchResult>& results, uint64_t loops)
+{
+    resetEnvironment();
+    nsl->setMetEpoch(hal::now());
+    
+    results.push_back(measure("sketch/setup", 1, [] { setup(); }));
+    results.push_back(measure("sketch/loop", loops, [] { loop(); }));
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Results Files                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+static void writeResults(FILE* output, const std::vector<BenchResult>& results)
+{
+    fprintf(output, "# thinsat_bench format %d\n", BENCH_FORMAT_VERSION);
+    fprintf(output, "benchmark\tcalls");
+    for (int column = 0; column < BENCH_COLUMN_COUNT; column++) {
+        fprintf(output, "\t%s", columnNames[column]);
+    }
+    fprintf(output, "\n");
+    
+    for (const BenchResult& result : results) {
+        fprintf(output, "%s\t%llu", result.name.c_str(), (unsigned long long)result.calls);
+        for (int column = 0; column < BENCH_COLUMN_COUNT; column++) {
+            fprintf(output, "\t%.3f", result.values[column]);
+        }
+        fprintf(output, "\n");
+    }
+}
+
+static bool readResults(const char* path, std::map<std::string, BenchResult>& results)
+{
+    FILE* input = fopen(path, "r");
+    if (!input) {
+        perror(path);
+        return false;
+    }
+    
+    char line[1024];
+    while (fgets(line, sizeof(line), input)) {
+        if (line[0] == '#' || !strncmp(line, "benchmark\t", 10)) {
+            continue;
+        }
+        
+        BenchResult result;
+        char* field = strtok(line, "\t\n");
+        if (!field) {
+            continue;
+        }
+        result.name  = field;
+        field        = strtok(NULL, "\t\n");
+        result.calls = field ? strtoull(field, NULL, 10) : 0;
+        
+        for (int column = 0; column < BENCH_COLUMN_COUNT; column++) {
+            field = strtok(NULL, "\t\n");
+            result.values[column] = field ? atof(field) : 0;
+        }
+        results[result.name] = result;
+    }
+    fclose(input);
+    return true;
+}
+
+/*!
+ * @brief Prints every metric that changed. Deterministic metrics that grew
+ * are regressions; host CPU time of calls over 1 µs only warns beyond the
+ * tolerance.
+ *
+ * @return the number of regressions
+ */
+static int compareResults(const std::vector<BenchResult>& results,
+                          const std::map<std::string, BenchResult>& baseline,
+                          double cpuTolerance)
+{
+    int regressions = 0;
+    
+    for (const BenchResult& result : results) {
+        auto previous = baseline.find(result.name);
+        if (previous == baseline.end()) {
+            fprintf(stderr, "new       %s\n", result.name.c_str());
+            continue;
+        }
+        
+        for (int column = 0; column < BENCH_COLUMN_COUNT; column++) {
+            double before = previous->second.values[column];
+            double after  = result.values[column];
+            double change = (before != 0) ? 100.0 * (after - before) / before : (after != 0 ? INFINITY : 0);
+            
+            if (column == BENCH_HOST_NS_COLUMN) {
+                // Sub-microsecond calls are dominated by timer noise
+                if (fabs(change) > cpuTolerance && (before >= 1000 || after >= 1000)) {
+                    fprintf(stderr, "cpu       %-40s %-18s %12.3f -> %12.3f (%+.1f%%)\n",
+                            result.name.c_str(), columnNames[column], before, after, change);
+                }
+            } else if (fabs(after - before) >= 0.0005) {
+                bool worse = after > before;
+                regressions += worse;
+                fprintf(stderr, "%-9s %-40s %-18s %12.3f -> %12.3f (%+.1f%%)\n",
+                        worse ? "REGRESSED" : "improved",
+                        result.name.c_str(), columnNames[column], before, after, change);
+            }
+        }
+    }
+    return regressions;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                       main                       │
+ *  └──────────────────────────────────────────────────┘ */
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--iterations N] [--loops N] [--output FILE]\n"
+                    "       [--compare BASELINE] [--cpu-tolerance PCT]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t    iterations   = 200;
+    uint64_t    loops        = 100;
+    const char* outputPath   = NULL;
+    const char* baselinePath = NULL;
+    double      cpuTolerance = 25;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+            loops = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (!strcmp(argv[i], "--compare") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--cpu-tolerance") && i + 1 < argc) {
+            cpuTolerance = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (iterations == 0 || loops == 0) {
+        usage(argv[0]);
+    }
+    
+    std::vector<BenchResult> results;
+    runApiBenchmarks(results, iterations);
+    runLoopBenchmark(results, loops);
+    
+    FILE* output = outputPath ? fopen(outputPath, "w") : stdout;
+    if (!output) {
+        perror(outputPath);
+        return 1;
+    }
+    writeResults(output, results);
+    if (outputPath) {
+        fclose(output);
+    }
+    
+    if (baselinePath) {
+        std::map<std::string, BenchResult> baseline;
+        if (!readResults(baselinePath, baseline)) {
+            return 1;
+        }
+        int regressions = compareResults(results, baseline, cpuTolerance);
+        fprintf(stderr, "%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ *  @file   ThinSatFuzzStreams.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Downlink streams for fuzzing and benchmarking the ground frame
+ *          parsers.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "ThinSatFuzzStreams.h"
+
+#include <algorithm>
+#include <random>
+
+#include "ThinSatDecoder.h"
+
+
+namespace fuzz {
+
+
+const CorruptionConfig bitFlipCorruption   = { 1e-4, 0,    0,    0   };
+const CorruptionConfig slipCorruption      = { 0,    1e-4, 1e-4, 0   };
+const CorruptionConfig preambleCorruption  = { 0,    0,    0,    0.5 };
+const CorruptionConfig mixedCorruption     = { 1e-4, 5e-5, 5e-5, 0.1 };
+
+
+/*!
+ * @brief   A stream of frames as the firmware sends them: science frames
+ *          with a MET advancing one second per frame and a short sample age,
+ *          and a profiler and energy report at fixed intervals. Payload
+ *          bytes are random.
+ */
+std::vector<uint8_t> makeFrames(size_t frames, uint64_t seed)
+{
+    std::vector<uint8_t> stream(frames * NSL_PACKET_SIZE);
+    std::mt19937_64      rng(seed);
+    uint32_t             met = (uint32_t)(rng() % 1000);
+    
+    for (size_t i = 0; i < frames; i++) {
+        uint8_t* f = &stream[i * NSL_PACKET_SIZE];
+        
+        for (size_t b = NSL_PACKET_HEADER_LENGTH; b < NSL_PACKET_SIZE; b++) {
+            f[b] = (uint8_t)rng();
+        }
+        f[0] = f[1] = f[2] = GROUND_HEADER_BYTE;
+        
+        met += 10;
+        f[GROUND_OFFSET_MET]     = (uint8_t)met;
+        f[GROUND_OFFSET_MET + 1] = (uint8_t)(met >> 8);
+        f[GROUND_OFFSET_MET + 2] = (uint8_t)(met >> 16);
+        
+        if (i % FUZZ_ENERGY_INTERVAL == FUZZ_ENERGY_INTERVAL - 1) {
+            f[GROUND_OFFSET_AGE] = GROUND_FRAME_TYPE_ENERGY;
+        } else if (i % FUZZ_PROFILE_INTERVAL == FUZZ_PROFILE_INTERVAL - 1) {
+            f[GROUND_OFFSET_AGE] = GROUND_FRAME_TYPE_PROFILE;
+        } else {
+            f[GROUND_OFFSET_AGE] = (uint8_t)(rng() % 20);
+        }
+    }
+    return stream;
+}
+
+
+/*!
+ * @brief   Returns stream with config's damage applied. False preambles are
+ *          written into the payload of frames assumed to start every
+ *          NSL_PACKET_SIZE bytes, then bytes are dropped, inserted and have
+ *          their bits flipped.
+ */
+std::vector<uint8_t> corrupt(const std::vector<uint8_t>& stream, const CorruptionConfig& config, uint64_t seed)
+{
+    std::mt19937_64                         rng(seed);
+    std::uniform_real_distribution<double>  unit(0, 1);
+    std::vector<uint8_t>                    damaged(stream);
+    
+    if (config.preambleRate > 0) {
+        const size_t span = NSL_PACKET_SIZE - 2 * NSL_PACKET_HEADER_LENGTH + 1;
+        
+        for (size_t f = 0; f + NSL_PACKET_SIZE <= damaged.size(); f += NSL_PACKET_SIZE) {
+            if (unit(rng) < config.preambleRate) {
+                size_t at = f + NSL_PACKET_HEADER_LENGTH + rng() % span;
+                damaged[at] = damaged[at + 1] = damaged[at + 2] = GROUND_HEADER_BYTE;
+            }
+        }
+    }
+    
+    if (config.dropRate > 0 || config.insertRate > 0) {
+        std::vector<uint8_t> slipped;
+        slipped.reserve(damaged.size() + damaged.size() / 16);
+        
+        for (uint8_t byte : damaged) {
+            if (unit(rng) < config.insertRate) {
+                slipped.push_back((uint8_t)rng());
+            }
+            if (unit(rng) >= config.dropRate) {
+                slipped.push_back(byte);
+            }
+        }
+        damaged.swap(slipped);
+    }
+    
+    if (config.bitFlipRate > 0) {
+        // Jump from one flipped bit to the next instead of drawing every bit
+        std::geometric_distribution<uint64_t> gap(config.bitFlipRate);
+        uint64_t                              bits = (uint64_t)damaged.size() * 8;
+        
+        for (uint64_t bit = gap(rng); bit < bits; bit += 1 + gap(rng)) {
+            damaged[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        }
+    }
+    return damaged;
+}
+
+
+/*!
+ * @brief   Uniformly random bytes, as a receiver outputs with no signal
+ */
+std::vector<uint8_t> makeNoise(size_t length, uint64_t seed)
+{
+    std::vector<uint8_t> noise(length);
+    std::mt19937_64      rng(seed);
+    
+    for (uint8_t& byte : noise) {
+        byte = (uint8_t)rng();
+    }
+    return noise;
+}
+
+
+/*!
+ * @brief   A header every period bytes with zeros between them. A period
+ *          of NSL_PACKET_HEADER_LENGTH or less fills the stream with 0x50;
+ *          any period other than NSL_PACKET_SIZE makes every header a false
+ *          candidate.
+ */
+std::vector<uint8_t> makeHeaderFlood(size_t length, size_t period)
+{
+    std::vector<uint8_t> flood(length, 0);
+    
+    if (period <= NSL_PACKET_HEADER_LENGTH) {
+        std::fill(flood.begin(), flood.end(), GROUND_HEADER_BYTE);
+        return flood;
+    }
+    for (size_t i = 0; i < length; i += period) {
+        for (size_t b = 0; b < NSL_PACKET_HEADER_LENGTH && i + b < length; b++) {
+            flood[i + b] = GROUND_HEADER_BYTE;
+        }
+    }
+    return flood;
+}
+
+
+} /* namespace fuzz */
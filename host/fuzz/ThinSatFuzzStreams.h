@@ -0,0 +1,64 @@
+/**
+ *  @file   ThinSatFuzzStreams.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Downlink streams for fuzzing and benchmarking the ground frame
+ *          parsers: valid ThinsatPacket_t frames, the same frames after the
+ *          damage an RF link does to them, and pathological header floods.
+ *
+ *          Damage is drawn per bit, per byte or per frame from a seed, so a
+ *          stream can be rebuilt exactly from its CorruptionConfig and seed.
+ *
+ * @code
+ *  std::vector<uint8_t> clean = fuzz::makeFrames(10000, 1);
+ *  std::vector<uint8_t> noisy = fuzz::corrupt(clean, fuzz::mixedCorruption, 2);
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatFuzzStreams_h
+#define ThinSatFuzzStreams_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+
+namespace fuzz {
+
+
+#define FUZZ_PROFILE_INTERVAL       64      ///< Every Nth frame of makeFrames() is a profiler report
+#define FUZZ_ENERGY_INTERVAL        256     ///< Every Nth frame of makeFrames() is an energy report
+
+
+/*!
+ * @brief   Damage applied by corrupt(). All zero leaves the stream unchanged.
+ */
+typedef struct
+{
+    double      bitFlipRate;        ///< Probability that any bit is inverted
+    double      dropRate;           ///< Probability that any byte is lost
+    double      insertRate;         ///< Probability that a random byte is inserted before any byte
+    double      preambleRate;       ///< Probability that a frame carries a false 0x50 0x50 0x50 in its payload
+} CorruptionConfig;
+
+extern const CorruptionConfig bitFlipCorruption;
+extern const CorruptionConfig slipCorruption;
+extern const CorruptionConfig preambleCorruption;
+extern const CorruptionConfig mixedCorruption;
+
+
+std::vector<uint8_t>    makeFrames(size_t frames, uint64_t seed);
+std::vector<uint8_t>    corrupt(const std::vector<uint8_t>& stream, const CorruptionConfig& config, uint64_t seed);
+std::vector<uint8_t>    makeNoise(size_t length, uint64_t seed);
+std::vector<uint8_t>    makeHeaderFlood(size_t length, size_t period);
+
+
+} /* namespace fuzz */
+
+
+#endif /* ThinSatFuzzStreams_h */
@@ -0,0 +1,229 @@
+/**
+ *  @file   thinsat_fuzz_parser.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Fuzz target for the ground frame parsers.
+ *
+ *          Byte 0 of an input sets how it is parsed: byte 0 % 3 is the
+ *          FrameSynchronizer header tolerance and byte 0 / 3 the size of the
+ *          pieces the stream is fed in (0: all at once). The rest of the
+ *          input is the downlink stream. It goes through both FrameScanner
+ *          and FrameSynchronizer, and every frame either delivers is decoded
+ *          and formatted as CSV. The target aborts, so the fuzzer reports
+ *          the input, when:
+ *          - a delivered frame does not start with NSL_PACKET_HEADER
+ *          - the parser's counters do not account for every input byte as
+ *            either part of a frame or skipped
+ *          - a CSV row is longer than GROUND_CSV_ROW_MAX
+ *
+ *          Built with THINSAT_ENABLE_FUZZER (clang), this is a libFuzzer
+ *          target and takes libFuzzer's arguments:
+ *
+ *              thinsat_fuzz_corpus corpus
+ *              thinsat_fuzz_parser -max_len=4096 corpus
+ *
+ *          Otherwise it runs each input given as a file, or every file in a
+ *          given directory, once; to reproduce a crash or check a corpus in
+ *          the regular build.
+ *
+ *          usage: thinsat_fuzz_parser FILE|DIR...
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatSync.h"
+
+
+/*!
+ * @brief   Aborts when an invariant does not hold
+ */
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        fprintf(stderr, "thinsat_fuzz_parser: %s\n", what);
+        abort();
+    }
+}
+
+/*!
+ * @brief   Decodes a delivered frame the way thinsat_decode does
+ */
+static void decodeFrame(const uint8_t* frame)
+{
+    check(ground::isHeader(frame), "frame delivered without a header");
+    
+    ground::ScienceRecord record;
+    ground::ScienceValues values;
+    ground::ProfileRecord profile;
+    ground::EnergyRecord  energy;
+    ground::StatsRecord   stats;
+    ground::SeriesRecord  series;
+    char                  row[GROUND_CSV_ROW_MAX + 64];
+    
+    switch (ground::getFrameKind(frame)) {
+    case ground::FrameScience:
+        ground::decodeScience(frame, record);
+        ground::scaleScience(record, values);
+        check(ground::formatScienceCsv(values, row, sizeof(row)) <= GROUND_CSV_ROW_MAX, "CSV row too long");
+        break;
+    case ground::FrameProfile:
+        ground::decodeProfile(frame, profile);
+        break;
+    case ground::FrameEnergy:
+        ground::decodeEnergy(frame, energy);
+        break;
+    case ground::FrameStats:
+        ground::decodeStats(frame, stats);
+        break;
+    case ground::FrameSeries:
+        ground::decodeSeries(frame, series);
+        check(series.count <= GROUND_SERIES_SAMPLES_MAX, "series sample count out of range");
+        break;
+    default:
+        break;
+    }
+}
+
+static void fuzzScanner(const uint8_t* data, size_t size, size_t piece)
+{
+    ground::FrameScanner scanner;
+    auto                 handler = [](const uint8_t* frame) { decodeFrame(frame); };
+    
+    for (size_t pos = 0; pos < size; pos += piece) {
+        scanner.scan(&data[pos], std::min(piece, size - pos), handler);
+    }
+    scanner.finish(handler);
+    
+    const ground::ScannerStats& stats = scanner.getStats();
+    check(stats.bytesScanned == size, "scanner lost input bytes");
+    check(stats.frames * NSL_PACKET_SIZE + stats.bytesSkipped == size, "scanner bytes unaccounted for");
+}
+
+/*!
+ * @brief   Feeds the synchronizer as read() does: unconsumed bytes are
+ *          presented again, followed by the next piece
+ */
+static void fuzzSynchronizer(const uint8_t* data, size_t size, size_t piece, uint8_t tolerance)
+{
+    ground::FrameSynchronizer sync(tolerance);
+    std::vector<uint8_t>      pending;
+    auto                      handler = [](const uint8_t* frame) { decodeFrame(frame); };
+    
+    for (size_t pos = 0; pos < size; pos += piece) {
+        size_t length = std::min(piece, size - pos);
+        bool   final  = pos + length == size;
+        
+        pending.insert(pending.end(), &data[pos], &data[pos] + length);
+        size_t used = sync.process(pending.data(), pending.size(), final, handler);
+        check(used <= pending.size(), "synchronizer consumed more than it was given");
+        pending.erase(pending.begin(), pending.begin() + used);
+    }
+    check(pending.empty(), "synchronizer left bytes after the final piece");
+    
+    const ground::SyncStats& stats = sync.getStats();
+    check(stats.bytesIn == size, "synchronizer lost input bytes");
+    check(stats.frames * NSL_PACKET_SIZE + stats.bytesDiscarded == size, "synchronizer bytes unaccounted for");
+    check(stats.falseCandidates <= stats.candidates, "more false candidates than candidates");
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size < 2) {
+        return 0;
+    }
+    
+    size_t  piece     = data[0] / 3 ? data[0] / 3 : size;
+    uint8_t tolerance = data[0] % 3;
+    
+    fuzzScanner(data + 1, size - 1, piece);
+    fuzzSynchronizer(data + 1, size - 1, piece, tolerance);
+    return 0;
+}
+
+
+#ifndef THINSAT_LIBFUZZER
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <string>
+
+
+static bool runFile(const std::string& path)
+{
+    FILE* input = fopen(path.c_str(), "rb");
+    if (!input) {
+        perror(path.c_str());
+        return false;
+    }
+    
+    std::vector<uint8_t> data;
+    uint8_t              buffer[65536];
+    size_t               got;
+    while ((got = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+        data.insert(data.end(), buffer, buffer + got);
+    }
+    bool failed = ferror(input);
+    fclose(input);
+    if (failed) {
+        perror(path.c_str());
+        return false;
+    }
+    
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s FILE|DIR...\n", argv[0]);
+        return 2;
+    }
+    
+    size_t inputs = 0;
+    bool   ok     = true;
+    
+    for (int i = 1; i < argc; i++) {
+        struct stat info;
+        if (stat(argv[i], &info) != 0) {
+            perror(argv[i]);
+            ok = false;
+            continue;
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            ok = runFile(argv[i]) && ok;
+            inputs++;
+            continue;
+        }
+        
+        DIR* dir = opendir(argv[i]);
+        if (!dir) {
+            perror(argv[i]);
+            ok = false;
+            continue;
+        }
+        while (struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            ok = runFile(std::string(argv[i]) + "/" + entry->d_name) && ok;
+            inputs++;
+        }
+        closedir(dir);
+    }
+    
+    printf("%zu inputs\n", inputs);
+    return ok ? 0 : 1;
+}
+
+#endif /* THINSAT_LIBFUZZER */
@@ -0,0 +1,111 @@
+/**
+ *  @file   SpscRing.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Bounded lock-free single-producer, single-consumer ring.
+ *
+ *          One thread pushes and one thread pops. The head and tail live on
+ *          separate cache lines, and each side keeps a cached copy of the
+ *          other side's index, so the shared lines are only touched when the
+ *          ring looks full (producer) or empty (consumer).
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SpscRing_h
+#define SpscRing_h
+
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+
+
+namespace ground {
+
+
+#define SPSC_CACHE_LINE     64
+
+
+template <typename T>
+class SpscRing
+{
+    
+public:
+    /*!
+     * @brief   capacity is rounded up to a power of two
+     */
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+    
+    bool tryPush(const T& item)
+    {
+        size_t tail = producer.index.load(std::memory_order_relaxed);
+        if (tail - producer.cached > mask) {
+            producer.cached = consumer.index.load(std::memory_order_acquire);
+            if (tail - producer.cached > mask) {
+                return false;
+            }
+        }
+        slots[tail & mask] = item;
+        producer.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool tryPop(T& item)
+    {
+        size_t head = consumer.index.load(std::memory_order_relaxed);
+        if (head == consumer.cached) {
+            consumer.cached = producer.index.load(std::memory_order_acquire);
+            if (head == consumer.cached) {
+                return false;
+            }
+        }
+        item = slots[head & mask];
+        consumer.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    /*!
+     * @brief   Called by the producer after its last push
+     */
+    void   close()          { closed.store(true, std::memory_order_release); }
+    bool   isClosed() const { return closed.load(std::memory_order_acquire); }
+    
+    /*!
+     * @brief   Approximate number of queued items, for monitoring
+     */
+    size_t size() const
+    {
+        return producer.index.load(std::memory_order_relaxed) - consumer.index.load(std::memory_order_relaxed);
+    }
+    size_t capacity() const { return mask + 1; }
+    
+private:
+    
+    struct alignas(SPSC_CACHE_LINE) Side
+    {
+        std::atomic<size_t> index{0};
+        size_t              cached = 0;     ///< Last seen index of the other side
+    };
+    
+    Side                producer;
+    Side                consumer;
+    alignas(SPSC_CACHE_LINE) std::atomic<bool> closed{false};
+    std::vector<T>      slots;
+    size_t              mask;
+    
+};
+
+
+} /* namespace ground */
+
+
+#endif /* SpscRing_h */
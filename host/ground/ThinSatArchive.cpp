@@ -0,0 +1,470 @@
+/**
+ *  @file   ThinSatArchive.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Append-only, memory-mapped archive of downlinked frames.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "ThinSatArchive.h"
+
+
+namespace ground {
+
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "archives are little-endian");
+static_assert(sizeof(ArchiveHeader)      == ARCHIVE_HEADER_SIZE, "archive header size");
+static_assert(sizeof(ArchiveRecord)      == ARCHIVE_RECORD_SIZE, "archive record size");
+static_assert(sizeof(ArchiveIndexHeader) == 16,                  "index header size");
+static_assert(sizeof(ArchiveIndexEntry)  == 16,                  "index entry size");
+
+#define ARCHIVE_FLUSH_RECORDS       4096    ///< Records buffered before append() flushes
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                     File I/O                     │
+ *  └──────────────────────────────────────────────────┘ */
+
+static bool writeAll(int fd, const void* data, size_t length, off_t offset)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    
+    while (length > 0) {
+        ssize_t written = pwrite(fd, p, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p      += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t length, off_t offset)
+{
+    ssize_t got = pread(fd, data, length, offset);
+    
+    if (got != (ssize_t)length) {
+        if (got >= 0) errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+static bool isValidHeader(const ArchiveHeader& header)
+{
+    return !memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) &&
+           header.version     == ARCHIVE_VERSION &&
+           header.headerSize  == ARCHIVE_HEADER_SIZE &&
+           header.recordSize  == ARCHIVE_RECORD_SIZE &&
+           header.frameSize   == NSL_PACKET_SIZE &&
+           header.indexStride > 0;
+}
+
+static uint64_t getIndexEntriesFor(uint64_t records, uint32_t stride)
+{
+    return (records + stride - 1) / stride;
+}
+
+static off_t getRecordOffset(uint64_t sequence)
+{
+    return ARCHIVE_HEADER_SIZE + (off_t)sequence * ARCHIVE_RECORD_SIZE;
+}
+
+static off_t getIndexOffset(uint64_t entry)
+{
+    return sizeof(ArchiveIndexHeader) + (off_t)entry * sizeof(ArchiveIndexEntry);
+}
+
+
+uint64_t estimateReceiveTime(const uint8_t* frame, uint64_t epoch)
+{
+    uint64_t ticks = readU24(&frame[GROUND_OFFSET_MET]);
+    
+    if (getFrameKind(frame) == FrameScience) {
+        ticks += frame[GROUND_OFFSET_AGE];
+    }
+    return epoch + ticks * (uint64_t)(GROUND_MET_TICK_S * 1e6);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Writer                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+bool ArchiveWriter::open(const std::string& path, uint32_t indexStride)
+{
+    struct stat   info;
+    ArchiveHeader header;
+    
+    close();
+    
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &info) < 0) {
+        close();
+        return false;
+    }
+    
+    if (info.st_size == 0) {
+        if (indexStride == 0) {
+            errno = EINVAL;
+            close();
+            return false;
+        }
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+        header.version     = ARCHIVE_VERSION;
+        header.headerSize  = ARCHIVE_HEADER_SIZE;
+        header.recordSize  = ARCHIVE_RECORD_SIZE;
+        header.frameSize   = NSL_PACKET_SIZE;
+        header.indexStride = indexStride;
+        header.createdTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch()).count();
+        if (!writeAll(fd, &header, sizeof(header), 0)) {
+            close();
+            return false;
+        }
+        records = 0;
+    } else {
+        if (!readAll(fd, &header, sizeof(header), 0)) {
+            close();
+            return false;
+        }
+        if (!isValidHeader(header)) {
+            errno = EINVAL;
+            close();
+            return false;
+        }
+        
+        // Cut off a record left partly written by a crash
+        records = (info.st_size - ARCHIVE_HEADER_SIZE) / ARCHIVE_RECORD_SIZE;
+        if (getRecordOffset(records) != info.st_size && ftruncate(fd, getRecordOffset(records)) < 0) {
+            close();
+            return false;
+        }
+    }
+    
+    stride   = header.indexStride;
+    lastTime = 0;
+    if (records > 0) {
+        ArchiveRecord last;
+        if (!readAll(fd, &last, sizeof(last), getRecordOffset(records - 1))) {
+            close();
+            return false;
+        }
+        lastTime = last.receiveTime;
+    }
+    
+    indexFd = ::open((path + ARCHIVE_INDEX_SUFFIX).c_str(), O_RDWR | O_CREAT, 0644);
+    if (indexFd < 0 || !repairIndex()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+/*!
+ * @brief   Brings the index file in line with the records on disk. Entries
+ *          are never ahead of the records, but they lag behind after a crash
+ *          between writing records and their index entries.
+ */
+bool ArchiveWriter::repairIndex()
+{
+    struct stat        info;
+    ArchiveIndexHeader header;
+    uint64_t           expected = getIndexEntriesFor(records, stride);
+    uint64_t           existing = 0;
+    
+    if (fstat(indexFd, &info) < 0) {
+        return false;
+    }
+    if (info.st_size >= (off_t)sizeof(header) && readAll(indexFd, &header, sizeof(header), 0) &&
+        !memcmp(header.magic, ARCHIVE_INDEX_MAGIC, sizeof(header.magic)) && header.indexStride == stride) {
+        existing = std::min<uint64_t>((info.st_size - sizeof(header)) / sizeof(ArchiveIndexEntry), expected);
+    } else {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, ARCHIVE_INDEX_MAGIC, sizeof(header.magic));
+        header.indexStride = stride;
+        if (!writeAll(indexFd, &header, sizeof(header), 0)) {
+            return false;
+        }
+    }
+    if (ftruncate(indexFd, getIndexOffset(existing)) < 0) {
+        return false;
+    }
+    
+    for (uint64_t entry = existing; entry < expected; entry++) {
+        ArchiveIndexEntry value;
+        value.sequence = entry * stride;
+        if (!readAll(fd, &value.receiveTime, sizeof(value.receiveTime), getRecordOffset(value.sequence)) ||
+            !writeAll(indexFd, &value, sizeof(value), getIndexOffset(entry))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*!
+ * @brief   Buffers one frame. Returns false if the archive is not open, the
+ *          receive time is earlier than the last record's, or a flush fails.
+ */
+bool ArchiveWriter::append(const uint8_t* frame, uint64_t receiveTime, uint16_t flags)
+{
+    if (fd < 0 || receiveTime < lastTime) {
+        errno = EINVAL;
+        return false;
+    }
+    
+    uint64_t sequence = getRecordCount();
+    if (sequence % stride == 0) {
+        pendingIndex.push_back({receiveTime, sequence});
+    }
+    
+    ArchiveRecord record;
+    record.receiveTime = receiveTime;
+    record.flags       = flags;
+    memcpy(record.frame, frame, NSL_PACKET_SIZE);
+    pending.push_back(record);
+    lastTime = receiveTime;
+    
+    return pending.size() < ARCHIVE_FLUSH_RECORDS || flush();
+}
+
+
+bool ArchiveWriter::flush()
+{
+    if (fd < 0) {
+        return false;
+    }
+    if (!pending.empty()) {
+        if (!writeAll(fd, pending.data(), pending.size() * sizeof(ArchiveRecord), getRecordOffset(records))) {
+            return false;
+        }
+        records += pending.size();
+        pending.clear();
+    }
+    if (!pendingIndex.empty()) {
+        uint64_t entry = pendingIndex.front().sequence / stride;
+        if (!writeAll(indexFd, pendingIndex.data(), pendingIndex.size() * sizeof(ArchiveIndexEntry),
+                      getIndexOffset(entry))) {
+            return false;
+        }
+        pendingIndex.clear();
+    }
+    return true;
+}
+
+
+void ArchiveWriter::close()
+{
+    if (fd >= 0) {
+        flush();
+        ::close(fd);
+    }
+    if (indexFd >= 0) {
+        ::close(indexFd);
+    }
+    fd      = -1;
+    indexFd = -1;
+    records = 0;
+    pending.clear();
+    pendingIndex.clear();
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Reader                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+bool ArchiveReader::open(const std::string& archivePath)
+{
+    close();
+    
+    path = archivePath;
+    fd   = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0 || !mapArchive()) {
+        close();
+        return false;
+    }
+    mapIndex();
+    return true;
+}
+
+
+/*!
+ * @brief   Maps records appended since open() or the last refresh().
+ *          References to records from before the call are invalidated.
+ */
+bool ArchiveReader::refresh()
+{
+    if (fd < 0 || !mapArchive()) {
+        return false;
+    }
+    mapIndex();
+    return true;
+}
+
+
+bool ArchiveReader::mapArchive()
+{
+    struct stat info;
+    
+    if (fstat(fd, &info) < 0) {
+        return false;
+    }
+    if (info.st_size < ARCHIVE_HEADER_SIZE) {
+        errno = EINVAL;
+        return false;
+    }
+    
+    if (map) {
+        munmap((void*)map, mapLength);
+        map = nullptr;
+    }
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    map       = (const uint8_t*)mapped;
+    mapLength = info.st_size;
+    
+    const ArchiveHeader* header = (const ArchiveHeader*)map;
+    if (!isValidHeader(*header)) {
+        errno = EINVAL;
+        return false;
+    }
+    stride  = header->indexStride;
+    records = (mapLength - ARCHIVE_HEADER_SIZE) / ARCHIVE_RECORD_SIZE;
+    
+    madvise((void*)map, mapLength, MADV_RANDOM);
+    return true;
+}
+
+
+/*!
+ * @brief   Maps the index file. If it is missing, belongs to another archive
+ *          or lags behind the records, the index is rebuilt in memory from
+ *          every stride-th record instead.
+ */
+void ArchiveReader::mapIndex()
+{
+    uint64_t expected = getIndexEntriesFor(records, stride);
+    
+    if (indexMap) {
+        munmap((void*)indexMap, indexLength);
+        indexMap = nullptr;
+    }
+    rebuiltIndex.clear();
+    index      = nullptr;
+    indexCount = 0;
+    
+    int indexFd = ::open((path + ARCHIVE_INDEX_SUFFIX).c_str(), O_RDONLY);
+    if (indexFd >= 0) {
+        struct stat info;
+        if (fstat(indexFd, &info) == 0 && info.st_size >= (off_t)sizeof(ArchiveIndexHeader)) {
+            void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, indexFd, 0);
+            if (mapped != MAP_FAILED) {
+                indexMap    = (const uint8_t*)mapped;
+                indexLength = info.st_size;
+            }
+        }
+        ::close(indexFd);
+    }
+    
+    if (indexMap) {
+        const ArchiveIndexHeader* header = (const ArchiveIndexHeader*)indexMap;
+        uint64_t available = (indexLength - sizeof(ArchiveIndexHeader)) / sizeof(ArchiveIndexEntry);
+        
+        if (!memcmp(header->magic, ARCHIVE_INDEX_MAGIC, sizeof(header->magic)) &&
+            header->indexStride == stride && available >= expected) {
+            index      = (const ArchiveIndexEntry*)(indexMap + sizeof(ArchiveIndexHeader));
+            indexCount = expected;
+            return;
+        }
+    }
+    
+    rebuiltIndex.resize(expected);
+    for (uint64_t entry = 0; entry < expected; entry++) {
+        rebuiltIndex[entry].sequence    = entry * stride;
+        rebuiltIndex[entry].receiveTime = (*this)[entry * stride].receiveTime;
+    }
+    index      = rebuiltIndex.data();
+    indexCount = expected;
+}
+
+
+void ArchiveReader::close()
+{
+    if (map) {
+        munmap((void*)map, mapLength);
+    }
+    if (indexMap) {
+        munmap((void*)indexMap, indexLength);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd         = -1;
+    map        = nullptr;
+    indexMap   = nullptr;
+    index      = nullptr;
+    indexCount = 0;
+    records    = 0;
+    rebuiltIndex.clear();
+}
+
+
+/*!
+ * @brief   Returns the sequence number of the first record received at or
+ *          after time, or size() if there is none. O(log n): one binary
+ *          search of the index and one of a single stride of records.
+ */
+uint64_t ArchiveReader::lowerBound(uint64_t time) const
+{
+    const ArchiveIndexEntry* end   = index + indexCount;
+    const ArchiveIndexEntry* entry = std::lower_bound(index, end, time,
+        [](const ArchiveIndexEntry& e, uint64_t t) { return e.receiveTime < t; });
+    
+    uint64_t low  = (entry == index) ? 0       : (entry - 1)->sequence;
+    uint64_t high = (entry == end)   ? records : entry->sequence;
+    
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if ((*this)[middle].receiveTime < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+
+/*!
+ * @brief   Finds the records received in [from, to): first is the first
+ *          sequence number in the window, last is one past the end.
+ */
+void ArchiveReader::findRange(uint64_t from, uint64_t to, uint64_t& first, uint64_t& last) const
+{
+    first = lowerBound(from);
+    last  = (to > from) ? lowerBound(to) : first;
+}
+
+
+} /* namespace ground */
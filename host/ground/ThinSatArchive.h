@@ -0,0 +1,206 @@
+/**
+ *  @file   ThinSatArchive.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Append-only, memory-mapped archive of downlinked ThinsatPacket_t
+ *          frames with a sparse time index.
+ *
+ *          An archive is two files:
+ *          - ARCHIVE: an ArchiveHeader followed by fixed-size ArchiveRecords,
+ *            each one frame with its ground receive time. A record's
+ *            sequence number is its position, so record n is at
+ *            ARCHIVE_HEADER_SIZE + n * ARCHIVE_RECORD_SIZE.
+ *          - ARCHIVE.idx: an ArchiveIndexHeader followed by one
+ *            ArchiveIndexEntry (receive time, sequence) per indexStride
+ *            records.
+ *
+ *          Receive times never decrease, so a reader finds any time window
+ *          with a binary search of the index and then of one indexStride
+ *          block of the mapped records. Nothing is copied or parsed up front.
+ *          A partial record left by a crash is ignored by readers and cut off
+ *          by the next writer. A missing or short index is rebuilt from every
+ *          indexStride-th record.
+ *
+ *  @note   Files are little-endian; the archive is only read and written on
+ *          little-endian hosts.
+ *
+ * @code
+ *  ground::ArchiveReader archive;
+ *  uint64_t              first, last;
+ *
+ *  archive.open("mission.tsa");
+ *  archive.findRange(startUs, endUs, first, last);
+ *  for (uint64_t i = first; i < last; i++) {
+ *      const uint8_t* frame = archive[i].frame;
+ *  }
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatArchive_h
+#define ThinSatArchive_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+
+
+namespace ground {
+
+
+#define ARCHIVE_MAGIC               "TSLARCHV"
+#define ARCHIVE_INDEX_MAGIC         "TSLINDEX"
+#define ARCHIVE_VERSION             1
+#define ARCHIVE_HEADER_SIZE         64
+#define ARCHIVE_RECORD_SIZE         48
+#define ARCHIVE_INDEX_STRIDE        1024    ///< Default records per index entry
+#define ARCHIVE_INDEX_SUFFIX        ".idx"
+
+#define ARCHIVE_FLAG_TIME_ESTIMATED 0x0001  ///< receiveTime was derived from met, not measured
+
+
+/*!
+ * @brief   First ARCHIVE_HEADER_SIZE bytes of an archive
+ */
+typedef struct __attribute__((__packed__))
+{
+    char        magic[8];           ///< ARCHIVE_MAGIC, not terminated
+    uint16_t    version;            ///< ARCHIVE_VERSION
+    uint16_t    headerSize;         ///< ARCHIVE_HEADER_SIZE
+    uint16_t    recordSize;         ///< ARCHIVE_RECORD_SIZE
+    uint16_t    frameSize;          ///< NSL_PACKET_SIZE
+    uint32_t    indexStride;        ///< Records per index entry
+    uint64_t    createdTime;        ///< us since the Unix epoch
+    uint8_t     reserved[36];       ///< Always 0
+} ArchiveHeader;
+
+
+/*!
+ * @brief   One archived frame
+ */
+typedef struct
+{
+    uint64_t    receiveTime;        ///< Ground receive time (us since the Unix epoch)
+    uint16_t    flags;              ///< ARCHIVE_FLAG_ bits
+    uint8_t     frame[NSL_PACKET_SIZE];
+} ArchiveRecord;
+
+
+typedef struct
+{
+    char        magic[8];           ///< ARCHIVE_INDEX_MAGIC
+    uint32_t    indexStride;        ///< Must match the archive
+    uint32_t    reserved;
+} ArchiveIndexHeader;
+
+
+typedef struct
+{
+    uint64_t    receiveTime;        ///< receiveTime of record sequence
+    uint64_t    sequence;           ///< A multiple of indexStride
+} ArchiveIndexEntry;
+
+
+/*!
+ * @brief   Estimates a frame's receive time, for captures that did not record
+ *          one: epoch (us) plus the transmission MET (met + sampleAge for
+ *          science frames, met for reports). Callers must keep the result
+ *          from running backwards across MET rollovers and reboots.
+ */
+uint64_t    estimateReceiveTime(const uint8_t* frame, uint64_t epoch);
+
+
+/*!
+ * @brief   Appends records to an archive, creating it if needed. Records
+ *          are buffered; flush() writes them, then their index entries, so
+ *          the index never points past the records on disk.
+ */
+class ArchiveWriter
+{
+    
+public:
+    ~ArchiveWriter() { close(); }
+    
+    bool     open(const std::string& path, uint32_t indexStride = ARCHIVE_INDEX_STRIDE);
+    bool     append(const uint8_t* frame, uint64_t receiveTime, uint16_t flags = 0);
+    bool     flush();
+    void     close();
+    
+    uint64_t getRecordCount()    { return records + pending.size(); }
+    uint64_t getLastTime()       { return lastTime; }
+    
+private:
+    
+    bool     repairIndex();
+    
+    int                             fd          = -1;
+    int                             indexFd     = -1;
+    uint32_t                        stride      = 0;
+    uint64_t                        records     = 0;    ///< Records on disk
+    uint64_t                        lastTime    = 0;
+    std::vector<ArchiveRecord>      pending;
+    std::vector<ArchiveIndexEntry>  pendingIndex;
+    
+};
+
+
+/*!
+ * @brief   Read-only view of an archive. Records are read straight from the
+ *          mapping and stay valid until refresh() or close().
+ */
+class ArchiveReader
+{
+    
+public:
+    ~ArchiveReader() { close(); }
+    
+    bool     open(const std::string& path);
+    bool     refresh();
+    void     close();
+    
+    uint64_t size() const            { return records; }
+    uint64_t getCreatedTime() const  { return ((const ArchiveHeader*)map)->createdTime; }
+    uint32_t getIndexStride() const  { return stride; }
+    uint64_t getIndexSize() const    { return indexCount; }
+    bool     isIndexRebuilt() const  { return !rebuiltIndex.empty(); }
+    
+    const ArchiveRecord& operator[](uint64_t sequence) const
+    {
+        return *(const ArchiveRecord*)(map + ARCHIVE_HEADER_SIZE + sequence * ARCHIVE_RECORD_SIZE);
+    }
+    
+    uint64_t lowerBound(uint64_t time) const;
+    void     findRange(uint64_t from, uint64_t to, uint64_t& first, uint64_t& last) const;
+    
+private:
+    
+    bool     mapArchive();
+    void     mapIndex();
+    
+    std::string                     path;
+    int                             fd          = -1;
+    const uint8_t*                  map         = nullptr;
+    size_t                          mapLength   = 0;
+    uint64_t                        records     = 0;
+    uint32_t                        stride      = 0;
+    
+    const uint8_t*                  indexMap    = nullptr;
+    size_t                          indexLength = 0;
+    const ArchiveIndexEntry*        index       = nullptr;
+    uint64_t                        indexCount  = 0;
+    std::vector<ArchiveIndexEntry>  rebuiltIndex;
+    
+};
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatArchive_h */
@@ -0,0 +1,611 @@
+/**
+ *  @file   ThinSatColumnStore.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Compressed columnar store of decoded science frames.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "ThinSatColumnStore.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GROUND_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define GROUND_HAVE_X86 0
+#endif
+
+
+namespace ground {
+
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "stores are little-endian");
+static_assert(sizeof(StoreHeader) == 32,                 "store header size");
+static_assert(sizeof(StoreColumn) == 32,                 "store column size");
+static_assert(STORE_BLOCK_ROWS % STORE_LANES == 0,       "blocks hold whole lane rows");
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Fields                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+static const char* const fieldNames[STORE_FIELD_COUNT] = {
+    "met", "sampleAge", "quatw", "quatx", "quaty", "quatz", "bnomagx", "bnomagy", "bnomagz",
+    "bnoCal", "bmePres", "bmeTemp", "tslTempExt", "tslVolts", "tslCurrent", "solar",
+    "tslMagXraw", "tslMagYraw", "tslMagZraw"
+};
+
+
+const char* getFieldName(StoreField field)
+{
+    return (field < STORE_FIELD_COUNT) ? fieldNames[field] : "unknown";
+}
+
+
+bool findField(const char* name, StoreField& field)
+{
+    for (int i = 0; i < STORE_FIELD_COUNT; i++) {
+        if (!strcmp(name, fieldNames[i])) {
+            field = (StoreField)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+int32_t getField(const ScienceRecord& r, StoreField field)
+{
+    switch (field) {
+        case FieldMet:          return r.met;
+        case FieldSampleAge:    return r.sampleAge;
+        case FieldQuatW:        return r.quat[0];
+        case FieldQuatX:        return r.quat[1];
+        case FieldQuatY:        return r.quat[2];
+        case FieldQuatZ:        return r.quat[3];
+        case FieldBnoMagX:      return r.bnomag[0];
+        case FieldBnoMagY:      return r.bnomag[1];
+        case FieldBnoMagZ:      return r.bnomag[2];
+        case FieldBnoCal:       return r.bnoCal;
+        case FieldBmePres:      return r.bmePres;
+        case FieldBmeTemp:      return r.bmeTemp;
+        case FieldTslTempExt:   return r.tslTempExt;
+        case FieldTslVolts:     return r.tslVolts;
+        case FieldTslCurrent:   return r.tslCurrent;
+        case FieldSolar:        return r.solar;
+        case FieldTslMagX:      return r.tslMag[0];
+        case FieldTslMagY:      return r.tslMag[1];
+        case FieldTslMagZ:      return r.tslMag[2];
+        default:                return 0;
+    }
+}
+
+
+/*!
+ * @brief   Engineering units per raw count, as scaleScience() applies them.
+ *          bnoCal and the TSLPB ADC channels are left in counts.
+ */
+double getFieldScale(StoreField field)
+{
+    switch (field) {
+        case FieldMet:
+        case FieldSampleAge:    return GROUND_MET_TICK_S;
+        case FieldQuatW:
+        case FieldQuatX:
+        case FieldQuatY:
+        case FieldQuatZ:        return 1.0 / GROUND_QUAT_SCALE;
+        case FieldBnoMagX:
+        case FieldBnoMagY:
+        case FieldBnoMagZ:      return 1.0 / GROUND_BNOMAG_SCALE;
+        case FieldBmePres:      return 1.0 / GROUND_BMEPRES_SCALE;
+        case FieldBmeTemp:      return 1.0 / GROUND_BMETEMP_SCALE;
+        case FieldTslMagX:
+        case FieldTslMagY:
+        case FieldTslMagZ:      return GROUND_TSLMAG_UT_PER_COUNT;
+        default:                return 1.0;
+    }
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Codecs                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+static inline uint32_t zigzag(int32_t value)     { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+static inline int32_t  unzigzag(uint32_t value)  { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+static inline uint8_t getWidth(uint32_t value)
+{
+    return value ? 32 - __builtin_clz(value) : 0;
+}
+
+/*!
+ * @brief   Bytes taken by count values packed at width bits over STORE_LANES
+ */
+static uint32_t getPackedLength(uint32_t count, uint8_t width)
+{
+    uint32_t perLane = (count + STORE_LANES - 1) / STORE_LANES;
+    return (perLane * width + 31) / 32 * STORE_LANES * sizeof(uint32_t);
+}
+
+/*!
+ * @brief   Packs count values at width bits. Value i goes to lane
+ *          i % STORE_LANES; each lane is a little-endian bit stream of
+ *          32-bit words, and word k of lane l is words[k * STORE_LANES + l].
+ */
+static void pack(const uint32_t* values, uint32_t count, uint8_t width, std::vector<uint32_t>& words)
+{
+    words.assign(getPackedLength(count, width) / sizeof(uint32_t), 0);
+    
+    for (uint32_t i = 0; i < count && width > 0; i++) {
+        uint32_t lane  = i % STORE_LANES;
+        uint32_t bit   = (i / STORE_LANES) * width;
+        uint32_t word  = bit / 32;
+        uint32_t shift = bit % 32;
+        
+        words[word * STORE_LANES + lane] |= values[i] << shift;
+        if (shift + width > 32) {
+            words[(word + 1) * STORE_LANES + lane] |= values[i] >> (32 - shift);
+        }
+    }
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t)value | 0x80);
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static uint32_t getVarint(const uint8_t*& p, const uint8_t* end)
+{
+    uint32_t value = 0;
+    
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Writer                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+static bool writeAt(int fd, const void* data, size_t length, off_t offset)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    
+    while (length > 0) {
+        ssize_t written = pwrite(fd, p, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p      += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
+
+
+bool ColumnStoreWriter::open(const std::string& path)
+{
+    StoreHeader header;
+    
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // Written again by close() with the row count and directory
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    if (!writeAt(fd, &header, sizeof(header), 0)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    
+    rows     = 0;
+    position = sizeof(header);
+    directory.clear();
+    for (int i = 0; i < STORE_FIELD_COUNT; i++) {
+        pending[i].clear();
+        pending[i].reserve(STORE_BLOCK_ROWS);
+    }
+    return true;
+}
+
+
+bool ColumnStoreWriter::append(const ScienceRecord& record)
+{
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+    for (int i = 0; i < STORE_FIELD_COUNT; i++) {
+        pending[i].push_back(getField(record, (StoreField)i));
+    }
+    rows++;
+    
+    return pending[0].size() < STORE_BLOCK_ROWS || writeBlock();
+}
+
+
+bool ColumnStoreWriter::writeBlock()
+{
+    StoreBlock block;
+    uint32_t   count = pending[0].size();
+    
+    if (count == 0) {
+        return true;
+    }
+    memset(&block, 0, sizeof(block));
+    block.rows = count;
+    
+    for (int i = 0; i < STORE_FIELD_COUNT; i++) {
+        if (!writeColumn(pending[i].data(), count, block.columns[i])) {
+            return false;
+        }
+        pending[i].clear();
+    }
+    directory.push_back(block);
+    return true;
+}
+
+
+/*!
+ * @brief   Encodes one column of a block with the smallest codec. Packing
+ *          wins ties; it decodes fastest.
+ */
+bool ColumnStoreWriter::writeColumn(const int32_t* values, uint32_t count, StoreColumn& column)
+{
+    int32_t  low  = *std::min_element(values, values + count);
+    int32_t  high = *std::max_element(values, values + count);
+    uint32_t offsets[STORE_BLOCK_ROWS];
+    int32_t  changes[STORE_BLOCK_ROWS];
+    uint32_t deltas[STORE_BLOCK_ROWS];
+    uint32_t maxDelta = 0;
+    uint32_t runs     = 1;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        offsets[i] = (uint32_t)values[i] - (uint32_t)low;
+        changes[i] = i ? (int32_t)((uint32_t)values[i] - (uint32_t)values[i - 1]) : 0;
+        runs      += (i > 0 && values[i] != values[i - 1]);
+    }
+    
+    // Centre the changes on their midpoint so a steady trend costs no bits
+    int32_t step = 0;
+    if (count > 1) {
+        int64_t minChange = *std::min_element(changes + 1, changes + count);
+        int64_t maxChange = *std::max_element(changes + 1, changes + count);
+        step = (int32_t)((minChange + maxChange) / 2);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        deltas[i] = i ? zigzag((int32_t)((uint32_t)changes[i] - (uint32_t)step)) : 0;
+        maxDelta  = std::max(maxDelta, deltas[i]);
+    }
+    
+    uint8_t  packWidth   = getWidth((uint32_t)high - (uint32_t)low);
+    uint8_t  deltaWidth  = getWidth(maxDelta);
+    uint32_t packLength  = getPackedLength(count, packWidth);
+    uint32_t deltaLength = getPackedLength(count, deltaWidth);
+    
+    std::vector<uint32_t> words;
+    std::vector<uint8_t>  bytes;
+    
+    // Run-length pairs are only worth building when runs are long
+    if (runs * 2 < std::min(packLength, deltaLength)) {
+        for (uint32_t i = 0; i < count; ) {
+            uint32_t run = 1;
+            while (i + run < count && values[i + run] == values[i]) run++;
+            putVarint(bytes, offsets[i]);
+            putVarint(bytes, run);
+            i += run;
+        }
+    }
+    
+    memset(&column, 0, sizeof(column));
+    column.min  = low;
+    column.max  = high;
+    column.base = values[0];
+    
+    const void* payload;
+    if (!bytes.empty() && bytes.size() < std::min(packLength, deltaLength)) {
+        column.codec  = StoreCodecRun;
+        column.length = bytes.size();
+        payload       = bytes.data();
+    } else if (deltaLength < packLength) {
+        column.codec  = StoreCodecDelta;
+        column.width  = deltaWidth;
+        column.step   = step;
+        column.length = deltaLength;
+        pack(deltas, count, deltaWidth, words);
+        payload       = words.data();
+    } else {
+        column.codec  = StoreCodecPack;
+        column.width  = packWidth;
+        column.length = packLength;
+        pack(offsets, count, packWidth, words);
+        payload       = words.data();
+    }
+    
+    column.offset = position;
+    if (column.length > 0) {
+        if (!writeAt(fd, payload, column.length, position)) {
+            return false;
+        }
+        position += (column.length + STORE_ALIGNMENT - 1) / STORE_ALIGNMENT * STORE_ALIGNMENT;
+    }
+    return true;
+}
+
+
+bool ColumnStoreWriter::close()
+{
+    if (fd < 0) {
+        return true;
+    }
+    
+    bool ok = writeBlock();
+    
+    StoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.version         = STORE_VERSION;
+    header.fieldCount      = STORE_FIELD_COUNT;
+    header.blockRows       = STORE_BLOCK_ROWS;
+    header.rowCount        = rows;
+    header.directoryOffset = position;
+    
+    ok = ok && writeAt(fd, directory.data(), directory.size() * sizeof(StoreBlock), position);
+    ok = ok && ftruncate(fd, position + directory.size() * sizeof(StoreBlock)) == 0;
+    ok = ok && writeAt(fd, &header, sizeof(header), 0);
+    position += directory.size() * sizeof(StoreBlock);
+    
+    ok = (::close(fd) == 0) && ok;
+    fd = -1;
+    directory.clear();
+    return ok;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Reader                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+bool ColumnStoreReader::open(const std::string& path)
+{
+    struct stat info;
+    
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0 || fstat(fd, &info) < 0) {
+        close();
+        return false;
+    }
+    if (info.st_size < (off_t)sizeof(StoreHeader)) {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+    
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    map       = (const uint8_t*)mapped;
+    mapLength = info.st_size;
+    
+    const StoreHeader* header = (const StoreHeader*)map;
+    uint64_t           count  = (header->rowCount + STORE_BLOCK_ROWS - 1) / STORE_BLOCK_ROWS;
+    
+    if (memcmp(header->magic, STORE_MAGIC, sizeof(header->magic)) || header->version != STORE_VERSION ||
+        header->fieldCount != STORE_FIELD_COUNT || header->blockRows != STORE_BLOCK_ROWS ||
+        header->directoryOffset < sizeof(StoreHeader) ||
+        header->directoryOffset + count * sizeof(StoreBlock) != mapLength) {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+    
+    rows       = header->rowCount;
+    blockCount = count;
+    blocks     = (const StoreBlock*)(map + header->directoryOffset);
+    
+    // Check every payload lies inside the file, so decoding never reads
+    // outside the mapping
+    for (uint32_t b = 0; b < blockCount; b++) {
+        bool valid = blocks[b].rows > 0 && blocks[b].rows <= STORE_BLOCK_ROWS;
+        for (int i = 0; i < STORE_FIELD_COUNT && valid; i++) {
+            const StoreColumn& column = blocks[b].columns[i];
+            valid = column.codec <= StoreCodecRun && column.width <= 32 &&
+                    column.offset + column.length <= header->directoryOffset &&
+                    (column.codec == StoreCodecRun || column.length >= getPackedLength(blocks[b].rows, column.width));
+        }
+        if (!valid) {
+            close();
+            errno = EINVAL;
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void ColumnStoreReader::close()
+{
+    if (map) {
+        munmap((void*)map, mapLength);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd         = -1;
+    map        = nullptr;
+    mapLength  = 0;
+    rows       = 0;
+    blockCount = 0;
+    blocks     = nullptr;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Decoding                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   Unpacks and reconstructs a bit-packed column. Writes whole lane
+ *          rows, so up to STORE_LANES - 1 values past count.
+ */
+static void unpackScalar(const uint32_t* words, uint32_t count, const StoreColumn& column, int32_t* values)
+{
+    uint32_t perLane = (count + STORE_LANES - 1) / STORE_LANES;
+    uint8_t  width   = column.width;
+    uint32_t mask    = (width == 32) ? 0xFFFFFFFF : (1u << width) - 1;
+    
+    for (uint32_t j = 0; j < perLane; j++) {
+        uint32_t bit   = j * width;
+        uint32_t word  = bit / 32;
+        uint32_t shift = bit % 32;
+        
+        for (uint32_t lane = 0; lane < STORE_LANES; lane++) {
+            uint32_t value = 0;
+            if (width > 0) {
+                value = words[word * STORE_LANES + lane] >> shift;
+                if (shift + width > 32) {
+                    value |= words[(word + 1) * STORE_LANES + lane] << (32 - shift);
+                }
+            }
+            values[j * STORE_LANES + lane] = value & mask;
+        }
+    }
+    
+    if (column.codec == StoreCodecDelta) {
+        uint32_t sum = column.base;
+        for (uint32_t i = 0; i < perLane * STORE_LANES; i++) {
+            sum      += (i ? (uint32_t)unzigzag(values[i]) + (uint32_t)column.step : 0);
+            values[i] = sum;
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < perLane * STORE_LANES; i++) {
+        values[i] = (uint32_t)values[i] + (uint32_t)column.min;
+    }
+}
+
+
+#if GROUND_HAVE_X86
+
+__attribute__((target("avx2")))
+static void unpackAVX2(const uint32_t* words, uint32_t count, const StoreColumn& column, int32_t* values)
+{
+    uint32_t perLane = (count + STORE_LANES - 1) / STORE_LANES;
+    uint8_t  width   = column.width;
+    __m256i  mask    = _mm256_set1_epi32((width == 32) ? -1 : (int)((1u << width) - 1));
+    __m256i  one     = _mm256_set1_epi32(1);
+    __m256i  zero    = _mm256_setzero_si256();
+    __m256i  last    = _mm256_set1_epi32(7);
+    __m256i  middle  = _mm256_set1_epi32(3);
+    __m256i  step    = _mm256_set1_epi32(column.step);
+    __m256i  carry   = _mm256_set1_epi32((int32_t)((uint32_t)column.base - (uint32_t)column.step));
+    __m256i  low     = _mm256_set1_epi32(column.min);
+    bool     delta   = (column.codec == StoreCodecDelta);
+    
+    for (uint32_t j = 0; j < perLane; j++) {
+        uint32_t bit   = j * width;
+        uint32_t word  = bit / 32;
+        uint32_t shift = bit % 32;
+        __m256i  v     = zero;
+        
+        if (width > 0) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)&words[word * STORE_LANES]);
+            v = _mm256_srl_epi32(a, _mm_cvtsi32_si128(shift));
+            if (shift + width > 32) {
+                __m256i b = _mm256_loadu_si256((const __m256i*)&words[(word + 1) * STORE_LANES]);
+                v = _mm256_or_si256(v, _mm256_sll_epi32(b, _mm_cvtsi32_si128(32 - shift)));
+            }
+            v = _mm256_and_si256(v, mask);
+        }
+        
+        if (delta) {
+            // Unzigzag and restore the step, then an 8-lane prefix sum:
+            // within each 128-bit half, then the low half's total added to
+            // the high half. Row 0 holds 0 + step, so the carry starts at
+            // base - step.
+            v = _mm256_xor_si256(_mm256_srli_epi32(v, 1), _mm256_sub_epi32(zero, _mm256_and_si256(v, one)));
+            v = _mm256_add_epi32(v, step);
+            v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+            v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+            __m256i lowTotal = _mm256_permutevar8x32_epi32(v, middle);
+            v = _mm256_add_epi32(v, _mm256_blend_epi32(zero, lowTotal, 0xF0));
+            v = _mm256_add_epi32(v, carry);
+            carry = _mm256_permutevar8x32_epi32(v, last);
+        } else {
+            v = _mm256_add_epi32(v, low);
+        }
+        _mm256_storeu_si256((__m256i*)&values[j * STORE_LANES], v);
+    }
+}
+
+#endif /* GROUND_HAVE_X86 */
+
+
+/*!
+ * @brief   Decodes one column of a block into values, which must hold
+ *          STORE_BLOCK_ROWS entries. DecodeSSE41 uses the scalar path.
+ */
+void ColumnStoreReader::decodeColumn(uint32_t block, StoreField field, int32_t* values, DecodePath path) const
+{
+    const StoreColumn& column = blocks[block].columns[field];
+    uint32_t           count  = blocks[block].rows;
+    const uint8_t*     data   = map + column.offset;
+    
+    if (column.codec == StoreCodecRun) {
+        const uint8_t* p   = data;
+        const uint8_t* end = data + column.length;
+        for (uint32_t i = 0; i < count; ) {
+            int32_t  value = (uint32_t)column.min + getVarint(p, end);
+            uint32_t run   = std::min(getVarint(p, end), count - i);
+            if (run == 0) {
+                run = count - i;    // Truncated payload; open() checked the rest
+            }
+            std::fill(values + i, values + i + run, value);
+            i += run;
+        }
+        return;
+    }
+    
+    if (path == DecodeAuto || path > getBestDecodePath()) {
+        path = getBestDecodePath();
+    }
+#if GROUND_HAVE_X86
+    if (path == DecodeAVX2) {
+        unpackAVX2((const uint32_t*)data, count, column, values);
+        return;
+    }
+#endif
+    unpackScalar((const uint32_t*)data, count, column, values);
+}
+
+
+} /* namespace ground */
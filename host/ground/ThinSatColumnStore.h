@@ -0,0 +1,232 @@
+/**
+ *  @file   ThinSatColumnStore.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Compressed columnar store of decoded science frames.
+ *
+ *          Rows are grouped in blocks of STORE_BLOCK_ROWS. Within a block
+ *          each UserDataStruct_t field is a column of its raw integer values,
+ *          compressed with whichever codec is smallest for that block:
+ *          - StoreCodecPack: value - min, bit-packed
+ *          - StoreCodecDelta: zigzag of the change from the previous row
+ *            less the block's typical change, bit-packed (smooth channels,
+ *            and met, which packs to nothing at a steady cadence)
+ *          - StoreCodecRun: run-length (value, count) pairs (bnoCal)
+ *          A column that never changes in a block is packed at width 0 and
+ *          takes no space at all.
+ *
+ *          Bit-packed values are interleaved across 8 lanes of 32-bit
+ *          words, so AVX2 unpacks 8 rows per step, and the delta prefix sum
+ *          runs in the same registers. The block directory at the end of the
+ *          file keeps each column's min and max (a zone map), so a scan can
+ *          skip blocks that cannot match a predicate without reading them.
+ *
+ *          The store falls short of a tenfold reduction on flight-like data. A
+ *          12 h simulated orbit (thinsat_host --orbit) stores 6.1x smaller than
+ *          its frames. The adaptive cadence sends extra frames between the 5 s
+ *          ones, so met changes by anything from 0 to 50 ticks and costs 6 bits
+ *          a row, against an entropy of 4.5 bits. Neither a delta of deltas
+ *          (entropy 5.7 bits) nor runs of equal steps (four rows in five start
+ *          a new run) does better, and even a free met would only give 6.9x;
+ *          solar and tslTempExt take most of the rest.
+ *
+ *          File layout: StoreHeader, column payloads (32-byte aligned), then
+ *          one StoreBlock per block at directoryOffset. The writer fills in
+ *          the header last, so a file whose header has no directory was not
+ *          closed and is rejected.
+ *
+ * @code
+ *  ground::ColumnStoreReader store;
+ *  int32_t                   values[STORE_BLOCK_ROWS];
+ *
+ *  store.open("mission.tsc");
+ *  for (uint32_t b = 0; b < store.getBlockCount(); b++) {
+ *      if (store.mayContain(b, ground::FieldSolar, 900, 1023)) {
+ *          store.decodeColumn(b, ground::FieldSolar, values);
+ *      }
+ *  }
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatColumnStore_h
+#define ThinSatColumnStore_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatColumns.h"
+
+
+namespace ground {
+
+
+#define STORE_MAGIC             "TSLCOLS1"
+#define STORE_VERSION           2
+#define STORE_BLOCK_ROWS        1024    ///< Rows per block. A multiple of STORE_LANES
+#define STORE_LANES             8       ///< 32-bit lanes the packed values are interleaved over
+#define STORE_ALIGNMENT         32      ///< Column payloads start on this boundary
+
+
+/*!
+ * @brief   Columns of the store, one per UserDataStruct_t field
+ */
+typedef enum
+{
+    FieldMet = 0,
+    FieldSampleAge,
+    FieldQuatW,                     ///< Unpacked quaternion, Q14
+    FieldQuatX,
+    FieldQuatY,
+    FieldQuatZ,
+    FieldBnoMagX,
+    FieldBnoMagY,
+    FieldBnoMagZ,
+    FieldBnoCal,
+    FieldBmePres,
+    FieldBmeTemp,
+    FieldTslTempExt,
+    FieldTslVolts,
+    FieldTslCurrent,
+    FieldSolar,
+    FieldTslMagX,
+    FieldTslMagY,
+    FieldTslMagZ,
+    STORE_FIELD_COUNT                   ///< Number of fields. Not a valid field
+} StoreField;
+
+
+typedef enum
+{
+    StoreCodecPack  = 0,
+    StoreCodecDelta = 1,
+    StoreCodecRun   = 2
+} StoreCodec;
+
+
+typedef struct __attribute__((__packed__))
+{
+    char        magic[8];           ///< STORE_MAGIC
+    uint16_t    version;            ///< STORE_VERSION
+    uint16_t    fieldCount;         ///< STORE_FIELD_COUNT
+    uint16_t    blockRows;          ///< STORE_BLOCK_ROWS
+    uint16_t    reserved;
+    uint64_t    rowCount;
+    uint64_t    directoryOffset;    ///< 0 until the writer is closed
+} StoreHeader;
+
+
+/*!
+ * @brief   One column of one block. min and max are the zone map.
+ */
+typedef struct __attribute__((__packed__))
+{
+    uint8_t     codec;              ///< StoreCodec
+    uint8_t     width;              ///< Bits per packed value
+    uint16_t    reserved;
+    int32_t     min;
+    int32_t     max;
+    int32_t     base;               ///< First row's value (StoreCodecDelta)
+    uint64_t    offset;             ///< Payload position in the file
+    uint32_t    length;             ///< Payload bytes
+    int32_t     step;               ///< Typical change per row, removed before zigzag (StoreCodecDelta)
+} StoreColumn;
+
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t    rows;
+    uint32_t    reserved;
+    StoreColumn columns[STORE_FIELD_COUNT];
+} StoreBlock;
+
+
+const char* getFieldName(StoreField field);
+bool        findField(const char* name, StoreField& field);
+int32_t     getField(const ScienceRecord& record, StoreField field);
+double      getFieldScale(StoreField field);
+
+
+/*!
+ * @brief   Writes a store. Rows are buffered until a block is full; close()
+ *          writes the last block, the directory and the header.
+ */
+class ColumnStoreWriter
+{
+    
+public:
+    ~ColumnStoreWriter() { close(); }
+    
+    bool     open(const std::string& path);
+    bool     append(const ScienceRecord& record);
+    bool     close();
+    
+    uint64_t getRowCount()      { return rows; }
+    uint64_t getBytesWritten()  { return position; }
+    
+private:
+    
+    bool     writeBlock();
+    bool     writeColumn(const int32_t* values, uint32_t count, StoreColumn& column);
+    
+    int                     fd          = -1;
+    uint64_t                rows        = 0;
+    uint64_t                position    = 0;
+    std::vector<StoreBlock> directory;
+    std::vector<int32_t>    pending[STORE_FIELD_COUNT];
+    
+};
+
+
+/*!
+ * @brief   Read-only, memory-mapped view of a closed store
+ */
+class ColumnStoreReader
+{
+    
+public:
+    ~ColumnStoreReader() { close(); }
+    
+    bool     open(const std::string& path);
+    void     close();
+    
+    uint64_t getRowCount() const        { return rows; }
+    uint32_t getBlockCount() const      { return blockCount; }
+    uint64_t getFileSize() const        { return mapLength; }
+    const StoreBlock& getBlock(uint32_t block) const { return blocks[block]; }
+    
+    /*!
+     * @brief   Returns false if no row of block can have low <= field <= high
+     */
+    bool     mayContain(uint32_t block, StoreField field, int32_t low, int32_t high) const
+    {
+        const StoreColumn& column = blocks[block].columns[field];
+        return column.max >= low && column.min <= high;
+    }
+    
+    void     decodeColumn(uint32_t block, StoreField field, int32_t* values,
+                          DecodePath path = DecodeAuto) const;
+    
+private:
+    
+    int                 fd          = -1;
+    const uint8_t*      map         = nullptr;
+    size_t              mapLength   = 0;
+    uint64_t            rows        = 0;
+    uint32_t            blockCount  = 0;
+    const StoreBlock*   blocks      = nullptr;
+    
+};
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatColumnStore_h */
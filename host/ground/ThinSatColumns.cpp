@@ -0,0 +1,522 @@
+/**
+ *  @file   ThinSatColumns.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Batch decoding of science frames into columns.
+ *
+ *          The vector kernels never read outside a frame. The int16 runs
+ *          (BNO055 and AK8963 fields) are loaded 8 bytes per frame and
+ *          transposed with shuffles. The vector paths unpack the
+ *          smallest-three quaternion with a float square root stepped to
+ *          the integer root of unpackQuaternion(), which the scalar path
+ *          calls, so all paths give the same bits. The remaining fields are
+ *          loaded as the 32-bit word that ends with them (a gather on AVX2),
+ *          so an int16 field is the word's top half and an arithmetic shift
+ *          sign-extends it. Gathers were slower than the transposes for the
+ *          int16 runs.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <string.h>
+
+#include "ThinSatColumns.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GROUND_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define GROUND_HAVE_X86 0
+#endif
+
+#define QUAT_ONE_SQUARED    ((int32_t)(GROUND_QUAT_SCALE * GROUND_QUAT_SCALE))    ///< 1.0 in Q28
+
+
+namespace ground {
+
+
+void ScienceColumns::resize(size_t count)
+{
+    met.resize(count);
+    sampleAge.resize(count);
+    for (int i = 0; i < 4; i++) {
+        quat[i].resize(count);
+    }
+    for (int i = 0; i < 3; i++) {
+        bnomag[i].resize(count);
+        tslMag[i].resize(count);
+    }
+    bnoCal.resize(count);
+    pressure.resize(count);
+    temperature.resize(count);
+    tslTempExt.resize(count);
+    tslVolts.resize(count);
+    tslCurrent.resize(count);
+    solar.resize(count);
+}
+
+
+/*!
+ * @brief   Raw column pointers, offset to the first row being decoded. The
+ *          kernels write through these rather than the vectors: the uint8_t
+ *          columns may alias anything, so writes through them would force
+ *          every vector's data pointer to be reloaded on each row.
+ */
+typedef struct
+{
+    uint32_t*   met;
+    uint8_t*    sampleAge;
+    float*      quat[4];
+    float*      bnomag[3];
+    uint8_t*    bnoCal;
+    float*      pressure;
+    float*      temperature;
+    uint16_t*   tslTempExt;
+    uint16_t*   tslVolts;
+    uint16_t*   tslCurrent;
+    uint16_t*   solar;
+    float*      tslMag[3];
+} ColumnPointers;
+
+
+static ColumnPointers getColumnPointers(ScienceColumns& columns, size_t row)
+{
+    ColumnPointers c;
+    
+    c.met       = &columns.met[row];
+    c.sampleAge = &columns.sampleAge[row];
+    for (int k = 0; k < 4; k++) {
+        c.quat[k] = &columns.quat[k][row];
+    }
+    for (int k = 0; k < 3; k++) {
+        c.bnomag[k] = &columns.bnomag[k][row];
+        c.tslMag[k] = &columns.tslMag[k][row];
+    }
+    c.bnoCal      = &columns.bnoCal[row];
+    c.pressure    = &columns.pressure[row];
+    c.temperature = &columns.temperature[row];
+    c.tslTempExt  = &columns.tslTempExt[row];
+    c.tslVolts    = &columns.tslVolts[row];
+    c.tslCurrent  = &columns.tslCurrent[row];
+    c.solar       = &columns.solar[row];
+    return c;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                   Scalar Path                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define SCALAR_BLOCK    64      ///< Frames per block; 2.4 KB, stays in L1
+
+/*!
+ * @brief   Decodes one field of every frame in a block. Working one column
+ *          at a time fills whole cache lines of each column before moving to
+ *          the next. Writing one element to each of 19 columns per frame is
+ *          several times slower once the columns outgrow the cache, because
+ *          equally aligned columns compete for the same cache sets.
+ */
+template <typename T, typename Decode>
+static inline void decodeField(const uint8_t* frames, size_t count, T* out, Decode decode)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = decode(&frames[i * NSL_PACKET_SIZE]);
+    }
+}
+
+static inline void decodeQuaternions(const uint8_t* frames, size_t count, ColumnPointers& c, size_t row)
+{
+    for (size_t i = 0; i < count; i++) {
+        int16_t q[4];
+        unpackQuaternion(readU32(&frames[i * NSL_PACKET_SIZE + GROUND_OFFSET_QUAT]), q);
+        for (int k = 0; k < 4; k++) {
+            c.quat[k][row + i] = (float)q[k] * GROUND_QUAT_PER_COUNT;
+        }
+    }
+}
+
+static void decodeScalar(const uint8_t* frames, size_t count, ColumnPointers c, size_t row)
+{
+    for (size_t i = 0; i < count; i += SCALAR_BLOCK, row += SCALAR_BLOCK) {
+        const uint8_t* f = &frames[i * NSL_PACKET_SIZE];
+        size_t         n = count - i < SCALAR_BLOCK ? count - i : SCALAR_BLOCK;
+        
+        decodeField(f, n, &c.met[row],       [](const uint8_t* p) { return readU24(&p[GROUND_OFFSET_MET]); });
+        decodeField(f, n, &c.sampleAge[row], [](const uint8_t* p) { return p[GROUND_OFFSET_AGE]; });
+        decodeQuaternions(f, n, c, row);
+        for (int k = 0; k < 3; k++) {
+            decodeField(f, n, &c.bnomag[k][row], [k](const uint8_t* p) {
+                return (float)readI16(&p[GROUND_OFFSET_BNOMAG + 2 * k]) * GROUND_BNOMAG_UT_PER_COUNT;
+            });
+            decodeField(f, n, &c.tslMag[k][row], [k](const uint8_t* p) {
+                return (float)readI16(&p[GROUND_OFFSET_TSLMAG + 2 * k]) * GROUND_TSLMAG_UT_PER_COUNT_F;
+            });
+        }
+        decodeField(f, n, &c.bnoCal[row], [](const uint8_t* p) { return p[GROUND_OFFSET_BNOCAL]; });
+        decodeField(f, n, &c.pressure[row], [](const uint8_t* p) {
+            return (float)readU24(&p[GROUND_OFFSET_BMEPRES]) * GROUND_BMEPRES_PA_PER_COUNT;
+        });
+        decodeField(f, n, &c.temperature[row], [](const uint8_t* p) {
+            return (float)readI16(&p[GROUND_OFFSET_BMETEMP]) * GROUND_BMETEMP_C_PER_COUNT;
+        });
+        decodeField(f, n, &c.tslTempExt[row], [](const uint8_t* p) {
+            return (uint16_t)(readU32(&p[GROUND_OFFSET_ADC]) & 0x3FF);
+        });
+        decodeField(f, n, &c.tslVolts[row], [](const uint8_t* p) {
+            return (uint16_t)((readU32(&p[GROUND_OFFSET_ADC]) >> 10) & 0x3FF);
+        });
+        decodeField(f, n, &c.tslCurrent[row], [](const uint8_t* p) {
+            return (uint16_t)((readU32(&p[GROUND_OFFSET_ADC]) >> 20) & 0x3FF);
+        });
+        decodeField(f, n, &c.solar[row], [](const uint8_t* p) {
+            return (uint16_t)(readU32(&p[GROUND_OFFSET_ADC + 1]) >> 22);
+        });
+    }
+}
+
+
+#if GROUND_HAVE_X86
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    AVX2 Path                     │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define AVX2_FRAMES     8
+
+__attribute__((target("avx2")))
+static inline void storeU8x8(uint8_t* out, __m256i v)
+{
+    const __m256i pick = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                          0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m256i  b  = _mm256_shuffle_epi8(v, pick);
+    uint32_t lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(b));
+    uint32_t hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(b, 1));
+    memcpy(out,     &lo, 4);
+    memcpy(out + 4, &hi, 4);
+}
+
+__attribute__((target("avx2")))
+static inline void storeU16x8(uint16_t* out, __m256i v)
+{
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(packed));
+}
+
+__attribute__((target("avx2")))
+static inline void storeI16x8(float* out, __m256i word, float scale)
+{
+    __m256 value = _mm256_cvtepi32_ps(_mm256_srai_epi32(word, 16));
+    _mm256_storeu_ps(out, _mm256_mul_ps(value, _mm256_set1_ps(scale)));
+}
+
+/*!
+ * @brief   Loads four int16 fields from each of eight frames, scales them and
+ *          transposes them so each output vector holds one field. Frames j
+ *          and j + 4 share a row, so the in-lane transpose leaves frames 0-3
+ *          in the low lane and 4-7 in the high lane.
+ */
+__attribute__((target("avx2")))
+static inline void loadI16Block8(const uint8_t* f, size_t offset, float scale, __m256 out[4])
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    __m256       r[4];
+    
+    for (int j = 0; j < 4; j++) {
+        __m128i lo    = _mm_loadl_epi64((const __m128i*)&f[j * NSL_PACKET_SIZE + offset]);
+        __m128i hi    = _mm_loadl_epi64((const __m128i*)&f[(j + 4) * NSL_PACKET_SIZE + offset]);
+        __m256i words = _mm256_cvtepi16_epi32(_mm_unpacklo_epi64(lo, hi));
+        r[j] = _mm256_mul_ps(_mm256_cvtepi32_ps(words), s);
+    }
+    
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+    __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+    __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    out[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    out[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    out[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    out[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+/*!
+ * @brief   Unpacks the smallest-three quaternions of eight frames, with the
+ *          same bits as unpackQuaternion(). The rounded square root is taken
+ *          in float, which is within one of the integer result since every
+ *          operand is below 2^28, and then stepped to the integer that
+ *          unpackQuaternion() gives: the k with k^2 - k < r <= k^2 + k, or
+ *          0 for r = 0.
+ */
+__attribute__((target("avx2")))
+static inline void decodeQuaternions8(const uint8_t* f, __m256i index, ColumnPointers& c, size_t row)
+{
+    const __m256i mask   = _mm256_set1_epi32(GROUND_QUAT_CODE_MAX);
+    const __m256i offset = _mm256_set1_epi32(GROUND_QUAT_CODE_ZERO);
+    const __m256i mul    = _mm256_set1_epi32(GROUND_QUAT_DECODE_MUL);
+    const __m256i half   = _mm256_set1_epi32(1 << 15);
+    const __m256i one    = _mm256_set1_epi32(1);
+    const __m256  scale  = _mm256_set1_ps(GROUND_QUAT_PER_COUNT);
+    __m256i       packed = _mm256_i32gather_epi32((const int*)(f + GROUND_OFFSET_QUAT), index, 1);
+    __m256i       stored[3];
+    __m256i       squares = _mm256_setzero_si256();
+    
+    for (int j = 0; j < 3; j++) {
+        __m256i code = _mm256_and_si256(_mm256_srli_epi32(packed, 20 - GROUND_QUAT_BITS * j), mask);
+        __m256i q    = _mm256_mullo_epi32(_mm256_sub_epi32(code, offset), mul);
+        stored[j] = _mm256_srai_epi32(_mm256_add_epi32(q, half), 16);
+        squares   = _mm256_add_epi32(squares, _mm256_mullo_epi32(stored[j], stored[j]));
+    }
+    
+    __m256i r    = _mm256_max_epi32(_mm256_sub_epi32(_mm256_set1_epi32(QUAT_ONE_SQUARED), squares), _mm256_setzero_si256());
+    __m256i root = _mm256_cvtps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(r)));
+    __m256i sq   = _mm256_mullo_epi32(root, root);
+    __m256i up   = _mm256_cmpgt_epi32(r, _mm256_add_epi32(sq, root));
+    __m256i down = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_sub_epi32(sq, root), _mm256_sub_epi32(r, one)),
+                                    _mm256_cmpgt_epi32(r, _mm256_setzero_si256()));
+    root = _mm256_add_epi32(_mm256_sub_epi32(root, up), down);
+    
+    // The stored components fill the places around the dropped one
+    __m256i largest = _mm256_srli_epi32(packed, GROUND_QUAT_INDEX_SHIFT);
+    __m256i q[4];
+    q[0] = stored[0];
+    q[1] = _mm256_blendv_epi8(stored[1], stored[0], _mm256_cmpeq_epi32(largest, _mm256_set1_epi32(0)));
+    q[2] = _mm256_blendv_epi8(stored[2], stored[1], _mm256_cmpgt_epi32(_mm256_set1_epi32(2), largest));
+    q[3] = stored[2];
+    for (int k = 0; k < 4; k++) {
+        q[k] = _mm256_blendv_epi8(q[k], root, _mm256_cmpeq_epi32(largest, _mm256_set1_epi32(k)));
+        _mm256_storeu_ps(&c.quat[k][row], _mm256_mul_ps(_mm256_cvtepi32_ps(q[k]), scale));
+    }
+}
+
+__attribute__((target("avx2")))
+static void decodeAVX2(const uint8_t* frames, size_t count, ColumnPointers c)
+{
+    const __m256i stride = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i index  = _mm256_mullo_epi32(stride, _mm256_set1_epi32(NSL_PACKET_SIZE));
+    const __m256i mask10 = _mm256_set1_epi32(0x3FF);
+    size_t        i      = 0;
+    size_t        row    = 0;
+    __m256        block[4];
+    
+    #define GATHER(offset)  _mm256_i32gather_epi32((const int*)(f + (offset)), index, 1)
+    #define GATHER16(offset) GATHER((offset) - 2)    ///< Word ending with the int16 at offset
+    
+    for (; i + AVX2_FRAMES <= count; i += AVX2_FRAMES, row += AVX2_FRAMES) {
+        const uint8_t* f = &frames[i * NSL_PACKET_SIZE];
+        
+        __m256i head = GATHER(GROUND_OFFSET_MET);
+        _mm256_storeu_si256((__m256i*)&c.met[row], _mm256_and_si256(head, _mm256_set1_epi32(0xFFFFFF)));
+        storeU8x8(&c.sampleAge[row], _mm256_srli_epi32(head, 24));
+        
+        decodeQuaternions8(f, index, c, row);
+        loadI16Block8(f, GROUND_OFFSET_BNOMAG, GROUND_BNOMAG_UT_PER_COUNT, block);
+        for (int k = 0; k < 3; k++) {
+            _mm256_storeu_ps(&c.bnomag[k][row], block[k]);
+        }
+        loadI16Block8(f, GROUND_OFFSET_TSLMAG - 2, GROUND_TSLMAG_UT_PER_COUNT_F, block);
+        for (int k = 0; k < 3; k++) {
+            _mm256_storeu_ps(&c.tslMag[k][row], block[k + 1]);
+        }
+        
+        storeU8x8(&c.bnoCal[row], _mm256_srli_epi32(GATHER(GROUND_OFFSET_BNOCAL - 3), 24));
+        __m256 pres = _mm256_cvtepi32_ps(_mm256_srli_epi32(GATHER(GROUND_OFFSET_BMEPRES - 1), 8));
+        _mm256_storeu_ps(&c.pressure[row], _mm256_mul_ps(pres, _mm256_set1_ps(GROUND_BMEPRES_PA_PER_COUNT)));
+        storeI16x8(&c.temperature[row], GATHER16(GROUND_OFFSET_BMETEMP), GROUND_BMETEMP_C_PER_COUNT);
+        
+        __m256i adc = GATHER(GROUND_OFFSET_ADC);
+        storeU16x8(&c.tslTempExt[row], _mm256_and_si256(adc, mask10));
+        storeU16x8(&c.tslVolts[row],   _mm256_and_si256(_mm256_srli_epi32(adc, 10), mask10));
+        storeU16x8(&c.tslCurrent[row], _mm256_and_si256(_mm256_srli_epi32(adc, 20), mask10));
+        storeU16x8(&c.solar[row],      _mm256_srli_epi32(GATHER(GROUND_OFFSET_ADC + 1), 22));
+    }
+    
+    #undef GATHER16
+    #undef GATHER
+    
+    decodeScalar(&frames[i * NSL_PACKET_SIZE], count - i, c, row);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                   SSE4.1 Path                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define SSE_FRAMES      4
+
+/*!
+ * @brief   Loads four int16 fields from each of four frames, scales them and
+ *          transposes them so each output vector holds one field.
+ */
+__attribute__((target("sse4.1")))
+static inline void loadI16Block(const uint8_t* f, size_t offset, float scale, __m128 out[4])
+{
+    const __m128 s = _mm_set1_ps(scale);
+    
+    for (int j = 0; j < SSE_FRAMES; j++) {
+        __m128i words = _mm_loadl_epi64((const __m128i*)&f[j * NSL_PACKET_SIZE + offset]);
+        out[j] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(words)), s);
+    }
+    _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i loadWords(const uint8_t* f, size_t offset)
+{
+    return _mm_setr_epi32(readU32(&f[offset]),                       readU32(&f[offset + NSL_PACKET_SIZE]),
+                          readU32(&f[offset + 2 * NSL_PACKET_SIZE]), readU32(&f[offset + 3 * NSL_PACKET_SIZE]));
+}
+
+__attribute__((target("sse4.1")))
+static inline void storeU8x4(uint8_t* out, __m128i v)
+{
+    uint32_t bytes = _mm_cvtsi128_si32(_mm_shuffle_epi8(v, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+                                                                         -1, -1, -1, -1, -1, -1, -1, -1)));
+    memcpy(out, &bytes, 4);
+}
+
+__attribute__((target("sse4.1")))
+static inline void storeU16x4(uint16_t* out, __m128i v)
+{
+    _mm_storel_epi64((__m128i*)out, _mm_packus_epi32(v, v));
+}
+
+/*!
+ * @brief   Unpacks the smallest-three quaternions of four frames, as
+ *          decodeQuaternions8() does
+ */
+__attribute__((target("sse4.1")))
+static inline void decodeQuaternions4(const uint8_t* f, ColumnPointers& c, size_t row)
+{
+    const __m128i mask   = _mm_set1_epi32(GROUND_QUAT_CODE_MAX);
+    const __m128i offset = _mm_set1_epi32(GROUND_QUAT_CODE_ZERO);
+    const __m128i mul    = _mm_set1_epi32(GROUND_QUAT_DECODE_MUL);
+    const __m128i half   = _mm_set1_epi32(1 << 15);
+    const __m128i one    = _mm_set1_epi32(1);
+    const __m128  scale  = _mm_set1_ps(GROUND_QUAT_PER_COUNT);
+    __m128i       packed = loadWords(f, GROUND_OFFSET_QUAT);
+    __m128i       stored[3];
+    __m128i       squares = _mm_setzero_si128();
+    
+    for (int j = 0; j < 3; j++) {
+        __m128i code = _mm_and_si128(_mm_srli_epi32(packed, 20 - GROUND_QUAT_BITS * j), mask);
+        __m128i q    = _mm_mullo_epi32(_mm_sub_epi32(code, offset), mul);
+        stored[j] = _mm_srai_epi32(_mm_add_epi32(q, half), 16);
+        squares   = _mm_add_epi32(squares, _mm_mullo_epi32(stored[j], stored[j]));
+    }
+    
+    __m128i r    = _mm_max_epi32(_mm_sub_epi32(_mm_set1_epi32(QUAT_ONE_SQUARED), squares), _mm_setzero_si128());
+    __m128i root = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(r)));
+    __m128i sq   = _mm_mullo_epi32(root, root);
+    __m128i up   = _mm_cmpgt_epi32(r, _mm_add_epi32(sq, root));
+    __m128i down = _mm_and_si128(_mm_cmpgt_epi32(_mm_sub_epi32(sq, root), _mm_sub_epi32(r, one)),
+                                    _mm_cmpgt_epi32(r, _mm_setzero_si128()));
+    root = _mm_add_epi32(_mm_sub_epi32(root, up), down);
+    
+    __m128i largest = _mm_srli_epi32(packed, GROUND_QUAT_INDEX_SHIFT);
+    __m128i q[4];
+    q[0] = stored[0];
+    q[1] = _mm_blendv_epi8(stored[1], stored[0], _mm_cmpeq_epi32(largest, _mm_set1_epi32(0)));
+    q[2] = _mm_blendv_epi8(stored[2], stored[1], _mm_cmpgt_epi32(_mm_set1_epi32(2), largest));
+    q[3] = stored[2];
+    for (int k = 0; k < 4; k++) {
+        q[k] = _mm_blendv_epi8(q[k], root, _mm_cmpeq_epi32(largest, _mm_set1_epi32(k)));
+        _mm_storeu_ps(&c.quat[k][row], _mm_mul_ps(_mm_cvtepi32_ps(q[k]), scale));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void decodeSSE41(const uint8_t* frames, size_t count, ColumnPointers c)
+{
+    const __m128i mask10 = _mm_set1_epi32(0x3FF);
+    size_t        i      = 0;
+    size_t        row    = 0;
+    __m128        block[4];
+    
+    for (; i + SSE_FRAMES <= count; i += SSE_FRAMES, row += SSE_FRAMES) {
+        const uint8_t* f = &frames[i * NSL_PACKET_SIZE];
+        
+        __m128i head = loadWords(f, GROUND_OFFSET_MET);
+        _mm_storeu_si128((__m128i*)&c.met[row], _mm_and_si128(head, _mm_set1_epi32(0xFFFFFF)));
+        storeU8x4(&c.sampleAge[row], _mm_srli_epi32(head, 24));
+        
+        // bnomagx..z plus bnoCal/bmePres (dropped), then the ADC tail
+        // (dropped) plus tslMagX..Z
+        decodeQuaternions4(f, c, row);
+        loadI16Block(f, GROUND_OFFSET_BNOMAG, GROUND_BNOMAG_UT_PER_COUNT, block);
+        for (int k = 0; k < 3; k++) {
+            _mm_storeu_ps(&c.bnomag[k][row], block[k]);
+        }
+        loadI16Block(f, GROUND_OFFSET_TSLMAG - 2, GROUND_TSLMAG_UT_PER_COUNT_F, block);
+        for (int k = 0; k < 3; k++) {
+            _mm_storeu_ps(&c.tslMag[k][row], block[k + 1]);
+        }
+        
+        storeU8x4(&c.bnoCal[row], _mm_srli_epi32(loadWords(f, GROUND_OFFSET_BNOCAL - 3), 24));
+        __m128 pres = _mm_cvtepi32_ps(_mm_srli_epi32(loadWords(f, GROUND_OFFSET_BMEPRES - 1), 8));
+        _mm_storeu_ps(&c.pressure[row], _mm_mul_ps(pres, _mm_set1_ps(GROUND_BMEPRES_PA_PER_COUNT)));
+        __m128 temp = _mm_cvtepi32_ps(_mm_srai_epi32(loadWords(f, GROUND_OFFSET_BMETEMP - 2), 16));
+        _mm_storeu_ps(&c.temperature[row], _mm_mul_ps(temp, _mm_set1_ps(GROUND_BMETEMP_C_PER_COUNT)));
+        
+        __m128i adc = loadWords(f, GROUND_OFFSET_ADC);
+        storeU16x4(&c.tslTempExt[row], _mm_and_si128(adc, mask10));
+        storeU16x4(&c.tslVolts[row],   _mm_and_si128(_mm_srli_epi32(adc, 10), mask10));
+        storeU16x4(&c.tslCurrent[row], _mm_and_si128(_mm_srli_epi32(adc, 20), mask10));
+        storeU16x4(&c.solar[row],      _mm_srli_epi32(loadWords(f, GROUND_OFFSET_ADC + 1), 22));
+    }
+    
+    decodeScalar(&frames[i * NSL_PACKET_SIZE], count - i, c, row);
+}
+
+#endif /* GROUND_HAVE_X86 */
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Dispatch                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+DecodePath getBestDecodePath()
+{
+#if GROUND_HAVE_X86
+    if (__builtin_cpu_supports("avx2"))     return DecodeAVX2;
+    if (__builtin_cpu_supports("sse4.1"))   return DecodeSSE41;
+#endif
+    return DecodeScalar;
+}
+
+
+const char* getDecodePathName(DecodePath path)
+{
+    switch (path) {
+        case DecodeScalar:  return "scalar";
+        case DecodeSSE41:   return "sse4.1";
+        case DecodeAVX2:    return "avx2";
+        default:            return "auto";
+    }
+}
+
+
+void decodeColumns(const uint8_t* frames, size_t count, ScienceColumns& columns,
+                   size_t first, DecodePath path)
+{
+    DecodePath best = getBestDecodePath();
+    
+    if (path == DecodeAuto || path > best) {
+        path = best;
+    }
+    
+    if (count == 0) {
+        return;
+    }
+    ColumnPointers c = getColumnPointers(columns, first);
+    
+    switch (path) {
+#if GROUND_HAVE_X86
+        case DecodeAVX2:    decodeAVX2(frames, count, c);       break;
+        case DecodeSSE41:   decodeSSE41(frames, count, c);      break;
+#endif
+        default:            decodeScalar(frames, count, c, 0);  break;
+    }
+}
+
+
+} /* namespace ground */
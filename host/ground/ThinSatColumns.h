@@ -0,0 +1,103 @@
+/**
+ *  @file   ThinSatColumns.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Batch decoding of science frames into columns (one array per
+ *          UserDataStruct_t field).
+ *
+ *          decodeColumns() takes a contiguous run of NSL_PACKET_SIZE science
+ *          frames, such as an archive read straight from disk, and writes
+ *          each field to its own column. AVX2 and SSE4.1 kernels are chosen
+ *          at run time; the scalar path is used everywhere else. All paths
+ *          produce bit-identical columns.
+ *
+ * @code
+ *  ground::ScienceColumns columns;
+ *
+ *  columns.resize(frameCount);
+ *  ground::decodeColumns(archive, frameCount, columns, 0);
+ *  float meanSolar = std::accumulate(columns.solar.begin(), columns.solar.end(), 0.0f) / frameCount;
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatColumns_h
+#define ThinSatColumns_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "ThinSatDecoder.h"
+
+
+namespace ground {
+
+
+/*!
+ * @brief   Column scale factors. The columns are single precision and are
+ *          scaled by multiplication so every path rounds the same way.
+ */
+#define GROUND_QUAT_PER_COUNT       (1.0f / 16384)
+#define GROUND_BNOMAG_UT_PER_COUNT  (1.0f / 10)
+#define GROUND_BMEPRES_PA_PER_COUNT (1.0f / 10)
+#define GROUND_BMETEMP_C_PER_COUNT  (1.0f / 10)
+#define GROUND_TSLMAG_UT_PER_COUNT_F ((float)GROUND_TSLMAG_UT_PER_COUNT)
+
+
+typedef enum
+{
+    DecodeAuto      = 0,        ///< Fastest path this CPU supports
+    DecodeScalar    = 1,
+    DecodeSSE41     = 2,        ///< 4 frames per step, shuffle/transpose kernels
+    DecodeAVX2      = 3         ///< 8 frames per step, gather and transpose kernels
+} DecodePath;
+
+
+/*!
+ * @brief   Science frames as columns. Units match ScienceValues.
+ */
+struct ScienceColumns
+{
+    std::vector<uint32_t>   met;            ///< 100 ms ticks
+    std::vector<uint8_t>    sampleAge;      ///< 100 ms ticks
+    std::vector<float>      quat[4];        ///< w, x, y, z
+    std::vector<float>      bnomag[3];      ///< uT
+    std::vector<uint8_t>    bnoCal;
+    std::vector<float>      pressure;       ///< Pa
+    std::vector<float>      temperature;    ///< °C
+    std::vector<uint16_t>   tslTempExt;     ///< ADC counts
+    std::vector<uint16_t>   tslVolts;       ///< ADC counts
+    std::vector<uint16_t>   tslCurrent;     ///< ADC counts
+    std::vector<uint16_t>   solar;          ///< ADC counts
+    std::vector<float>      tslMag[3];      ///< uT
+    
+    void    resize(size_t count);
+    size_t  size() const { return met.size(); }
+};
+
+
+DecodePath  getBestDecodePath();
+const char* getDecodePathName(DecodePath path);
+
+/*!
+ * @brief   Decodes count frames starting at frames into rows first to
+ *          first + count - 1 of columns.
+ *
+ * @note    Every frame must be a science frame (see getFrameKind()) and
+ *          columns must already hold first + count rows. Frames need no
+ *          alignment. Requesting a path the CPU lacks falls back to the
+ *          best one it has.
+ */
+void        decodeColumns(const uint8_t* frames, size_t count, ScienceColumns& columns,
+                          size_t first, DecodePath path = DecodeAuto);
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatColumns_h */
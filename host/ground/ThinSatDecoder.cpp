@@ -0,0 +1,513 @@
+/**
+ *  @file   ThinSatDecoder.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Ground decoder for ThinsatPacket_t downlink streams.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "ThinSatDecoder.h"
+
+#include "Arduino.h"
+#include "ThinSat_DataPacket.h"
+#include "TSLPB_AdaptiveRate.h"
+#include "TSLPB_Quaternion.h"
+#include "TSLPB_SeriesCodec.h"
+
+
+namespace ground {
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │           Layout checks against firmware         │
+ *  └──────────────────────────────────────────────────┘ */
+
+static_assert(sizeof(UserDataStruct_t) == NSL_PACKET_SIZE,            "science frame size");
+static_assert(offsetof(UserDataStruct_t, sampleAge) == GROUND_OFFSET_AGE,    "sampleAge offset");
+static_assert(offsetof(UserDataStruct_t, quat)      == GROUND_OFFSET_QUAT,   "quat offset");
+static_assert(offsetof(UserDataStruct_t, refreshed) == GROUND_OFFSET_REFRESHED, "refreshed offset");
+static_assert(offsetof(UserDataStruct_t, spare)     == GROUND_OFFSET_SPARE,  "spare offset");
+static_assert(offsetof(UserDataStruct_t, bnomagx)   == GROUND_OFFSET_BNOMAG, "bnomagx offset");
+static_assert(offsetof(UserDataStruct_t, bnoCal)    == GROUND_OFFSET_BNOCAL, "bnoCal offset");
+static_assert(offsetof(UserDataStruct_t, bmeTemp)   == GROUND_OFFSET_BMETEMP,"bmeTemp offset");
+static_assert(offsetof(UserDataStruct_t, tslMagXraw)== GROUND_OFFSET_TSLMAG, "tslMagXraw offset");
+static_assert(offsetof(ProfileDataStruct_t, histogram)   == 22, "profile layout");
+static_assert(offsetof(EnergyDataStruct_t, busVolts)     == 31, "energy layout");
+static_assert(offsetof(StatsDataStruct_t, seconds)       == 36, "stats layout");
+static_assert(offsetof(SeriesDataStruct_t, sequence)     == GROUND_OFFSET_SERIES_SEQUENCE, "series layout");
+static_assert(offsetof(SeriesDataStruct_t, bits)         == GROUND_OFFSET_SERIES_BITS,     "series layout");
+static_assert(TSL_SAMPLE_AGE_MAX       == GROUND_SAMPLE_AGE_MAX,       "sample age limit");
+static_assert(TSL_FRAME_TYPE_PROFILE   == GROUND_FRAME_TYPE_PROFILE,   "profile frame type");
+static_assert(TSL_FRAME_TYPE_ENERGY    == GROUND_FRAME_TYPE_ENERGY,    "energy frame type");
+static_assert(TSL_FRAME_TYPE_I2C_TRACE == GROUND_FRAME_TYPE_I2C_TRACE, "trace frame type");
+static_assert(TSL_FRAME_TYPE_STATS     == GROUND_FRAME_TYPE_STATS,     "stats frame type");
+static_assert(TSL_FRAME_TYPE_SERIES    == GROUND_FRAME_TYPE_SERIES,    "series frame type");
+static_assert((1 << RateGyro)          == GROUND_REFRESHED_ATTITUDE &&
+              (1 << RateSolar)         == GROUND_REFRESHED_SOLAR &&
+              (1 << RateCurrent)       == GROUND_REFRESHED_CURRENT &&
+              (1 << RateMagnetometer)  == GROUND_REFRESHED_TSLMAG &&
+              (1 << RateHousekeeping)  == GROUND_REFRESHED_HOUSEKEEPING, "refreshed channels");
+static_assert(TSL_QUAT_ONE             == GROUND_QUAT_SCALE,           "quaternion scale");
+static_assert(TSL_QUAT_BITS            == GROUND_QUAT_BITS,            "quaternion bits");
+static_assert(TSL_QUAT_INDEX_SHIFT     == GROUND_QUAT_INDEX_SHIFT,     "quaternion index");
+static_assert(TSL_QUAT_CODE_ZERO       == GROUND_QUAT_CODE_ZERO,       "quaternion zero");
+static_assert(TSL_QUAT_DECODE_MUL      == GROUND_QUAT_DECODE_MUL,      "quaternion decode");
+static_assert(TSL_SERIES_FRAME_BYTES   == GROUND_SERIES_BYTES,         "series bitstream");
+static_assert(TSL_SERIES_SAMPLES_MAX   == GROUND_SERIES_SAMPLES_MAX,   "series samples");
+static_assert(TSL_SERIES_ORDER_MAX     == GROUND_SERIES_ORDER_MAX &&
+              TSL_SERIES_ORDER_BITS    == GROUND_SERIES_ORDER_BITS,    "series predictor");
+static_assert(TSL_SERIES_RAW_ORDER     == GROUND_SERIES_RAW_ORDER &&
+              TSL_SERIES_RAW_SAMPLES   == GROUND_SERIES_RAW_SAMPLES,   "series raw frame");
+static_assert(TSL_SERIES_K_BITS        == GROUND_SERIES_K_BITS &&
+              TSL_SERIES_K_MAX         == GROUND_SERIES_K_MAX &&
+              TSL_SERIES_ESCAPE        == GROUND_SERIES_ESCAPE &&
+              TSL_SERIES_RAW_BITS      == GROUND_SERIES_RAW_BITS,      "series Rice code");
+static_assert(TSL_SERIES_RICE_COUNT_START == GROUND_SERIES_RICE_COUNT_START &&
+              TSL_SERIES_RICE_COUNT_MAX   == GROUND_SERIES_RICE_COUNT_MAX, "series Rice state");
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Frame Decoding                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+FrameKind getFrameKind(const uint8_t* frame)
+{
+    uint8_t type = frame[GROUND_OFFSET_AGE];
+    
+    if (type <= GROUND_SAMPLE_AGE_MAX)          return FrameScience;
+    if (type == GROUND_FRAME_TYPE_PROFILE)      return FrameProfile;
+    if (type == GROUND_FRAME_TYPE_ENERGY)       return FrameEnergy;
+    if (type == GROUND_FRAME_TYPE_I2C_TRACE)    return FrameI2CTrace;
+    if (type == GROUND_FRAME_TYPE_STATS)        return FrameStats;
+    if (type == GROUND_FRAME_TYPE_SERIES)       return FrameSeries;
+    return FrameUnknown;
+}
+
+
+/*!
+ * @brief   Rebuilds w, x, y, z in Q14 from a smallest-three quaternion. The
+ *          same integer steps as tslUnpackQuaternion(), so the result is
+ *          exactly the firmware's.
+ */
+void unpackQuaternion(uint32_t packed, int16_t quaternion[4])
+{
+    int      largest = packed >> GROUND_QUAT_INDEX_SHIFT;
+    int      shift   = GROUND_QUAT_INDEX_SHIFT;
+    uint32_t squares = 0;
+    
+    for (int i = 0; i < 4; i++) {
+        if (i == largest) {
+            continue;
+        }
+        shift -= GROUND_QUAT_BITS;
+        int32_t code = (packed >> shift) & GROUND_QUAT_CODE_MAX;
+        
+        quaternion[i] = (int16_t)(((code - GROUND_QUAT_CODE_ZERO) * GROUND_QUAT_DECODE_MUL + (1 << 15)) >> 16);
+        squares      += (uint32_t)(quaternion[i] * quaternion[i]);
+    }
+    
+    // Rounded integer square root of 1 - squares
+    uint32_t one       = (uint32_t)GROUND_QUAT_SCALE * (uint32_t)GROUND_QUAT_SCALE;
+    uint32_t remainder = squares < one ? one - squares : 0;
+    uint32_t root      = 0;
+    for (uint32_t bit = 1u << 30; bit; bit >>= 2) {
+        if (remainder >= root + bit) {
+            remainder -= root + bit;
+            root       = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    quaternion[largest] = (int16_t)(remainder > root ? root + 1 : root);
+}
+
+
+void decodeScience(const uint8_t* frame, ScienceRecord& record)
+{
+    record.met        = readU24(&frame[GROUND_OFFSET_MET]);
+    record.sampleAge  = frame[GROUND_OFFSET_AGE];
+    record.refreshed  = frame[GROUND_OFFSET_REFRESHED];
+    record.quatPacked = readU32(&frame[GROUND_OFFSET_QUAT]);
+    
+    unpackQuaternion(record.quatPacked, record.quat);
+    for (int i = 0; i < 3; i++) {
+        record.bnomag[i] = readI16(&frame[GROUND_OFFSET_BNOMAG + 2 * i]);
+        record.tslMag[i] = readI16(&frame[GROUND_OFFSET_TSLMAG + 2 * i]);
+    }
+    
+    record.bnoCal  = frame[GROUND_OFFSET_BNOCAL];
+    record.bmePres = readU24(&frame[GROUND_OFFSET_BMEPRES]);
+    record.bmeTemp = readI16(&frame[GROUND_OFFSET_BMETEMP]);
+    
+    uint64_t adc = readU32(&frame[GROUND_OFFSET_ADC]) | ((uint64_t)frame[GROUND_OFFSET_ADC + 4] << 32);
+    record.tslTempExt = adc         & 0x3FF;
+    record.tslVolts   = (adc >> 10) & 0x3FF;
+    record.tslCurrent = (adc >> 20) & 0x3FF;
+    record.solar      = (adc >> 30) & 0x3FF;
+}
+
+
+void scaleScience(const ScienceRecord& record, ScienceValues& values)
+{
+    values.acquisitionTime = record.met * GROUND_MET_TICK_S;
+    values.sampleAge       = record.sampleAge * GROUND_MET_TICK_S;
+    values.refreshed       = record.refreshed;
+    
+    for (int i = 0; i < 4; i++) {
+        values.quat[i] = record.quat[i] / GROUND_QUAT_SCALE;
+    }
+    for (int i = 0; i < 3; i++) {
+        values.bnomag[i] = record.bnomag[i] / GROUND_BNOMAG_SCALE;
+        values.tslMag[i] = record.tslMag[i] * GROUND_TSLMAG_UT_PER_COUNT;
+    }
+    
+    // bnoCal packs sys, gyro, accel, mag from the high bits down
+    values.calSystem = (record.bnoCal >> 6) & 0x03;
+    values.calGyro   = (record.bnoCal >> 4) & 0x03;
+    values.calAccel  = (record.bnoCal >> 2) & 0x03;
+    values.calMag    =  record.bnoCal       & 0x03;
+    
+    values.pressure    = record.bmePres / GROUND_BMEPRES_SCALE;
+    values.temperature = record.bmeTemp / GROUND_BMETEMP_SCALE;
+    values.tslTempExt  = record.tslTempExt;
+    values.tslVolts    = record.tslVolts;
+    values.tslCurrent  = record.tslCurrent;
+    values.solar       = record.solar;
+}
+
+
+void decodeProfile(const uint8_t* frame, ProfileRecord& record)
+{
+    record.met      = readU24(&frame[GROUND_OFFSET_MET]);
+    record.phase    = frame[7];
+    record.count    = readU16(&frame[8]);
+    record.minTime  = readU32(&frame[10]);
+    record.maxTime  = readU32(&frame[14]);
+    record.meanTime = readU32(&frame[18]);
+    memcpy(record.histogram, &frame[22], sizeof(record.histogram));
+}
+
+
+void decodeEnergy(const uint8_t* frame, EnergyRecord& record)
+{
+    record.met          = readU24(&frame[GROUND_OFFSET_MET]);
+    record.orbit        = readU16(&frame[7]);
+    record.orbitSeconds = readU16(&frame[9]);
+    for (int i = 0; i < 4; i++) {
+        record.phaseCharge[i] = readU32(&frame[11 + 4 * i]);
+    }
+    record.orbitCharge  = readU32(&frame[27]);
+    record.busVolts     = readU16(&frame[31]);
+}
+
+
+void decodeStats(const uint8_t* frame, StatsRecord& record)
+{
+    record.met          = readU24(&frame[GROUND_OFFSET_MET]);
+    record.firstChannel = frame[7];
+    for (int i = 0; i < 2; i++) {
+        record.count[i]    = readU16(&frame[8 + 2 * i]);
+        record.minimum[i]  = readI16(&frame[12 + 2 * i]);
+        record.maximum[i]  = readI16(&frame[16 + 2 * i]);
+        record.mean[i]     = (int32_t)readU32(&frame[20 + 4 * i]);
+        record.variance[i] = readU32(&frame[28 + 4 * i]);
+    }
+    record.seconds      = readU16(&frame[36]);
+}
+
+
+/*!
+ * @brief   MSB-first reader of a series bitstream. Reads past the end fail.
+ */
+typedef struct
+{
+    const uint8_t*  data;
+    int             position;
+    
+    bool read(int bits, uint32_t& value)
+    {
+        if (position + bits > 8 * GROUND_SERIES_BYTES) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < bits; i++, position++) {
+            value = (value << 1) | ((data[position >> 3] >> (7 - (position & 7))) & 1);
+        }
+        return true;
+    }
+} SeriesBits;
+
+
+/*!
+ * @brief   Decodes a TSL_FRAME_TYPE_SERIES frame, independently of the
+ *          firmware encoder but with the same integer steps
+ *
+ * @return  false if the frame is not a valid coding: no samples or too
+ *          many, a predictor order of 0 after the first axis, a bitstream
+ *          that ends early, or a sample outside int16_t. record.count is then
+ *          the number of samples decoded before the error.
+ */
+bool decodeSeries(const uint8_t* frame, SeriesRecord& record)
+{
+    record.met      = readU24(&frame[GROUND_OFFSET_MET]);
+    record.source   = frame[GROUND_OFFSET_SERIES_SOURCE] & 0x0F;
+    record.capture  = frame[GROUND_OFFSET_SERIES_SOURCE] >> 4;
+    record.period   = frame[GROUND_OFFSET_SERIES_PERIOD];
+    record.sequence = readU16(&frame[GROUND_OFFSET_SERIES_SEQUENCE]);
+    record.count    = 0;
+    
+    int count = frame[GROUND_OFFSET_SERIES_COUNT];
+    if (count == 0 || count > GROUND_SERIES_SAMPLES_MAX) {
+        return false;
+    }
+    
+    SeriesBits bits = { &frame[GROUND_OFFSET_SERIES_BITS], 0 };
+    uint32_t   order[GROUND_SERIES_AXES], riceSum[GROUND_SERIES_AXES], riceCount[GROUND_SERIES_AXES];
+    
+    if (!bits.read(GROUND_SERIES_ORDER_BITS, order[0])) {
+        return false;
+    }
+    
+    // A raw frame: the samples verbatim
+    if (order[0] == GROUND_SERIES_RAW_ORDER) {
+        if (count > GROUND_SERIES_RAW_SAMPLES) {
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            for (int axis = 0; axis < GROUND_SERIES_AXES; axis++) {
+                uint32_t raw;
+                if (!bits.read(16, raw)) {
+                    return false;
+                }
+                record.samples[i][axis] = (int16_t)raw;
+            }
+            record.count++;
+        }
+        return true;
+    }
+    
+    for (int axis = 0; axis < GROUND_SERIES_AXES; axis++) {
+        uint32_t k;
+        if ((axis > 0 && !bits.read(GROUND_SERIES_ORDER_BITS, order[axis])) || !bits.read(GROUND_SERIES_K_BITS, k) ||
+            order[axis] == 0) {
+            return false;
+        }
+        riceCount[axis] = GROUND_SERIES_RICE_COUNT_START;
+        riceSum[axis]   = riceCount[axis] << k;
+    }
+    for (int axis = 0; axis < GROUND_SERIES_AXES; axis++) {
+        uint32_t raw;
+        if (!bits.read(16, raw)) {
+            return false;
+        }
+        record.samples[0][axis] = (int16_t)raw;
+    }
+    record.count = 1;
+    
+    for (int i = 1; i < count; i++) {
+        for (int axis = 0; axis < GROUND_SERIES_AXES; axis++) {
+            
+            // Polynomial prediction from the samples of this frame
+            int32_t x1 = record.samples[i - 1][axis];
+            int32_t x2 = i >= 2 ? record.samples[i - 2][axis] : 0;
+            int32_t x3 = i >= 3 ? record.samples[i - 3][axis] : 0;
+            int32_t prediction;
+            switch (std::min((int)order[axis], i)) {
+                case 1:     prediction = x1;                    break;
+                case 2:     prediction = 2 * x1 - x2;           break;
+                default:    prediction = 3 * (x1 - x2) + x3;    break;
+            }
+            prediction = std::max(-32768, std::min(32767, prediction));
+            
+            uint32_t k = 0;
+            while (k < GROUND_SERIES_K_MAX && (riceCount[axis] << k) < riceSum[axis]) {
+                k++;
+            }
+            
+            uint32_t quotient = 0, bit, m;
+            while (quotient < GROUND_SERIES_ESCAPE) {
+                if (!bits.read(1, bit)) {
+                    return false;
+                }
+                if (!bit) {
+                    break;
+                }
+                quotient++;
+            }
+            if (quotient == GROUND_SERIES_ESCAPE) {
+                if (!bits.read(GROUND_SERIES_RAW_BITS, m)) {
+                    return false;
+                }
+            } else {
+                uint32_t remainder;
+                if (!bits.read(k, remainder)) {
+                    return false;
+                }
+                m = (quotient << k) | remainder;
+            }
+            
+            int32_t value = prediction + ((m & 1) ? -(int32_t)((m + 1) >> 1) : (int32_t)(m >> 1));
+            if (value < -32768 || value > 32767) {
+                return false;
+            }
+            record.samples[i][axis] = (int16_t)value;
+            
+            riceSum[axis] += m;
+            if (++riceCount[axis] >= GROUND_SERIES_RICE_COUNT_MAX) {
+                riceSum[axis]   >>= 1;
+                riceCount[axis] >>= 1;
+            }
+        }
+        record.count++;
+    }
+    return true;
+}
+
+
+/*!
+ * @brief   Writes one GROUND_CSV_HEADER row, with a newline, and returns its
+ *          length as snprintf() does
+ */
+int formatScienceCsv(const ScienceValues& v, char* buffer, size_t size)
+{
+    return snprintf(buffer, size,
+                    "%.1f,%.1f,%u,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f,%u,%u,%u,%u,%.1f,%.1f,%u,%u,%u,%u,%.2f,%.2f,%.2f\n",
+                    v.acquisitionTime, v.sampleAge, v.refreshed, v.quat[0], v.quat[1], v.quat[2], v.quat[3],
+                    v.bnomag[0], v.bnomag[1], v.bnomag[2], v.calSystem, v.calGyro, v.calAccel, v.calMag,
+                    v.pressure, v.temperature, v.tslTempExt, v.tslVolts, v.tslCurrent, v.solar,
+                    v.tslMag[0], v.tslMag[1], v.tslMag[2]);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Stream Scanner                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+void FrameScanner::scan(const uint8_t* data, size_t length, const FrameHandler& handler)
+{
+    stats.bytesScanned += length;
+    
+    if (!carry.empty()) {
+        // Complete the partial frame from the last call. Three frames of new
+        // data always get the scan past the carried bytes, so the rest can
+        // be scanned in place without copying it.
+        size_t saved = carry.size();
+        size_t take  = std::min(length, (size_t)(3 * NSL_PACKET_SIZE));
+        
+        carry.insert(carry.end(), data, data + take);
+        size_t used = scanBuffer(carry.data(), carry.size(), false, handler);
+        
+        if (take == length) {
+            carry.erase(carry.begin(), carry.begin() + used);
+            return;
+        }
+        data   += used - saved;
+        length -= used - saved;
+        carry.clear();
+    }
+    
+    size_t used = scanBuffer(data, length, false, handler);
+    carry.assign(data + used, data + length);
+}
+
+
+void FrameScanner::finish(const FrameHandler& handler)
+{
+    scanBuffer(carry.data(), carry.size(), true, handler);
+    carry.clear();
+}
+
+
+/*!
+ * @brief   Returns true when the frame at pos is followed by a header, or by
+ *          the end of a final buffer.
+ */
+static bool isFollowed(const uint8_t* data, size_t length, size_t pos)
+{
+    size_t next = pos + NSL_PACKET_SIZE;
+    
+    if (next + NSL_PACKET_HEADER_LENGTH <= length) {
+        return isHeader(&data[next]);
+    }
+    return next == length;
+}
+
+
+/*!
+ * @brief   Delivers the frames in data and returns the number of bytes
+ *          consumed. Unless final, scanning stops where a header does not yet
+ *          have two frames and a header behind it.
+ *
+ * @note    A frame is good if the next one starts right behind it. Otherwise
+ *          a header inside it means the frame was cut short and the real one
+ *          starts there. A header that overlaps the frame's own header (a met
+ *          byte of 0x50 extends the run of header bytes) only counts when it
+ *          is itself followed by a header.
+ */
+size_t FrameScanner::scanBuffer(const uint8_t* data, size_t length, bool final, const FrameHandler& handler)
+{
+    const size_t lookahead = 2 * NSL_PACKET_SIZE + NSL_PACKET_HEADER_LENGTH;
+    size_t       pos       = 0;
+    
+    while (length - pos >= NSL_PACKET_HEADER_LENGTH) {
+        
+        const uint8_t* hit = (const uint8_t*)memchr(&data[pos], GROUND_HEADER_BYTE,
+                                                    length - pos - (NSL_PACKET_HEADER_LENGTH - 1));
+        if (!hit) {
+            stats.bytesSkipped += length - pos - (NSL_PACKET_HEADER_LENGTH - 1);
+            pos = length - (NSL_PACKET_HEADER_LENGTH - 1);
+            break;
+        }
+        stats.bytesSkipped += (hit - data) - pos;
+        pos = hit - data;
+        
+        if (!isHeader(&data[pos])) {
+            stats.bytesSkipped++;
+            pos++;
+            continue;
+        }
+        
+        size_t available = length - pos;
+        if (available < (final ? NSL_PACKET_SIZE : lookahead)) {
+            break;
+        }
+        
+        size_t inner = 0;
+        if (!isFollowed(data, length, pos)) {
+            size_t end = pos + std::min(available, (size_t)NSL_PACKET_SIZE + NSL_PACKET_HEADER_LENGTH - 1);
+            for (size_t j = pos + 1; j + NSL_PACKET_HEADER_LENGTH <= end; j++) {
+                if (isHeader(&data[j]) &&
+                    (j >= pos + NSL_PACKET_HEADER_LENGTH || isFollowed(data, length, j))) {
+                    inner = j;
+                    break;
+                }
+            }
+        }
+        
+        if (inner == 0) {
+            handler(&data[pos]);
+            stats.frames++;
+            pos += NSL_PACKET_SIZE;
+        } else {
+            stats.shortFrames++;
+            stats.bytesSkipped += inner - pos;
+            pos = inner;
+        }
+    }
+    
+    if (final) {
+        stats.bytesSkipped += length - pos;
+        pos = length;
+    }
+    return pos;
+}
+
+
+} /* namespace ground */
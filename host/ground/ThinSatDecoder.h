@@ -0,0 +1,313 @@
+/**
+ *  @file   ThinSatDecoder.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Ground decoder for ThinsatPacket_t downlink streams.
+ *
+ *          Frames are decoded from explicit little-endian byte offsets, not
+ *          by casting to the firmware's packed structs, so the decoder does
+ *          not depend on the host compiler's layout rules. The offsets below
+ *          are the wire format. ThinSatDecoder.cpp checks them against
+ *          ThinSat_DataPacket.h at compile time.
+ *
+ * @code
+ *  ground::FrameScanner scanner;
+ *  ground::ScienceRecord record;
+ *
+ *  size_t length = fread(buffer, 1, sizeof(buffer), capture);
+ *  scanner.scan(buffer, length, [&](const uint8_t* frame) {
+ *      if (ground::getFrameKind(frame) == ground::FrameScience) {
+ *          ground::decodeScience(frame, record);
+ *      }
+ *  });
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatDecoder_h
+#define ThinSatDecoder_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "NSL_ThinSat.h"
+
+
+namespace ground {
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │              Wire Format (byte offsets)          │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define GROUND_HEADER_BYTE          0x50    ///< Each NSL_PACKET_HEADER byte
+
+#define GROUND_OFFSET_MET           3       ///< uint24 mission elapsed time (100 ms ticks)
+#define GROUND_OFFSET_AGE           6       ///< uint8 sampleAge, or frameType >= 0xF0
+#define GROUND_OFFSET_QUAT          7       ///< uint32 smallest-three quaternion
+#define GROUND_OFFSET_REFRESHED     11      ///< uint8 bit per GROUND_REFRESHED_* channel read at met
+#define GROUND_OFFSET_SPARE         12      ///< 3 unused bytes
+#define GROUND_OFFSET_BNOMAG        15      ///< int16 bnomagx, bnomagy, bnomagz
+#define GROUND_OFFSET_BNOCAL        21      ///< uint8 sys:2 gyro:2 accel:2 mag:2
+#define GROUND_OFFSET_BMEPRES       22      ///< uint24 pressure (0.1 Pa)
+#define GROUND_OFFSET_BMETEMP       25      ///< int16 temperature (0.1 °C)
+#define GROUND_OFFSET_ADC           27      ///< 40 bits: tslTempExt, tslVolts, tslCurrent, solar (10 bits each, LSb first)
+#define GROUND_OFFSET_TSLMAG        32      ///< int16 tslMagXraw, tslMagYraw, tslMagZraw
+
+#define GROUND_REFRESHED_ATTITUDE   0x01    ///< quat, bnomag, bnoCal (RateGyro)
+#define GROUND_REFRESHED_SOLAR      0x02    ///< solar (RateSolar)
+#define GROUND_REFRESHED_CURRENT    0x04    ///< tslVolts, tslCurrent (RateCurrent)
+#define GROUND_REFRESHED_TSLMAG     0x08    ///< tslMag (RateMagnetometer)
+#define GROUND_REFRESHED_HOUSEKEEPING 0x10  ///< bmePres, bmeTemp, tslTempExt (RateHousekeeping)
+
+#define GROUND_SAMPLE_AGE_MAX       0xEF    ///< Larger sampleAge values are frame types
+#define GROUND_FRAME_TYPE_PROFILE   0xF0
+#define GROUND_FRAME_TYPE_ENERGY    0xF1
+#define GROUND_FRAME_TYPE_I2C_TRACE 0xF2
+#define GROUND_FRAME_TYPE_STATS     0xF3
+#define GROUND_FRAME_TYPE_SERIES    0xF4
+
+#define GROUND_MET_TICK_S           0.1     ///< Seconds per MET tick
+#define GROUND_QUAT_SCALE           16384.0 ///< Unpacked quaternion components are Q14
+#define GROUND_BNOMAG_SCALE         10.0    ///< bnomag* = uT * 10
+#define GROUND_BMEPRES_SCALE        10.0    ///< bmePres = Pa * 10
+#define GROUND_BMETEMP_SCALE        10.0    ///< bmeTemp = °C * 10
+#define GROUND_TSLMAG_UT_PER_COUNT  (4912.0 / 0x7FF8)   ///< MAG_MAX_VALUE_FLOAT / MAG_MAX_BYTE_VALUE
+#define GROUND_STATS_SCALE          256.0   ///< Stats mean and variance are Q8
+
+#define GROUND_QUAT_BITS            10      ///< Bits per stored quaternion component
+#define GROUND_QUAT_CODE_MAX        1023
+#define GROUND_QUAT_CODE_ZERO       511     ///< Code of a zero component
+#define GROUND_QUAT_INDEX_SHIFT     30      ///< Index of the dropped component, in the top bits
+#define GROUND_QUAT_DECODE_MUL      1485812 ///< Q14 = ((code - 511) * MUL + 2^15) >> 16
+
+#define GROUND_OFFSET_SERIES_SOURCE 7       ///< uint8 source:4, capture number:4
+#define GROUND_OFFSET_SERIES_PERIOD 8       ///< uint8 sample period (ms)
+#define GROUND_OFFSET_SERIES_SEQUENCE 9     ///< uint16 index of the first sample in the capture
+#define GROUND_OFFSET_SERIES_COUNT  11      ///< uint8 samples in the frame
+#define GROUND_OFFSET_SERIES_BITS   12      ///< Coded samples, see TSLPB_SeriesCodec.h
+#define GROUND_SERIES_BYTES         26      ///< Bitstream bytes
+#define GROUND_SERIES_AXES          3
+#define GROUND_SERIES_SAMPLES_MAX   48
+#define GROUND_SERIES_ORDER_BITS    2
+#define GROUND_SERIES_ORDER_MAX     3
+#define GROUND_SERIES_RAW_ORDER     0       ///< First axis' order of a raw frame
+#define GROUND_SERIES_RAW_SAMPLES   4       ///< Most samples of a raw frame, 16 bits per axis
+#define GROUND_SERIES_K_BITS        4
+#define GROUND_SERIES_K_MAX         15
+#define GROUND_SERIES_ESCAPE        16      ///< Rice quotient that announces a raw value
+#define GROUND_SERIES_RAW_BITS      17
+#define GROUND_SERIES_RICE_COUNT_START 4
+#define GROUND_SERIES_RICE_COUNT_MAX 16
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Decoded Frames                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+typedef enum
+{
+    FrameScience    = 0,        ///< UserDataStruct_t
+    FrameProfile    = 1,        ///< ProfileDataStruct_t
+    FrameEnergy     = 2,        ///< EnergyDataStruct_t
+    FrameI2CTrace   = 3,        ///< I2CTraceDataStruct_t
+    FrameStats      = 4,        ///< StatsDataStruct_t
+    FrameSeries     = 5,        ///< SeriesDataStruct_t
+    FrameUnknown    = 6         ///< Reserved frame type
+} FrameKind;
+
+
+/*!
+ * @brief   Integer contents of a science frame, exactly as sent
+ */
+typedef struct
+{
+    uint32_t    met;
+    uint8_t     sampleAge;
+    uint8_t     refreshed;          ///< GROUND_REFRESHED_* channels read at met
+    uint32_t    quatPacked;         ///< Smallest-three quaternion as sent
+    int16_t     quat[4];            ///< w, x, y, z unpacked from quatPacked (Q14)
+    int16_t     bnomag[3];          ///< x, y, z
+    uint8_t     bnoCal;
+    uint32_t    bmePres;
+    int16_t     bmeTemp;
+    uint16_t    tslTempExt;
+    uint16_t    tslVolts;
+    uint16_t    tslCurrent;
+    uint16_t    solar;
+    int16_t     tslMag[3];          ///< x, y, z raw counts
+} ScienceRecord;
+
+
+/*!
+ * @brief   A science frame in engineering units
+ */
+typedef struct
+{
+    double      acquisitionTime;    ///< Seconds of MET at acquisition
+    double      sampleAge;          ///< Seconds from acquisition to transmission
+    uint8_t     refreshed;          ///< GROUND_REFRESHED_* channels read at acquisitionTime
+    double      quat[4];            ///< Unit quaternion w, x, y, z
+    double      bnomag[3];          ///< BNO055 field (uT)
+    uint8_t     calSystem;          ///< BNO055 calibration status 0-3
+    uint8_t     calGyro;
+    uint8_t     calAccel;
+    uint8_t     calMag;
+    double      pressure;           ///< BMP280 (Pa)
+    double      temperature;        ///< BMP280 (°C)
+    uint16_t    tslTempExt;         ///< ADC counts
+    uint16_t    tslVolts;           ///< ADC counts
+    uint16_t    tslCurrent;         ///< ADC counts
+    uint16_t    solar;              ///< ADC counts
+    double      tslMag[3];          ///< AK8963 field (uT)
+} ScienceValues;
+
+
+/*!
+ * @brief   Loop-phase profiler report
+ */
+typedef struct
+{
+    uint32_t    met;
+    uint8_t     phase;
+    uint16_t    count;
+    uint32_t    minTime;
+    uint32_t    maxTime;
+    uint32_t    meanTime;
+    uint8_t     histogram[16];
+} ProfileRecord;
+
+
+/*!
+ * @brief   Energy ledger report
+ */
+typedef struct
+{
+    uint32_t    met;
+    uint16_t    orbit;
+    uint16_t    orbitSeconds;
+    uint32_t    phaseCharge[4];     ///< mAs, per TSLPB_EnergyPhase_t
+    uint32_t    orbitCharge;        ///< mAs
+    uint16_t    busVolts;
+} EnergyRecord;
+
+
+/*!
+ * @brief   Channel statistics report, two channels per frame
+ */
+typedef struct
+{
+    uint32_t    met;
+    uint8_t     firstChannel;       ///< TSLPB_StatsChannel_t of index 0
+    uint16_t    count[2];
+    int16_t     minimum[2];
+    int16_t     maximum[2];
+    int32_t     mean[2];            ///< Q8
+    uint32_t    variance[2];        ///< Q8
+    uint16_t    seconds;
+} StatsRecord;
+
+
+/*!
+ * @brief   Decoded high-rate capture frame. Sample i was taken
+ *          (sequence + i) * period ms after the capture started.
+ */
+typedef struct
+{
+    uint32_t    met;                ///< MET of the first sample
+    uint8_t     source;             ///< TSLPB_SeriesSource_t
+    uint8_t     capture;            ///< Capture number modulo 16
+    uint8_t     period;             ///< Sample period (ms)
+    uint16_t    sequence;           ///< Index of samples[0] in the capture
+    uint8_t     count;              ///< Samples decoded
+    int16_t     samples[GROUND_SERIES_SAMPLES_MAX][GROUND_SERIES_AXES];   ///< x, y, z
+} SeriesRecord;
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                   Field Access                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+inline uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline int16_t  readI16(const uint8_t* p) { return (int16_t)readU16(p); }
+inline uint32_t readU24(const uint8_t* p) { return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16); }
+inline uint32_t readU32(const uint8_t* p) { return readU24(p) | ((uint32_t)p[3] << 24); }
+
+inline bool isHeader(const uint8_t* p)
+{
+    return p[0] == GROUND_HEADER_BYTE && p[1] == GROUND_HEADER_BYTE && p[2] == GROUND_HEADER_BYTE;
+}
+
+FrameKind   getFrameKind(const uint8_t* frame);
+void        unpackQuaternion(uint32_t packed, int16_t quaternion[4]);
+void        decodeScience(const uint8_t* frame, ScienceRecord& record);
+void        scaleScience(const ScienceRecord& record, ScienceValues& values);
+void        decodeProfile(const uint8_t* frame, ProfileRecord& record);
+void        decodeEnergy(const uint8_t* frame, EnergyRecord& record);
+void        decodeStats(const uint8_t* frame, StatsRecord& record);
+bool        decodeSeries(const uint8_t* frame, SeriesRecord& record);
+
+#define GROUND_CSV_HEADER   "time_s,age_s,refreshed,quat_w,quat_x,quat_y,quat_z,bno_mag_x_uT,bno_mag_y_uT,bno_mag_z_uT," \
+                            "cal_sys,cal_gyro,cal_accel,cal_mag,pressure_Pa,temperature_C," \
+                            "tsl_temp_ext,tsl_volts,tsl_current,solar,tsl_mag_x_uT,tsl_mag_y_uT,tsl_mag_z_uT"
+#define GROUND_CSV_ROW_MAX  256     ///< Longest row formatScienceCsv() writes, with newline
+
+int         formatScienceCsv(const ScienceValues& values, char* buffer, size_t size);
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Stream Scanner                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   Scanner counters
+ */
+typedef struct
+{
+    uint64_t    bytesScanned;       ///< Bytes passed to scan()
+    uint64_t    frames;             ///< Frames delivered
+    uint64_t    bytesSkipped;       ///< Bytes outside any frame
+    uint64_t    shortFrames;        ///< Headers followed by a new header before NSL_PACKET_SIZE bytes
+} ScannerStats;
+
+
+typedef std::function<void(const uint8_t* frame)> FrameHandler;
+
+
+/*!
+ * @brief   Finds NSL_PACKET_SIZE frames in a byte stream. A frame starts with
+ *          NSL_PACKET_HEADER and is accepted when the next header follows it
+ *          or no other header starts inside it. Otherwise it was cut short
+ *          and the scan resumes at the inner header. Data may be passed in pieces
+ *          of any size; a partial frame at the end of one call is completed
+ *          by the next. Call finish() at the end of the stream.
+ */
+class FrameScanner
+{
+    
+public:
+    void     scan(const uint8_t* data, size_t length, const FrameHandler& handler);
+    void     finish(const FrameHandler& handler);
+    
+    const ScannerStats& getStats() { return stats; }
+    
+private:
+    
+    size_t   scanBuffer(const uint8_t* data, size_t length, bool final, const FrameHandler& handler);
+    
+    std::vector<uint8_t>    carry;      ///< Unscanned bytes from the last call
+    ScannerStats            stats = {};
+    
+};
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatDecoder_h */
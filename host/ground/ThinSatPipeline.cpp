@@ -0,0 +1,465 @@
+/**
+ *  @file   ThinSatPipeline.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Multi-threaded ground pipeline for downlinked frame streams.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "ThinSatPipeline.h"
+#include "ThinSatArchive.h"
+#include "ThinSatColumnStore.h"
+
+
+namespace ground {
+
+
+#define PIPELINE_SPIN_LIMIT     64      ///< Busy-wait polls before yielding the core
+
+
+static const char* const stageNames[PIPELINE_STAGE_COUNT] = { "reader", "framer", "decoder", "writer" };
+
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void relax(uint32_t& spins)
+{
+    if (spins++ < PIPELINE_SPIN_LIMIT) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+/*!
+ * @brief   Pins the calling thread to the stage's core, if one was given
+ */
+static int pinStage(const PipelineOptions& options, PipelineStage stage)
+{
+    if ((size_t)stage >= options.cores.size() || options.cores[stage] < 0) {
+        return -1;
+    }
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(options.cores[stage], &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return -1;
+    }
+    return options.cores[stage];
+}
+
+
+Pipeline::Pipeline(const PipelineOptions& pipelineOptions) :
+    options(pipelineOptions),
+    chunkPool(std::max(pipelineOptions.chunks, 2u)),
+    batchPool(std::max(pipelineOptions.batches, 2u)),
+    filledChunks(chunkPool.size()),
+    freeChunks(chunkPool.size()),
+    framedBatches(batchPool.size()),
+    decodedBatches(batchPool.size()),
+    freeBatches(batchPool.size())
+{
+    options.batchFrames = std::max(options.batchFrames, 1u);
+    
+    for (PipelineChunk& chunk : chunkPool) {
+        chunk.data.resize(PIPELINE_CHUNK_SIZE);
+        freeChunks.tryPush(&chunk);
+    }
+    for (PipelineBatch& batch : batchPool) {
+        batch.frames.resize(options.batchFrames * NSL_PACKET_SIZE);
+        batch.kinds.resize(options.batchFrames);
+        batch.records.resize(options.batchFrames);
+        batch.count = 0;
+        freeBatches.tryPush(&batch);
+    }
+    memset(stats, 0, sizeof(stats));
+    memset(&totals, 0, sizeof(totals));
+}
+
+
+Pipeline::~Pipeline()
+{
+}
+
+
+/*!
+ * @brief   Pops the next item, waiting while the ring is empty. Returns false
+ *          once the ring is closed and drained, or the pipeline failed.
+ */
+template <typename T>
+bool Pipeline::pop(SpscRing<T*>& ring, T*& item, uint64_t& waitNs)
+{
+    if (ring.tryPop(item)) {
+        return true;
+    }
+    
+    uint64_t start = nowNs();
+    uint32_t spins = 0;
+    bool     got   = false;
+    
+    while (!failed.load(std::memory_order_relaxed)) {
+        if (ring.tryPop(item)) {
+            got = true;
+            break;
+        }
+        if (ring.isClosed()) {
+            got = ring.tryPop(item);
+            break;
+        }
+        relax(spins);
+    }
+    waitNs += nowNs() - start;
+    return got;
+}
+
+
+/*!
+ * @brief   Pushes an item, waiting while the ring is full. Returns false if
+ *          the pipeline failed while waiting.
+ */
+template <typename T>
+bool Pipeline::push(SpscRing<T*>& ring, T* item, PipelineStageStats& stage)
+{
+    if (ring.tryPush(item)) {
+        return true;
+    }
+    
+    uint64_t start = nowNs();
+    uint32_t spins = 0;
+    bool     done  = false;
+    
+    stage.blockedCount++;
+    while (!failed.load(std::memory_order_relaxed)) {
+        if (ring.tryPush(item)) {
+            done = true;
+            break;
+        }
+        relax(spins);
+    }
+    stage.blockedNs += nowNs() - start;
+    return done;
+}
+
+
+/*!
+ * @brief   Takes a recycled item from a return ring. Waiting here means the
+ *          downstream stages still hold every item, so it counts as blocked.
+ */
+template <typename T>
+bool Pipeline::acquire(SpscRing<T*>& ring, T*& item, PipelineStageStats& stage)
+{
+    if (ring.tryPop(item)) {
+        return true;
+    }
+    stage.blockedCount++;
+    return pop(ring, item, stage.blockedNs);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Stages                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+void Pipeline::runReader()
+{
+    PipelineStageStats& stage = stats[StageReader];
+    
+    stage.core = pinStage(options, StageReader);
+    uint64_t start = nowNs();
+    
+    for (uint32_t pass = 0; pass < options.passes && !failed; pass++) {
+        for (const std::string& path : options.inputs) {
+            bool  useStdin = (path == "-");
+            FILE* input    = useStdin ? stdin : fopen(path.c_str(), "rb");
+            bool  end      = false;
+            
+            if (!input) {
+                perror(path.c_str());
+                failed = true;
+                break;
+            }
+            
+            while (!end) {
+                PipelineChunk* chunk;
+                
+                // Waiting for a free chunk is backpressure from the framer
+                if (!acquire(freeChunks, chunk, stage)) {
+                    break;
+                }
+                chunk->length    = fread(chunk->data.data(), 1, chunk->data.size(), input);
+                chunk->endOfPass = end = (chunk->length < chunk->data.size());
+                stage.bytes     += chunk->length;
+                stage.items++;
+                
+                if (!push(filledChunks, chunk, stage)) {
+                    break;
+                }
+            }
+            if (!useStdin) {
+                fclose(input);
+            }
+            if (failed) {
+                break;
+            }
+        }
+    }
+    
+    filledChunks.close();
+    stage.busyNs = nowNs() - start - stage.starvedNs - stage.blockedNs;
+}
+
+
+void Pipeline::runFramer()
+{
+    PipelineStageStats& stage   = stats[StageFramer];
+    PipelineBatch*      batch   = nullptr;
+    FrameScanner*       scanner = new FrameScanner();
+    bool                ok      = true;
+    
+    stage.core = pinStage(options, StageFramer);
+    uint64_t start = nowNs();
+    
+    auto addFrame = [&](const uint8_t* frame) {
+        if (!ok) {
+            return;
+        }
+        if (!batch) {
+            // Waiting for a free batch is backpressure from the writer
+            if (!acquire(freeBatches, batch, stage)) {
+                ok = false;
+                return;
+            }
+            batch->count = 0;
+        }
+        memcpy(&batch->frames[batch->count * NSL_PACKET_SIZE], frame, NSL_PACKET_SIZE);
+        stage.frames++;
+        if (++batch->count == options.batchFrames) {
+            stage.items++;
+            ok    = push(framedBatches, batch, stage);
+            batch = nullptr;
+        }
+    };
+    
+    PipelineChunk* chunk;
+    while (ok && pop(filledChunks, chunk, stage.starvedNs)) {
+        stage.bytes += chunk->length;
+        scanner->scan(chunk->data.data(), chunk->length, addFrame);
+        
+        // Frames never straddle two passes or two inputs
+        if (chunk->endOfPass) {
+            scanner->finish(addFrame);
+            totals.bytesSkipped += scanner->getStats().bytesSkipped;
+            totals.shortFrames  += scanner->getStats().shortFrames;
+            delete scanner;
+            scanner = new FrameScanner();
+        }
+        ok = ok && push(freeChunks, chunk, stage);
+    }
+    
+    if (ok && batch && batch->count > 0) {
+        stage.items++;
+        push(framedBatches, batch, stage);
+    }
+    delete scanner;
+    
+    framedBatches.close();
+    stage.busyNs = nowNs() - start - stage.starvedNs - stage.blockedNs;
+}
+
+
+void Pipeline::runDecoder()
+{
+    PipelineStageStats& stage = stats[StageDecoder];
+    bool                csv   = !options.csvPath.empty();
+    
+    stage.core = pinStage(options, StageDecoder);
+    uint64_t start = nowNs();
+    
+    PipelineBatch* batch;
+    while (pop(framedBatches, batch, stage.starvedNs)) {
+        batch->csv.clear();
+        
+        for (uint32_t i = 0; i < batch->count; i++) {
+            const uint8_t* frame = &batch->frames[i * NSL_PACKET_SIZE];
+            FrameKind      kind  = getFrameKind(frame);
+            
+            batch->kinds[i] = kind;
+            totals.kinds[kind]++;
+            if (kind == FrameUnknown) {
+                totals.invalid++;
+            }
+            if (kind != FrameScience) {
+                continue;
+            }
+            
+            decodeScience(frame, batch->records[i]);
+            if (csv) {
+                ScienceValues values;
+                char          row[GROUND_CSV_ROW_MAX];
+                scaleScience(batch->records[i], values);
+                batch->csv.append(row, formatScienceCsv(values, row, sizeof(row)));
+            }
+        }
+        
+        stage.items++;
+        stage.frames += batch->count;
+        stage.bytes  += batch->count * NSL_PACKET_SIZE;
+        if (!push(decodedBatches, batch, stage)) {
+            break;
+        }
+    }
+    
+    decodedBatches.close();
+    stage.busyNs = nowNs() - start - stage.starvedNs - stage.blockedNs;
+}
+
+
+void Pipeline::runWriter()
+{
+    PipelineStageStats& stage = stats[StageWriter];
+    ArchiveWriter       archive;
+    ColumnStoreWriter   store;
+    FILE*               csv   = nullptr;
+    uint64_t            epoch = options.epoch > 0 ? (uint64_t)(options.epoch * 1e6 + 0.5) : 0;
+    
+    stage.core = pinStage(options, StageWriter);
+    uint64_t start = nowNs();
+    
+    bool ok = true;
+    if (!options.archivePath.empty() && !archive.open(options.archivePath)) {
+        perror(options.archivePath.c_str());
+        ok = false;
+    }
+    if (ok && !options.columnPath.empty() && !store.open(options.columnPath)) {
+        perror(options.columnPath.c_str());
+        ok = false;
+    }
+    if (ok && !options.csvPath.empty()) {
+        csv = (options.csvPath == "-") ? stdout : fopen(options.csvPath.c_str(), "w");
+        if (!csv || fputs(GROUND_CSV_HEADER "\n", csv) < 0) {
+            perror(options.csvPath.c_str());
+            ok = false;
+        }
+    }
+    if (!ok) {
+        failed = true;
+    }
+    
+    PipelineBatch* batch;
+    while (ok && pop(decodedBatches, batch, stage.starvedNs)) {
+        for (uint32_t i = 0; i < batch->count && !options.archivePath.empty(); i++) {
+            const uint8_t* frame = &batch->frames[i * NSL_PACKET_SIZE];
+            uint64_t       time  = std::max(estimateReceiveTime(frame, epoch), archive.getLastTime());
+            if (!archive.append(frame, time, ARCHIVE_FLAG_TIME_ESTIMATED)) {
+                totals.writeErrors++;
+            }
+        }
+        for (uint32_t i = 0; i < batch->count && !options.columnPath.empty(); i++) {
+            if (batch->kinds[i] == FrameScience && !store.append(batch->records[i])) {
+                totals.writeErrors++;
+            }
+        }
+        if (csv && fwrite(batch->csv.data(), 1, batch->csv.size(), csv) != batch->csv.size()) {
+            totals.writeErrors++;
+        }
+        
+        stage.items++;
+        stage.frames += batch->count;
+        stage.bytes  += batch->count * NSL_PACKET_SIZE;
+        if (!push(freeBatches, batch, stage)) {
+            break;
+        }
+    }
+    
+    if (!options.archivePath.empty() && !archive.flush()) {
+        totals.writeErrors++;
+    }
+    archive.close();
+    if (!options.columnPath.empty() && !store.close()) {
+        totals.writeErrors++;
+    }
+    if (csv && csv != stdout) {
+        fclose(csv);
+    } else if (csv) {
+        fflush(csv);
+    }
+    stage.busyNs = nowNs() - start - stage.starvedNs - stage.blockedNs;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Run and Report                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   Runs every stage to completion. Returns false if an input or
+ *          output could not be opened or a write failed.
+ */
+bool Pipeline::run()
+{
+    uint64_t start = nowNs();
+    
+    std::thread writer([this]()  { runWriter();  });
+    std::thread decoder([this]() { runDecoder(); });
+    std::thread framer([this]()  { runFramer();  });
+    std::thread reader([this]()  { runReader();  });
+    
+    reader.join();
+    framer.join();
+    decoder.join();
+    writer.join();
+    
+    totals.seconds = (nowNs() - start) / 1e9;
+    return !failed && totals.writeErrors == 0;
+}
+
+
+void Pipeline::printStats(FILE* output)
+{
+    double wallNs = totals.seconds * 1e9;
+    
+    fprintf(output, "%-8s %5s %10s %10s %9s %7s %8s %8s %8s\n", "stage", "core", "items", "frames",
+            "MB/s", "busy%", "starved%", "blocked%", "blocks");
+    for (int s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        const PipelineStageStats& stage = stats[s];
+        fprintf(output, "%-8s %5d %10llu %10llu %9.1f %7.1f %8.1f %8.1f %8llu\n", stageNames[s], stage.core,
+                (unsigned long long)stage.items, (unsigned long long)stage.frames,
+                totals.seconds > 0 ? stage.bytes / totals.seconds / 1e6 : 0.0,
+                wallNs > 0 ? 100.0 * stage.busyNs / wallNs : 0.0,
+                wallNs > 0 ? 100.0 * stage.starvedNs / wallNs : 0.0,
+                wallNs > 0 ? 100.0 * stage.blockedNs / wallNs : 0.0,
+                (unsigned long long)stage.blockedCount);
+    }
+    fprintf(output, "\nframes              %llu (science %llu, profile %llu, energy %llu, trace %llu, stats %llu, series %llu, unknown %llu)\n",
+            (unsigned long long)stats[StageDecoder].frames,
+            (unsigned long long)totals.kinds[FrameScience], (unsigned long long)totals.kinds[FrameProfile],
+            (unsigned long long)totals.kinds[FrameEnergy], (unsigned long long)totals.kinds[FrameI2CTrace],
+            (unsigned long long)totals.kinds[FrameStats], (unsigned long long)totals.kinds[FrameSeries],
+            (unsigned long long)totals.kinds[FrameUnknown]);
+    fprintf(output, "bytes skipped       %llu\n", (unsigned long long)totals.bytesSkipped);
+    fprintf(output, "short frames        %llu\n", (unsigned long long)totals.shortFrames);
+    fprintf(output, "write errors        %llu\n", (unsigned long long)totals.writeErrors);
+    fprintf(output, "wall time           %.3f s (%.1f MB/s, %.2f M frames/s)\n", totals.seconds,
+            totals.seconds > 0 ? stats[StageReader].bytes / totals.seconds / 1e6 : 0.0,
+            totals.seconds > 0 ? stats[StageDecoder].frames / totals.seconds / 1e6 : 0.0);
+}
+
+
+} /* namespace ground */
@@ -0,0 +1,179 @@
+/**
+ *  @file   ThinSatPipeline.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Multi-threaded ground pipeline for downlinked frame streams.
+ *
+ *          Four stages, each on its own thread, connected by SpscRings:
+ *
+ *          reader  -> framer  -> decoder -> writer
+ *          (chunks)   (batches of frames)   (archive, store, CSV)
+ *
+ *          - reader:  reads the inputs in PipelineChunk buffers, optionally
+ *                     several passes over the same files
+ *          - framer:  finds frames with a FrameScanner and copies them into
+ *                     PipelineBatches of up to batchFrames frames
+ *          - decoder: classifies and validates each frame, decodes and
+ *                     scales the science frames and, if CSV output is on,
+ *                     formats them
+ *          - writer:  appends to an archive, a column store and/or a CSV file
+ *
+ *          Chunks and batches are allocated once and recycled through return
+ *          rings, so steady state does no allocation. A stage whose output
+ *          ring is full waits (backpressure); the time each stage spends
+ *          working, waiting for input and waiting for room in its output is
+ *          counted in PipelineStageStats.
+ *
+ * @code
+ *  ground::PipelineOptions options;
+ *  options.inputs.push_back("capture.bin");
+ *  options.archivePath = "mission.tsa";
+ *  options.cores       = {0, 1, 2, 3};
+ *
+ *  ground::Pipeline pipeline(options);
+ *  pipeline.run();
+ *  pipeline.printStats(stdout);
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatPipeline_h
+#define ThinSatPipeline_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "SpscRing.h"
+
+
+namespace ground {
+
+
+#define PIPELINE_CHUNK_SIZE     (256 * 1024)    ///< Bytes per reader chunk
+#define PIPELINE_CHUNKS         8               ///< Chunks in flight
+#define PIPELINE_BATCH_FRAMES   1024            ///< Frames per batch
+#define PIPELINE_BATCHES        16              ///< Batches in flight
+
+
+typedef enum
+{
+    StageReader     = 0,
+    StageFramer     = 1,
+    StageDecoder    = 2,
+    StageWriter     = 3,
+    PIPELINE_STAGE_COUNT            ///< Number of stages. Not a valid stage
+} PipelineStage;
+
+
+typedef struct
+{
+    std::vector<std::string>    inputs;             ///< Raw captures ("-" for stdin, single pass only)
+    uint32_t                    passes      = 1;    ///< Times each input is replayed
+    std::string                 archivePath;        ///< ArchiveWriter output, if set
+    std::string                 columnPath;         ///< ColumnStoreWriter output, if set
+    std::string                 csvPath;            ///< Science frames in engineering units, if set
+    double                      epoch       = 0;    ///< Receive time base for the archive (Unix s)
+    std::vector<int>            cores;              ///< Core per stage; -1 or missing leaves it unpinned
+    uint32_t                    batchFrames = PIPELINE_BATCH_FRAMES;
+    uint32_t                    chunks      = PIPELINE_CHUNKS;
+    uint32_t                    batches     = PIPELINE_BATCHES;
+} PipelineOptions;
+
+
+/*!
+ * @brief   Counters of one stage. Written only by the stage's thread; read
+ *          them after run() returns.
+ */
+typedef struct
+{
+    uint64_t    items;              ///< Chunks (reader) or batches handled
+    uint64_t    bytes;              ///< Input bytes (reader, framer) or frame bytes
+    uint64_t    frames;             ///< Frames handled (framer and later)
+    uint64_t    busyNs;             ///< Time spent working
+    uint64_t    starvedNs;          ///< Time waiting for input
+    uint64_t    blockedNs;          ///< Time waiting for room downstream (backpressure)
+    uint64_t    blockedCount;       ///< Waits for room downstream or a free item
+    int         core;               ///< Core the stage ran on, -1 if unpinned
+} PipelineStageStats;
+
+
+typedef struct
+{
+    uint64_t    kinds[FrameUnknown + 1];    ///< Frames by FrameKind
+    uint64_t    invalid;                    ///< Unknown frame types
+    uint64_t    bytesSkipped;               ///< Framer bytes outside any frame
+    uint64_t    shortFrames;                ///< Framer resyncs
+    uint64_t    writeErrors;
+    double      seconds;                    ///< Wall time of run()
+} PipelineTotals;
+
+
+struct PipelineChunk
+{
+    std::vector<uint8_t>    data;
+    size_t                  length;
+    bool                    endOfPass;      ///< Last chunk of one pass over one input
+};
+
+
+struct PipelineBatch
+{
+    std::vector<uint8_t>        frames;     ///< count * NSL_PACKET_SIZE bytes
+    uint32_t                    count;
+    std::vector<uint8_t>        kinds;      ///< FrameKind of each frame
+    std::vector<ScienceRecord>  records;    ///< Valid for science frames
+    std::string                 csv;        ///< Formatted science rows, if CSV output is on
+};
+
+
+class Pipeline
+{
+    
+public:
+    explicit Pipeline(const PipelineOptions& options);
+    ~Pipeline();
+    
+    bool     run();
+    void     printStats(FILE* output);
+    
+    const PipelineStageStats& getStageStats(PipelineStage stage) { return stats[stage]; }
+    const PipelineTotals&     getTotals()                        { return totals; }
+    
+private:
+    
+    void     runReader();
+    void     runFramer();
+    void     runDecoder();
+    void     runWriter();
+    
+    template <typename T> bool pop(SpscRing<T*>& ring, T*& item, uint64_t& waitNs);
+    template <typename T> bool push(SpscRing<T*>& ring, T* item, PipelineStageStats& stage);
+    template <typename T> bool acquire(SpscRing<T*>& ring, T*& item, PipelineStageStats& stage);
+    
+    PipelineOptions                 options;
+    std::vector<PipelineChunk>      chunkPool;
+    std::vector<PipelineBatch>      batchPool;
+    SpscRing<PipelineChunk*>        filledChunks;   ///< reader -> framer
+    SpscRing<PipelineChunk*>        freeChunks;     ///< framer -> reader
+    SpscRing<PipelineBatch*>        framedBatches;  ///< framer -> decoder
+    SpscRing<PipelineBatch*>        decodedBatches; ///< decoder -> writer
+    SpscRing<PipelineBatch*>        freeBatches;    ///< writer -> framer
+    PipelineStageStats              stats[PIPELINE_STAGE_COUNT];
+    PipelineTotals                  totals;
+    std::atomic<bool>               failed{false};
+    
+};
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatPipeline_h */
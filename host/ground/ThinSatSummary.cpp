@@ -0,0 +1,293 @@
+/**
+ *  @file   ThinSatSummary.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Per-block summaries of an archive and windowed aggregates over
+ *          them.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "ThinSatSummary.h"
+
+
+namespace ground {
+
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "summaries are little-endian");
+static_assert(sizeof(SummaryHeader) == 32,                "summary header size");
+static_assert(sizeof(FieldSummary)  == 24,                "field summary size");
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Aggregates                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+void clearAggregate(Aggregate& aggregate)
+{
+    memset(&aggregate, 0, sizeof(aggregate));
+    aggregate.min = INT32_MAX;
+    aggregate.max = INT32_MIN;
+}
+
+
+/*!
+ * @brief   Adds one value (Welford's update)
+ */
+void addValue(Aggregate& a, int32_t value)
+{
+    double delta = value - a.mean;
+    
+    a.count++;
+    a.mean += delta / a.count;
+    a.m2   += delta * (value - a.mean);
+    a.min   = std::min(a.min, value);
+    a.max   = std::max(a.max, value);
+}
+
+
+/*!
+ * @brief   Adds a block of count values (Chan's parallel update). The
+ *          block's own spread is computed exactly from its integer sums
+ *          before anything is rounded.
+ */
+void addSummary(Aggregate& a, const FieldSummary& summary, uint32_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    
+    __int128 spread = (__int128)count * summary.sumSquares - (__int128)summary.sum * summary.sum;
+    double   mean   = (double)summary.sum / count;
+    double   m2     = (double)spread / count;
+    double   delta  = mean - a.mean;
+    uint64_t total  = a.count + count;
+    
+    a.m2   += m2 + delta * delta * ((double)a.count * count / total);
+    a.mean += delta * count / total;
+    a.count = total;
+    a.min   = std::min(a.min, summary.min);
+    a.max   = std::max(a.max, summary.max);
+}
+
+
+/*!
+ * @brief   Adds field of every science frame in records [first, last)
+ */
+static void decodeRange(const ArchiveReader& archive, StoreField field,
+                        uint64_t first, uint64_t last, Aggregate& result)
+{
+    ScienceRecord record;
+    
+    for (uint64_t i = first; i < last; i++) {
+        const uint8_t* frame = archive[i].frame;
+        if (getFrameKind(frame) == FrameScience) {
+            decodeScience(frame, record);
+            addValue(result, getField(record, field));
+        }
+    }
+    result.recordsDecoded += last - first;
+}
+
+
+/*!
+ * @brief   Adds field over records [first, last) by decoding every one of
+ *          them. For checking ArchiveSummary::aggregate().
+ */
+void scanAggregate(const ArchiveReader& archive, StoreField field,
+                   uint64_t first, uint64_t last, Aggregate& result)
+{
+    decodeRange(archive, field, first, std::min(last, archive.size()), result);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                 Archive Summary                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+static void summarizeBlock(const ArchiveReader& archive, uint64_t block, SummaryBlock& summary)
+{
+    ScienceRecord record;
+    uint64_t      first = block * SUMMARY_BLOCK_RECORDS;
+    
+    memset(&summary, 0, sizeof(summary));
+    for (int f = 0; f < STORE_FIELD_COUNT; f++) {
+        summary.fields[f].min = INT32_MAX;
+        summary.fields[f].max = INT32_MIN;
+    }
+    
+    for (uint64_t i = first; i < first + SUMMARY_BLOCK_RECORDS; i++) {
+        const uint8_t* frame = archive[i].frame;
+        if (getFrameKind(frame) != FrameScience) {
+            continue;
+        }
+        decodeScience(frame, record);
+        summary.count++;
+        
+        for (int f = 0; f < STORE_FIELD_COUNT; f++) {
+            FieldSummary& field = summary.fields[f];
+            int64_t       value = getField(record, (StoreField)f);
+            
+            field.min         = std::min(field.min, (int32_t)value);
+            field.max         = std::max(field.max, (int32_t)value);
+            field.sum        += value;
+            field.sumSquares += (uint64_t)(value * value);
+        }
+    }
+}
+
+
+static bool readAll(int fd, void* data, size_t length, off_t offset)
+{
+    uint8_t* p = (uint8_t*)data;
+    
+    while (length > 0) {
+        ssize_t got = pread(fd, p, length, offset);
+        if (got <= 0) {
+            if (got == 0) {
+                errno = EIO;
+            }
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p      += got;
+        length -= got;
+        offset += got;
+    }
+    return true;
+}
+
+
+static bool writeAll(int fd, const void* data, size_t length, off_t offset)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    
+    while (length > 0) {
+        ssize_t put = pwrite(fd, p, length, offset);
+        if (put < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p      += put;
+        length -= put;
+        offset += put;
+    }
+    return true;
+}
+
+
+/*!
+ * @brief   Loads the summary at path and summarizes the archive's complete
+ *          blocks it does not cover yet, saving them. A summary of another
+ *          archive, or of a different version, is rebuilt. If path cannot be
+ *          written the summary is kept in memory only. Returns false with
+ *          errno set on a read or write error.
+ */
+bool ArchiveSummary::open(const ArchiveReader& archive, const std::string& path)
+{
+    blocks.clear();
+    built = 0;
+    
+    uint64_t complete = archive.size() / SUMMARY_BLOCK_RECORDS;
+    int      fd       = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    
+    SummaryHeader header;
+    struct stat   info;
+    bool          valid = (fd >= 0 && fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(header) &&
+                           readAll(fd, &header, sizeof(header), 0));
+    
+    valid = valid && !memcmp(header.magic, SUMMARY_MAGIC, sizeof(header.magic)) &&
+            header.version        == SUMMARY_VERSION &&
+            header.fieldCount     == STORE_FIELD_COUNT &&
+            header.blockRecords   == SUMMARY_BLOCK_RECORDS &&
+            header.archiveCreated == archive.getCreatedTime();
+    
+    // A partial block left by an interrupted write is summarized again
+    uint64_t stored = valid ? (info.st_size - sizeof(header)) / sizeof(SummaryBlock) : 0;
+    if (stored > complete) {
+        stored = 0;
+    }
+    
+    blocks.resize(stored);
+    if (stored > 0 && !readAll(fd, blocks.data(), stored * sizeof(SummaryBlock), sizeof(header))) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    
+    blocks.resize(complete);
+    for (uint64_t b = stored; b < complete; b++) {
+        summarizeBlock(archive, b, blocks[b]);
+    }
+    built = complete - stored;
+    
+    if (fd < 0) {
+        return true;
+    }
+    
+    bool saved = true;
+    if (stored == 0) {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SUMMARY_MAGIC, sizeof(header.magic));
+        header.version        = SUMMARY_VERSION;
+        header.fieldCount     = STORE_FIELD_COUNT;
+        header.blockRecords   = SUMMARY_BLOCK_RECORDS;
+        header.archiveCreated = archive.getCreatedTime();
+        saved = writeAll(fd, &header, sizeof(header), 0);
+    }
+    off_t end = sizeof(header) + complete * sizeof(SummaryBlock);
+    saved = saved && writeAll(fd, blocks.data() + stored, built * sizeof(SummaryBlock),
+                              sizeof(header) + stored * sizeof(SummaryBlock));
+    saved = saved && ftruncate(fd, end) == 0;
+    
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return saved;
+}
+
+
+/*!
+ * @brief   Adds field over archive records [first, last) to result. Whole
+ *          summary blocks come from the summary; the rest is decoded.
+ */
+void ArchiveSummary::aggregate(const ArchiveReader& archive, StoreField field,
+                               uint64_t first, uint64_t last, Aggregate& result) const
+{
+    uint64_t pos = first;
+    
+    last = std::min(last, archive.size());
+    while (pos < last) {
+        uint64_t block = pos / SUMMARY_BLOCK_RECORDS;
+        uint64_t start = block * SUMMARY_BLOCK_RECORDS;
+        uint64_t end   = start + SUMMARY_BLOCK_RECORDS;
+        
+        if (pos == start && end <= last && block < blocks.size()) {
+            addSummary(result, blocks[block].fields[field], blocks[block].count);
+            result.blocksSummarized++;
+            pos = end;
+        } else {
+            end = std::min(end, last);
+            decodeRange(archive, field, pos, end, result);
+            pos = end;
+        }
+    }
+}
+
+
+} /* namespace ground */
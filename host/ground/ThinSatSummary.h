@@ -0,0 +1,145 @@
+/**
+ *  @file   ThinSatSummary.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Per-block summaries of an archive and windowed aggregates over
+ *          them.
+ *
+ *          ARCHIVE.sum keeps, for every SUMMARY_BLOCK_RECORDS records of the
+ *          archive, the count, min, max, sum and sum of squares of each
+ *          StoreField over the block's science frames. An aggregate over a
+ *          record range takes every block it covers whole from the summary
+ *          and decodes only the records of the partial blocks at its ends,
+ *          so a window costs at most two blocks of decoding however long it
+ *          is.
+ *
+ *          Blocks are merged with Chan's parallel variance update; each
+ *          block's own variance comes exactly from its integer sums. The
+ *          summary file grows with the archive: open() summarizes complete
+ *          blocks added since the last open and appends them. Records past
+ *          the last complete block are always decoded.
+ *
+ * @code
+ *  ground::ArchiveReader  archive;
+ *  ground::ArchiveSummary summary;
+ *  ground::Aggregate      result;
+ *  uint64_t               first, last;
+ *
+ *  archive.open("mission.tsa");
+ *  summary.open(archive, "mission.tsa" SUMMARY_SUFFIX);
+ *  archive.findRange(startUs, endUs, first, last);
+ *  summary.aggregate(archive, ground::FieldTslCurrent, first, last, result);
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatSummary_h
+#define ThinSatSummary_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "ThinSatArchive.h"
+#include "ThinSatColumnStore.h"
+
+
+namespace ground {
+
+
+#define SUMMARY_MAGIC           "TSLSUMRY"
+#define SUMMARY_VERSION         1
+#define SUMMARY_SUFFIX          ".sum"
+#define SUMMARY_BLOCK_RECORDS   1024    ///< Archive records per summary block
+
+
+typedef struct __attribute__((__packed__))
+{
+    char        magic[8];           ///< SUMMARY_MAGIC
+    uint16_t    version;            ///< SUMMARY_VERSION
+    uint16_t    fieldCount;         ///< STORE_FIELD_COUNT
+    uint32_t    blockRecords;       ///< SUMMARY_BLOCK_RECORDS
+    uint64_t    archiveCreated;     ///< createdTime of the summarized archive
+    uint8_t     reserved[8];
+} SummaryHeader;
+
+
+/*!
+ * @brief   Moments of one field over one block, in raw counts
+ */
+typedef struct __attribute__((__packed__))
+{
+    int32_t     min;
+    int32_t     max;
+    int64_t     sum;
+    uint64_t    sumSquares;
+} FieldSummary;
+
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t        count;          ///< Science frames in the block
+    uint32_t        reserved;
+    FieldSummary    fields[STORE_FIELD_COUNT];
+} SummaryBlock;
+
+
+/*!
+ * @brief   Running aggregate of one field, in raw counts
+ */
+typedef struct
+{
+    uint64_t    count;
+    int32_t     min;
+    int32_t     max;
+    double      mean;
+    double      m2;                 ///< Sum of squared differences from the mean
+    uint64_t    blocksSummarized;   ///< Blocks taken from the summary
+    uint64_t    recordsDecoded;     ///< Records decoded at the window edges
+    
+    double      variance() const    { return count > 1 ? m2 / (count - 1) : 0.0; }
+} Aggregate;
+
+
+void        clearAggregate(Aggregate& aggregate);
+void        addValue(Aggregate& aggregate, int32_t value);
+void        addSummary(Aggregate& aggregate, const FieldSummary& summary, uint32_t count);
+
+
+/*!
+ * @brief   Block summaries of one archive, loaded into memory and extended
+ *          on disk as the archive grows
+ */
+class ArchiveSummary
+{
+    
+public:
+    bool     open(const ArchiveReader& archive, const std::string& path);
+    
+    uint64_t getBlockCount() const      { return blocks.size(); }
+    uint64_t getBlocksBuilt() const     { return built; }
+    
+    void     aggregate(const ArchiveReader& archive, StoreField field,
+                       uint64_t first, uint64_t last, Aggregate& result) const;
+    
+private:
+    
+    std::vector<SummaryBlock>   blocks;
+    uint64_t                    built   = 0;    ///< Blocks summarized by the last open()
+    
+};
+
+
+void        scanAggregate(const ArchiveReader& archive, StoreField field,
+                          uint64_t first, uint64_t last, Aggregate& result);
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatSummary_h */
@@ -0,0 +1,412 @@
+/**
+ *  @file   ThinSatSync.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Error-tolerant streaming frame synchronizer.
+ *
+ *          While locked, the only per-frame work is a 3-byte compare
+ *          NSL_PACKET_SIZE bytes ahead. The vector header search is only run
+ *          while hunting.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "ThinSatSync.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GROUND_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define GROUND_HAVE_X86 0
+#endif
+
+
+namespace ground {
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Frame Ring                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+FrameRing::~FrameRing()
+{
+    close();
+}
+
+
+/*!
+ * @brief   Maps a ring of at least capacity bytes, rounded up to whole pages.
+ *          Returns false with errno set if the mapping fails.
+ */
+bool FrameRing::open(size_t capacity)
+{
+    close();
+    
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t want = std::max(capacity, (size_t)4 * NSL_PACKET_SIZE);
+    want = (want + page - 1) / page * page;
+    
+    int fd = memfd_create("thinsat_ring", MFD_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, (off_t)want) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    
+    // Reserve both halves first so the two views land back to back
+    uint8_t* region = (uint8_t*)mmap(nullptr, 2 * want, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool     mapped = (region != MAP_FAILED);
+    
+    for (int view = 0; mapped && view < 2; view++) {
+        mapped = mmap(region + view * want, want, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    }
+    
+    int error = errno;
+    ::close(fd);
+    if (!mapped) {
+        if (region != MAP_FAILED) {
+            munmap(region, 2 * want);
+        }
+        errno = error;
+        return false;
+    }
+    
+    base = region;
+    size = want;
+    head = tail = 0;
+    return true;
+}
+
+
+void FrameRing::close()
+{
+    if (base) {
+        munmap(base, 2 * size);
+    }
+    base = nullptr;
+    size = 0;
+    head = tail = 0;
+}
+
+
+/*!
+ * @brief   Returns where the next bytes go and how many fit
+ */
+uint8_t* FrameRing::getWriteSpace(size_t& space)
+{
+    space = size - (size_t)(head - tail);
+    return base + head % size;
+}
+
+
+void FrameRing::commit(size_t length)
+{
+    head += length;
+}
+
+
+/*!
+ * @brief   Returns the oldest unreleased byte. All length bytes are
+ *          contiguous, even across the end of the ring.
+ */
+uint8_t* FrameRing::getReadData(size_t& length)
+{
+    length = (size_t)(head - tail);
+    return base + tail % size;
+}
+
+
+void FrameRing::release(size_t length)
+{
+    tail += length;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Header Search                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+static size_t findHeaderScalar(const uint8_t* data, size_t length)
+{
+    size_t pos = 0;
+    
+    while (length - pos >= NSL_PACKET_HEADER_LENGTH) {
+        const uint8_t* hit = (const uint8_t*)memchr(&data[pos], GROUND_HEADER_BYTE,
+                                                    length - pos - (NSL_PACKET_HEADER_LENGTH - 1));
+        if (!hit) {
+            break;
+        }
+        pos = hit - data;
+        if (isHeader(hit)) {
+            return pos;
+        }
+        pos++;
+    }
+    return length;
+}
+
+
+#if GROUND_HAVE_X86
+
+/*!
+ * @brief   Compares three overlapping loads, so bit n of the mask is set
+ *          when bytes n, n+1 and n+2 are all header bytes.
+ */
+__attribute__((target("avx2")))
+static size_t findHeaderAVX2(const uint8_t* data, size_t length)
+{
+    const __m256i header = _mm256_set1_epi8((char)GROUND_HEADER_BYTE);
+    size_t        pos    = 0;
+    
+    for (; pos + 32 + NSL_PACKET_HEADER_LENGTH - 1 <= length; pos += 32) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&data[pos]),     header);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&data[pos + 1]), header);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&data[pos + 2]), header);
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(a, b), c));
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return pos + findHeaderScalar(&data[pos], length - pos);
+}
+
+
+static size_t findHeaderSSE2(const uint8_t* data, size_t length)
+{
+    const __m128i header = _mm_set1_epi8((char)GROUND_HEADER_BYTE);
+    size_t        pos    = 0;
+    
+    for (; pos + 16 + NSL_PACKET_HEADER_LENGTH - 1 <= length; pos += 16) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&data[pos]),     header);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&data[pos + 1]), header);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&data[pos + 2]), header);
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(a, b), c));
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return pos + findHeaderScalar(&data[pos], length - pos);
+}
+
+#endif
+
+
+typedef size_t (*HeaderSearch)(const uint8_t* data, size_t length);
+
+static HeaderSearch selectHeaderSearch()
+{
+#if GROUND_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findHeaderAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return findHeaderSSE2;
+    }
+#endif
+    return findHeaderScalar;
+}
+
+
+/*!
+ * @brief   Returns the offset of the first run of three header bytes that
+ *          lies entirely within data, or length if there is none
+ */
+size_t findHeader(const uint8_t* data, size_t length)
+{
+    static const HeaderSearch search = selectHeaderSearch();
+    return search(data, length);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                   Synchronizer                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+FrameSynchronizer::FrameSynchronizer(uint8_t headerTolerance, size_t ringCapacity) :
+    ringSize(ringCapacity),
+    tolerance(std::min(headerTolerance, (uint8_t)(NSL_PACKET_HEADER_LENGTH - 1)))
+{
+}
+
+
+/*!
+ * @brief   Reads what fd has ready into the ring and delivers the frames it
+ *          completes. Returns false at the end of the stream, with errno 0,
+ *          or on a read error, with errno set.
+ */
+bool FrameSynchronizer::read(int fd, const FrameHandler& handler)
+{
+    if (ring.capacity() == 0 && !ring.open(ringSize)) {
+        return false;
+    }
+    
+    size_t   space;
+    uint8_t* free = ring.getWriteSpace(space);
+    ssize_t  got;
+    
+    do {
+        got = ::read(fd, free, space);
+    } while (got < 0 && errno == EINTR);
+    
+    if (got < 0) {
+        return false;
+    }
+    ring.commit((size_t)got);
+    
+    size_t   length;
+    uint8_t* data = ring.getReadData(length);
+    ring.release(process(data, length, got == 0, handler));
+    
+    if (got == 0) {
+        errno = 0;
+        return false;
+    }
+    return true;
+}
+
+
+static inline uint8_t countHeaderErrors(const uint8_t* p)
+{
+    return (p[0] != GROUND_HEADER_BYTE) + (p[1] != GROUND_HEADER_BYTE) + (p[2] != GROUND_HEADER_BYTE);
+}
+
+
+void FrameSynchronizer::lock()
+{
+    state        = SyncLocked;
+    lastRepaired = false;
+    stats.acquisitions++;
+    
+    if (everLocked) {
+        uint64_t recovery = offset - lostAt;
+        stats.recoveryBytes   += recovery;
+        stats.maxRecoveryBytes = std::max(stats.maxRecoveryBytes, recovery);
+    }
+    everLocked = true;
+}
+
+
+void FrameSynchronizer::loseLock()
+{
+    state  = SyncHunting;
+    lostAt = offset;
+    stats.syncLosses++;
+}
+
+
+/*!
+ * @brief   Delivers the frames in data and returns the number of bytes
+ *          consumed. data must start with the first byte the last call did
+ *          not consume. Unless final, up to NSL_PACKET_SIZE +
+ *          NSL_PACKET_HEADER_LENGTH bytes are left for the next call.
+ *          Repaired headers are rewritten in place.
+ */
+size_t FrameSynchronizer::process(uint8_t* data, size_t length, bool final, const FrameHandler& handler)
+{
+    const size_t confirm = NSL_PACKET_SIZE + NSL_PACKET_HEADER_LENGTH;     // Through the next header
+    const size_t check   = confirm + 1;                                     // ... and one byte past it
+    uint64_t     start   = offset;
+    size_t       pos     = 0;
+    
+    stats.bytesIn = std::max(stats.bytesIn, start + length);
+    
+    while (true) {
+        offset = start + pos;
+        
+        if (state == SyncLocked) {
+            // The header at pos was already accepted; the frame is complete
+            // when the next one shows up where it should
+            if (length - pos < check) {
+                if (final && length - pos >= NSL_PACKET_SIZE) {
+                    handler(&data[pos]);
+                    stats.frames++;
+                    pos += NSL_PACKET_SIZE;
+                }
+                break;
+            }
+            
+            // A dropped or inserted byte leaves the next header one byte
+            // off, which looks like a single bad header byte, and a lock one
+            // byte off sees [payload, 0x50, 0x50] or [0x50, 0x50, met] every
+            // frame. A repair is only made right after a clean header and
+            // when no exact header sits one byte either side.
+            uint8_t* next   = &data[pos + NSL_PACKET_SIZE];
+            uint8_t  errors = countHeaderErrors(next);
+            bool     slip   = errors && (isHeader(next - 1) || isHeader(next + 1));
+            if (errors > tolerance || (errors && lastRepaired) || slip) {
+                loseLock();
+                stats.bytesDiscarded++;
+                pos++;
+                continue;
+            }
+            if (errors) {
+                memset(next, GROUND_HEADER_BYTE, NSL_PACKET_HEADER_LENGTH);
+                stats.headersRepaired++;
+            }
+            lastRepaired = (errors != 0);
+            handler(&data[pos]);
+            stats.frames++;
+            pos += NSL_PACKET_SIZE;
+        
+        } else {
+            if (length - pos < NSL_PACKET_HEADER_LENGTH) {
+                break;
+            }
+            
+            size_t hit = findHeader(&data[pos], length - pos);
+            if (hit == length - pos) {
+                // The last two bytes may still start a header
+                hit = length - pos - (NSL_PACKET_HEADER_LENGTH - 1);
+                stats.bytesDiscarded += hit;
+                pos += hit;
+                break;
+            }
+            stats.bytesDiscarded += hit;
+            pos   += hit;
+            offset = start + pos;
+            
+            if (length - pos < confirm) {
+                // A lone frame at the very end of the stream is accepted
+                if (final && length - pos == NSL_PACKET_SIZE) {
+                    stats.candidates++;
+                    lock();
+                    continue;
+                }
+                break;
+            }
+            
+            stats.candidates++;
+            if (isHeader(&data[pos + NSL_PACKET_SIZE])) {
+                lock();
+            } else {
+                stats.falseCandidates++;
+                stats.bytesDiscarded++;
+                pos++;
+            }
+        }
+    }
+    
+    if (final) {
+        stats.bytesDiscarded += length - pos;
+        pos = length;
+    }
+    offset = start + pos;
+    return pos;
+}
+
+
+} /* namespace ground */
@@ -0,0 +1,154 @@
+/**
+ *  @file   ThinSatSync.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Error-tolerant streaming frame synchronizer for downlinked
+ *          ThinsatPacket_t streams.
+ *
+ *          Frames carry only a 3-byte NSL_PACKET_HEADER: no length and no
+ *          checksum. A payload that happens to contain 0x505050 looks like a
+ *          header, and a dropped or inserted byte shifts every frame behind
+ *          it. The synchronizer runs a two-state loop:
+ *          - SyncHunting: vector search for a run of three header bytes.
+ *            A candidate is only accepted when a second header starts
+ *            exactly NSL_PACKET_SIZE bytes later; otherwise it is counted
+ *            as a false candidate and the search resumes one byte further.
+ *          - SyncLocked: each frame is delivered once the header
+ *            NSL_PACKET_SIZE bytes later is seen. Up to headerTolerance
+ *            corrupted header bytes are accepted (and repaired) so a bit
+ *            error in a header does not drop the lock, but never in two
+ *            headers in a row. Anything worse is a sync loss: the frame is
+ *            discarded and hunting restarts one byte into it, so lock is
+ *            regained within two clean frames.
+ *
+ *          Input is read straight into a FrameRing, a ring buffer mapped
+ *          twice back to back so that every window of it is contiguous.
+ *          Frames are handed out as pointers into the ring and never copied.
+ *
+ * @code
+ *  ground::FrameSynchronizer sync;
+ *
+ *  while (sync.read(fd, [](const uint8_t* frame) { ... })) {
+ *  }
+ *  if (errno) perror("read");
+ *  sync.getStats().syncLosses;
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatSync_h
+#define ThinSatSync_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ThinSatDecoder.h"
+
+
+namespace ground {
+
+
+#define SYNC_RING_SIZE          (1 << 20)   ///< Default FrameRing capacity (bytes)
+#define SYNC_HEADER_TOLERANCE   1           ///< Default bad header bytes accepted while locked
+
+
+/*!
+ * @brief   Single-threaded ring buffer whose storage is mapped twice, back
+ *          to back. Readable and writable regions are always contiguous, so
+ *          read() can fill it directly and callers can parse it in place.
+ */
+class FrameRing
+{
+    
+public:
+    ~FrameRing();
+    
+    bool     open(size_t capacity);
+    void     close();
+    
+    uint8_t* getWriteSpace(size_t& space);
+    void     commit(size_t length);
+    uint8_t* getReadData(size_t& length);
+    void     release(size_t length);
+    
+    size_t   capacity()     { return size; }
+    
+private:
+    
+    uint8_t* base   = nullptr;
+    size_t   size   = 0;            ///< Capacity, a multiple of the page size
+    uint64_t head   = 0;            ///< Bytes ever committed
+    uint64_t tail   = 0;            ///< Bytes ever released
+    
+};
+
+
+typedef enum
+{
+    SyncHunting     = 0,
+    SyncLocked      = 1
+} SyncState;
+
+
+/*!
+ * @brief   Synchronizer counters
+ */
+typedef struct
+{
+    uint64_t    bytesIn;            ///< Bytes passed to process()
+    uint64_t    frames;             ///< Frames delivered
+    uint64_t    bytesDiscarded;     ///< Bytes outside any delivered frame
+    uint64_t    candidates;         ///< Header runs examined while hunting
+    uint64_t    falseCandidates;    ///< Candidates without a header NSL_PACKET_SIZE later
+    uint64_t    acquisitions;       ///< Transitions to SyncLocked
+    uint64_t    syncLosses;         ///< Transitions back to SyncHunting
+    uint64_t    headersRepaired;    ///< Headers accepted with headerTolerance errors
+    uint64_t    recoveryBytes;      ///< Bytes between each sync loss and the next lock
+    uint64_t    maxRecoveryBytes;   ///< Longest single recovery
+} SyncStats;
+
+
+/*!
+ * @brief   Streaming frame synchronizer. Feed it with read() from a file
+ *          descriptor, or call process() on buffers you own.
+ */
+class FrameSynchronizer
+{
+    
+public:
+    explicit FrameSynchronizer(uint8_t headerTolerance = SYNC_HEADER_TOLERANCE, size_t ringSize = SYNC_RING_SIZE);
+    
+    bool     read(int fd, const FrameHandler& handler);
+    size_t   process(uint8_t* data, size_t length, bool final, const FrameHandler& handler);
+    
+    SyncState        getState()  { return state; }
+    const SyncStats& getStats()  { return stats; }
+    
+private:
+    
+    void     lock();
+    void     loseLock();
+    
+    FrameRing   ring;
+    size_t      ringSize;
+    uint8_t     tolerance;
+    SyncState   state           = SyncHunting;
+    uint64_t    offset          = 0;        ///< Stream position of the first unconsumed byte
+    uint64_t    lostAt          = 0;        ///< Stream position of the last sync loss
+    bool        everLocked      = false;
+    bool        lastRepaired    = false;    ///< The last header accepted while locked was repaired
+    SyncStats   stats           = {};
+    
+};
+
+
+size_t      findHeader(const uint8_t* data, size_t length);
+
+
+} /* namespace ground */
+
+
+#endif /* ThinSatSync_h */
@@ -0,0 +1,171 @@
+/**
+ *  @file   Adafruit_BMP280.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host implementation of the Adafruit BMP280 library subset
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "Adafruit_BMP280.h"
+
+
+Adafruit_BMP280::Adafruit_BMP280()
+    : _i2caddr(BMP280_ADDRESS), t_fine(0), _bmp280_calib()
+{
+}
+
+bool Adafruit_BMP280::begin(uint8_t addr, uint8_t chipid)
+{
+    _i2caddr = addr;
+    
+    Wire.begin();
+    
+    if (read8(BMP280_REGISTER_CHIPID) != chipid) {
+        return false;
+    }
+    
+    readCoefficients();
+    write8(BMP280_REGISTER_CONTROL, 0x3F);  // 16x pressure, 1x temperature oversampling, normal mode
+    delay(100);
+    return true;
+}
+
+void Adafruit_BMP280::readCoefficients()
+{
+    _bmp280_calib.dig_T1 = read16_LE(BMP280_REGISTER_DIG_T1);
+    _bmp280_calib.dig_T2 = readS16_LE(BMP280_REGISTER_DIG_T2);
+    _bmp280_calib.dig_T3 = readS16_LE(BMP280_REGISTER_DIG_T3);
+    
+    _bmp280_calib.dig_P1 = read16_LE(BMP280_REGISTER_DIG_P1);
+    _bmp280_calib.dig_P2 = readS16_LE(BMP280_REGISTER_DIG_P2);
+    _bmp280_calib.dig_P3 = readS16_LE(BMP280_REGISTER_DIG_P3);
+    _bmp280_calib.dig_P4 = readS16_LE(BMP280_REGISTER_DIG_P4);
+    _bmp280_calib.dig_P5 = readS16_LE(BMP280_REGISTER_DIG_P5);
+    _bmp280_calib.dig_P6 = readS16_LE(BMP280_REGISTER_DIG_P6);
+    _bmp280_calib.dig_P7 = readS16_LE(BMP280_REGISTER_DIG_P7);
+    _bmp280_calib.dig_P8 = readS16_LE(BMP280_REGISTER_DIG_P8);
+    _bmp280_calib.dig_P9 = readS16_LE(BMP280_REGISTER_DIG_P9);
+}
+
+/*!
+ * @brief Bosch integer temperature compensation. Also updates t_fine, which
+ * the pressure compensation needs.
+ *
+ * @return temperature in degrees C
+ */
+float Adafruit_BMP280::readTemperature()
+{
+    int32_t var1, var2;
+    
+    int32_t adc_T = read24(BMP280_REGISTER_TEMPDATA);
+    adc_T >>= 4;
+    
+    var1 = ((((adc_T >> 3) - ((int32_t)_bmp280_calib.dig_T1 << 1))) *
+            ((int32_t)_bmp280_calib.dig_T2)) >> 11;
+    
+    var2 = (((((adc_T >> 4) - ((int32_t)_bmp280_calib.dig_T1)) *
+              ((adc_T >> 4) - ((int32_t)_bmp280_calib.dig_T1))) >> 12) *
+            ((int32_t)_bmp280_calib.dig_T3)) >> 14;
+    
+    t_fine = var1 + var2;
+    
+    float T = (t_fine * 5 + 128) >> 8;
+    return T / 100;
+}
+
+/*!
+ * @brief Bosch 64-bit integer pressure compensation
+ *
+ * @return pressure in Pa
+ */
+float Adafruit_BMP280::readPressure()
+{
+    int64_t var1, var2, p;
+    
+    readTemperature();  // Must be done first to get t_fine
+    
+    int32_t adc_P = read24(BMP280_REGISTER_PRESSUREDATA);
+    adc_P >>= 4;
+    
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)_bmp280_calib.dig_P6;
+    var2 = var2 + ((var1 * (int64_t)_bmp280_calib.dig_P5) << 17);
+    var2 = var2 + (((int64_t)_bmp280_calib.dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)_bmp280_calib.dig_P3) >> 8) +
+           ((var1 * (int64_t)_bmp280_calib.dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)_bmp280_calib.dig_P1) >> 33;
+    
+    if (var1 == 0) {
+        return 0;   // avoid exception caused by division by zero
+    }
+    p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)_bmp280_calib.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)_bmp280_calib.dig_P8) * p) >> 19;
+    
+    p = ((p + var1 + var2) >> 8) + (((int64_t)_bmp280_calib.dig_P7) << 4);
+    return (float)p / 256;
+}
+
+float Adafruit_BMP280::readAltitude(float seaLevelhPa)
+{
+    float pressure = readPressure() / 100;
+    return 44330 * (1.0 - pow(pressure / seaLevelhPa, 0.1903));
+}
+
+void Adafruit_BMP280::write8(uint8_t reg, uint8_t value)
+{
+    Wire.beginTransmission(_i2caddr);
+    Wire.write(reg);
+    Wire.write(value);
+    Wire.endTransmission();
+}
+
+uint8_t Adafruit_BMP280::read8(uint8_t reg)
+{
+    Wire.beginTransmission(_i2caddr);
+    Wire.write(reg);
+    Wire.endTransmission();
+    Wire.requestFrom(_i2caddr, (uint8_t)1);
+    return (uint8_t)Wire.read();
+}
+
+uint16_t Adafruit_BMP280::read16(uint8_t reg)
+{
+    Wire.beginTransmission(_i2caddr);
+    Wire.write(reg);
+    Wire.endTransmission();
+    Wire.requestFrom(_i2caddr, (uint8_t)2);
+    uint16_t value = (uint8_t)Wire.read();
+    return (value << 8) | (uint8_t)Wire.read();
+}
+
+uint16_t Adafruit_BMP280::read16_LE(uint8_t reg)
+{
+    uint16_t temp = read16(reg);
+    return (temp >> 8) | (temp << 8);
+}
+
+int16_t Adafruit_BMP280::readS16_LE(uint8_t reg)
+{
+    return (int16_t)read16_LE(reg);
+}
+
+uint32_t Adafruit_BMP280::read24(uint8_t reg)
+{
+    uint32_t value;
+    
+    Wire.beginTransmission(_i2caddr);
+    Wire.write(reg);
+    Wire.endTransmission();
+    Wire.requestFrom(_i2caddr, (uint8_t)3);
+    
+    value  = (uint8_t)Wire.read();
+    value <<= 8;
+    value |= (uint8_t)Wire.read();
+    value <<= 8;
+    value |= (uint8_t)Wire.read();
+    return value;
+}
@@ -0,0 +1,96 @@
+/**
+ *  @file   Adafruit_BMP280.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Adafruit BMP280 library (I2C only).
+ *
+ *          Reads the calibration and ADC registers over the simulated I2C bus
+ *          and applies the Bosch integer compensation exactly like the
+ *          Adafruit library, so any register model attached at BMP280_ADDRESS
+ *          supplies the data.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef Adafruit_BMP280_h
+#define Adafruit_BMP280_h
+
+#include "Arduino.h"
+#include "Wire.h"
+
+
+#define BMP280_ADDRESS  0x77
+#define BMP280_CHIPID   0x58
+
+enum
+{
+    BMP280_REGISTER_DIG_T1          = 0x88,
+    BMP280_REGISTER_DIG_T2          = 0x8A,
+    BMP280_REGISTER_DIG_T3          = 0x8C,
+    BMP280_REGISTER_DIG_P1          = 0x8E,
+    BMP280_REGISTER_DIG_P2          = 0x90,
+    BMP280_REGISTER_DIG_P3          = 0x92,
+    BMP280_REGISTER_DIG_P4          = 0x94,
+    BMP280_REGISTER_DIG_P5          = 0x96,
+    BMP280_REGISTER_DIG_P6          = 0x98,
+    BMP280_REGISTER_DIG_P7          = 0x9A,
+    BMP280_REGISTER_DIG_P8          = 0x9C,
+    BMP280_REGISTER_DIG_P9          = 0x9E,
+    BMP280_REGISTER_CHIPID          = 0xD0,
+    BMP280_REGISTER_VERSION         = 0xD1,
+    BMP280_REGISTER_SOFTRESET       = 0xE0,
+    BMP280_REGISTER_CAL26           = 0xE1,
+    BMP280_REGISTER_CONTROL         = 0xF4,
+    BMP280_REGISTER_CONFIG          = 0xF5,
+    BMP280_REGISTER_PRESSUREDATA    = 0xF7,
+    BMP280_REGISTER_TEMPDATA        = 0xFA
+};
+
+typedef struct
+{
+    uint16_t dig_T1;
+    int16_t  dig_T2;
+    int16_t  dig_T3;
+    uint16_t dig_P1;
+    int16_t  dig_P2;
+    int16_t  dig_P3;
+    int16_t  dig_P4;
+    int16_t  dig_P5;
+    int16_t  dig_P6;
+    int16_t  dig_P7;
+    int16_t  dig_P8;
+    int16_t  dig_P9;
+} bmp280_calib_data;
+
+
+class Adafruit_BMP280
+{
+
+public:
+    Adafruit_BMP280();
+    
+    bool    begin(uint8_t addr = BMP280_ADDRESS, uint8_t chipid = BMP280_CHIPID);
+    float   readTemperature();
+    float   readPressure();
+    float   readAltitude(float seaLevelhPa = 1013.25);
+    
+private:
+    
+    void     readCoefficients();
+    
+    void     write8(uint8_t reg, uint8_t value);
+    uint8_t  read8(uint8_t reg);
+    uint16_t read16(uint8_t reg);
+    uint16_t read16_LE(uint8_t reg);
+    int16_t  readS16_LE(uint8_t reg);
+    uint32_t read24(uint8_t reg);
+    
+    uint8_t             _i2caddr;
+    int32_t             t_fine;
+    bmp280_calib_data   _bmp280_calib;
+    
+};
+
+#endif /* Adafruit_BMP280_h */
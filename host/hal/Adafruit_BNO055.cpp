@@ -0,0 +1,170 @@
+/**
+ *  @file   Adafruit_BNO055.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host implementation of the Adafruit BNO055 library subset
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "Adafruit_BNO055.h"
+
+
+Adafruit_BNO055::Adafruit_BNO055(int32_t sensorID, uint8_t address)
+    : _sensorID(sensorID), _address(address), _mode(OPERATION_MODE_NDOF)
+{
+}
+
+/*!
+ * @brief Same sequence as the Adafruit library: check the chip ID, reset,
+ * select normal power mode and enter the requested operating mode.
+ */
+bool Adafruit_BNO055::begin(adafruit_bno055_opmode_t mode)
+{
+    uint8_t id = read8(BNO055_CHIP_ID_ADDR);
+    if (id != BNO055_ID) {
+        delay(1000);    // The BNO055 can take a second to boot
+        id = read8(BNO055_CHIP_ID_ADDR);
+        if (id != BNO055_ID) {
+            return false;
+        }
+    }
+    
+    setMode(OPERATION_MODE_CONFIG);
+    
+    write8(BNO055_SYS_TRIGGER_ADDR, 0x20);  // Reset
+    delay(30);
+    while (read8(BNO055_CHIP_ID_ADDR) != BNO055_ID) {
+        delay(10);
+    }
+    delay(50);
+    
+    write8(BNO055_PWR_MODE_ADDR, 0x00);     // Normal power mode
+    delay(10);
+    write8(BNO055_PAGE_ID_ADDR, 0);
+    write8(BNO055_SYS_TRIGGER_ADDR, 0x0);
+    delay(10);
+    
+    setMode(mode);
+    delay(20);
+    
+    return true;
+}
+
+void Adafruit_BNO055::setMode(adafruit_bno055_opmode_t mode)
+{
+    _mode = mode;
+    write8(BNO055_OPR_MODE_ADDR, _mode);
+    delay(30);
+}
+
+void Adafruit_BNO055::setExtCrystalUse(boolean usextal)
+{
+    adafruit_bno055_opmode_t modeback = _mode;
+    
+    setMode(OPERATION_MODE_CONFIG);
+    delay(25);
+    write8(BNO055_PAGE_ID_ADDR, 0);
+    write8(BNO055_SYS_TRIGGER_ADDR, usextal ? 0x80 : 0x00);
+    delay(10);
+    setMode(modeback);
+    delay(20);
+}
+
+void Adafruit_BNO055::getCalibration(uint8_t* sys, uint8_t* gyro, uint8_t* accel, uint8_t* mag)
+{
+    uint8_t calData = read8(BNO055_CALIB_STAT_ADDR);
+    
+    if (sys != NULL)   { *sys   = (calData >> 6) & 0x03; }
+    if (gyro != NULL)  { *gyro  = (calData >> 4) & 0x03; }
+    if (accel != NULL) { *accel = (calData >> 2) & 0x03; }
+    if (mag != NULL)   { *mag   = calData & 0x03; }
+}
+
+int8_t Adafruit_BNO055::getTemp()
+{
+    return (int8_t)read8(BNO055_TEMP_ADDR);
+}
+
+/*!
+ * @brief Reads a 3-axis vector. Scaling matches the Adafruit library
+ * (magnetometer 16 LSB/uT, gyroscope 16 LSB/dps, Euler 16 LSB/deg,
+ * accelerations 100 LSB/m/s^2).
+ */
+imu::Vector<3> Adafruit_BNO055::getVector(adafruit_vector_type_t vector_type)
+{
+    imu::Vector<3> xyz;
+    uint8_t buffer[6] = {0};
+    
+    readLen((adafruit_bno055_reg_t)vector_type, buffer, 6);
+    
+    int16_t x = ((int16_t)buffer[0]) | (((int16_t)buffer[1]) << 8);
+    int16_t y = ((int16_t)buffer[2]) | (((int16_t)buffer[3]) << 8);
+    int16_t z = ((int16_t)buffer[4]) | (((int16_t)buffer[5]) << 8);
+    
+    double scale;
+    switch (vector_type) {
+        case VECTOR_MAGNETOMETER:
+        case VECTOR_GYROSCOPE:
+        case VECTOR_EULER:
+            scale = 16.0;
+            break;
+        default:
+            scale = 100.0;
+            break;
+    }
+    
+    xyz[0] = x / scale;
+    xyz[1] = y / scale;
+    xyz[2] = z / scale;
+    return xyz;
+}
+
+/*!
+ * @brief Reads the fused quaternion (2^14 LSB per unit)
+ */
+imu::Quaternion Adafruit_BNO055::getQuat()
+{
+    uint8_t buffer[8] = {0};
+    
+    readLen(BNO055_QUATERNION_DATA_W_LSB_ADDR, buffer, 8);
+    
+    int16_t w = (((uint16_t)buffer[1]) << 8) | ((uint16_t)buffer[0]);
+    int16_t x = (((uint16_t)buffer[3]) << 8) | ((uint16_t)buffer[2]);
+    int16_t y = (((uint16_t)buffer[5]) << 8) | ((uint16_t)buffer[4]);
+    int16_t z = (((uint16_t)buffer[7]) << 8) | ((uint16_t)buffer[6]);
+    
+    const double scale = (1.0 / (1 << 14));
+    return imu::Quaternion(scale * w, scale * x, scale * y, scale * z);
+}
+
+uint8_t Adafruit_BNO055::read8(adafruit_bno055_reg_t reg)
+{
+    uint8_t value = 0;
+    readLen(reg, &value, 1);
+    return value;
+}
+
+bool Adafruit_BNO055::readLen(adafruit_bno055_reg_t reg, uint8_t* buffer, uint8_t len)
+{
+    Wire.beginTransmission(_address);
+    Wire.write((uint8_t)reg);
+    Wire.endTransmission();
+    Wire.requestFrom(_address, len);
+    
+    for (uint8_t i = 0; i < len; i++) {
+        int value = Wire.read();
+        buffer[i] = (value < 0) ? 0xFF : (uint8_t)value;   // Idle bus reads high
+    }
+    return true;
+}
+
+bool Adafruit_BNO055::write8(adafruit_bno055_reg_t reg, uint8_t value)
+{
+    Wire.beginTransmission(_address);
+    Wire.write((uint8_t)reg);
+    Wire.write(value);
+    Wire.endTransmission();
+    return true;
+}
@@ -0,0 +1,86 @@
+/**
+ *  @file   Adafruit_BNO055.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Adafruit BNO055 library.
+ *
+ *          Performs the same register transactions as the Adafruit library on
+ *          the simulated I2C bus and decodes the replies with the same
+ *          scaling, so bus time is realistic and any register model attached
+ *          at BNO055_ADDRESS_A supplies the data.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef Adafruit_BNO055_h
+#define Adafruit_BNO055_h
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "utility/imumaths.h"
+
+
+#define BNO055_ADDRESS_A    0x28
+#define BNO055_ADDRESS_B    0x29
+#define BNO055_ID           0xA0
+
+
+class Adafruit_BNO055
+{
+
+public:
+    
+    typedef enum
+    {
+        BNO055_CHIP_ID_ADDR             = 0x00,
+        BNO055_PAGE_ID_ADDR             = 0x07,
+        BNO055_QUATERNION_DATA_W_LSB_ADDR = 0x20,
+        BNO055_TEMP_ADDR                = 0x34,
+        BNO055_CALIB_STAT_ADDR          = 0x35,
+        BNO055_OPR_MODE_ADDR            = 0x3D,
+        BNO055_PWR_MODE_ADDR            = 0x3E,
+        BNO055_SYS_TRIGGER_ADDR         = 0x3F
+    } adafruit_bno055_reg_t;
+    
+    typedef enum
+    {
+        OPERATION_MODE_CONFIG           = 0x00,
+        OPERATION_MODE_NDOF             = 0x0C
+    } adafruit_bno055_opmode_t;
+    
+    typedef enum
+    {
+        VECTOR_ACCELEROMETER            = 0x08,
+        VECTOR_MAGNETOMETER             = 0x0E,
+        VECTOR_GYROSCOPE                = 0x14,
+        VECTOR_EULER                    = 0x1A,
+        VECTOR_LINEARACCEL              = 0x28,
+        VECTOR_GRAVITY                  = 0x2E
+    } adafruit_vector_type_t;
+    
+    Adafruit_BNO055(int32_t sensorID = -1, uint8_t address = BNO055_ADDRESS_A);
+    
+    bool            begin(adafruit_bno055_opmode_t mode = OPERATION_MODE_NDOF);
+    void            setMode(adafruit_bno055_opmode_t mode);
+    void            setExtCrystalUse(boolean usextal);
+    void            getCalibration(uint8_t* sys, uint8_t* gyro, uint8_t* accel, uint8_t* mag);
+    int8_t          getTemp();
+    
+    imu::Vector<3>  getVector(adafruit_vector_type_t vector_type);
+    imu::Quaternion getQuat();
+    
+private:
+    
+    uint8_t         read8(adafruit_bno055_reg_t reg);
+    bool            readLen(adafruit_bno055_reg_t reg, uint8_t* buffer, uint8_t len);
+    bool            write8(adafruit_bno055_reg_t reg, uint8_t value);
+    
+    int32_t                     _sensorID;
+    uint8_t                     _address;
+    adafruit_bno055_opmode_t    _mode;
+    
+};
+
+#endif /* Adafruit_BNO055_h */
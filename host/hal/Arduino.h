@@ -0,0 +1,85 @@
+/**
+ *  @file   Arduino.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Arduino core. Provides the subset of the
+ *          Arduino API used by the TSLPB library and the VCSFA_ThinSat sketch,
+ *          backed by the virtual clock and simulated pins in HostHal.h.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+
+typedef uint8_t     byte;
+typedef bool        boolean;
+typedef uint16_t    word;
+
+#define HIGH            0x1
+#define LOW             0x0
+
+#define INPUT           0x0
+#define OUTPUT          0x1
+#define INPUT_PULLUP    0x2
+
+#define CHANGE          1
+#define FALLING         2
+#define RISING          3
+
+#define NOT_AN_INTERRUPT    -1
+
+// ATmega328P (Arduino Pro Mini) analog pin numbers
+#define A0  14
+#define A1  15
+#define A2  16
+#define A3  17
+#define A4  18
+#define A5  19
+#define A6  20
+#define A7  21
+
+#define digitalPinToInterrupt(p)    ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+// The AVR core defines these as macros. Templates keep <algorithm> usable.
+using std::min;
+using std::max;
+using std::abs;
+
+#define constrain(amt, low, high)   ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define lowByte(w)                  ((uint8_t)((w) & 0xff))
+#define highByte(w)                 ((uint8_t)((w) >> 8))
+#define bitRead(value, bit)         (((value) >> (bit)) & 0x01)
+#define bit(b)                      (1UL << (b))
+
+
+unsigned long millis();
+unsigned long micros();
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+
+void          pinMode(uint8_t pin, uint8_t mode);
+void          digitalWrite(uint8_t pin, uint8_t val);
+int           digitalRead(uint8_t pin);
+int           analogRead(uint8_t pin);
+
+void          attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void          detachInterrupt(uint8_t interruptNum);
+void          interrupts();
+void          noInterrupts();
+
+
+#include "HardwareSerial.h"
+
+#endif /* Arduino_h */
@@ -0,0 +1,54 @@
+/**
+ *  @file   EEPROM.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Arduino EEPROM library. The contents live in
+ *          the host HAL (see hal::eeprom()) and survive hal::reset(), as they
+ *          survive a power cycle.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HostHal.h"
+
+
+class EEPROMClass
+{
+    
+public:
+    uint8_t  read(int idx);
+    void     write(int idx, uint8_t val);
+    void     update(int idx, uint8_t val);
+    uint16_t length()                       { return HAL_EEPROM_SIZE; }
+    
+    template <typename T> T& get(int idx, T& t)
+    {
+        uint8_t* bytes = (uint8_t*)&t;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            bytes[i] = read(idx + (int)i);
+        }
+        return t;
+    }
+    
+    template <typename T> const T& put(int idx, const T& t)
+    {
+        const uint8_t* bytes = (const uint8_t*)&t;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            update(idx + (int)i, bytes[i]);
+        }
+        return t;
+    }
+    
+};
+
+extern EEPROMClass EEPROM;
+
+#endif /* EEPROM_h */
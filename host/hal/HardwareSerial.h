@@ -0,0 +1,49 @@
+/**
+ *  @file   HardwareSerial.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Arduino HardwareSerial class. Bytes written
+ *          by the firmware go to the hal::SerialEndpoint attached in
+ *          HostHal.h.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+class HardwareSerial
+{
+
+public:
+    void    begin(unsigned long baud);
+    void    end();
+    
+    int     available();
+    int     peek();
+    int     read();
+    int     availableForWrite();
+    void    flush();
+    
+    size_t  write(uint8_t byte);
+    size_t  write(const uint8_t* buffer, size_t size);
+    size_t  write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    size_t  write(const char* str)                 { return write((const uint8_t*)str, strlen(str)); }
+    
+    size_t  print(const char* str)                 { return write(str); }
+    size_t  println(const char* str)               { return write(str) + write("\r\n"); }
+    
+    operator bool() { return true; }
+    
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HardwareSerial_h */
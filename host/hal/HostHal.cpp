@@ -0,0 +1,614 @@
+/**
+ *  @file   HostHal.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host implementation of the Arduino core: virtual clock, pins,
+ *          ADC, interrupts, sleep, and the simulated I2C bus and serial port
+ *          behind Wire and Serial.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "Arduino.h"
+#include "avr/sleep.h"
+#include "EEPROM.h"
+#include "HostHalInternal.h"
+
+#include <algorithm>
+#include <deque>
+#include <new>
+#include <utility>
+
+
+HardwareSerial Serial;
+
+
+namespace hal {
+
+namespace {
+
+struct HalState
+{
+    uint64_t                clockNs         = 0;
+    
+    uint8_t                 pinModes[HAL_PIN_COUNT]     = {};
+    uint8_t                 pinOutputs[HAL_PIN_COUNT]   = {};
+    uint8_t                 pinInputs[HAL_PIN_COUNT]    = {};
+    DigitalInputProvider    pinProviders[HAL_PIN_COUNT];
+    uint16_t                analogInputs[HAL_PIN_COUNT] = {};
+    AnalogInputProvider     analogProvider;
+    
+    I2cDevice*              i2cDevices[128] = {};
+    I2cFaultProvider        i2cFaults;
+    uint32_t                i2cClock        = HAL_I2C_DEFAULT_CLOCK;
+    I2cStats                i2c             = {};
+    
+    SerialEndpoint*         serialEndpoint  = NULL;
+    uint32_t                serialBaud      = 0;
+    std::deque<uint64_t>    serialTxDone;           ///< Stop bit times of bytes in the UART (ns)
+    std::deque<std::pair<uint8_t, uint64_t> > serialRx; ///< Received bytes and their arrival times (ns)
+    SerialStats             serial          = {};
+    
+    uint64_t                sleepWakeNs     = HAL_SLEEP_WAKE_INTERVAL_US * 1000ULL;
+    bool                    sleepEnabled    = false;
+    BlockingStats           blocking        = {};
+    
+    EepromStats             eeprom          = {};
+};
+
+HalState state;
+
+/*!
+ * @brief Non-volatile, so outside HalState. Starts erased.
+ */
+struct EepromContents
+{
+    uint8_t                 bytes[HAL_EEPROM_SIZE];
+    
+    EepromContents() { memset(bytes, 0xFF, sizeof(bytes)); }
+};
+
+EepromContents eepromContents;
+
+
+/*!
+ * @brief Time one I2C transaction occupies the bus: start, address + ACK,
+ * 9 bits per data byte, and stop (or repeated start).
+ */
+uint64_t i2cTransactionNs(size_t length)
+{
+    uint64_t bits = 1 + 9 + 9 * (uint64_t)length + 1;
+    return bits * 1000000000ULL / state.i2cClock;
+}
+
+/*!
+ * @brief The device addressed, or NULL if it is missing or the fault
+ * provider fails the transaction
+ */
+I2cDevice* i2cTarget(uint8_t address, bool read)
+{
+    I2cDevice* device = state.i2cDevices[address & 0x7F];
+    
+    if (device && state.i2cFaults && state.i2cFaults(address & 0x7F, read, now())) {
+        state.i2c.faults++;
+        return NULL;
+    }
+    return device;
+}
+
+void i2cAccount(size_t length)
+{
+    uint64_t busNs = i2cTransactionNs(length);
+    
+    state.i2c.transactions++;
+    state.i2c.busTimeUs += busNs / 1000;
+    advanceNanos(busNs);
+}
+
+} /* namespace */
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Virtual Clock                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+uint64_t now()
+{
+    return state.clockNs / 1000;
+}
+
+uint64_t nowNanos()
+{
+    return state.clockNs;
+}
+
+void advance(uint64_t microseconds)
+{
+    state.clockNs += microseconds * 1000;
+}
+
+void advanceNanos(uint64_t nanoseconds)
+{
+    state.clockNs += nanoseconds;
+}
+
+void reset()
+{
+    state.~HalState();
+    new (&state) HalState();
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                 Digital and Analog               │
+ *  └──────────────────────────────────────────────────┘ */
+
+void setDigitalInput(uint8_t pin, uint8_t level)
+{
+    if (pin < HAL_PIN_COUNT) {
+        state.pinInputs[pin] = level;
+    }
+}
+
+void setDigitalInputProvider(uint8_t pin, DigitalInputProvider provider)
+{
+    if (pin < HAL_PIN_COUNT) {
+        state.pinProviders[pin] = provider;
+    }
+}
+
+uint8_t getDigitalOutput(uint8_t pin)
+{
+    return (pin < HAL_PIN_COUNT) ? state.pinOutputs[pin] : LOW;
+}
+
+uint8_t getPinMode(uint8_t pin)
+{
+    return (pin < HAL_PIN_COUNT) ? state.pinModes[pin] : INPUT;
+}
+
+void setAnalogInput(uint8_t pin, uint16_t value)
+{
+    if (pin < HAL_PIN_COUNT) {
+        state.analogInputs[pin] = value & 0x3FF;
+    }
+}
+
+void setAnalogInputProvider(AnalogInputProvider provider)
+{
+    state.analogProvider = provider;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                       I2C                        │
+ *  └──────────────────────────────────────────────────┘ */
+
+void attachI2cDevice(uint8_t address, I2cDevice* device)
+{
+    state.i2cDevices[address & 0x7F] = device;
+}
+
+void detachI2cDevice(uint8_t address)
+{
+    state.i2cDevices[address & 0x7F] = NULL;
+}
+
+I2cDevice* getI2cDevice(uint8_t address)
+{
+    return state.i2cDevices[address & 0x7F];
+}
+
+void setI2cFaultProvider(I2cFaultProvider provider)
+{
+    state.i2cFaults = provider;
+}
+
+void setI2cClock(uint32_t hz)
+{
+    state.i2cClock = hz ? hz : HAL_I2C_DEFAULT_CLOCK;
+}
+
+uint32_t getI2cClock()
+{
+    return state.i2cClock;
+}
+
+I2cStats& i2cStats()
+{
+    return state.i2c;
+}
+
+bool i2cWriteTransaction(uint8_t address, const uint8_t* data, size_t length, bool /* sendStop */)
+{
+    I2cDevice* device = i2cTarget(address, false);
+    bool acked = (device != NULL) && device->write(data, length);
+    
+    // A missing device NACKs the address byte, which ends the transaction
+    i2cAccount(device ? length : 0);
+    state.i2c.writeTransactions++;
+    if (device) {
+        state.i2c.bytesWritten += length;
+    }
+    if (!acked) {
+        state.i2c.nacks++;
+    }
+    return acked;
+}
+
+size_t i2cReadTransaction(uint8_t address, uint8_t* buffer, size_t length, bool /* sendStop */)
+{
+    I2cDevice* device = i2cTarget(address, true);
+    size_t received = device ? device->read(buffer, length) : 0;
+    
+    i2cAccount(received);
+    state.i2c.readTransactions++;
+    state.i2c.bytesRead += received;
+    if (received == 0) {
+        state.i2c.nacks++;
+    }
+    return received;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Serial                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+void attachSerialEndpoint(SerialEndpoint* endpoint)
+{
+    state.serialEndpoint = endpoint;
+}
+
+void serialInject(const uint8_t* data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        state.serialRx.push_back(std::make_pair(data[i], state.clockNs));
+    }
+}
+
+/*!
+ * @brief Queues bytes for the firmware to receive. The first start bit is at
+ * startUs; each byte becomes available when its stop bit has been received.
+ */
+void serialInjectAt(const uint8_t* data, size_t length, uint64_t startUs)
+{
+    uint64_t arrival = startUs * 1000;
+    
+    for (size_t i = 0; i < length; i++) {
+        arrival += getSerialByteTimeNanos();
+        state.serialRx.push_back(std::make_pair(data[i], arrival));
+    }
+}
+
+uint32_t getSerialBaud()
+{
+    return state.serialBaud;
+}
+
+/*!
+ * @brief Time one byte occupies the line, 0 before Serial.begin()
+ */
+uint64_t getSerialByteTimeNanos()
+{
+    if (state.serialBaud == 0) {
+        return 0;
+    }
+    return HAL_SERIAL_FRAME_BITS * 1000000000ULL / state.serialBaud;
+}
+
+SerialStats& serialStats()
+{
+    return state.serial;
+}
+
+void serialBegin(uint32_t baud)
+{
+    state.serialBaud = baud;
+    state.serialTxDone.clear();
+}
+
+namespace {
+
+/*!
+ * @brief Blocks until the UART has room for one more byte: the transmit
+ * buffer plus the shift register.
+ */
+void serialWaitForRoom()
+{
+    while (!state.serialTxDone.empty() && state.serialTxDone.front() <= state.clockNs) {
+        state.serialTxDone.pop_front();
+    }
+    if (state.serialTxDone.size() > HAL_SERIAL_TX_BUFFER_SIZE) {
+        uint64_t waitNs = state.serialTxDone.front() - state.clockNs;
+        
+        state.serial.txBlockedUs += waitNs / 1000;
+        advanceNanos(waitNs);
+        state.serialTxDone.pop_front();
+    }
+}
+
+} /* namespace */
+
+size_t serialWrite(const uint8_t* data, size_t length)
+{
+    state.serial.writeCalls++;
+    state.serial.bytesWritten += length;
+    
+    uint64_t byteNs = getSerialByteTimeNanos();
+    
+    for (size_t i = 0; i < length; i++) {
+        uint64_t deliveredNs = state.clockNs;
+        
+        if (byteNs) {
+            serialWaitForRoom();
+            
+            uint64_t lineFree = state.serialTxDone.empty() ? state.clockNs : state.serialTxDone.back();
+            deliveredNs = std::max(lineFree, state.clockNs) + byteNs;
+            state.serialTxDone.push_back(deliveredNs);
+        }
+        
+        if (state.serialEndpoint) {
+            state.serialEndpoint->receive(data[i], now(), deliveredNs / 1000);
+        }
+    }
+    return length;
+}
+
+namespace {
+
+bool serialRxReady()
+{
+    return !state.serialRx.empty() && state.serialRx.front().second <= state.clockNs;
+}
+
+} /* namespace */
+
+int serialAvailable()
+{
+    int count = 0;
+    
+    for (size_t i = 0; i < state.serialRx.size() && state.serialRx[i].second <= state.clockNs; i++) {
+        count++;
+    }
+    return count;
+}
+
+int serialPeek()
+{
+    return serialRxReady() ? state.serialRx.front().first : -1;
+}
+
+int serialRead()
+{
+    if (!serialRxReady()) {
+        return -1;
+    }
+    uint8_t byte = state.serialRx.front().first;
+    state.serialRx.pop_front();
+    state.serial.bytesRead++;
+    return byte;
+}
+
+/*!
+ * @brief Blocks until the last byte written has left the UART
+ */
+void serialFlush()
+{
+    if (!state.serialTxDone.empty() && state.serialTxDone.back() > state.clockNs) {
+        uint64_t waitNs = state.serialTxDone.back() - state.clockNs;
+        
+        state.serial.txBlockedUs += waitNs / 1000;
+        advanceNanos(waitNs);
+    }
+    state.serialTxDone.clear();
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                 Delays and Sleep                 │
+ *  └──────────────────────────────────────────────────┘ */
+
+void setSleepWakeInterval(uint64_t microseconds)
+{
+    state.sleepWakeNs = microseconds * 1000;
+}
+
+BlockingStats& blockingStats()
+{
+    return state.blocking;
+}
+
+namespace {
+
+void sleepUntilWake()
+{
+    state.blocking.sleeps++;
+    state.blocking.sleepTimeUs += state.sleepWakeNs / 1000;
+    advanceNanos(state.sleepWakeNs);
+}
+
+} /* namespace */
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      EEPROM                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+uint8_t* eeprom()
+{
+    return eepromContents.bytes;
+}
+
+void eraseEeprom()
+{
+    memset(eepromContents.bytes, 0xFF, sizeof(eepromContents.bytes));
+}
+
+EepromStats& eepromStats()
+{
+    return state.eeprom;
+}
+
+} /* namespace hal */
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Arduino Core API                │
+ *  └──────────────────────────────────────────────────┘ */
+
+unsigned long millis()
+{
+    return (uint32_t)(hal::now() / 1000);   // Wraps at 2^32 like the AVR core
+}
+
+unsigned long micros()
+{
+    return (uint32_t)hal::now();
+}
+
+void delay(unsigned long ms)
+{
+    hal::state.blocking.delayCalls++;
+    hal::state.blocking.delayTimeUs += (uint64_t)ms * 1000;
+    hal::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hal::state.blocking.delayCalls++;
+    hal::state.blocking.delayTimeUs += us;
+    hal::advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < HAL_PIN_COUNT) {
+        hal::state.pinModes[pin] = mode;
+        if (mode == INPUT_PULLUP) {
+            hal::state.pinInputs[pin] = HIGH;
+        }
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin < HAL_PIN_COUNT) {
+        hal::state.pinOutputs[pin] = val ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= HAL_PIN_COUNT) {
+        return LOW;
+    }
+    if (hal::state.pinProviders[pin]) {
+        return hal::state.pinProviders[pin](pin, hal::now()) ? HIGH : LOW;
+    }
+    if (hal::state.pinModes[pin] == OUTPUT) {
+        return hal::state.pinOutputs[pin];
+    }
+    return hal::state.pinInputs[pin];
+}
+
+int analogRead(uint8_t pin)
+{
+    uint16_t value = 0;
+    
+    if (pin < HAL_PIN_COUNT) {
+        value = hal::state.analogProvider ? hal::state.analogProvider(pin, hal::now())
+                                          : hal::state.analogInputs[pin];
+    }
+    hal::advance(HAL_ANALOG_READ_TIME_US);
+    return value & 0x3FF;
+}
+
+void attachInterrupt(uint8_t /* interruptNum */, void (* /* userFunc */)(void), int /* mode */) { }
+void detachInterrupt(uint8_t /* interruptNum */) { }
+void interrupts() { }
+void noInterrupts() { }
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                   avr/sleep.h                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+void set_sleep_mode(uint8_t mode)
+{
+    hal::state.blocking.lastSleepMode = mode;
+}
+
+void sleep_enable()
+{
+    hal::state.sleepEnabled = true;
+}
+
+void sleep_disable()
+{
+    hal::state.sleepEnabled = false;
+}
+
+void sleep_cpu()
+{
+    if (hal::state.sleepEnabled) {
+        hal::sleepUntilWake();
+    }
+}
+
+void sleep_mode()
+{
+    sleep_enable();
+    sleep_cpu();
+    sleep_disable();
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  HardwareSerial                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+void   HardwareSerial::begin(unsigned long baud)                 { hal::serialBegin(baud); }
+void   HardwareSerial::end()                                     { }
+int    HardwareSerial::available()                               { return hal::serialAvailable(); }
+int    HardwareSerial::peek()                                    { return hal::serialPeek(); }
+int    HardwareSerial::read()                                    { return hal::serialRead(); }
+int    HardwareSerial::availableForWrite()                       { return HAL_SERIAL_TX_BUFFER_SIZE - 1; }
+void   HardwareSerial::flush()                                   { hal::serialFlush(); }
+size_t HardwareSerial::write(uint8_t byte)                       { return hal::serialWrite(&byte, 1); }
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) { return hal::serialWrite(buffer, size); }
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      EEPROM                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+EEPROMClass EEPROM;
+
+uint8_t EEPROMClass::read(int idx)
+{
+    if (idx < 0 || idx >= HAL_EEPROM_SIZE) {
+        return 0xFF;
+    }
+    hal::state.eeprom.bytesRead++;
+    return hal::eepromContents.bytes[idx];
+}
+
+void EEPROMClass::write(int idx, uint8_t val)
+{
+    if (idx < 0 || idx >= HAL_EEPROM_SIZE) {
+        return;
+    }
+    hal::eepromContents.bytes[idx] = val;
+    hal::state.eeprom.bytesWritten++;
+    hal::state.eeprom.busyTimeUs += HAL_EEPROM_WRITE_US;
+    hal::advance(HAL_EEPROM_WRITE_US);
+}
+
+void EEPROMClass::update(int idx, uint8_t val)
+{
+    if (read(idx) != val) {
+        write(idx, val);
+    }
+}
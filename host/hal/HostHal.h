@@ -0,0 +1,221 @@
+/**
+ *  @file   HostHal.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Simulation control interface of the host Arduino HAL.
+ *
+ *          The host HAL lets the unmodified TSLPB sources and the
+ *          VCSFA_ThinSat sketch build and run as a native Linux program. All
+ *          time is virtual: millis(), micros() and delay() use a simulated
+ *          clock that only moves when the firmware waits, sleeps, or uses a
+ *          bus. Test and benchmark code uses the functions in this header to
+ *          drive pins, attach simulated I2C and serial devices and read the
+ *          bus statistics.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef HostHal_h
+#define HostHal_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+
+namespace hal {
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Virtual Clock                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+uint64_t now();                                 ///< Virtual time in microseconds since reset()
+uint64_t nowNanos();                            ///< Virtual time in nanoseconds since reset()
+void     advance(uint64_t microseconds);        ///< Moves the virtual clock forward
+void     advanceNanos(uint64_t nanoseconds);    ///< Moves the virtual clock forward
+void     reset();                               ///< Clears the clock, pins, devices and statistics
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                 Digital and Analog               │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define HAL_PIN_COUNT               32          ///< Pins 0-21 are used by the Pro Mini
+#define HAL_ANALOG_READ_TIME_US     112         ///< One ADC conversion (13 cycles at 125 kHz plus overhead)
+
+typedef std::function<uint8_t(uint8_t pin, uint64_t timeUs)>    DigitalInputProvider;
+typedef std::function<uint16_t(uint8_t pin, uint64_t timeUs)>   AnalogInputProvider;
+
+void     setDigitalInput(uint8_t pin, uint8_t level);
+void     setDigitalInputProvider(uint8_t pin, DigitalInputProvider provider);
+uint8_t  getDigitalOutput(uint8_t pin);
+uint8_t  getPinMode(uint8_t pin);
+
+void     setAnalogInput(uint8_t pin, uint16_t value);
+void     setAnalogInputProvider(AnalogInputProvider provider);
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                       I2C                        │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define HAL_I2C_DEFAULT_CLOCK       100000      ///< TWI clock after Wire.begin() (Hz)
+#define HAL_I2C_BUFFER_LENGTH       32          ///< Same as the AVR Wire library
+
+/*!
+ * @brief   A simulated I2C slave. Attach it to an address with
+ *          attachI2cDevice(). The HAL calls write() for every write
+ *          transaction and read() for every read transaction addressed to it.
+ */
+class I2cDevice
+{
+public:
+    virtual ~I2cDevice() {}
+    
+    /*!
+     * @brief   Handles one write transaction (all bytes after the address).
+     * @return  false to NACK the transaction
+     */
+    virtual bool   write(const uint8_t* data, size_t length) = 0;
+    
+    /*!
+     * @brief   Handles one read transaction. Fills buffer with up to length
+     *          bytes.
+     * @return  the number of bytes provided (0 to NACK the address)
+     */
+    virtual size_t read(uint8_t* buffer, size_t length) = 0;
+};
+
+/*!
+ * @brief   I2C bus counters. Bus time includes start, address, data, ACK and
+ *          stop bits at the configured clock.
+ */
+typedef struct
+{
+    uint64_t    transactions;       ///< Write and read transactions, including NACKed ones
+    uint64_t    writeTransactions;  ///< Write transactions
+    uint64_t    readTransactions;   ///< Read transactions
+    uint64_t    bytesWritten;       ///< Data bytes sent to slaves
+    uint64_t    bytesRead;          ///< Data bytes received from slaves
+    uint64_t    nacks;              ///< Transactions not acknowledged by any device
+    uint64_t    faults;             ///< Transactions NACKed by the fault provider
+    uint64_t    busTimeUs;          ///< Virtual time the bus was busy
+} I2cStats;
+
+/*!
+ * @brief   Decides whether a transaction fails on the bus. Return true to make
+ *          the addressed device NACK it; the device does not see it.
+ */
+typedef std::function<bool(uint8_t address, bool read, uint64_t timeUs)>  I2cFaultProvider;
+
+void      attachI2cDevice(uint8_t address, I2cDevice* device);
+void      detachI2cDevice(uint8_t address);
+I2cDevice* getI2cDevice(uint8_t address);
+void      setI2cFaultProvider(I2cFaultProvider provider);
+void      setI2cClock(uint32_t hz);
+uint32_t  getI2cClock();
+I2cStats& i2cStats();
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Serial                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define HAL_SERIAL_TX_BUFFER_SIZE   64          ///< SERIAL_TX_BUFFER_SIZE of the AVR core
+#define HAL_SERIAL_FRAME_BITS       10          ///< 8N1: start, 8 data, stop
+
+/*!
+ * @brief   The far end of the Serial port. Receives every byte the firmware
+ *          writes with Serial.write().
+ *
+ *          Once Serial.begin() has set a baud rate, bytes leave the UART one
+ *          frame time apart and the firmware blocks in Serial.write() while
+ *          the transmit buffer is full, as on the AVR. Bytes are handed to the
+ *          endpoint when they are written, together with the virtual time
+ *          their stop bit will have been sent.
+ */
+class SerialEndpoint
+{
+public:
+    virtual ~SerialEndpoint() {}
+    
+    /*!
+     * @brief   Called once per byte.
+     * @param[in]   byte        The byte on the wire
+     * @param[in]   writeUs     Virtual time at which Serial.write() accepted the byte
+     * @param[in]   deliveredUs Virtual time at which the byte's stop bit ends
+     */
+    virtual void receive(uint8_t byte, uint64_t writeUs, uint64_t deliveredUs) = 0;
+};
+
+/*!
+ * @brief   Serial port counters
+ */
+typedef struct
+{
+    uint64_t    bytesWritten;       ///< Bytes written by the firmware
+    uint64_t    writeCalls;         ///< Calls to Serial.write()
+    uint64_t    bytesRead;          ///< Bytes read by the firmware
+    uint64_t    txBlockedUs;        ///< Virtual time spent waiting in Serial.write() and Serial.flush()
+} SerialStats;
+
+void         attachSerialEndpoint(SerialEndpoint* endpoint);
+void         serialInject(const uint8_t* data, size_t length);
+void         serialInjectAt(const uint8_t* data, size_t length, uint64_t startUs);
+uint32_t     getSerialBaud();
+uint64_t     getSerialByteTimeNanos();
+SerialStats& serialStats();
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                 Delays and Sleep                 │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define HAL_SLEEP_WAKE_INTERVAL_US  1024        ///< Timer0 overflow wakes SLEEP_MODE_IDLE at 16 MHz
+
+/*!
+ * @brief   Time the firmware spent blocked on purpose
+ */
+typedef struct
+{
+    uint64_t    delayCalls;         ///< Calls to delay() and delayMicroseconds()
+    uint64_t    delayTimeUs;        ///< Virtual time spent in delay() and delayMicroseconds()
+    uint64_t    sleeps;             ///< Calls to sleep_mode() / sleep_cpu()
+    uint64_t    sleepTimeUs;        ///< Virtual time spent asleep
+    uint8_t     lastSleepMode;      ///< Mode passed to set_sleep_mode()
+} BlockingStats;
+
+void           setSleepWakeInterval(uint64_t microseconds);
+BlockingStats& blockingStats();
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      EEPROM                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+#define HAL_EEPROM_SIZE             1024        ///< ATmega328P
+#define HAL_EEPROM_WRITE_US         3400        ///< Erase and write of one byte (tWD_EEPROM)
+
+/*!
+ * @brief   EEPROM counters. Every byte written blocks the firmware for
+ *          HAL_EEPROM_WRITE_US, as back-to-back writes do on the AVR.
+ */
+typedef struct
+{
+    uint64_t    bytesRead;          ///< Bytes read by the firmware
+    uint64_t    bytesWritten;       ///< Bytes programmed; EEPROM.update() skips unchanged bytes
+    uint64_t    busyTimeUs;         ///< Virtual time spent waiting for writes
+} EepromStats;
+
+uint8_t*     eeprom();                          ///< HAL_EEPROM_SIZE bytes of contents. Kept across reset()
+void         eraseEeprom();                     ///< Sets every byte to 0xFF, as on a new part
+EepromStats& eepromStats();
+
+
+} /* namespace hal */
+
+
+#endif /* HostHal_h */
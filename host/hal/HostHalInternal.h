@@ -0,0 +1,33 @@
+/**
+ *  @file   HostHalInternal.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Functions shared between the host HAL translation units. Not for
+ *          use by firmware or simulation code.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef HostHalInternal_h
+#define HostHalInternal_h
+
+#include "HostHal.h"
+
+
+namespace hal {
+
+bool    i2cWriteTransaction(uint8_t address, const uint8_t* data, size_t length, bool sendStop);
+size_t  i2cReadTransaction(uint8_t address, uint8_t* buffer, size_t length, bool sendStop);
+
+void    serialBegin(uint32_t baud);
+size_t  serialWrite(const uint8_t* data, size_t length);
+int     serialAvailable();
+int     serialPeek();
+int     serialRead();
+void    serialFlush();
+
+} /* namespace hal */
+
+#endif /* HostHalInternal_h */
@@ -0,0 +1,113 @@
+/**
+ *  @file   Wire.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host implementation of the Wire library on the simulated I2C bus
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "Wire.h"
+#include "HostHalInternal.h"
+
+
+TwoWire Wire;
+
+
+void TwoWire::begin()
+{
+    hal::setI2cClock(HAL_I2C_DEFAULT_CLOCK);
+    rxIndex  = 0;
+    rxLength = 0;
+    txLength = 0;
+}
+
+void TwoWire::end() { }
+
+void TwoWire::setClock(uint32_t clock)
+{
+    hal::setI2cClock(clock);
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    transmitting = true;
+    txAddress    = address;
+    txLength     = 0;
+}
+
+/*!
+ * @brief Sends the buffered bytes as one write transaction.
+ *
+ * @return 0 success, 2 address NACK, 3 data NACK (same codes as AVR Wire)
+ */
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+    bool acked = hal::i2cWriteTransaction(txAddress, txBuffer, txLength, sendStop);
+    bool present = hal::getI2cDevice(txAddress) != NULL;
+    
+    transmitting = false;
+    txLength     = 0;
+    
+    if (acked) {
+        return 0;
+    }
+    return present ? 3 : 2;
+}
+
+/*!
+ * @brief Performs one read transaction and buffers the bytes received.
+ *
+ * @return the number of bytes received
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+    if (quantity > BUFFER_LENGTH) {
+        quantity = BUFFER_LENGTH;
+    }
+    
+    rxIndex  = 0;
+    rxLength = (uint8_t)hal::i2cReadTransaction(address, rxBuffer, quantity, sendStop);
+    return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (!transmitting || txLength >= BUFFER_LENGTH) {
+        return 0;
+    }
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity)
+{
+    size_t written = 0;
+    
+    while (written < quantity && write(data[written])) {
+        written++;
+    }
+    return written;
+}
+
+int TwoWire::available()
+{
+    return rxLength - rxIndex;
+}
+
+int TwoWire::read()
+{
+    if (rxIndex >= rxLength) {
+        return -1;
+    }
+    return rxBuffer[rxIndex++];
+}
+
+int TwoWire::peek()
+{
+    if (rxIndex >= rxLength) {
+        return -1;
+    }
+    return rxBuffer[rxIndex];
+}
@@ -0,0 +1,71 @@
+/**
+ *  @file   Wire.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Arduino Wire (TWI) library.
+ *
+ *          Follows the AVR library's buffering: bytes written after
+ *          beginTransmission() are only sent by endTransmission(), and
+ *          requestFrom() performs a complete read transaction on its own.
+ *          Transactions are delivered to the hal::I2cDevice attached at the
+ *          address and take virtual bus time.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HostHal.h"
+
+#define BUFFER_LENGTH   HAL_I2C_BUFFER_LENGTH
+
+
+class TwoWire
+{
+
+public:
+    void    begin();
+    void    end();
+    void    setClock(uint32_t clock);
+    
+    void    beginTransmission(uint8_t address);
+    void    beginTransmission(int address)  { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop);
+    uint8_t endTransmission()               { return endTransmission((uint8_t)true); }
+    
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity)  { return requestFrom(address, quantity, (uint8_t)true); }
+    uint8_t requestFrom(int address, int quantity)          { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)true); }
+    uint8_t requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop); }
+    
+    size_t  write(uint8_t data);
+    size_t  write(const uint8_t* data, size_t quantity);
+    size_t  write(int data)                 { return write((uint8_t)data); }
+    
+    int     available();
+    int     read();
+    int     peek();
+    void    flush() {}
+    
+private:
+    
+    uint8_t txAddress = 0;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength  = 0;
+    bool    transmitting = false;
+    
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxIndex   = 0;
+    uint8_t rxLength  = 0;
+    
+};
+
+extern TwoWire Wire;
+
+#endif /* TwoWire_h */
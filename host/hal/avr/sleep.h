@@ -0,0 +1,31 @@
+/**
+ *  @file   sleep.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for avr-libc <avr/sleep.h>. Sleeping moves the virtual
+ *          clock to the next wake-up (see hal::setSleepWakeInterval()).
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef HostHal_avr_sleep_h
+#define HostHal_avr_sleep_h
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE         0
+#define SLEEP_MODE_ADC          1
+#define SLEEP_MODE_PWR_DOWN     2
+#define SLEEP_MODE_PWR_SAVE     3
+#define SLEEP_MODE_STANDBY      6
+#define SLEEP_MODE_EXT_STANDBY  7
+
+void set_sleep_mode(uint8_t mode);
+void sleep_enable();
+void sleep_disable();
+void sleep_cpu();
+void sleep_mode();
+
+#endif /* HostHal_avr_sleep_h */
@@ -0,0 +1,63 @@
+/**
+ *  @file   imumaths.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Host stand-in for the Adafruit BNO055 "imumaths" vector and
+ *          quaternion types. Only the accessors used by the sketch.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef HostHal_imumaths_h
+#define HostHal_imumaths_h
+
+#include <stdint.h>
+
+
+namespace imu {
+
+
+template <uint8_t N>
+class Vector
+{
+public:
+    Vector() { for (uint8_t i = 0; i < N; i++) { p_vec[i] = 0; } }
+    
+    double& operator[](int n)       { return p_vec[n]; }
+    double  operator[](int n) const { return p_vec[n]; }
+    
+    double& x() { return p_vec[0]; }
+    double& y() { return p_vec[1]; }
+    double& z() { return p_vec[2]; }
+    
+private:
+    double p_vec[N];
+};
+
+
+class Quaternion
+{
+public:
+    Quaternion() : _w(1.0), _x(0.0), _y(0.0), _z(0.0) {}
+    Quaternion(double w, double x, double y, double z) : _w(w), _x(x), _y(y), _z(z) {}
+    
+    double& w() { return _w; }
+    double& x() { return _x; }
+    double& y() { return _y; }
+    double& z() { return _z; }
+    
+    double  w() const { return _w; }
+    double  x() const { return _x; }
+    double  y() const { return _y; }
+    double  z() const { return _z; }
+    
+private:
+    double _w, _x, _y, _z;
+};
+
+
+} /* namespace imu */
+
+#endif /* HostHal_imumaths_h */
@@ -0,0 +1,305 @@
+/**
+ *  @file   SimAK8963.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the AK8963 magnetometer
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimAK8963.h"
+#include "MPU9250_REGS.h"
+
+#include <math.h>
+#include <string.h>
+
+
+namespace sim {
+
+
+SimAK8963::SimAK8963()
+{
+    setField(0, 0, 0);
+    setSensitivityAdjustment(128, 128, 128);
+    setIronDistortion({ 0, 0, 0 }, { 1, 1, 1 });
+    softReset();
+}
+
+/*!
+ * @brief Sets a constant magnetic field in µT, in the AK8963 axes
+ */
+void SimAK8963::setField(double xMicroTesla, double yMicroTesla, double zMicroTesla)
+{
+    SimVector3 value = { xMicroTesla, yMicroTesla, zMicroTesla };
+    field = [value](uint64_t) { return value; };
+}
+
+/*!
+ * @brief Sets a function of virtual time that gives the magnetic field in µT.
+ * It is sampled when each measurement completes.
+ */
+void SimAK8963::setFieldProvider(VectorProvider provider)
+{
+    field = provider;
+}
+
+/*!
+ * @brief Sets the fuse ROM sensitivity adjustment values. The output is
+ * H / (1 + (ASA - 128) / 256), so firmware that applies the datasheet
+ * correction recovers H. 128 means no adjustment.
+ */
+void SimAK8963::setSensitivityAdjustment(uint8_t asaX, uint8_t asaY, uint8_t asaZ)
+{
+    asa[0] = asaX;
+    asa[1] = asaY;
+    asa[2] = asaZ;
+}
+
+/*!
+ * @brief Sets the distortion of the field by the host board: each axis of the
+ * input is multiplied by gain and offsetMicroTesla is added. Self-test
+ * results are not distorted.
+ */
+void SimAK8963::setIronDistortion(SimVector3 offsetMicroTesla, SimVector3 gain)
+{
+    ironOffset = offsetMicroTesla;
+    ironGain   = gain;
+}
+
+void SimAK8963::softReset()
+{
+    memset(data, 0, sizeof(data));
+    address       = 0;
+    status1       = 0;
+    status2       = 0;
+    control       = 0;
+    selfTest      = 0;
+    readProtected = false;
+    pending       = false;
+    period        = 0;
+}
+
+/*!
+ * @brief Writes CNTL1 and schedules the first measurement of the new mode
+ */
+void SimAK8963::setControl(uint8_t value, uint64_t timeUs)
+{
+    control = value & (MAG_MODE_BITMASK | MAG_MODE_16_BIT);
+    pending = false;
+    period  = 0;
+    
+    switch (control & MAG_MODE_BITMASK) {
+        case MAG_MODE_CONTINUOUS_8HZ:
+            period = SIM_AK8963_PERIOD_8HZ_US;
+            break;
+        case MAG_MODE_CONTINUOUS_100HZ:
+            period = SIM_AK8963_PERIOD_100HZ_US;
+            break;
+        case MAG_MODE_SINGLE_MEAS:
+        case MAG_MODE_SELF_TEST:
+            break;
+        default:
+            // Power-down, fuse ROM, and modes not modeled: no measurements
+            return;
+    }
+    
+    pending    = true;
+    nextResult = timeUs + SIM_AK8963_MEASUREMENT_US;
+}
+
+/*!
+ * @brief Completes every measurement due by timeUs. When several continuous
+ * results are due at once only the newest is stored; the others count as
+ * overruns.
+ */
+void SimAK8963::update(uint64_t timeUs)
+{
+    if (!pending || nextResult > timeUs) {
+        return;
+    }
+    
+    if (period == 0) {
+        completeMeasurement(nextResult);
+        
+        // One-shot modes return to power-down
+        control &= ~MAG_MODE_BITMASK;
+        pending  = false;
+        return;
+    }
+    
+    uint64_t missed = (timeUs - nextResult) / period;
+    if (missed > 0) {
+        completeMeasurement(nextResult);
+        droppedResults += missed - 1;
+        nextResult     += missed * period;
+    }
+    completeMeasurement(nextResult);
+    nextResult += period;
+}
+
+/*!
+ * @brief Stores one result, unless a read of the previous result is in
+ * progress, and updates DRDY, DOR and HOFL.
+ */
+void SimAK8963::completeMeasurement(uint64_t timeUs)
+{
+    if (readProtected) {
+        status1 |= MAG_MASK_DATA_OVERRUN;
+        droppedResults++;
+        return;
+    }
+    if (status1 & MAG_MASK_DATA_READY) {
+        status1 |= MAG_MASK_DATA_OVERRUN;
+        droppedResults++;
+    }
+    
+    bool       is16Bit  = (control & MAG_MODE_16_BIT) != 0;
+    double     perCount = is16Bit ? 0.15 : 0.6;
+    int16_t    limit    = is16Bit ? 32760 : 8190;
+    SimVector3 h;
+    
+    if ((control & MAG_MODE_BITMASK) == MAG_MODE_SELF_TEST) {
+        // Internal self-test field, inside the datasheet limits
+        bool generator = (selfTest & SIM_AK8963_ASTC_SELF) != 0;
+        h.x = generator ?   15 : 0;
+        h.y = generator ?  -20 : 0;
+        h.z = generator ? -250 : 0;
+    } else {
+        h   = field(timeUs);
+        h.x = h.x * ironGain.x + ironOffset.x;
+        h.y = h.y * ironGain.y + ironOffset.y;
+        h.z = h.z * ironGain.z + ironOffset.z;
+    }
+    
+    double axes[3] = { h.x, h.y, h.z };
+    for (int axis = 0; axis < 3; axis++) {
+        double  adjustment = 1 + (asa[axis] - 128) / 256.0;
+        int16_t counts     = simQuantize(axes[axis] / adjustment, 1 / perCount, -limit, limit);
+        
+        data[2 * axis]     = counts & 0xFF;
+        data[2 * axis + 1] = (uint16_t)counts >> 8;
+    }
+    
+    bool overflow = fabs(h.x) + fabs(h.y) + fabs(h.z) >= SIM_AK8963_OVERFLOW_UT;
+    
+    status2  = (overflow ? MAG_MASK_DATA_OVERFLOW : 0) | (is16Bit ? MAG_MASK_DATA_BIT_RESOLUTION : 0);
+    status1 |= MAG_MASK_DATA_READY;
+}
+
+/*!
+ * @brief Returns one register and applies its read side effects
+ */
+uint8_t SimAK8963::readRegister(uint8_t reg)
+{
+    switch (reg) {
+        case MPU9250_MAG_REG_DEVICE_ID:
+            return SIM_AK8963_DEVICE_ID;
+        case MPU9250_MAG_REG_INFORMATION:
+            return 0;
+        case MPU9250_MAG_REG_STATUS_1:
+            return status1;
+            
+        case MPU9250_MAG_REG_X_DATA_LSB:
+        case MPU9250_MAG_REG_X_DATA_MSB:
+        case MPU9250_MAG_REG_Y_DATA_LSB:
+        case MPU9250_MAG_REG_Y_DATA_MSB:
+        case MPU9250_MAG_REG_Z_DATA_LSB:
+        case MPU9250_MAG_REG_Z_DATA_MSB:
+            status1      &= ~(MAG_MASK_DATA_READY | MAG_MASK_DATA_OVERRUN);
+            readProtected = true;
+            return data[reg - MPU9250_MAG_REG_X_DATA_LSB];
+            
+        case MPU9250_MAG_REG_STATUS_2:
+            status1      &= ~(MAG_MASK_DATA_READY | MAG_MASK_DATA_OVERRUN);
+            readProtected = false;
+            return status2;
+            
+        case MPU9250_MAG_REG_CONTROL:
+            return control;
+        case MPU9250_MAG_REG_SELF_TEST:
+            return selfTest;
+            
+        case MPU9250_MAG_REG_X_SENSITIVITY:
+        case MPU9250_MAG_REG_Y_SENSITIVITY:
+        case MPU9250_MAG_REG_Z_SENSITIVITY:
+            if ((control & MAG_MODE_BITMASK) == SIM_AK8963_MODE_FUSE_ROM) {
+                return asa[reg - MPU9250_MAG_REG_X_SENSITIVITY];
+            }
+            return 0;
+            
+        default:
+            return 0;
+    }
+}
+
+/*!
+ * @brief The first byte sets the register address. Following bytes are
+ * written to consecutive registers; read-only registers ignore them.
+ */
+bool SimAK8963::write(const uint8_t* bytes, size_t length)
+{
+    if (i2cDisabled) {
+        return false;
+    }
+    
+    uint64_t timeUs = hal::now();
+    update(timeUs);
+    
+    if (length == 0) {
+        return true;
+    }
+    
+    uint8_t reg = bytes[0];
+    for (size_t i = 1; i < length; i++, reg++) {
+        switch (reg) {
+            case MPU9250_MAG_REG_CONTROL:
+                setControl(bytes[i], timeUs);
+                break;
+            case SIM_AK8963_CNTL2:
+                if (bytes[i] & SIM_AK8963_CNTL2_SOFT_RESET) {
+                    softReset();
+                }
+                break;
+            case MPU9250_MAG_REG_SELF_TEST:
+                selfTest = bytes[i] & SIM_AK8963_ASTC_SELF;
+                break;
+            case MPU9250_MAG_REG_I2C_DISABLE:
+                i2cDisabled = (bytes[i] == SIM_AK8963_I2C_DISABLE_CODE);
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // The register address is kept for the next read
+    address = bytes[0];
+    return true;
+}
+
+/*!
+ * @brief Reads consecutive registers from the current address. The address
+ * wraps to WIA after ASTC and after ASAZ, as on the device.
+ */
+size_t SimAK8963::read(uint8_t* buffer, size_t length)
+{
+    if (i2cDisabled) {
+        return 0;
+    }
+    
+    update(hal::now());
+    
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = readRegister(address);
+        
+        if (address == MPU9250_MAG_REG_SELF_TEST || address == MPU9250_MAG_REG_Z_SENSITIVITY) {
+            address = MPU9250_MAG_REG_DEVICE_ID;
+        } else {
+            address++;
+        }
+    }
+    return length;
+}
+
+
+} /* namespace sim */
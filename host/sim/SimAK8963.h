@@ -0,0 +1,102 @@
+/**
+ *  @file   SimAK8963.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the AK8963 magnetometer inside the
+ *          MPU-9250. The AK8963 is only reachable on the TSLPB bus while the
+ *          MPU-9250 is in bypass mode (see SimMPU9250).
+ *
+ *          Modeled behavior:
+ *          - Power-down, single, continuous 1 (8 Hz), continuous 2 (100 Hz),
+ *            self-test and fuse ROM modes. A result is ready
+ *            SIM_AK8963_MEASUREMENT_US after a measurement starts.
+ *          - ST1 DRDY is set when a result is stored and cleared by reading a
+ *            data register or ST2. DOR is set when a result is stored while
+ *            DRDY is still set, or lost while a read is in progress.
+ *          - Reading a data register protects the stored result until ST2
+ *            is read. ST2 reports HOFL for the stored result and BITM.
+ *          - 14-bit (0.6 µT/LSb) and 16-bit (0.15 µT/LSb) output, little
+ *            endian, scaled by the per-axis sensitivity adjustment (ASA)
+ *            values, which read as 0 outside fuse ROM mode.
+ *          - Soft reset (CNTL2) and I2C disable (I2CDIS).
+ *          - Hard- and soft-iron distortion from the host board, a per-axis
+ *            gain and offset applied to the field before it is measured.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimAK8963_h
+#define SimAK8963_h
+
+#include "HostHal.h"
+#include "SimTypes.h"
+#include "MPU9250_REGS.h"
+
+
+namespace sim {
+
+
+#define SIM_AK8963_DEVICE_ID            0x48    ///< WIA register contents
+#define SIM_AK8963_MEASUREMENT_US       7200    ///< Maximum single measurement time
+#define SIM_AK8963_PERIOD_8HZ_US        125000  ///< Continuous measurement mode 1
+#define SIM_AK8963_PERIOD_100HZ_US      10000   ///< Continuous measurement mode 2
+#define SIM_AK8963_OVERFLOW_UT          4912    ///< HOFL when |X|+|Y|+|Z| reaches this (µT)
+#define SIM_AK8963_I2C_DISABLE_CODE     0x1B    ///< Written to I2CDIS to disable the I2C interface
+#define SIM_AK8963_MODE_FUSE_ROM        0x0F    ///< CNTL1 mode with read access to ASAX-ASAZ
+#define SIM_AK8963_CNTL2                0x0B    ///< CNTL2 register (soft reset)
+#define SIM_AK8963_CNTL2_SOFT_RESET     0x01    ///< CNTL2 soft reset bit
+#define SIM_AK8963_ASTC_SELF            0x40    ///< ASTC bit that enables the self-test field
+
+
+class SimAK8963 : public hal::I2cDevice
+{
+    
+public:
+    SimAK8963();
+    
+    void     setField(double xMicroTesla, double yMicroTesla, double zMicroTesla);
+    void     setFieldProvider(VectorProvider provider);
+    void     setSensitivityAdjustment(uint8_t asaX, uint8_t asaY, uint8_t asaZ);
+    void     setIronDistortion(SimVector3 offsetMicroTesla, SimVector3 gain);
+    
+    uint8_t  getMode() { return control & MAG_MODE_BITMASK; }
+    uint32_t getDroppedResults() { return droppedResults; }
+    
+    bool     write(const uint8_t* data, size_t length);
+    size_t   read(uint8_t* buffer, size_t length);
+    
+private:
+    
+    void     softReset();
+    void     setControl(uint8_t value, uint64_t timeUs);
+    void     update(uint64_t timeUs);
+    void     completeMeasurement(uint64_t timeUs);
+    uint8_t  readRegister(uint8_t reg);
+    
+    VectorProvider  field;
+    
+    uint8_t     asa[3];                     ///< Fuse ROM sensitivity adjustment values
+    SimVector3  ironOffset;                 ///< Hard-iron field added to the input (µT)
+    SimVector3  ironGain;                   ///< Soft-iron gain of each axis
+    uint8_t     data[6];                    ///< HXL - HZH of the stored result
+    uint8_t     address         = 0;        ///< Register address for the next read
+    uint8_t     status1         = 0;        ///< ST1: DRDY and DOR
+    uint8_t     status2         = 0;        ///< ST2: HOFL and BITM of the stored result
+    uint8_t     control         = 0;        ///< CNTL1: mode and output bit setting
+    uint8_t     selfTest        = 0;        ///< ASTC
+    bool        i2cDisabled     = false;
+    bool        readProtected   = false;    ///< Data register read started, waiting for ST2
+    uint64_t    nextResult      = 0;        ///< Virtual time the pending measurement is ready
+    uint64_t    period          = 0;        ///< Continuous mode period, 0 for one-shot modes
+    bool        pending         = false;    ///< A measurement is in progress
+    uint32_t    droppedResults  = 0;        ///< Results lost to overrun or read protection
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimAK8963_h */
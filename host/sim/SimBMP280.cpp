@@ -0,0 +1,344 @@
+/**
+ *  @file   SimBMP280.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the BMP280
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimBMP280.h"
+
+#include <string.h>
+
+
+namespace sim {
+
+
+/*!
+ * @brief   Trimming parameters of the datasheet's compensation example
+ */
+static const SimBmp280Calibration defaultCalibration = {
+    27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000
+};
+
+static const uint64_t standbyUs[8] = {
+    500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000
+};
+
+
+SimBMP280::SimBMP280()
+{
+    setTemperature(25);
+    setPressure(101325);
+    setCalibration(defaultCalibration);
+    softReset();
+}
+
+/*!
+ * @brief Sets a constant temperature in °C
+ */
+void SimBMP280::setTemperature(double celsius)
+{
+    temperature = [celsius](uint64_t) { return celsius; };
+}
+
+void SimBMP280::setTemperatureProvider(ScalarProvider provider)
+{
+    temperature = provider;
+}
+
+/*!
+ * @brief Sets a constant pressure in Pa
+ */
+void SimBMP280::setPressure(double pascals)
+{
+    pressure = [pascals](uint64_t) { return pascals; };
+}
+
+void SimBMP280::setPressureProvider(ScalarProvider provider)
+{
+    pressure = provider;
+}
+
+/*!
+ * @brief Sets a function of virtual time that gives the ADC codes directly.
+ * Takes precedence over the temperature and pressure providers; pass an
+ * empty provider to return to them.
+ */
+void SimBMP280::setRawProvider(Bmp280RawProvider provider)
+{
+    raw = provider;
+}
+
+/*!
+ * @brief Sets the trimming parameters. They are stored in the register file
+ * too, so set them before the driver reads them.
+ */
+void SimBMP280::setCalibration(const SimBmp280Calibration& calibration)
+{
+    const uint16_t* words = (const uint16_t*)&calibration;
+    
+    calib = calibration;
+    for (int i = 0; i < 12; i++) {
+        registers[SIM_BMP280_REG_CALIB + 2 * i]     = words[i] & 0xFF;
+        registers[SIM_BMP280_REG_CALIB + 2 * i + 1] = words[i] >> 8;
+    }
+}
+
+/*!
+ * @brief Bosch 32-bit integer temperature compensation
+ *
+ * @return  temperature in 0.01 °C. tFine is set for compensatePressure().
+ */
+int32_t SimBMP280::compensateTemperature(int32_t adcT, int32_t& tFine)
+{
+    int32_t var1 = ((((adcT >> 3) - ((int32_t)calib.T1 << 1))) * ((int32_t)calib.T2)) >> 11;
+    int32_t var2 = (((((adcT >> 4) - ((int32_t)calib.T1)) * ((adcT >> 4) - ((int32_t)calib.T1))) >> 12) *
+                    ((int32_t)calib.T3)) >> 14;
+    
+    tFine = var1 + var2;
+    return (tFine * 5 + 128) >> 8;
+}
+
+/*!
+ * @brief Bosch 64-bit integer pressure compensation
+ *
+ * @return  pressure in Pa, Q24.8
+ */
+int64_t SimBMP280::compensatePressure(int32_t adcP, int32_t tFine)
+{
+    int64_t var1, var2, p;
+    
+    var1 = ((int64_t)tFine) - 128000;
+    var2 = var1 * var1 * (int64_t)calib.P6;
+    var2 = var2 + ((var1 * (int64_t)calib.P5) << 17);
+    var2 = var2 + (((int64_t)calib.P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)calib.P3) >> 8) + ((var1 * (int64_t)calib.P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib.P1) >> 33;
+    
+    if (var1 == 0) {
+        return 0;
+    }
+    p    = 1048576 - adcP;
+    p    = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)calib.P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)calib.P8) * p) >> 19;
+    
+    return ((p + var1 + var2) >> 8) + (((int64_t)calib.P7) << 4);
+}
+
+/*!
+ * @brief Returns the ADC code whose compensated temperature is closest to
+ * celsius. Compensation rises with the code.
+ */
+uint32_t SimBMP280::findTemperatureCode(double celsius)
+{
+    double   target = celsius * 100;
+    uint32_t low    = 0;
+    uint32_t high   = SIM_BMP280_ADC_MAX;
+    int32_t  tFine;
+    
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (compensateTemperature(middle, tFine) < target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low > 0 && target - compensateTemperature(low - 1, tFine) < compensateTemperature(low, tFine) - target) {
+        low--;
+    }
+    return low;
+}
+
+/*!
+ * @brief Returns the ADC code whose compensated pressure at tFine is closest
+ * to pascals. Compensation falls as the code rises.
+ */
+uint32_t SimBMP280::findPressureCode(double pascals, int32_t tFine)
+{
+    double   target = pascals * 256;
+    uint32_t low    = 0;
+    uint32_t high   = SIM_BMP280_ADC_MAX;
+    
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (compensatePressure(middle, tFine) > target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low > 0 && compensatePressure(low - 1, tFine) - target < target - compensatePressure(low, tFine)) {
+        low--;
+    }
+    return low;
+}
+
+void SimBMP280::softReset()
+{
+    SimBmp280Calibration calibration = calib;
+    
+    memset(registers, 0, sizeof(registers));
+    setCalibration(calibration);
+    registers[SIM_BMP280_REG_ID] = SIM_BMP280_CHIP_ID;
+    for (int reg = SIM_BMP280_REG_PRESS; reg < SIM_BMP280_REG_TEMP + 3; reg += 3) {
+        registers[reg] = SIM_BMP280_ADC_SKIPPED >> 12;
+    }
+    address    = 0;
+    lastResult = UINT64_MAX;
+}
+
+/*!
+ * @brief Datasheet maximum measurement time for the oversampling settings
+ */
+uint64_t SimBMP280::getMeasurementUs()
+{
+    uint8_t  control     = registers[SIM_BMP280_REG_CTRL_MEAS];
+    uint8_t  osrsT       = control >> 5;
+    uint8_t  osrsP       = (control >> 2) & 0x07;
+    uint64_t samplesT    = osrsT ? 1 << (osrsT > 5 ? 4 : osrsT - 1) : 0;
+    uint64_t samplesP    = osrsP ? 1 << (osrsP > 5 ? 4 : osrsP - 1) : 0;
+    
+    return 1250 + 2300 * samplesT + (samplesP ? 2300 * samplesP + 575 : 0);
+}
+
+uint64_t SimBMP280::getStandbyUs()
+{
+    return standbyUs[registers[SIM_BMP280_REG_CONFIG] >> 5];
+}
+
+void SimBMP280::startMeasurements(uint64_t timeUs)
+{
+    firstResult = timeUs + getMeasurementUs();
+    lastResult  = UINT64_MAX;
+}
+
+/*!
+ * @brief Stores the result of the last measurement finished by timeUs and
+ * updates STATUS.measuring. A forced measurement returns to sleep mode.
+ */
+void SimBMP280::update(uint64_t timeUs)
+{
+    uint8_t mode = registers[SIM_BMP280_REG_CTRL_MEAS] & 0x03;
+    
+    registers[SIM_BMP280_REG_STATUS] = 0;
+    if (mode == 0) {
+        return;
+    }
+    if (timeUs < firstResult) {
+        registers[SIM_BMP280_REG_STATUS] = SIM_BMP280_STATUS_MEASURING;
+        return;
+    }
+    
+    if (mode != 0x03) {
+        measure(firstResult);
+        registers[SIM_BMP280_REG_CTRL_MEAS] &= ~0x03;
+        return;
+    }
+    
+    uint64_t measurement = getMeasurementUs();
+    uint64_t cycle       = measurement + getStandbyUs();
+    uint64_t index       = (timeUs - firstResult) / cycle;
+    
+    if (index != lastResult) {
+        lastResult = index;
+        measure(firstResult + index * cycle);
+    }
+    if (timeUs >= firstResult + (index + 1) * cycle - measurement) {
+        registers[SIM_BMP280_REG_STATUS] = SIM_BMP280_STATUS_MEASURING;
+    }
+}
+
+void SimBMP280::measure(uint64_t timeUs)
+{
+    SimBmp280Raw codes;
+    
+    if (raw) {
+        codes = raw(timeUs);
+    } else {
+        int32_t tFine;
+        codes.temperature = findTemperatureCode(temperature(timeUs));
+        compensateTemperature(codes.temperature, tFine);
+        codes.pressure    = findPressureCode(pressure(timeUs), tFine);
+    }
+    
+    uint8_t control = registers[SIM_BMP280_REG_CTRL_MEAS];
+    if ((control >> 5) == 0) {
+        codes.temperature = SIM_BMP280_ADC_SKIPPED;
+    }
+    if (((control >> 2) & 0x07) == 0) {
+        codes.pressure = SIM_BMP280_ADC_SKIPPED;
+    }
+    
+    uint32_t values[2] = { codes.pressure & SIM_BMP280_ADC_MAX, codes.temperature & SIM_BMP280_ADC_MAX };
+    for (int i = 0; i < 2; i++) {
+        registers[SIM_BMP280_REG_PRESS + 3 * i]     = values[i] >> 12;
+        registers[SIM_BMP280_REG_PRESS + 3 * i + 1] = (values[i] >> 4) & 0xFF;
+        registers[SIM_BMP280_REG_PRESS + 3 * i + 2] = (values[i] & 0x0F) << 4;
+    }
+}
+
+/*!
+ * @brief The first byte sets the register address. Following bytes are
+ * written to consecutive registers; only ctrl_meas, config and reset are
+ * writable. config is ignored in normal mode.
+ */
+bool SimBMP280::write(const uint8_t* data, size_t length)
+{
+    uint64_t timeUs = hal::now();
+    
+    update(timeUs);
+    
+    if (length == 0) {
+        return true;
+    }
+    
+    address = data[0];
+    
+    uint8_t reg = address;
+    for (size_t i = 1; i < length; i++, reg++) {
+        switch (reg) {
+            case SIM_BMP280_REG_RESET:
+                if (data[i] == SIM_BMP280_RESET_CODE) {
+                    softReset();
+                    return true;
+                }
+                break;
+            case SIM_BMP280_REG_CTRL_MEAS:
+                registers[reg] = data[i];
+                if (data[i] & 0x03) {
+                    startMeasurements(timeUs);
+                }
+                break;
+            case SIM_BMP280_REG_CONFIG:
+                if ((registers[SIM_BMP280_REG_CTRL_MEAS] & 0x03) != 0x03) {
+                    registers[reg] = data[i];
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+/*!
+ * @brief Reads consecutive registers. A burst read returns the results of
+ * one measurement.
+ */
+size_t SimBMP280::read(uint8_t* buffer, size_t length)
+{
+    update(hal::now());
+    
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = registers[address++];
+    }
+    return length;
+}
+
+
+} /* namespace sim */
@@ -0,0 +1,137 @@
+/**
+ *  @file   SimBMP280.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the BMP280 pressure sensor the sketch
+ *          reads at BMP280_ADDRESS.
+ *
+ *          Modeled behavior:
+ *          - Sleep, forced and normal modes. A measurement takes the
+ *            datasheet's maximum measurement time for the oversampling
+ *            settings in ctrl_meas; normal mode repeats it after the t_sb
+ *            standby time in config. STATUS.measuring is set meanwhile.
+ *          - Result registers hold the 20-bit ADC codes of the last finished
+ *            measurement, big endian, in the upper 20 bits of three bytes.
+ *            A skipped measurement reads 0x80000.
+ *          - Trimming parameters at 0x88 - 0x9F (little endian). Physical
+ *            inputs are turned into the ADC codes whose Bosch compensation
+ *            comes closest to them, so a driver recovers the input to the
+ *            compensation's resolution. A raw provider bypasses this.
+ *          - Soft reset (0xB6 to the reset register).
+ *
+ *          The IIR filter and the SPI interface are not modeled.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimBMP280_h
+#define SimBMP280_h
+
+#include "HostHal.h"
+#include "SimTypes.h"
+#include "Adafruit_BMP280.h"
+
+
+namespace sim {
+
+
+#define SIM_BMP280_CHIP_ID              0x58
+#define SIM_BMP280_RESET_CODE           0xB6    ///< Written to the reset register
+#define SIM_BMP280_ADC_SKIPPED          0x80000 ///< Result of a skipped measurement
+#define SIM_BMP280_ADC_MAX              0xFFFFF ///< 20-bit ADC
+
+#define SIM_BMP280_REG_CALIB            0x88    ///< dig_T1 - dig_P9, 24 bytes
+#define SIM_BMP280_REG_ID               0xD0
+#define SIM_BMP280_REG_RESET            0xE0
+#define SIM_BMP280_REG_STATUS           0xF3
+#define SIM_BMP280_REG_CTRL_MEAS        0xF4    ///< osrs_t (7:5), osrs_p (4:2), mode (1:0)
+#define SIM_BMP280_REG_CONFIG           0xF5    ///< t_sb (7:5), filter (4:2)
+#define SIM_BMP280_REG_PRESS            0xF7    ///< press_msb, press_lsb, press_xlsb
+#define SIM_BMP280_REG_TEMP             0xFA    ///< temp_msb, temp_lsb, temp_xlsb
+#define SIM_BMP280_STATUS_MEASURING     0x08
+
+
+/*!
+ * @brief   Trimming parameters, in register order
+ */
+typedef struct
+{
+    uint16_t    T1;
+    int16_t     T2;
+    int16_t     T3;
+    uint16_t    P1;
+    int16_t     P2;
+    int16_t     P3;
+    int16_t     P4;
+    int16_t     P5;
+    int16_t     P6;
+    int16_t     P7;
+    int16_t     P8;
+    int16_t     P9;
+} SimBmp280Calibration;
+
+
+/*!
+ * @brief   ADC codes of one measurement
+ */
+typedef struct
+{
+    uint32_t    temperature;
+    uint32_t    pressure;
+} SimBmp280Raw;
+
+typedef std::function<SimBmp280Raw(uint64_t timeUs)> Bmp280RawProvider; ///< ADC codes at a virtual time (µs)
+
+
+class SimBMP280 : public hal::I2cDevice
+{
+    
+public:
+    SimBMP280();
+    
+    void     setTemperature(double celsius);
+    void     setTemperatureProvider(ScalarProvider provider);
+    void     setPressure(double pascals);
+    void     setPressureProvider(ScalarProvider provider);
+    void     setRawProvider(Bmp280RawProvider provider);
+    void     setCalibration(const SimBmp280Calibration& calibration);
+    
+    const SimBmp280Calibration& getCalibration() { return calib; }
+    
+    int32_t  compensateTemperature(int32_t adcT, int32_t& tFine);
+    int64_t  compensatePressure(int32_t adcP, int32_t tFine);
+    uint32_t findTemperatureCode(double celsius);
+    uint32_t findPressureCode(double pascals, int32_t tFine);
+    
+    bool     write(const uint8_t* data, size_t length);
+    size_t   read(uint8_t* buffer, size_t length);
+    
+private:
+    
+    void     softReset();
+    void     startMeasurements(uint64_t timeUs);
+    uint64_t getMeasurementUs();
+    uint64_t getStandbyUs();
+    void     update(uint64_t timeUs);
+    void     measure(uint64_t timeUs);
+    
+    ScalarProvider      temperature;
+    ScalarProvider      pressure;
+    Bmp280RawProvider   raw;
+    
+    SimBmp280Calibration calib;
+    
+    uint8_t     registers[256];             ///< Register file
+    uint8_t     address         = 0;        ///< Register address for the next read
+    uint64_t    firstResult     = 0;        ///< Virtual time the first measurement of the mode ends
+    uint64_t    lastResult      = UINT64_MAX; ///< Index of the measurement in the result registers
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimBMP280_h */
@@ -0,0 +1,233 @@
+/**
+ *  @file   SimBNO055.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the BNO055
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimBNO055.h"
+
+#include <string.h>
+
+
+namespace sim {
+
+
+SimBNO055::SimBNO055()
+{
+    setOrientation(1, 0, 0, 0);
+    setField(0, 0, 0);
+    setCalibrationStatus(0);
+    setTemperature(25);
+    systemReset(0);
+}
+
+/*!
+ * @brief Sets a constant orientation
+ */
+void SimBNO055::setOrientation(double w, double x, double y, double z)
+{
+    SimQuaternion value = { w, x, y, z };
+    orientation = [value](uint64_t) { return value; };
+}
+
+void SimBNO055::setOrientationProvider(QuaternionProvider provider)
+{
+    orientation = provider;
+}
+
+/*!
+ * @brief Sets a constant magnetic field in µT, in the BNO055 axes
+ */
+void SimBNO055::setField(double xMicroTesla, double yMicroTesla, double zMicroTesla)
+{
+    SimVector3 value = { xMicroTesla, yMicroTesla, zMicroTesla };
+    field = [value](uint64_t) { return value; };
+}
+
+void SimBNO055::setFieldProvider(VectorProvider provider)
+{
+    field = provider;
+}
+
+/*!
+ * @brief Sets a constant CALIB_STAT value: system, gyroscope, accelerometer
+ * and magnetometer status, two bits each from the MSb
+ */
+void SimBNO055::setCalibrationStatus(uint8_t status)
+{
+    calibration = [status](uint64_t) { return (double)status; };
+}
+
+void SimBNO055::setCalibrationProvider(ScalarProvider provider)
+{
+    calibration = provider;
+}
+
+/*!
+ * @brief Sets a constant die temperature in °C
+ */
+void SimBNO055::setTemperature(double celsius)
+{
+    temperature = [celsius](uint64_t) { return celsius; };
+}
+
+void SimBNO055::setTemperatureProvider(ScalarProvider provider)
+{
+    temperature = provider;
+}
+
+/*!
+ * @brief Restores the power-on register contents. The device is silent until
+ * it has booted.
+ */
+void SimBNO055::systemReset(uint64_t timeUs)
+{
+    memset(registers, 0, sizeof(registers));
+    registers[SIM_BNO055_REG_CHIP_ID]   = SIM_BNO055_CHIP_ID;
+    registers[SIM_BNO055_REG_ST_RESULT] = SIM_BNO055_ST_RESULT_PASS;
+    address    = 0;
+    bootedAt   = timeUs + SIM_BNO055_BOOT_US;
+    modeStart  = bootedAt;
+    lastSample = UINT64_MAX;
+}
+
+bool SimBNO055::usesMagnetometer(uint8_t mode)
+{
+    // MAGONLY, ACCMAG, MAGGYRO, AMG and every fusion mode but IMU
+    return mode == 0x02 || mode == 0x04 || mode == 0x05 || mode == 0x07 || mode > SIM_BNO055_MODE_IMU;
+}
+
+/*!
+ * @brief Loads the output registers with the most recent output period
+ */
+void SimBNO055::update(uint64_t timeUs)
+{
+    uint8_t mode = getMode();
+    
+    if (mode == SIM_BNO055_MODE_CONFIG || timeUs < modeStart + SIM_BNO055_OUTPUT_PERIOD_US) {
+        return;
+    }
+    
+    uint64_t index = (timeUs - modeStart) / SIM_BNO055_OUTPUT_PERIOD_US;
+    if (index == lastSample) {
+        return;
+    }
+    lastSample = index;
+    
+    sample(modeStart + index * SIM_BNO055_OUTPUT_PERIOD_US);
+}
+
+void SimBNO055::sample(uint64_t timeUs)
+{
+    uint8_t mode = getMode();
+    
+    if (usesMagnetometer(mode)) {
+        SimVector3 h = field(timeUs);
+        int16_t    counts[3] = {
+            simQuantize(h.x, SIM_BNO055_MAG_LSB_PER_UT, INT16_MIN, INT16_MAX),
+            simQuantize(h.y, SIM_BNO055_MAG_LSB_PER_UT, INT16_MIN, INT16_MAX),
+            simQuantize(h.z, SIM_BNO055_MAG_LSB_PER_UT, INT16_MIN, INT16_MAX)
+        };
+        for (int i = 0; i < 3; i++) {
+            registers[SIM_BNO055_REG_MAG_DATA + 2 * i]     = counts[i] & 0xFF;
+            registers[SIM_BNO055_REG_MAG_DATA + 2 * i + 1] = (uint16_t)counts[i] >> 8;
+        }
+    }
+    
+    if (mode >= SIM_BNO055_MODE_IMU) {
+        SimQuaternion q = orientation(timeUs);
+        int16_t       counts[4] = {
+            simQuantize(q.w, SIM_BNO055_QUAT_LSB_PER_UNIT, INT16_MIN, INT16_MAX),
+            simQuantize(q.x, SIM_BNO055_QUAT_LSB_PER_UNIT, INT16_MIN, INT16_MAX),
+            simQuantize(q.y, SIM_BNO055_QUAT_LSB_PER_UNIT, INT16_MIN, INT16_MAX),
+            simQuantize(q.z, SIM_BNO055_QUAT_LSB_PER_UNIT, INT16_MIN, INT16_MAX)
+        };
+        for (int i = 0; i < 4; i++) {
+            registers[SIM_BNO055_REG_QUA_DATA + 2 * i]     = counts[i] & 0xFF;
+            registers[SIM_BNO055_REG_QUA_DATA + 2 * i + 1] = (uint16_t)counts[i] >> 8;
+        }
+    }
+    
+    registers[SIM_BNO055_REG_TEMP]       = (uint8_t)simQuantize(temperature(timeUs), 1, INT8_MIN, INT8_MAX);
+    registers[SIM_BNO055_REG_CALIB_STAT] = (uint8_t)calibration(timeUs);
+}
+
+/*!
+ * @brief The first byte sets the register address. Following bytes are
+ * written to consecutive registers of page 0. Only OPR_MODE, PAGE_ID and
+ * SYS_TRIGGER can be written outside CONFIG mode.
+ */
+bool SimBNO055::write(const uint8_t* data, size_t length)
+{
+    uint64_t timeUs = hal::now();
+    
+    if (timeUs < bootedAt) {
+        return false;
+    }
+    update(timeUs);
+    
+    if (length == 0) {
+        return true;
+    }
+    
+    address = data[0] & 0x7F;
+    
+    uint8_t reg = address;
+    for (size_t i = 1; i < length; i++, reg = (reg + 1) & 0x7F) {
+        if (registers[SIM_BNO055_REG_PAGE_ID] != 0 && reg != SIM_BNO055_REG_PAGE_ID) {
+            continue;   // Page 1 is not modeled
+        }
+        switch (reg) {
+            case SIM_BNO055_REG_OPR_MODE:
+                registers[reg] = data[i] & 0x0F;
+                modeStart      = timeUs;
+                lastSample     = UINT64_MAX;
+                break;
+            case SIM_BNO055_REG_SYS_TRIGGER:
+                if (data[i] & SIM_BNO055_RST_SYS) {
+                    systemReset(timeUs);
+                    return true;
+                }
+                registers[reg] = data[i] & 0xC0;    // CLK_SEL, RST_INT
+                break;
+            case SIM_BNO055_REG_PAGE_ID:
+                registers[reg] = data[i];
+                break;
+            default:
+                // Outputs, IDs and status registers are read-only
+                if (getMode() == SIM_BNO055_MODE_CONFIG && reg > SIM_BNO055_REG_SYS_STATUS + 1) {
+                    registers[reg] = data[i];
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+/*!
+ * @brief Reads consecutive registers. A burst read of the output registers
+ * returns one coherent sample.
+ */
+size_t SimBNO055::read(uint8_t* buffer, size_t length)
+{
+    uint64_t timeUs = hal::now();
+    
+    if (timeUs < bootedAt) {
+        return 0;
+    }
+    update(timeUs);
+    
+    for (size_t i = 0; i < length; i++) {
+        bool page0 = (registers[SIM_BNO055_REG_PAGE_ID] == 0 || address == SIM_BNO055_REG_PAGE_ID);
+        buffer[i]  = page0 ? registers[address] : 0;
+        address    = (address + 1) & 0x7F;
+    }
+    return length;
+}
+
+
+} /* namespace sim */
@@ -0,0 +1,107 @@
+/**
+ *  @file   SimBNO055.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the BNO055 absolute orientation sensor
+ *          the sketch reads at BNO055_ADDRESS_A.
+ *
+ *          Modeled behavior:
+ *          - The device does not acknowledge its address for
+ *            SIM_BNO055_BOOT_US after power-on or a RST_SYS reset.
+ *          - CONFIG mode and the non-fusion and fusion operating modes. In
+ *            any mode but CONFIG the output registers are refreshed every
+ *            SIM_BNO055_OUTPUT_PERIOD_US: magnetometer data (16 LSb/µT) in
+ *            the modes that use the magnetometer, quaternion data (2^14 LSb
+ *            per unit) in the fusion modes. Output registers keep their last
+ *            values in CONFIG mode.
+ *          - TEMP (1 °C/LSb) and CALIB_STAT from their providers.
+ *          - Page 0 only. Configuration registers can only be written in
+ *            CONFIG mode and read back what was written.
+ *
+ *          Accelerometer, gyroscope, Euler, linear acceleration and gravity
+ *          outputs, interrupts and the page 1 registers are not modeled and
+ *          read as 0.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimBNO055_h
+#define SimBNO055_h
+
+#include "HostHal.h"
+#include "SimTypes.h"
+#include "Adafruit_BNO055.h"
+
+
+namespace sim {
+
+
+#define SIM_BNO055_CHIP_ID              0xA0
+#define SIM_BNO055_BOOT_US              650000  ///< Power-on / reset to CONFIG mode
+#define SIM_BNO055_OUTPUT_PERIOD_US     10000   ///< 100 Hz fusion output rate
+#define SIM_BNO055_MAG_LSB_PER_UT       16.0
+#define SIM_BNO055_QUAT_LSB_PER_UNIT    16384.0
+
+#define SIM_BNO055_REG_CHIP_ID          0x00
+#define SIM_BNO055_REG_PAGE_ID          0x07
+#define SIM_BNO055_REG_MAG_DATA         0x0E    ///< MAG_DATA_X_LSB, 6 bytes
+#define SIM_BNO055_REG_QUA_DATA         0x20    ///< QUA_DATA_W_LSB, 8 bytes
+#define SIM_BNO055_REG_TEMP             0x34
+#define SIM_BNO055_REG_CALIB_STAT       0x35
+#define SIM_BNO055_REG_ST_RESULT        0x36
+#define SIM_BNO055_REG_SYS_STATUS       0x39
+#define SIM_BNO055_REG_OPR_MODE         0x3D
+#define SIM_BNO055_REG_SYS_TRIGGER      0x3F
+#define SIM_BNO055_RST_SYS              0x20    ///< SYS_TRIGGER system reset bit
+#define SIM_BNO055_MODE_CONFIG          0x00
+#define SIM_BNO055_MODE_IMU             0x08    ///< First fusion mode
+#define SIM_BNO055_ST_RESULT_PASS       0x0F    ///< All self tests passed
+
+
+class SimBNO055 : public hal::I2cDevice
+{
+    
+public:
+    SimBNO055();
+    
+    void     setOrientation(double w, double x, double y, double z);
+    void     setOrientationProvider(QuaternionProvider provider);
+    void     setField(double xMicroTesla, double yMicroTesla, double zMicroTesla);
+    void     setFieldProvider(VectorProvider provider);
+    void     setCalibrationStatus(uint8_t status);
+    void     setCalibrationProvider(ScalarProvider provider);
+    void     setTemperature(double celsius);
+    void     setTemperatureProvider(ScalarProvider provider);
+    
+    uint8_t  getMode() { return registers[SIM_BNO055_REG_OPR_MODE]; }
+    
+    bool     write(const uint8_t* data, size_t length);
+    size_t   read(uint8_t* buffer, size_t length);
+    
+private:
+    
+    void     systemReset(uint64_t timeUs);
+    void     update(uint64_t timeUs);
+    void     sample(uint64_t timeUs);
+    bool     usesMagnetometer(uint8_t mode);
+    
+    QuaternionProvider  orientation;
+    VectorProvider      field;
+    ScalarProvider      calibration;
+    ScalarProvider      temperature;
+    
+    uint8_t     registers[128];             ///< Page 0 register file
+    uint8_t     address         = 0;        ///< Register address for the next read
+    uint64_t    bootedAt        = 0;        ///< Virtual time the device answers again
+    uint64_t    modeStart       = 0;        ///< Virtual time the operating mode was entered
+    uint64_t    lastSample      = UINT64_MAX; ///< Index of the output period in the registers
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimBNO055_h */
@@ -0,0 +1,149 @@
+/**
+ *  @file   SimLM75A.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the LM75A digital temperature sensor
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimLM75A.h"
+#include "TSLPB.h"
+
+
+namespace sim {
+
+
+SimLM75A::SimLM75A()
+{
+    setTemperature(20.0);
+}
+
+/*!
+ * @brief Sets a constant die temperature in °C
+ */
+void SimLM75A::setTemperature(double celsius)
+{
+    temperature = [celsius](uint64_t) { return celsius; };
+}
+
+/*!
+ * @brief Sets a function of virtual time that gives the die temperature in
+ * °C. It is sampled when each conversion completes.
+ */
+void SimLM75A::setTemperatureProvider(ScalarProvider provider)
+{
+    temperature = provider;
+}
+
+/*!
+ * @brief Returns the temperature register as the firmware would read it now
+ */
+uint16_t SimLM75A::getTemperatureRegister()
+{
+    update(hal::now());
+    return tempRegister;
+}
+
+/*!
+ * @brief Completes the conversions due by timeUs. While the shutdown bit is
+ * set the temperature register keeps its last value.
+ */
+void SimLM75A::update(uint64_t timeUs)
+{
+    uint64_t conversion = timeUs / SIM_LM75A_CONVERSION_PERIOD_US;
+    
+    if (conversion == lastConversion) {
+        return;
+    }
+    lastConversion = conversion;
+    
+    if (configuration & SIM_LM75A_CONF_SHUTDOWN) {
+        return;
+    }
+    
+    double  celsius = temperature(conversion * SIM_LM75A_CONVERSION_PERIOD_US);
+    int16_t counts  = simQuantize(celsius, 1 / LMA_TEMP_REG_DEGREES_PER_LSB, -1024, 1023);
+    
+    tempRegister = (uint16_t)counts << LMA_TEMP_REG_UNUSED_LSBS;
+}
+
+uint16_t SimLM75A::getRegister(uint8_t reg)
+{
+    switch (reg) {
+        case LM75A_TEMPERATURE:     return tempRegister;
+        case LM75A_CONFIGURATION:   return configuration;
+        case LM75A_T_HYST:          return tHyst;
+        case LM75A_T_OS:            return tOs;
+        case LM75A_PRODUCT_ID:      return SIM_LM75A_PRODUCT_ID;
+        default:                    return 0;
+    }
+}
+
+/*!
+ * @brief The first byte sets the pointer. Following bytes are written to the
+ * selected register, MSB first. T_HYST and T_OS keep their 9 MSbs.
+ */
+bool SimLM75A::write(const uint8_t* data, size_t length)
+{
+    update(hal::now());
+    
+    if (length == 0) {
+        return true;
+    }
+    
+    pointer = data[0];
+    
+    switch (pointer) {
+        case LM75A_CONFIGURATION:
+            if (length >= 2) {
+                configuration = data[1];
+            }
+            break;
+        case LM75A_T_HYST:
+            if (length >= 3) {
+                tHyst = ((data[1] << 8) | data[2]) & 0xFF80;
+            }
+            break;
+        case LM75A_T_OS:
+            if (length >= 3) {
+                tOs = ((data[1] << 8) | data[2]) & 0xFF80;
+            }
+            break;
+        case LM75A_TEMPERATURE:
+        case LM75A_PRODUCT_ID:
+            // Read only. Extra bytes are ignored
+            break;
+        default:
+            // Invalid pointer. The address was acknowledged, the data is not
+            return length == 1;
+    }
+    return true;
+}
+
+/*!
+ * @brief Reads the register selected by the pointer. Two-byte registers are
+ * sent MSB first and repeat if the master keeps reading.
+ */
+size_t SimLM75A::read(uint8_t* buffer, size_t length)
+{
+    update(hal::now());
+    
+    uint16_t value  = getRegister(pointer);
+    bool     isWord = (pointer == LM75A_TEMPERATURE) ||
+                      (pointer == LM75A_T_HYST) ||
+                      (pointer == LM75A_T_OS);
+    
+    for (size_t i = 0; i < length; i++) {
+        if (isWord) {
+            buffer[i] = (i % 2 == 0) ? (value >> 8) : (value & 0xFF);
+        } else {
+            buffer[i] = (uint8_t)value;
+        }
+    }
+    return length;
+}
+
+
+} /* namespace sim */
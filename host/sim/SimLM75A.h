@@ -0,0 +1,71 @@
+/**
+ *  @file   SimLM75A.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the LM75A digital temperature sensors
+ *          (DT1 - DT6) on the TSLPB.
+ *
+ *          The model keeps the pointer register between transactions: a
+ *          one-byte write only moves the pointer, and a read without a
+ *          pointer write returns the register selected last. The temperature
+ *          register is updated once per conversion period and reads as an
+ *          11-bit, left-justified two's complement value (0.125 °C per LSb).
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimLM75A_h
+#define SimLM75A_h
+
+#include "HostHal.h"
+#include "SimTypes.h"
+
+
+namespace sim {
+
+
+#define SIM_LM75A_CONVERSION_PERIOD_US  100000  ///< One conversion every 100 ms
+#define SIM_LM75A_PRODUCT_ID            0xA1    ///< Contents of the product ID register (0x07)
+#define SIM_LM75A_DEFAULT_T_OS          0x5000  ///< 80 °C power-on overtemperature threshold
+#define SIM_LM75A_DEFAULT_T_HYST        0x4B00  ///< 75 °C power-on hysteresis
+#define SIM_LM75A_CONF_SHUTDOWN         0x01    ///< Configuration bit that stops conversions
+
+
+class SimLM75A : public hal::I2cDevice
+{
+    
+public:
+    SimLM75A();
+    
+    void     setTemperature(double celsius);
+    void     setTemperatureProvider(ScalarProvider provider);
+    
+    uint16_t getTemperatureRegister();
+    uint8_t  getPointer() { return pointer; }
+    
+    bool     write(const uint8_t* data, size_t length);
+    size_t   read(uint8_t* buffer, size_t length);
+    
+private:
+    
+    void     update(uint64_t timeUs);
+    uint16_t getRegister(uint8_t reg);
+    
+    ScalarProvider  temperature;
+    
+    uint8_t     pointer         = 0;                        ///< Pointer register
+    uint8_t     configuration   = 0;                        ///< Configuration register
+    uint16_t    tOs             = SIM_LM75A_DEFAULT_T_OS;   ///< Overtemperature shutdown threshold
+    uint16_t    tHyst           = SIM_LM75A_DEFAULT_T_HYST; ///< Hysteresis threshold
+    uint16_t    tempRegister    = 0;                        ///< Result of the last conversion
+    uint64_t    lastConversion  = 0;                        ///< Index of the last completed conversion
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimLM75A_h */
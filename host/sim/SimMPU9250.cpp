@@ -0,0 +1,207 @@
+/**
+ *  @file   SimMPU9250.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the MPU-9250
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimMPU9250.h"
+#include "TSLPB.h"
+
+#include <string.h>
+
+
+namespace sim {
+
+
+SimMPU9250::SimMPU9250(SimAK8963* magnetometer) : magnetometer(magnetometer)
+{
+    setAcceleration(0, 0, 1);
+    setAngularRate(0, 0, 0);
+    setTemperature(25);
+    deviceReset();
+}
+
+/*!
+ * @brief Sets a constant specific force in g
+ */
+void SimMPU9250::setAcceleration(double xG, double yG, double zG)
+{
+    SimVector3 value = { xG, yG, zG };
+    acceleration = [value](uint64_t) { return value; };
+}
+
+void SimMPU9250::setAccelerationProvider(VectorProvider provider)
+{
+    acceleration = provider;
+}
+
+/*!
+ * @brief Sets a constant angular rate in degrees per second
+ */
+void SimMPU9250::setAngularRate(double xDps, double yDps, double zDps)
+{
+    SimVector3 value = { xDps, yDps, zDps };
+    angularRate = [value](uint64_t) { return value; };
+}
+
+void SimMPU9250::setAngularRateProvider(VectorProvider provider)
+{
+    angularRate = provider;
+}
+
+/*!
+ * @brief Sets a constant die temperature in °C
+ */
+void SimMPU9250::setTemperature(double celsius)
+{
+    temperature = [celsius](uint64_t) { return celsius; };
+}
+
+void SimMPU9250::setTemperatureProvider(ScalarProvider provider)
+{
+    temperature = provider;
+}
+
+void SimMPU9250::deviceReset()
+{
+    memset(registers, 0, sizeof(registers));
+    registers[SIM_MPU9250_REG_PWR_MGMT_1] = SIM_MPU9250_PWR_MGMT_1_DEFAULT;
+    registers[SIM_MPU9250_REG_WHO_AM_I]   = SIM_MPU9250_WHO_AM_I_VALUE;
+    address    = 0;
+    lastSample = UINT64_MAX;
+    updateBypass();
+}
+
+/*!
+ * @brief Connects or disconnects the AK8963 to match BYPASS_EN and SLEEP
+ */
+void SimMPU9250::updateBypass()
+{
+    bool enabled = (registers[MPU9250_REG_INT_PIN_BYPASS] & MPU9250_PASSTHROUGH_ON) &&
+                  !(registers[SIM_MPU9250_REG_PWR_MGMT_1] & SIM_MPU9250_SLEEP);
+    
+    if (magnetometer == NULL || enabled == bypass) {
+        bypass = enabled && magnetometer;
+        return;
+    }
+    
+    bypass = enabled;
+    if (bypass) {
+        hal::attachI2cDevice(MAG_ADDRESS, magnetometer);
+    } else {
+        hal::detachI2cDevice(MAG_ADDRESS);
+    }
+}
+
+/*!
+ * @brief Internal sample period: 1 kHz with the DLPF enabled, 8 kHz without,
+ * divided by 1 + SMPLRT_DIV.
+ */
+uint64_t SimMPU9250::getSamplePeriodUs()
+{
+    uint8_t  dlpf = registers[SIM_MPU9250_REG_CONFIG] & 0x07;
+    uint64_t base = (dlpf == 0 || dlpf == 7) ? 125 : 1000;
+    return base * (1 + registers[SIM_MPU9250_REG_SMPLRT_DIV]);
+}
+
+/*!
+ * @brief Loads the output registers with the most recent sample. Sampling
+ * stops while the device sleeps.
+ */
+void SimMPU9250::update(uint64_t timeUs)
+{
+    if (registers[SIM_MPU9250_REG_PWR_MGMT_1] & SIM_MPU9250_SLEEP) {
+        return;
+    }
+    
+    uint64_t period = getSamplePeriodUs();
+    uint64_t sample = timeUs / period;
+    if (sample == lastSample) {
+        return;
+    }
+    lastSample = sample;
+    
+    uint64_t   sampleTime = sample * period;
+    uint8_t    gyroRange  = (registers[SIM_MPU9250_REG_GYRO_CONFIG]  >> 3) & 0x03;
+    uint8_t    accelRange = (registers[SIM_MPU9250_REG_ACCEL_CONFIG] >> 3) & 0x03;
+    double     gyroScale  = SIM_MPU9250_GYRO_LSB_PER_DPS / (1 << gyroRange);
+    double     accelScale = SIM_MPU9250_ACCEL_LSB_PER_G  / (1 << accelRange);
+    SimVector3 a          = acceleration(sampleTime);
+    SimVector3 w          = angularRate(sampleTime);
+    double     celsius    = temperature(sampleTime) - SIM_MPU9250_TEMP_OFFSET_C;
+    
+    int16_t outputs[7] = {
+        simQuantize(a.x, accelScale, INT16_MIN, INT16_MAX),
+        simQuantize(a.y, accelScale, INT16_MIN, INT16_MAX),
+        simQuantize(a.z, accelScale, INT16_MIN, INT16_MAX),
+        simQuantize(celsius, SIM_MPU9250_TEMP_LSB_PER_C, INT16_MIN, INT16_MAX),
+        simQuantize(w.x, gyroScale, INT16_MIN, INT16_MAX),
+        simQuantize(w.y, gyroScale, INT16_MIN, INT16_MAX),
+        simQuantize(w.z, gyroScale, INT16_MIN, INT16_MAX)
+    };
+    
+    for (int i = 0; i < 7; i++) {
+        registers[MPU9250_ACCEL_XOUT_MSB + 2 * i]     = (uint16_t)outputs[i] >> 8;
+        registers[MPU9250_ACCEL_XOUT_MSB + 2 * i + 1] = outputs[i] & 0xFF;
+    }
+}
+
+bool SimMPU9250::isReadOnly(uint8_t reg)
+{
+    // Self-test results, interrupt status, sensor outputs and WHO_AM_I
+    return (reg <= MPU9250_GYRO_SELF_TEST_Z) ||
+           (reg >= MPU9250_ACCEL_SELF_TEST_X && reg <= MPU9250_ACCEL_SELF_TEST_Z) ||
+           (reg >= 0x3A && reg <= 0x60) ||
+           (reg == SIM_MPU9250_REG_WHO_AM_I);
+}
+
+/*!
+ * @brief The first byte sets the register address. Following bytes are
+ * written to consecutive registers.
+ */
+bool SimMPU9250::write(const uint8_t* data, size_t length)
+{
+    update(hal::now());
+    
+    if (length == 0) {
+        return true;
+    }
+    
+    address = data[0] & 0x7F;
+    
+    uint8_t reg = address;
+    for (size_t i = 1; i < length; i++, reg = (reg + 1) & 0x7F) {
+        if (reg == SIM_MPU9250_REG_PWR_MGMT_1 && (data[i] & SIM_MPU9250_H_RESET)) {
+            deviceReset();
+            return true;
+        }
+        if (!isReadOnly(reg)) {
+            registers[reg] = data[i];
+        }
+    }
+    
+    updateBypass();
+    return true;
+}
+
+/*!
+ * @brief Reads consecutive registers. A burst read of the output registers
+ * returns one coherent sample.
+ */
+size_t SimMPU9250::read(uint8_t* buffer, size_t length)
+{
+    update(hal::now());
+    
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = registers[address];
+        address   = (address + 1) & 0x7F;
+    }
+    return length;
+}
+
+
+} /* namespace sim */
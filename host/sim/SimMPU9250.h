@@ -0,0 +1,93 @@
+/**
+ *  @file   SimMPU9250.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Register-level model of the MPU-9250 accelerometer, gyroscope and
+ *          temperature sensor on the TSLPB.
+ *
+ *          Output registers (0x3B - 0x48) are big endian and hold the sample
+ *          taken at the last tick of the internal sample clock, scaled by the
+ *          full-scale settings in GYRO_CONFIG and ACCEL_CONFIG. Reads and
+ *          writes auto-increment the register address. Setting BYPASS_EN in
+ *          INT_PIN_CFG connects the AK8963 to the bus at MAG_ADDRESS;
+ *          clearing it, a device reset, or sleep disconnects it again.
+ *
+ *          The FIFO, interrupts, the I2C master and the DMP are not modeled.
+ *          Their registers read back what was written.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimMPU9250_h
+#define SimMPU9250_h
+
+#include "HostHal.h"
+#include "SimTypes.h"
+#include "SimAK8963.h"
+
+
+namespace sim {
+
+
+#define SIM_MPU9250_WHO_AM_I_VALUE      0x71    ///< WHO_AM_I contents
+#define SIM_MPU9250_REG_SMPLRT_DIV      0x19    ///< Sample rate divider
+#define SIM_MPU9250_REG_CONFIG          0x1A    ///< DLPF_CFG in bits 2:0
+#define SIM_MPU9250_REG_GYRO_CONFIG     0x1B    ///< GYRO_FS_SEL in bits 4:3
+#define SIM_MPU9250_REG_ACCEL_CONFIG    0x1C    ///< ACCEL_FS_SEL in bits 4:3
+#define SIM_MPU9250_REG_PWR_MGMT_1      0x6B    ///< H_RESET (bit 7), SLEEP (bit 6)
+#define SIM_MPU9250_REG_WHO_AM_I        0x75
+#define SIM_MPU9250_PWR_MGMT_1_DEFAULT  0x01    ///< Reset value: awake, auto clock select
+#define SIM_MPU9250_H_RESET             0x80
+#define SIM_MPU9250_SLEEP               0x40
+#define SIM_MPU9250_GYRO_LSB_PER_DPS    131.0   ///< At ±250 dps
+#define SIM_MPU9250_ACCEL_LSB_PER_G     16384.0 ///< At ±2 g
+#define SIM_MPU9250_TEMP_LSB_PER_C      333.87
+#define SIM_MPU9250_TEMP_OFFSET_C       21.0    ///< Temperature that reads as 0
+
+
+class SimMPU9250 : public hal::I2cDevice
+{
+    
+public:
+    SimMPU9250(SimAK8963* magnetometer = NULL);
+    
+    void     setAcceleration(double xG, double yG, double zG);
+    void     setAccelerationProvider(VectorProvider provider);
+    void     setAngularRate(double xDps, double yDps, double zDps);
+    void     setAngularRateProvider(VectorProvider provider);
+    void     setTemperature(double celsius);
+    void     setTemperatureProvider(ScalarProvider provider);
+    
+    uint8_t  getRegister(uint8_t reg) { return registers[reg & 0x7F]; }
+    bool     isBypassEnabled() { return bypass; }
+    
+    bool     write(const uint8_t* data, size_t length);
+    size_t   read(uint8_t* buffer, size_t length);
+    
+private:
+    
+    void     deviceReset();
+    void     updateBypass();
+    void     update(uint64_t timeUs);
+    uint64_t getSamplePeriodUs();
+    bool     isReadOnly(uint8_t reg);
+    
+    SimAK8963*      magnetometer;
+    VectorProvider  acceleration;
+    VectorProvider  angularRate;
+    ScalarProvider  temperature;
+    
+    uint8_t     registers[128];             ///< Register file
+    uint8_t     address         = 0;        ///< Register address for the next read
+    bool        bypass          = false;    ///< AK8963 connected to the bus
+    uint64_t    lastSample      = UINT64_MAX; ///< Index of the sample in the output registers
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimMPU9250_h */
@@ -0,0 +1,291 @@
+/**
+ *  @file   SimMission.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  One randomized simulated mission
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimMission.h"
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "SimTslpbBoard.h"
+#include "SimBNO055.h"
+#include "SimBMP280.h"
+#include "SimMothership.h"
+#include "SimOrbit.h"
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include <random>
+
+
+namespace sim {
+
+
+const char* const simFaultKindNames[SIM_FAULT_KIND_COUNT] = {
+    "none", "dropout", "stuck"
+};
+
+const char* const simFaultDeviceNames[SIM_FAULT_DEVICE_COUNT] = {
+    "bno055", "bmp280", "imu", "magnetometer", "analog"
+};
+
+const SimMissionConfig simDefaultMissionConfig = {
+    3600,       // seconds
+    2, 20,      // ready (s)
+    0.2, 5,     // busy (s)
+    2,          // outages per hour
+    120,        // longest outage (s)
+    200,        // longest post-packet busy (ms)
+    0.5,        // ACK/NAK replies
+    1e-3,       // highest I2C failure probability
+    0.2,        // sensor faults
+    600,        // longest sensor fault (s)
+    -1,         // faulted device drawn per mission
+    10          // highest tumble rate (dps)
+};
+
+
+/*!
+ * @brief Bucket of a latency in a log-linear histogram: exact below
+ * SIM_LATENCY_STEPS, then SIM_LATENCY_STEPS buckets per power of two.
+ */
+int simLatencyBucket(uint64_t microseconds)
+{
+    if (microseconds < SIM_LATENCY_STEPS) {
+        return (int)microseconds;
+    }
+    
+    int octave = 63 - __builtin_clzll(microseconds);
+    int step   = (int)(microseconds >> (octave - 3)) & (SIM_LATENCY_STEPS - 1);
+    int bucket = (octave - 2) * SIM_LATENCY_STEPS + step;
+    
+    return bucket < SIM_LATENCY_BUCKETS ? bucket : SIM_LATENCY_BUCKETS - 1;
+}
+
+/*!
+ * @brief Smallest latency that falls in bucket
+ */
+uint64_t simLatencyBucketStart(int bucket)
+{
+    if (bucket < SIM_LATENCY_STEPS) {
+        return bucket;
+    }
+    
+    int octave = bucket / SIM_LATENCY_STEPS + 2;
+    int step   = bucket % SIM_LATENCY_STEPS;
+    
+    return (uint64_t)(SIM_LATENCY_STEPS + step) << (octave - 3);
+}
+
+void runMission(const SimMissionConfig& config, uint64_t seed, SimMissionResult& result)
+{
+    std::mt19937_64                         rng(seed);
+    std::uniform_real_distribution<double>  unit(0, 1);
+    auto uniform = [&](double low, double high) { return low + (high - low) * unit(rng); };
+    
+    clock_t  cpuStart = clock();
+    uint64_t endUs    = (uint64_t)(config.seconds * 1e6);
+    
+    memset(&result, 0, sizeof(result));
+    result.seed = seed;
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                   Environment                    │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    // A random orbit, season, attitude and tumble
+    SimOrbitConfig orbitConfig = simDefaultOrbitConfig;
+    double         z    = uniform(-1, 1), phi = uniform(0, 2 * M_PI);
+    double         rate = uniform(0, config.tumbleMaxDps);
+    
+    orbitConfig.altitudeKm      = uniform(350, 550);
+    orbitConfig.inclinationDeg  = uniform(0, 98);
+    orbitConfig.raanDeg         = uniform(0, 360);
+    orbitConfig.latitudeArgDeg  = uniform(0, 360);
+    orbitConfig.sunLongitudeDeg = uniform(0, 360);
+    orbitConfig.greenwichDeg    = uniform(0, 360);
+    orbitConfig.bodyRateDps     = { rate * sqrt(1 - z * z) * cos(phi), rate * sqrt(1 - z * z) * sin(phi), rate * z };
+    
+    double half = uniform(0, M_PI);
+    z   = uniform(-1, 1);
+    phi = uniform(0, 2 * M_PI);
+    orbitConfig.attitude = { cos(half), sin(half) * sqrt(1 - z * z) * cos(phi),
+                             sin(half) * sqrt(1 - z * z) * sin(phi), sin(half) * z };
+    
+    double basePascals = uniform(95000, 105000);
+    
+    result.tumbleDps = rate;
+    
+    SimOrbit orbit(orbitConfig);
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                   Sensor Fault                   │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    uint64_t faultStart = 0;
+    uint64_t faultEnd   = 0;
+    int      faultChannel = 0;
+    
+    if (unit(rng) < config.sensorFaultProbability) {
+        result.faultKind   = 1 + (uint8_t)(rng() % (SIM_FAULT_KIND_COUNT - 1));
+        result.faultDevice = (uint8_t)(rng() % SIM_FAULT_DEVICE_COUNT);
+        if (config.faultDevice >= 0) {
+            // Drawn anyway, so the rest of the mission matches the same seed's
+            result.faultDevice = (uint8_t)config.faultDevice;
+        }
+        faultChannel       = (int)(rng() % 6);
+        faultStart         = (uint64_t)(uniform(0, config.seconds) * 1e6);
+        faultEnd           = faultStart + (uint64_t)(uniform(1, config.faultMaxSeconds) * 1e6);
+    }
+    
+    // A stuck device sees the time its fault began
+    auto deviceTime = [=, &result](int device, uint64_t timeUs) {
+        bool stuck = result.faultKind == FaultStuck && result.faultDevice == device &&
+                     timeUs >= faultStart && timeUs < faultEnd;
+        return stuck ? faultStart : timeUs;
+    };
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                     Devices                      │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    SimTslpbBoard  board;
+    SimBNO055      bno;
+    SimBMP280      bmp;
+    SimMothership  nsl;
+    
+    // Feed the environment to every device, then wrap the providers a
+    // fault can affect
+    orbit.attach(board, &bno, &bmp);
+    bno.setOrientationProvider([&](uint64_t t) { return orbit.attitude(deviceTime(FaultBno055, t)); });
+    bno.setFieldProvider([&](uint64_t t) { return orbit.fieldBody(deviceTime(FaultBno055, t)); });
+    bno.setCalibrationProvider([](uint64_t t) { return t < 60000000 ? 0x00 : 0xFF; });
+    bno.setTemperatureProvider([&](uint64_t t) { return orbit.boardCelsius(deviceTime(FaultBno055, t)); });
+    
+    bmp.setTemperatureProvider([&](uint64_t t) { return orbit.boardCelsius(deviceTime(FaultBmp280, t)); });
+    bmp.setPressureProvider([=](uint64_t t) {
+        return basePascals + 200 * sin(2 * M_PI * deviceTime(FaultBmp280, t) / 5.52e9);
+    });
+    
+    // The tumble rate is constant, so a stuck gyroscope only shows in its
+    // temperature
+    board.imu.setTemperatureProvider([&](uint64_t t) { return orbit.boardCelsius(deviceTime(FaultImu, t)); });
+    board.mag.setFieldProvider([&](uint64_t t) { return orbit.fieldMagnetometer(deviceTime(FaultMagnetometer, t)); });
+    
+    // Analog channels in ADC counts; the supply is not part of the orbit model
+    ScalarProvider analog[6] = {
+        [&](uint64_t t) { return orbit.solarCounts(t); },
+        [&](uint64_t t) { return orbit.irCounts(t); },
+        [&](uint64_t t) { return SimOrbit::temperatureCounts(orbit.boardCelsius(t)); },
+        [&](uint64_t t) { return SimOrbit::temperatureCounts(orbit.panelCelsius(t)); },
+        [](uint64_t t)  { return 200 + 40 * sin(t / 7e6); },
+        [](uint64_t)    { return 700.0; }
+    };
+    for (int channel = 0; channel < 6; channel++) {
+        ScalarProvider provider = analog[channel];
+        board.setAnalogSensorProvider((TSLPB_AnalogSensor_t)channel, [=, &result](uint64_t t) {
+            bool faulted = result.faultDevice == FaultAnalog && result.faultKind != FaultNone &&
+                           channel == faultChannel && t >= faultStart && t < faultEnd;
+            if (faulted) {
+                return result.faultKind == FaultDropout ? 0.0 : provider(faultStart);
+            }
+            return provider(t);
+        });
+    }
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │           Bus Errors and Device Dropouts         │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    result.busErrorRate = uniform(0, config.busErrorMax);
+    
+    uint8_t dropoutAddress[SIM_FAULT_DEVICE_COUNT] = {
+        BNO055_ADDRESS_A, BMP280_ADDRESS, IMU_ADDRESS, MAG_ADDRESS, 0
+    };
+    std::mt19937_64 busRng(rng());
+    
+    hal::reset();
+    board.attach();
+    hal::attachI2cDevice(BNO055_ADDRESS_A, &bno);
+    hal::attachI2cDevice(BMP280_ADDRESS, &bmp);
+    nsl.attach();
+    
+    hal::setI2cFaultProvider([&](uint8_t address, bool, uint64_t timeUs) {
+        bool dropped = result.faultKind == FaultDropout && address == dropoutAddress[result.faultDevice] &&
+                       timeUs >= faultStart && timeUs < faultEnd;
+        return dropped || (busRng() >> 11) * 0x1.0p-53 < result.busErrorRate;
+    });
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                Mothership Schedule               │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    uint64_t readyUs = (uint64_t)(uniform(config.readyMinSeconds, config.readyMaxSeconds) * 1e6);
+    uint64_t busyUs  = (uint64_t)(uniform(config.busyMinSeconds, config.busyMaxSeconds) * 1e6);
+    
+    nsl.setPeriodicSchedule(readyUs, busyUs, (uint64_t)(unit(rng) * (readyUs + busyUs)));
+    
+    std::poisson_distribution<int> outages(config.outagesPerHour * config.seconds / 3600);
+    for (int i = outages(rng); i > 0; i--) {
+        uint64_t start = (uint64_t)(uniform(0, config.seconds) * 1e6);
+        nsl.addBusyInterval(start, start + (uint64_t)(uniform(1, config.outageMaxSeconds) * 1e6));
+    }
+    nsl.setPostFrameBusy((uint64_t)(uniform(0, config.postBusyMaxMs) * 1000));
+    nsl.setAckEnabled(unit(rng) < config.ackProbability);
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                       Run                        │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    nsl.setMetEpoch(hal::now());
+    setup();
+    while (hal::now() < endUs) {
+        loop();
+        result.loops++;
+    }
+    
+    const hal::I2cStats&            i2c      = hal::i2cStats();
+    const hal::BlockingStats&       blocking = hal::blockingStats();
+    const SimMothershipStats&       link     = nsl.getStats();
+    
+    result.virtualUs        = hal::now();
+    result.framesSent       = hal::serialStats().bytesWritten / NSL_PACKET_SIZE;
+    result.framesReceived   = link.framesReceived;
+    result.framesAccepted   = link.framesAccepted;
+    result.busyViolations   = link.busyViolations;
+    result.headerErrors     = link.headerErrors;
+    result.partialFrames    = link.timeouts;
+    result.i2cTransactions  = i2c.transactions;
+    result.i2cNacks         = i2c.nacks;
+    result.i2cFaults        = i2c.faults;
+    
+    for (const SimNslFrame& frame : nsl.getFrames()) {
+        ThinsatPacket_t packet;
+        memcpy(packet.NSLPacket, frame.bytes, NSL_PACKET_SIZE);
+        
+        bool science = packet.payloadData.sampleAge <= TSL_SAMPLE_AGE_MAX;
+        if (frame.headerValid && !frame.sentWhileBusy && science && frame.endUs >= frame.acquisitionUs) {
+            result.latency[simLatencyBucket(frame.endUs - frame.acquisitionUs)]++;
+        }
+    }
+    
+    double seconds      = result.virtualUs / 1e6;
+    double sleepSeconds = blocking.sleepTimeUs / 1e6;
+    double charge       = SIM_POWER_MCU_ACTIVE_MA * (seconds - sleepSeconds) +
+                          SIM_POWER_MCU_IDLE_MA   * sleepSeconds +
+                          SIM_POWER_I2C_MA        * (i2c.busTimeUs / 1e6) +
+                          SIM_POWER_SENSORS_MA    * seconds;      // mA s
+    
+    result.energyJoules = SIM_POWER_SUPPLY_VOLTS * charge / 1000;
+    result.cpuSeconds   = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+}
+
+
+} /* namespace sim */
@@ -0,0 +1,147 @@
+/**
+ *  @file   SimMission.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  One randomized simulated mission: the sketch on the simulated
+ *          TSLPB, BNO055, BMP280 and NSL Mothership, with a mothership
+ *          busy schedule, sensor faults and I2C bus errors drawn from a
+ *          seed.
+ *
+ *          A mission draws, from its seed:
+ *          - a periodic busy/ready schedule with a random phase, unscheduled
+ *            outages, a busy time after each packet and ACK/NAK replies
+ *          - an orbit, season, initial attitude and tumble for the SimOrbit
+ *            environment the sensors see, and a base pressure
+ *          - a probability that any I2C transaction fails (NACK)
+ *          - optionally one sensor fault: a device that stops answering
+ *            (dropout) or keeps returning the same reading (stuck) for a
+ *            window of the mission
+ *
+ *          runMission() calls the sketch's setup() and loop() of whichever
+ *          firmware the program links, which keep their state in globals.
+ *          Run each mission in a fresh process.
+ *
+ *          Energy is a host estimate from the virtual time the firmware
+ *          spent awake, asleep and driving the I2C bus, plus the sensors'
+ *          supply current; the SIM_POWER_ constants are datasheet typicals.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimMission_h
+#define SimMission_h
+
+#include <stdint.h>
+
+
+namespace sim {
+
+
+#define SIM_POWER_SUPPLY_VOLTS          3.3
+#define SIM_POWER_MCU_ACTIVE_MA         3.6     ///< ATmega328P at 8 MHz, including delay() busy waits
+#define SIM_POWER_MCU_IDLE_MA           0.9     ///< ATmega328P in SLEEP_MODE_IDLE
+#define SIM_POWER_I2C_MA                0.7     ///< Pull-up current while the bus is driven
+#define SIM_POWER_SENSORS_MA            16.5    ///< BNO055 NDOF, MPU-9250, AK8963, BMP280 and six LM75A
+
+#define SIM_LATENCY_STEPS               8       ///< Histogram buckets per power of two
+#define SIM_LATENCY_BUCKETS             (36 * SIM_LATENCY_STEPS)    ///< Up to 2^37 µs
+
+
+typedef enum
+{
+    MissionPending      = 0,        ///< Not run yet
+    MissionCompleted    = 1,        ///< Ran for the configured duration
+    MissionHung         = 2,        ///< Killed by the host timeout
+    MissionCrashed      = 3         ///< The process died
+} SimMissionStatus;
+
+typedef enum
+{
+    FaultNone           = 0,
+    FaultDropout        = 1,        ///< The device NACKs every transaction (analog: reads 0)
+    FaultStuck          = 2,        ///< The device repeats the reading it had when the fault began
+    SIM_FAULT_KIND_COUNT
+} SimFaultKind;
+
+typedef enum
+{
+    FaultBno055         = 0,
+    FaultBmp280         = 1,
+    FaultImu            = 2,        ///< MPU-9250 gyroscope and accelerometer
+    FaultMagnetometer   = 3,        ///< AK8963
+    FaultAnalog         = 4,        ///< One channel of the analog mux
+    SIM_FAULT_DEVICE_COUNT
+} SimFaultDevice;
+
+extern const char* const simFaultKindNames[SIM_FAULT_KIND_COUNT];
+extern const char* const simFaultDeviceNames[SIM_FAULT_DEVICE_COUNT];
+
+
+/*!
+ * @brief   Ranges the missions are drawn from
+ */
+typedef struct
+{
+    double      seconds;                ///< Virtual duration of a mission
+    double      readyMinSeconds;        ///< Ready time of the periodic schedule
+    double      readyMaxSeconds;
+    double      busyMinSeconds;         ///< Busy time of the periodic schedule
+    double      busyMaxSeconds;
+    double      outagesPerHour;         ///< Mean rate of unscheduled busy intervals
+    double      outageMaxSeconds;       ///< Longest unscheduled busy interval
+    double      postBusyMaxMs;          ///< Longest busy time after each packet
+    double      ackProbability;         ///< Share of missions whose mothership replies ACK/NAK
+    double      busErrorMax;            ///< Highest per-transaction I2C failure probability
+    double      sensorFaultProbability; ///< Share of missions with a sensor fault
+    double      faultMaxSeconds;        ///< Longest sensor fault
+    int         faultDevice;            ///< SimFaultDevice of every sensor fault, or -1 to draw it
+    double      tumbleMaxDps;           ///< Highest tumble rate
+} SimMissionConfig;
+
+extern const SimMissionConfig simDefaultMissionConfig;
+
+
+/*!
+ * @brief   Outcome of one mission. Plain data, so it can live in memory
+ *          shared between processes.
+ */
+typedef struct
+{
+    uint64_t    seed;
+    uint8_t     status;                 ///< SimMissionStatus
+    uint8_t     faultKind;              ///< SimFaultKind
+    uint8_t     faultDevice;            ///< SimFaultDevice
+    double      busErrorRate;           ///< Per-transaction I2C failure probability drawn
+    double      tumbleDps;
+    
+    uint64_t    virtualUs;              ///< Virtual time at the end of the mission
+    uint64_t    loops;                  ///< Passes of loop()
+    uint64_t    framesSent;             ///< Packets written by the firmware
+    uint64_t    framesReceived;         ///< Complete packets at the mothership
+    uint64_t    framesAccepted;         ///< Packets the mothership accepted
+    uint64_t    busyViolations;
+    uint64_t    headerErrors;
+    uint64_t    partialFrames;
+    uint64_t    i2cTransactions;
+    uint64_t    i2cNacks;               ///< Includes injected faults
+    uint64_t    i2cFaults;              ///< Transactions failed by the bus error model
+    
+    double      energyJoules;           ///< Estimated payload energy
+    double      cpuSeconds;             ///< Host CPU time of the mission
+    
+    uint32_t    latency[SIM_LATENCY_BUCKETS];   ///< Acquisition to delivery of accepted science frames
+} SimMissionResult;
+
+
+void        runMission(const SimMissionConfig& config, uint64_t seed, SimMissionResult& result);
+
+int         simLatencyBucket(uint64_t microseconds);
+uint64_t    simLatencyBucketStart(int bucket);
+
+
+} /* namespace sim */
+
+
+#endif /* SimMission_h */
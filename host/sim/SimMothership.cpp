@@ -0,0 +1,206 @@
+/**
+ *  @file   SimMothership.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Simulated NSL Mothership
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimMothership.h"
+
+#include <algorithm>
+#include <string.h>
+
+
+namespace sim {
+
+
+namespace {
+
+void recordLatency(SimLatencyStats& latency, uint64_t valueUs)
+{
+    if (latency.count == 0 || valueUs < latency.min) latency.min = valueUs;
+    if (valueUs > latency.max)                       latency.max = valueUs;
+    latency.count++;
+    latency.total += valueUs;
+}
+
+} /* namespace */
+
+
+SimMothership::SimMothership()
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(&current, 0, sizeof(current));
+}
+
+/*!
+ * @brief Connects the mothership to the serial port and the status pin. Call
+ * after hal::reset().
+ */
+void SimMothership::attach()
+{
+    hal::attachSerialEndpoint(this);
+    hal::setDigitalInputProvider(TSL_SERIAL_STATUS_PIN, [this](uint8_t, uint64_t timeUs) {
+        return (uint8_t)(isBusy(timeUs) ? NSL_SERIAL_BUSY : NSL_SERIAL_READY);
+    });
+}
+
+void SimMothership::setAlwaysReady()
+{
+    periodicReadyUs = 0;
+    busyIntervals.clear();
+    postFrameBusyUs = 0;
+}
+
+/*!
+ * @brief Repeats readyUs of ready followed by busyUs of busy, starting
+ * offsetUs into the cycle at virtual time 0.
+ */
+void SimMothership::setPeriodicSchedule(uint64_t readyUs, uint64_t busyUs, uint64_t offsetUs)
+{
+    periodicReadyUs  = readyUs;
+    periodicBusyUs   = busyUs;
+    periodicOffsetUs = offsetUs;
+}
+
+/*!
+ * @brief Adds a busy window [startUs, endUs). Windows must be added in order
+ * of their start time.
+ */
+void SimMothership::addBusyInterval(uint64_t startUs, uint64_t endUs)
+{
+    busyIntervals.push_back(std::make_pair(startUs, endUs));
+}
+
+/*!
+ * @brief Makes the mothership busy for busyUs after each complete packet
+ * while it forwards the packet.
+ */
+void SimMothership::setPostFrameBusy(uint64_t busyUs)
+{
+    postFrameBusyUs = busyUs;
+}
+
+void SimMothership::setAckEnabled(bool enabled, uint64_t delayUs)
+{
+    ackEnabled = enabled;
+    ackDelayUs = delayUs;
+}
+
+/*!
+ * @brief Sets the virtual time at which the payload's MET was 0, normally
+ * the time of TSLPB::begin(). Used to reconstruct acquisition times.
+ */
+void SimMothership::setMetEpoch(uint64_t epochUs)
+{
+    metEpochUs = epochUs;
+}
+
+bool SimMothership::isBusy(uint64_t timeUs)
+{
+    if (timeUs < postFrameBusyUntil) {
+        return true;
+    }
+    
+    if (periodicReadyUs) {
+        uint64_t phase = (timeUs + periodicOffsetUs) % (periodicReadyUs + periodicBusyUs);
+        if (phase >= periodicReadyUs) {
+            return true;
+        }
+    }
+    
+    if (!busyIntervals.empty()) {
+        std::pair<uint64_t, uint64_t> key(timeUs, UINT64_MAX);
+        auto next = std::upper_bound(busyIntervals.begin(), busyIntervals.end(), key);
+        if (next != busyIntervals.begin() && timeUs < (next - 1)->second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimMothership::receive(uint8_t byte, uint64_t writeUs, uint64_t deliveredUs)
+{
+    uint64_t startUs = deliveredUs - hal::getSerialByteTimeNanos() / 1000;
+    
+    stats.bytesReceived++;
+    
+    // A long silence ends a partial packet
+    if (currentLength > 0 && startUs - lastByteUs > SIM_NSL_FRAME_TIMEOUT_US) {
+        stats.bytesDiscarded += currentLength;
+        stats.timeouts++;
+        currentLength = 0;
+    }
+    
+    if (currentLength == 0) {
+        memset(&current, 0, sizeof(current));
+        current.writeUs = writeUs;
+        current.startUs = startUs;
+    }
+    
+    if (isBusy(startUs)) {
+        current.sentWhileBusy = true;
+    }
+    
+    current.bytes[currentLength++] = byte;
+    current.endUs = deliveredUs;
+    lastByteUs    = deliveredUs;
+    
+    if (currentLength == NSL_PACKET_SIZE) {
+        completeFrame();
+        currentLength = 0;
+    }
+}
+
+void SimMothership::completeFrame()
+{
+    const uint8_t header[] = NSL_PACKET_HEADER;
+    ThinsatPacket_t packet;
+    
+    memcpy(packet.NSLPacket, current.bytes, NSL_PACKET_SIZE);
+    
+    current.headerValid   = memcmp(current.bytes, header, NSL_PACKET_HEADER_LENGTH) == 0;
+    current.acquisitionUs = metEpochUs + (uint64_t)packet.payloadData.met * TSL_MET_TICK_MS * 1000;
+    
+    bool accepted = current.headerValid && !current.sentWhileBusy;
+    
+    stats.framesReceived++;
+    if (!current.headerValid)   stats.headerErrors++;
+    if (current.sentWhileBusy)  stats.busyViolations++;
+    if (accepted)               stats.framesAccepted++;
+    
+    // Only science frames carry an acquisition time
+    if (accepted && packet.payloadData.sampleAge <= TSL_SAMPLE_AGE_MAX && current.writeUs >= current.acquisitionUs) {
+        recordLatency(stats.queueing, current.writeUs - current.acquisitionUs);
+    }
+    recordLatency(stats.buffering, current.startUs - current.writeUs);
+    recordLatency(stats.delivery,  current.endUs   - current.writeUs);
+    
+    frames.push_back(current);
+    
+    postFrameBusyUntil = current.endUs + postFrameBusyUs;
+    reply(accepted, current.endUs);
+}
+
+void SimMothership::reply(bool accepted, uint64_t timeUs)
+{
+    if (!ackEnabled) {
+        return;
+    }
+    
+    const uint8_t ack[] = NSL_SERIAL_ACK;
+    const uint8_t nak[] = NSL_SERIAL_NAK;
+    
+    hal::serialInjectAt(accepted ? ack : nak, sizeof(ack), timeUs + ackDelayUs);
+    if (accepted) {
+        stats.acks++;
+    } else {
+        stats.naks++;
+    }
+}
+
+
+} /* namespace sim */
@@ -0,0 +1,152 @@
+/**
+ *  @file   SimMothership.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Simulated NSL Mothership at the far end of the payload serial
+ *          link.
+ *
+ *          The mothership drives TSL_SERIAL_STATUS_PIN from a busy/ready
+ *          schedule, receives bytes at the pace of the UART on the virtual
+ *          clock, frames them into NSL_PACKET_SIZE packets and checks the
+ *          NSL_PACKET_HEADER. Optionally it answers each packet with
+ *          NSL_SERIAL_ACK or NSL_SERIAL_NAK. Every packet is kept with its
+ *          timing so that queueing and delivery latency can be reported.
+ *
+ *          A packet is rejected (NAK) when its header is wrong or when any of
+ *          its bytes started while the line was busy. Bytes that do not make
+ *          a full packet before SIM_NSL_FRAME_TIMEOUT_US of silence are
+ *          discarded.
+ *
+ * @code
+ *  sim::SimMothership nsl;
+ *
+ *  hal::reset();
+ *  nsl.attach();
+ *  nsl.setPeriodicSchedule(4000000, 1000000);  // 4 s ready, 1 s busy
+ *  nsl.setPostFrameBusy(50000);                // busy 50 ms after each packet
+ *
+ *  setup();
+ *  while (hal::now() < 60000000) loop();
+ *
+ *  const sim::SimMothershipStats& stats = nsl.getStats();
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimMothership_h
+#define SimMothership_h
+
+#include "TSLPB.h"
+#include "HostHal.h"
+
+#include <vector>
+
+
+namespace sim {
+
+
+#define SIM_NSL_FRAME_TIMEOUT_US    20000   ///< Silence that ends a partial packet
+#define SIM_NSL_ACK_DELAY_US        1000    ///< Time from a packet's last byte to the ACK/NAK
+
+
+/*!
+ * @brief   One packet as received by the mothership
+ */
+typedef struct
+{
+    uint8_t     bytes[NSL_PACKET_SIZE];
+    bool        headerValid;        ///< Header matched NSL_PACKET_HEADER
+    bool        sentWhileBusy;      ///< At least one byte started while the line was busy
+    uint64_t    acquisitionUs;      ///< Acquisition time reconstructed from the MET field
+    uint64_t    writeUs;            ///< First byte accepted by Serial.write()
+    uint64_t    startUs;            ///< Start bit of the first byte
+    uint64_t    endUs;              ///< Stop bit of the last byte
+} SimNslFrame;
+
+
+/*!
+ * @brief   Running latency statistics, in microseconds
+ */
+typedef struct
+{
+    uint64_t    count;
+    uint64_t    min;
+    uint64_t    max;
+    uint64_t    total;
+} SimLatencyStats;
+
+
+/*!
+ * @brief   Mothership counters
+ */
+typedef struct
+{
+    uint64_t        bytesReceived;      ///< Every byte on the line
+    uint64_t        bytesDiscarded;     ///< Bytes of partial packets
+    uint64_t        framesReceived;     ///< Complete packets
+    uint64_t        framesAccepted;     ///< Complete packets with a valid header, sent while ready
+    uint64_t        headerErrors;       ///< Complete packets with a bad header
+    uint64_t        busyViolations;     ///< Complete packets sent (partly) while busy
+    uint64_t        timeouts;           ///< Partial packets ended by silence
+    uint64_t        acks;               ///< NSL_SERIAL_ACK replies sent
+    uint64_t        naks;               ///< NSL_SERIAL_NAK replies sent
+    SimLatencyStats queueing;           ///< Acquisition to first byte written (includes CTS waits)
+    SimLatencyStats buffering;          ///< First byte written to its start bit (UART queue)
+    SimLatencyStats delivery;           ///< First byte written to the last stop bit
+} SimMothershipStats;
+
+
+class SimMothership : public hal::SerialEndpoint
+{
+    
+public:
+    SimMothership();
+    
+    void     attach();
+    
+    void     setAlwaysReady();
+    void     setPeriodicSchedule(uint64_t readyUs, uint64_t busyUs, uint64_t offsetUs = 0);
+    void     addBusyInterval(uint64_t startUs, uint64_t endUs);
+    void     setPostFrameBusy(uint64_t busyUs);
+    void     setAckEnabled(bool enabled, uint64_t delayUs = SIM_NSL_ACK_DELAY_US);
+    void     setMetEpoch(uint64_t epochUs);
+    
+    bool     isBusy(uint64_t timeUs);
+    
+    const SimMothershipStats&        getStats()  { return stats; }
+    const std::vector<SimNslFrame>&  getFrames() { return frames; }
+    
+    void     receive(uint8_t byte, uint64_t writeUs, uint64_t deliveredUs);
+    
+private:
+    
+    void     completeFrame();
+    void     reply(bool accepted, uint64_t timeUs);
+    
+    uint64_t periodicReadyUs    = 0;            ///< 0 disables the periodic schedule
+    uint64_t periodicBusyUs     = 0;
+    uint64_t periodicOffsetUs   = 0;
+    std::vector<std::pair<uint64_t, uint64_t> > busyIntervals; ///< Sorted [start, end) windows
+    uint64_t postFrameBusyUs    = 0;
+    uint64_t postFrameBusyUntil = 0;
+    bool     ackEnabled         = false;
+    uint64_t ackDelayUs         = SIM_NSL_ACK_DELAY_US;
+    uint64_t metEpochUs         = 0;
+    
+    SimNslFrame     current;                    ///< Packet being received
+    size_t          currentLength   = 0;
+    uint64_t        lastByteUs      = 0;
+    
+    SimMothershipStats          stats;
+    std::vector<SimNslFrame>    frames;
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimMothership_h */
@@ -0,0 +1,306 @@
+/**
+ *  @file   SimOrbit.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Orbit environment of the payload
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimOrbit.h"
+
+#include <math.h>
+
+
+namespace sim {
+
+
+const SimOrbitConfig simDefaultOrbitConfig = {
+    400,                    // altitude (km)
+    51.6,                   // inclination (deg)
+    0, 0, 0, 0,             // RAAN, argument of latitude, sun longitude, Greenwich angle (deg)
+    { 1, 0, 0, 0 },         // attitude
+    { 0.5, 1.5, 2.0 },      // body rate (dps)
+    0.0121,                 // 11 x 11 cm panel
+    0.6, 0.8,               // absorptivity, emissivity
+    20, 40,                 // panel, board heat capacity (J/K)
+    0.05,                   // conductance (W/K)
+    0.15,                   // board power (W)
+    20, 22                  // panel, board temperature (°C)
+};
+
+#define DEG                 (M_PI / 180)
+#define KELVIN              273.15
+
+
+SimOrbit::SimOrbit(const SimOrbitConfig& config) : config(config)
+{
+    radiusKm   = SIM_ORBIT_EARTH_RADIUS_KM + config.altitudeKm;
+    meanMotion = sqrt(SIM_ORBIT_EARTH_MU / (radiusKm * radiusKm * radiusKm));
+    
+    // The dipole moment points at the geomagnetic south pole
+    double lat = SIM_ORBIT_DIPOLE_LAT_DEG * DEG;
+    double lon = SIM_ORBIT_DIPOLE_LON_DEG * DEG;
+    dipole = { -cos(lat) * cos(lon), -cos(lat) * sin(lon), -sin(lat) };
+    
+    SimVector3 rate = config.bodyRateDps;
+    double     dps  = sqrt(rate.x * rate.x + rate.y * rate.y + rate.z * rate.z);
+    
+    rateRad  = dps * DEG;
+    rateAxis = dps > 0 ? SimVector3{ rate.x / dps, rate.y / dps, rate.z / dps } : SimVector3{ 0, 0, 1 };
+    
+    panelKelvin = config.panelCelsius + KELVIN;
+    boardKelvin = config.boardCelsius + KELVIN;
+}
+
+/*!
+ * @brief Installs providers that feed the environment to the board's
+ * magnetometer, gyroscope, LM75A sensors and the Solar, IR, TempExt and
+ * TempInt channels, and to the BNO055 and BMP280 if given. The orbit must
+ * outlive the devices. The LM75A sensors sit between the board (DT1) and
+ * the panel (DT6).
+ */
+void SimOrbit::attach(SimTslpbBoard& board, SimBNO055* bno, SimBMP280* bmp)
+{
+    board.imu.setAngularRateProvider([this](uint64_t) { return config.bodyRateDps; });
+    board.imu.setAccelerationProvider([](uint64_t) { return SimVector3{ 0, 0, 0 }; });
+    board.imu.setTemperatureProvider([this](uint64_t t) { return boardCelsius(t); });
+    board.mag.setFieldProvider([this](uint64_t t) { return fieldMagnetometer(t); });
+    
+    for (int i = 0; i < SIM_TSLPB_DT_COUNT; i++) {
+        double weight = (double)i / (SIM_TSLPB_DT_COUNT - 1);
+        board.dt[i].setTemperatureProvider([this, weight](uint64_t t) {
+            Sample s = lookup(t);
+            return s.board + (s.panel - s.board) * weight;
+        });
+    }
+    
+    board.setAnalogSensorProvider(Solar,   [this](uint64_t t) { return solarCounts(t); });
+    board.setAnalogSensorProvider(IR,      [this](uint64_t t) { return irCounts(t); });
+    board.setAnalogSensorProvider(TempExt, [this](uint64_t t) { return temperatureCounts(panelCelsius(t)); });
+    board.setAnalogSensorProvider(TempInt, [this](uint64_t t) { return temperatureCounts(boardCelsius(t)); });
+    
+    if (bno) {
+        bno->setOrientationProvider([this](uint64_t t) { return attitude(t); });
+        bno->setFieldProvider([this](uint64_t t) { return fieldBody(t); });
+        bno->setTemperatureProvider([this](uint64_t t) { return boardCelsius(t); });
+    }
+    if (bmp) {
+        bmp->setTemperatureProvider([this](uint64_t t) { return boardCelsius(t); });
+    }
+}
+
+/*!
+ * @brief Body to inertial attitude: the initial attitude turned about the
+ * body rate axis
+ */
+SimQuaternion SimOrbit::attitude(uint64_t timeUs)
+{
+    double        half = rateRad * (timeUs / 1e6) / 2;
+    double        s    = sin(half);
+    SimQuaternion a    = config.attitude;
+    SimQuaternion b    = { cos(half), rateAxis.x * s, rateAxis.y * s, rateAxis.z * s };
+    
+    return { a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+             a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+             a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+             a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w };
+}
+
+SimVector3 SimOrbit::sunBody(uint64_t timeUs)
+{
+    return simRotateInverse(attitude(timeUs), lookup(timeUs).sun);
+}
+
+SimVector3 SimOrbit::fieldBody(uint64_t timeUs)
+{
+    return simRotateInverse(attitude(timeUs), lookup(timeUs).field);
+}
+
+/*!
+ * @brief   The body field in the AK8963's axes, which are the MPU-9250's
+ *          (the body frame) with x and y swapped and z inverted
+ */
+SimVector3 SimOrbit::fieldMagnetometer(uint64_t timeUs)
+{
+    SimVector3 body = fieldBody(timeUs);
+    return { body.y, body.x, -body.z };
+}
+
+double SimOrbit::sunlit(uint64_t timeUs)
+{
+    return lookup(timeUs).sunlit;
+}
+
+double SimOrbit::panelCelsius(uint64_t timeUs)
+{
+    return lookup(timeUs).panel;
+}
+
+double SimOrbit::boardCelsius(uint64_t timeUs)
+{
+    return lookup(timeUs).board;
+}
+
+/*!
+ * @brief View factor of a +Z facing plate to the Earth
+ */
+double SimOrbit::earthView(const SimQuaternion& q, const SimVector3& nadir)
+{
+    double ratio = SIM_ORBIT_EARTH_RADIUS_KM / radiusKm;
+    double z     = simRotateInverse(q, nadir).z;
+    
+    return z > 0 ? ratio * ratio * z : 0;
+}
+
+/*!
+ * @brief Solar sensor: direct sun plus Earth albedo
+ */
+double SimOrbit::solarCounts(uint64_t timeUs)
+{
+    SimQuaternion q = attitude(timeUs);
+    Sample        s = lookup(timeUs);
+    double        z = simRotateInverse(q, s.sun).z;
+    double        direct = (z > 0) ? s.sunlit * z : 0;
+    
+    return SIM_ORBIT_SOLAR_FULL_COUNTS * (direct + SIM_ORBIT_ALBEDO * s.dayside * earthView(q, s.nadir));
+}
+
+/*!
+ * @brief IR sensor: rises as it turns towards the Earth
+ */
+double SimOrbit::irCounts(uint64_t timeUs)
+{
+    double z = simRotateInverse(attitude(timeUs), lookup(timeUs).nadir).z;
+    
+    return SIM_ORBIT_IR_DARK_COUNTS + SIM_ORBIT_IR_EARTH_COUNTS * (z > 0 ? z : 0);
+}
+
+/*!
+ * @brief ADC counts of an analog temperature sensor at celsius
+ */
+double SimOrbit::temperatureCounts(double celsius)
+{
+    double volts  = SIM_ORBIT_TEMP_OFFSET_VOLTS + SIM_ORBIT_TEMP_VOLTS_PER_C * celsius;
+    double counts = volts / SIM_ORBIT_ADC_VOLTS * 1023;
+    
+    return counts < 0 ? 0 : (counts > 1023 ? 1023 : counts);
+}
+
+/*!
+ * @brief Propagates the next SIM_ORBIT_BATCH steps. The thermal model is
+ * integrated with forward Euler steps; its time constants are minutes.
+ */
+void SimOrbit::propagate()
+{
+    const double step    = SIM_ORBIT_STEP_US / 1e6;
+    const double sinInc  = sin(config.inclinationDeg * DEG), cosInc  = cos(config.inclinationDeg * DEG);
+    const double sinRaan = sin(config.raanDeg * DEG),        cosRaan = cos(config.raanDeg * DEG);
+    const double sinObl  = sin(SIM_ORBIT_OBLIQUITY_DEG * DEG), cosObl = cos(SIM_ORBIT_OBLIQUITY_DEG * DEG);
+    const double ratio   = SIM_ORBIT_EARTH_RADIUS_KM / radiusKm;
+    const double dipoleScale = SIM_ORBIT_DIPOLE_UT * ratio * ratio * ratio;
+    
+    batches.emplace_back();
+    Batch& batch = batches.back();
+    
+    for (int i = 0; i < SIM_ORBIT_BATCH; i++) {
+        double t = (nextStep + i) * step;
+        
+        // Position on the circular orbit and the sun, inertial frame
+        double u  = config.latitudeArgDeg * DEG + meanMotion * t;
+        double rx = cosRaan * cos(u) - sinRaan * sin(u) * cosInc;
+        double ry = sinRaan * cos(u) + cosRaan * sin(u) * cosInc;
+        double rz = sin(u) * sinInc;
+        
+        double lambda = config.sunLongitudeDeg * DEG + 2 * M_PI * t / SIM_ORBIT_YEAR_S;
+        double sx = cos(lambda), sy = cosObl * sin(lambda), sz = sinObl * sin(lambda);
+        
+        // Cylindrical shadow behind the Earth
+        double along  = rx * sx + ry * sy + rz * sz;
+        double sunlit = (along < 0 && 1 - along * along < ratio * ratio) ? 0 : 1;
+        
+        // Dipole turned with the Earth: B = B0 (Re/r)^3 (3 (m.r) r - m)
+        double theta = config.greenwichDeg * DEG + SIM_ORBIT_EARTH_RATE * t;
+        double mx = cos(theta) * dipole.x - sin(theta) * dipole.y;
+        double my = sin(theta) * dipole.x + cos(theta) * dipole.y;
+        double mz = dipole.z;
+        double mr = mx * rx + my * ry + mz * rz;
+        
+        batch.sun[0][i]   = (float)sx;
+        batch.sun[1][i]   = (float)sy;
+        batch.sun[2][i]   = (float)sz;
+        batch.sunlit[i]   = (float)sunlit;
+        batch.field[0][i] = (float)(dipoleScale * (3 * mr * rx - mx));
+        batch.field[1][i] = (float)(dipoleScale * (3 * mr * ry - my));
+        batch.field[2][i] = (float)(dipoleScale * (3 * mr * rz - mz));
+        batch.nadir[0][i] = (float)-rx;
+        batch.nadir[1][i] = (float)-ry;
+        batch.nadir[2][i] = (float)-rz;
+        batch.dayside[i]  = (float)(along > 0 ? along : 0);
+        batch.panel[i]    = (float)(panelKelvin - KELVIN);
+        batch.board[i]    = (float)(boardKelvin - KELVIN);
+        
+        // Heat balance of the +Z panel and the board behind it
+        SimQuaternion q      = attitude((uint64_t)(t * 1e6));
+        SimVector3    normal = simRotate(q, { 0, 0, 1 });
+        SimVector3    nadir  = { -rx, -ry, -rz };
+        double cosSun  = normal.x * sx + normal.y * sy + normal.z * sz;
+        double view    = earthView(q, nadir);
+        double flux    = config.panelAbsorptivity * SIM_ORBIT_SOLAR_FLUX *
+                         ((cosSun > 0 ? sunlit * cosSun : 0) + SIM_ORBIT_ALBEDO * batch.dayside[i] * view) +
+                         config.panelEmissivity * SIM_ORBIT_EARTH_IR_FLUX * view;
+        double t2      = panelKelvin * panelKelvin;
+        double radiated = config.panelEmissivity * SIM_ORBIT_STEFAN_BOLTZMANN * t2 * t2;
+        double conducted = config.conductance * (panelKelvin - boardKelvin);
+        
+        panelKelvin += step * (config.panelAreaM2 * (flux - radiated) - conducted) / config.panelHeatCapacity;
+        boardKelvin += step * (config.boardPowerW + conducted) / config.boardHeatCapacity;
+    }
+    
+    nextStep += SIM_ORBIT_BATCH;
+    if (batches.size() > SIM_ORBIT_RETAIN_BATCHES) {
+        batches.pop_front();
+        firstStep += SIM_ORBIT_BATCH;
+    }
+}
+
+/*!
+ * @brief Environment at timeUs, interpolated between the steps around it.
+ * Propagates as far as needed.
+ */
+SimOrbit::Sample SimOrbit::lookup(uint64_t timeUs)
+{
+    uint64_t step     = timeUs / SIM_ORBIT_STEP_US;
+    double   fraction = (double)(timeUs % SIM_ORBIT_STEP_US) / SIM_ORBIT_STEP_US;
+    
+    while (step + 1 >= nextStep) {
+        propagate();
+    }
+    if (step < firstStep) {
+        step     = firstStep;
+        fraction = 0;
+    }
+    
+    uint64_t a  = step - firstStep;
+    uint64_t b  = a + 1;
+    const Batch& ba = batches[a / SIM_ORBIT_BATCH];
+    const Batch& bb = batches[b / SIM_ORBIT_BATCH];
+    size_t   ia = a % SIM_ORBIT_BATCH;
+    size_t   ib = b % SIM_ORBIT_BATCH;
+    
+    auto lerp = [fraction](float x, float y) { return x + (y - x) * fraction; };
+    
+    Sample s;
+    s.sun     = { lerp(ba.sun[0][ia], bb.sun[0][ib]),   lerp(ba.sun[1][ia], bb.sun[1][ib]),   lerp(ba.sun[2][ia], bb.sun[2][ib]) };
+    s.field   = { lerp(ba.field[0][ia], bb.field[0][ib]), lerp(ba.field[1][ia], bb.field[1][ib]), lerp(ba.field[2][ia], bb.field[2][ib]) };
+    s.nadir   = { lerp(ba.nadir[0][ia], bb.nadir[0][ib]), lerp(ba.nadir[1][ia], bb.nadir[1][ib]), lerp(ba.nadir[2][ia], bb.nadir[2][ib]) };
+    s.sunlit  = lerp(ba.sunlit[ia],  bb.sunlit[ib]);
+    s.dayside = lerp(ba.dayside[ia], bb.dayside[ib]);
+    s.panel   = lerp(ba.panel[ia],   bb.panel[ib]);
+    s.board   = lerp(ba.board[ia],   bb.board[ib]);
+    return s;
+}
+
+
+} /* namespace sim */
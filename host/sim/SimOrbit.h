@@ -0,0 +1,191 @@
+/**
+ *  @file   SimOrbit.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Orbit environment of the payload: where it is, where the sun
+ *          is, what field it flies through, how it is tumbling and how warm
+ *          it is, as inputs for the simulated sensors.
+ *
+ *          Models:
+ *          - Circular LEO orbit of a given altitude, inclination, right
+ *            ascension of the ascending node and initial argument of latitude
+ *          - Sun direction from its ecliptic longitude, advancing one turn
+ *            per year, with a cylindrical Earth shadow
+ *          - Tilted dipole geomagnetic field, rotating with the Earth
+ *          - Torque-free tumble at a constant body rate
+ *          - Two-node thermal model: the external panel, heated by the sun,
+ *            Earth albedo and Earth IR and radiating to space, conducting to
+ *            the board, which dissipates the payload's power
+ *
+ *          The panel, the Solar and IR sensors face body +Z. The environment
+ *          is propagated in batches of SIM_ORBIT_BATCH steps of
+ *          SIM_ORBIT_STEP_US, stored as arrays of inertial-frame quantities;
+ *          lookups interpolate between steps and rotate into the body frame
+ *          at the exact query time, so the tumble is not sampled. The last
+ *          SIM_ORBIT_RETAIN_BATCHES batches are kept; earlier times read the
+ *          oldest kept step.
+ *
+ * @code
+ *  sim::SimTslpbBoard board;
+ *  sim::SimBNO055     bno;
+ *  sim::SimOrbit      orbit;       // sim::simDefaultOrbitConfig
+ *
+ *  hal::reset();
+ *  board.attach();
+ *  hal::attachI2cDevice(BNO055_ADDRESS_A, &bno);
+ *  orbit.attach(board, &bno, NULL);
+ *
+ *  setup();
+ *  while (hal::now() < 5520000000ULL) loop();  // one orbit
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimOrbit_h
+#define SimOrbit_h
+
+#include "SimTypes.h"
+#include "SimTslpbBoard.h"
+#include "SimBNO055.h"
+#include "SimBMP280.h"
+
+#include <deque>
+
+
+namespace sim {
+
+
+#define SIM_ORBIT_STEP_US               1000000     ///< Propagation step
+#define SIM_ORBIT_BATCH                 1024        ///< Steps propagated at a time
+#define SIM_ORBIT_RETAIN_BATCHES        8           ///< Batches kept for lookups
+
+#define SIM_ORBIT_EARTH_RADIUS_KM       6371.0
+#define SIM_ORBIT_EARTH_MU              398600.4418 ///< km^3/s^2
+#define SIM_ORBIT_EARTH_RATE            7.2921159e-5    ///< rad/s
+#define SIM_ORBIT_YEAR_S                31558149.8  ///< Sidereal year
+#define SIM_ORBIT_OBLIQUITY_DEG         23.44
+#define SIM_ORBIT_DIPOLE_UT             29.4        ///< Equatorial surface field of the dipole
+#define SIM_ORBIT_DIPOLE_LAT_DEG        80.7        ///< Geomagnetic north pole
+#define SIM_ORBIT_DIPOLE_LON_DEG        -72.7
+
+#define SIM_ORBIT_SOLAR_FLUX            1361.0      ///< W/m^2
+#define SIM_ORBIT_EARTH_IR_FLUX         237.0       ///< W/m^2
+#define SIM_ORBIT_ALBEDO                0.3
+#define SIM_ORBIT_STEFAN_BOLTZMANN      5.670374e-8
+
+#define SIM_ORBIT_SOLAR_FULL_COUNTS     1000.0      ///< Solar sensor reading in full sun, normal incidence
+#define SIM_ORBIT_IR_DARK_COUNTS        100.0       ///< IR sensor reading facing deep space
+#define SIM_ORBIT_IR_EARTH_COUNTS       600.0       ///< IR sensor increase facing the Earth
+#define SIM_ORBIT_ADC_VOLTS             3.3         ///< ADC reference
+#define SIM_ORBIT_TEMP_OFFSET_VOLTS     0.5         ///< Analog temperature sensors at 0 °C
+#define SIM_ORBIT_TEMP_VOLTS_PER_C      0.01
+
+
+/*!
+ * @brief   Orbit, attitude and thermal parameters
+ */
+typedef struct
+{
+    double          altitudeKm;
+    double          inclinationDeg;
+    double          raanDeg;                ///< Right ascension of the ascending node
+    double          latitudeArgDeg;         ///< Argument of latitude at time 0
+    double          sunLongitudeDeg;        ///< Ecliptic longitude of the sun at time 0
+    double          greenwichDeg;           ///< Greenwich sidereal angle at time 0
+    
+    SimQuaternion   attitude;               ///< Body to inertial at time 0
+    SimVector3      bodyRateDps;            ///< Constant tumble rate in the body frame
+    
+    double          panelAreaM2;
+    double          panelAbsorptivity;
+    double          panelEmissivity;
+    double          panelHeatCapacity;      ///< J/K
+    double          boardHeatCapacity;      ///< J/K
+    double          conductance;            ///< Panel to board, W/K
+    double          boardPowerW;            ///< Dissipated on the board
+    double          panelCelsius;           ///< At time 0
+    double          boardCelsius;           ///< At time 0
+} SimOrbitConfig;
+
+extern const SimOrbitConfig simDefaultOrbitConfig;
+
+
+class SimOrbit
+{
+    
+public:
+    SimOrbit(const SimOrbitConfig& config = simDefaultOrbitConfig);
+    
+    void     attach(SimTslpbBoard& board, SimBNO055* bno, SimBMP280* bmp);
+    
+    SimQuaternion attitude(uint64_t timeUs);
+    SimVector3    angularRate() { return config.bodyRateDps; }
+    SimVector3    sunBody(uint64_t timeUs);
+    SimVector3    fieldBody(uint64_t timeUs);
+    SimVector3    fieldMagnetometer(uint64_t timeUs);
+    double        sunlit(uint64_t timeUs);
+    double        panelCelsius(uint64_t timeUs);
+    double        boardCelsius(uint64_t timeUs);
+    
+    double        solarCounts(uint64_t timeUs);
+    double        irCounts(uint64_t timeUs);
+    static double temperatureCounts(double celsius);
+    
+private:
+    
+    /*!
+     * @brief   One batch of propagated steps, inertial frame
+     */
+    typedef struct
+    {
+        float   sun[3][SIM_ORBIT_BATCH];    ///< Unit sun vector
+        float   sunlit[SIM_ORBIT_BATCH];    ///< 1 in sunlight, 0 in the Earth's shadow
+        float   field[3][SIM_ORBIT_BATCH];  ///< Geomagnetic field (µT)
+        float   nadir[3][SIM_ORBIT_BATCH];  ///< Unit vector to the Earth's center
+        float   dayside[SIM_ORBIT_BATCH];   ///< Cosine of the sun's zenith angle below the payload, 0 at night
+        float   panel[SIM_ORBIT_BATCH];     ///< Panel temperature (°C)
+        float   board[SIM_ORBIT_BATCH];     ///< Board temperature (°C)
+    } Batch;
+    
+    /*!
+     * @brief   A step's quantities, interpolated
+     */
+    typedef struct
+    {
+        SimVector3  sun;
+        double      sunlit;
+        SimVector3  field;
+        SimVector3  nadir;
+        double      dayside;
+        double      panel;
+        double      board;
+    } Sample;
+    
+    void     propagate();
+    Sample   lookup(uint64_t timeUs);
+    double   earthView(const SimQuaternion& q, const SimVector3& nadir);
+    
+    SimOrbitConfig  config;
+    
+    double          radiusKm;
+    double          meanMotion;             ///< rad/s
+    SimVector3      dipole;                 ///< Unit dipole moment, Earth fixed
+    double          rateRad;                ///< |bodyRate| in rad/s
+    SimVector3      rateAxis;               ///< Body rate direction
+    
+    std::deque<Batch>   batches;
+    uint64_t        firstStep       = 0;    ///< Step index of batches.front()[0]
+    uint64_t        nextStep        = 0;    ///< First step not propagated
+    double          panelKelvin;            ///< Thermal state at nextStep
+    double          boardKelvin;
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimOrbit_h */
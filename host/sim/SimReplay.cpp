@@ -0,0 +1,326 @@
+/**
+ *  @file   SimReplay.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Drives the simulated payload with recorded science frames
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimReplay.h"
+#include "TSLPB_Quaternion.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+namespace sim {
+
+
+#define REPLAY_QUAT_PER_COUNT   (1.0 / (1 << 14))  ///< Adafruit_BNO055::getQuat() scale
+#define REPLAY_BNOMAG_PER_COUNT (1.0 / 16.0)       ///< Adafruit_BNO055::getVector() scale (µT)
+#define REPLAY_BNOMAG_SCALE     10                 ///< Sketch: bnomag = field * 10
+#define REPLAY_AK8963_UT        0.15               ///< TSLPB::begin() selects 16-bit output
+#define REPLAY_AK8963_LIMIT     32760              ///< Largest 16-bit output
+#define REPLAY_MET_TICK_S       0.1
+#define REPLAY_COUNT_SEARCH     64                 ///< Register counts tried either side of the estimate
+
+
+const char* const simReplayFieldNames[SIM_REPLAY_FIELD_COUNT] = {
+    "header", "met", "sampleAge", "quat", "bnomag", "bnoCal", "bmePres", "bmeTemp",
+    "tslTempExt", "tslVolts", "tslCurrent", "solar", "tslMag", "refreshed"
+};
+
+static const TSLPB_AnalogSensor_t analogSensors[4] = { TempExt, Voltage, Current, Solar };
+
+
+SimReplay::SimReplay(SimTslpbBoard& board, SimBNO055& bno, SimBMP280& bmp) :
+    board(board), bno(bno), bmp(bmp)
+{
+    inputs.orientation = { 1, 0, 0, 0 };
+}
+
+/*!
+ * @brief Points every model input at the frame being replayed and attaches
+ * the BNO055 and BMP280. Call after SimTslpbBoard::attach().
+ */
+void SimReplay::attach()
+{
+    SimReplayInputs* current = &inputs;
+    
+    bno.setOrientationProvider([current](uint64_t) { return current->orientation; });
+    bno.setFieldProvider([current](uint64_t) { return current->bnoField; });
+    bno.setCalibrationProvider([current](uint64_t) { return (double)current->bnoCalibration; });
+    bmp.setRawProvider([current](uint64_t) { return current->bmp; });
+    board.mag.setFieldProvider([current](uint64_t) { return current->tslField; });
+    board.imu.setAngularRateProvider([current](uint64_t) { return current->angularRate; });
+    
+    for (int i = 0; i < 4; i++) {
+        board.setAnalogSensorProvider(analogSensors[i], [current, i](uint64_t) {
+            return (double)current->analog[i];
+        });
+    }
+    
+    hal::attachI2cDevice(BNO055_ADDRESS_A, &bno);
+    hal::attachI2cDevice(BMP280_ADDRESS, &bmp);
+}
+
+/*!
+ * @brief Returns a register count for which the sketch's
+ * (int16_t)(count * perCount * scale) gives value, or the nearest count and
+ * false if there is none.
+ */
+static bool findCount(int16_t value, double perCount, int scale, int16_t& count)
+{
+    double estimate = value / (perCount * scale);
+    long   center   = lround(estimate);
+    
+    for (long offset = 0; offset <= REPLAY_COUNT_SEARCH; offset++) {
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            long candidate = center + sign * offset;
+            if (candidate < INT16_MIN || candidate > INT16_MAX) {
+                continue;
+            }
+            double product = (candidate * perCount) * scale;
+            if (product > INT16_MIN - 1 && product < INT16_MAX + 1 && (int16_t)product == value) {
+                count = (int16_t)candidate;
+                return true;
+            }
+        }
+    }
+    count = (int16_t)fmax(INT16_MIN, fmin(INT16_MAX, estimate));
+    return false;
+}
+
+/*!
+ * @brief Sets the model inputs that make the next pass of loop() record
+ * the fields of record
+ */
+void SimReplay::setFrame(const ground::ScienceRecord& record)
+{
+    int16_t count;
+    bool    found;
+    
+    inputs.unreachable = 0;
+    
+    // The sketch packs the BNO055's Q14 counts, which the unpacked quaternion
+    // already is. Near ties between the two largest components, packing it
+    // again can drop the other one.
+    inputs.orientation = { record.quat[0] * REPLAY_QUAT_PER_COUNT, record.quat[1] * REPLAY_QUAT_PER_COUNT,
+                           record.quat[2] * REPLAY_QUAT_PER_COUNT, record.quat[3] * REPLAY_QUAT_PER_COUNT };
+    if (tslPackQuaternion(record.quat) != record.quatPacked) {
+        inputs.unreachable |= 1 << ReplayQuat;
+    }
+    
+    // The sketch stores BNO055 x in bnomagy, y in bnomagz and z in bnomagx
+    const int16_t bnoAxes[3] = { record.bnomag[1], record.bnomag[2], record.bnomag[0] };
+    double        field[3];
+    found = true;
+    for (int i = 0; i < 3; i++) {
+        found   &= findCount(bnoAxes[i], REPLAY_BNOMAG_PER_COUNT, REPLAY_BNOMAG_SCALE, count);
+        field[i] = count * REPLAY_BNOMAG_PER_COUNT;
+    }
+    inputs.bnoField = { field[0], field[1], field[2] };
+    if (!found) {
+        inputs.unreachable |= 1 << ReplayBnoMag;
+    }
+    
+    inputs.bnoCalibration = record.bnoCal;
+    inputs.tslField = { record.tslMag[0] * REPLAY_AK8963_UT,
+                        record.tslMag[1] * REPLAY_AK8963_UT,
+                        record.tslMag[2] * REPLAY_AK8963_UT };
+    for (int i = 0; i < 3; i++) {
+        if (abs(record.tslMag[i]) > REPLAY_AK8963_LIMIT) {
+            inputs.unreachable |= 1 << ReplayTslMag;
+        }
+    }
+    
+    const uint16_t analog[4] = { record.tslTempExt, record.tslVolts, record.tslCurrent, record.solar };
+    memcpy(inputs.analog, analog, sizeof(analog));
+    
+    findBmpCodes(record.bmeTemp, record.bmePres);
+    estimateRate(record);
+}
+
+/*!
+ * @brief The sketch's readings for a pair of ADC codes: the Adafruit driver
+ * converts to float and the sketch scales by 10 and truncates.
+ */
+static int16_t sketchTemperature(SimBMP280& bmp, uint32_t adcT, int32_t& tFine)
+{
+    float T = bmp.compensateTemperature(adcT, tFine);
+    return (int16_t)((T / 100) * 10);
+}
+
+static uint32_t sketchPressure(SimBMP280& bmp, uint32_t adcP, int32_t tFine)
+{
+    float p = (float)bmp.compensatePressure(adcP, tFine) / 256 * 10;
+    return p <= 0 ? 0 : (uint32_t)(unsigned long)p & 0xFFFFFF;
+}
+
+/*!
+ * @brief Finds BMP280 ADC codes that give temperature and pressure. The
+ * pressure code steps about 0.16 Pa, coarser than the 0.1 Pa field, so every
+ * temperature code that rounds to the recorded temperature is tried: each
+ * one shifts the pressure scale by a fraction of a step.
+ */
+void SimReplay::findBmpCodes(int16_t temperature, uint32_t pressure)
+{
+    int32_t  tFine;
+    uint32_t low  = 0;
+    uint32_t high = SIM_BMP280_ADC_MAX;
+    
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (sketchTemperature(bmp, middle, tFine) < temperature) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    uint32_t bestT     = low;
+    uint32_t bestP     = 0;
+    int64_t  bestError = INT64_MAX;
+    int32_t  lastFine  = INT32_MIN;
+    
+    for (uint32_t adcT = low; adcT <= SIM_BMP280_ADC_MAX && bestError != 0; adcT++) {
+        if (sketchTemperature(bmp, adcT, tFine) != temperature) {
+            break;
+        }
+        if (tFine == lastFine) {
+            continue;
+        }
+        lastFine = tFine;
+        
+        // Pressure falls as the code rises
+        uint32_t pLow  = 0;
+        uint32_t pHigh = SIM_BMP280_ADC_MAX;
+        while (pLow < pHigh) {
+            uint32_t middle = (pLow + pHigh) / 2;
+            if (sketchPressure(bmp, middle, tFine) > pressure) {
+                pLow = middle + 1;
+            } else {
+                pHigh = middle;
+            }
+        }
+        for (uint32_t adcP = (pLow > 0 ? pLow - 1 : 0); adcP <= pLow; adcP++) {
+            int64_t error = llabs((int64_t)sketchPressure(bmp, adcP, tFine) - (int64_t)pressure);
+            if (error < bestError) {
+                bestError = error;
+                bestT     = adcT;
+                bestP     = adcP;
+            }
+        }
+    }
+    
+    inputs.bmp.temperature = bestT;
+    inputs.bmp.pressure    = bestP;
+    if (sketchTemperature(bmp, bestT, tFine) != temperature) {
+        inputs.unreachable |= 1 << ReplayBmeTemp;
+    }
+    if (bestError != 0) {
+        inputs.unreachable |= 1 << ReplayBmePres;
+    }
+}
+
+/*!
+ * @brief Sets the MPU-9250 rate to the rotation between the last two
+ * distinct recorded attitudes, in the BNO055 body axes
+ */
+void SimReplay::estimateRate(const ground::ScienceRecord& record)
+{
+    if (haveAttitude && !memcmp(attitude, record.quat, sizeof(attitude))) {
+        return;
+    }
+    
+    double a[4], b[4], normA = 0, normB = 0;
+    for (int i = 0; i < 4; i++) {
+        a[i]   = attitude[i];
+        b[i]   = record.quat[i];
+        normA += a[i] * a[i];
+        normB += b[i] * b[i];
+    }
+    
+    uint32_t ticks = (record.met - attitudeMet) & TSL_MET_MASK;
+    bool     valid = haveAttitude && ticks > 0 && normA > 0 && normB > 0;
+    
+    memcpy(attitude, record.quat, sizeof(attitude));
+    attitudeMet  = record.met;
+    haveAttitude = true;
+    
+    if (!valid) {
+        inputs.angularRate = { 0, 0, 0 };
+        return;
+    }
+    
+    // conj(a) * b is the rotation from a to b in the body frame
+    double w =  a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    double x =  a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+    double y =  a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1];
+    double z =  a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0];
+    double v = sqrt(x * x + y * y + z * z);
+    
+    if (w < 0) {
+        w = -w; x = -x; y = -y; z = -z;     // Shortest rotation
+    }
+    if (v == 0) {
+        inputs.angularRate = { 0, 0, 0 };
+        return;
+    }
+    
+    double degrees = 2 * atan2(v, w) * 180 / M_PI;
+    double dps     = degrees / (ticks * REPLAY_MET_TICK_S);
+    inputs.angularRate = { x / v * dps, y / v * dps, z / v * dps };
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Frame Diff                    │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief Compares two science frames. Returns a bit per SimReplayField that
+ * differs, 0 if the frames are identical.
+ */
+uint32_t diffFrames(const uint8_t* original, const uint8_t* replayed)
+{
+    if (!memcmp(original, replayed, NSL_PACKET_SIZE)) {
+        return 0;
+    }
+    
+    static const struct { SimReplayField field; uint8_t offset; uint8_t length; } ranges[] = {
+        { ReplayHeader,     0,                      NSL_PACKET_HEADER_LENGTH },
+        { ReplayMet,        GROUND_OFFSET_MET,      3 },
+        { ReplaySampleAge,  GROUND_OFFSET_AGE,      1 },
+        { ReplayRefreshed,  GROUND_OFFSET_REFRESHED, 1 },
+        { ReplayQuat,       GROUND_OFFSET_QUAT,     4 },
+        { ReplayBnoMag,     GROUND_OFFSET_BNOMAG,   6 },
+        { ReplayBnoCal,     GROUND_OFFSET_BNOCAL,   1 },
+        { ReplayBmePres,    GROUND_OFFSET_BMEPRES,  3 },
+        { ReplayBmeTemp,    GROUND_OFFSET_BMETEMP,  2 },
+        { ReplayTslMag,     GROUND_OFFSET_TSLMAG,   6 }
+    };
+    
+    uint32_t differences = 0;
+    for (const auto& range : ranges) {
+        if (memcmp(&original[range.offset], &replayed[range.offset], range.length)) {
+            differences |= 1 << range.field;
+        }
+    }
+    
+    ground::ScienceRecord a, b;
+    ground::decodeScience(original, a);
+    ground::decodeScience(replayed, b);
+    if (a.tslTempExt != b.tslTempExt)  differences |= 1 << ReplayTempExt;
+    if (a.tslVolts   != b.tslVolts)    differences |= 1 << ReplayVolts;
+    if (a.tslCurrent != b.tslCurrent)  differences |= 1 << ReplayCurrent;
+    if (a.solar      != b.solar)       differences |= 1 << ReplaySolar;
+    
+    return differences;
+}
+
+
+} /* namespace sim */
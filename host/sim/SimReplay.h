@@ -0,0 +1,135 @@
+/**
+ *  @file   SimReplay.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Drives the simulated payload with the readings of recorded
+ *          science frames, so the firmware can be re-run against the
+ *          conditions that produced a downlink.
+ *
+ *          For each recorded frame the replay works out register contents
+ *          that make the firmware's own arithmetic give back the recorded
+ *          field: the BNO055 quaternion counts that pack to quat, the field
+ *          counts that truncate to bnomagx - bnomagz (with the sketch's axis
+ *          order), the BMP280 ADC codes whose compensated, float-converted
+ *          readings truncate to bmePres and bmeTemp, AK8963 fields that
+ *          quantize to tslMagXraw - tslMagZraw, and the four mux ADC counts.
+ *          The providers return the inputs of the frame being replayed,
+ *          whatever virtual time a model samples them at, so every reading
+ *          taken during a pass of loop() sees that frame's values.
+ *
+ *          The frames do not carry the TSLPB gyro, which only sets the
+ *          attitude channel's sample period. The MPU-9250 is given the
+ *          angular rate between the last two distinct recorded attitudes
+ *          instead. LM75A readings are not in the frames either and keep
+ *          their defaults; the sketch does not read them.
+ *
+ * @code
+ *  sim::SimTslpbBoard board;
+ *  sim::SimBNO055     bno;
+ *  sim::SimBMP280     bmp;
+ *  sim::SimReplay     replay(board, bno, bmp);
+ *
+ *  hal::reset();
+ *  board.attach();
+ *  replay.attach();
+ *  replay.setFrame(recorded[0]);
+ *  setup();
+ *  for (each recorded frame) {
+ *      replay.setFrame(record);
+ *      loop();
+ *  }
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimReplay_h
+#define SimReplay_h
+
+#include "SimTslpbBoard.h"
+#include "SimBNO055.h"
+#include "SimBMP280.h"
+#include "ThinSatDecoder.h"
+
+
+namespace sim {
+
+
+/*!
+ * @brief   Science frame fields, as compared by diffFrames()
+ */
+typedef enum
+{
+    ReplayHeader        = 0,
+    ReplayMet           = 1,
+    ReplaySampleAge     = 2,
+    ReplayQuat          = 3,
+    ReplayBnoMag        = 4,
+    ReplayBnoCal        = 5,
+    ReplayBmePres       = 6,
+    ReplayBmeTemp       = 7,
+    ReplayTempExt       = 8,
+    ReplayVolts         = 9,
+    ReplayCurrent       = 10,
+    ReplaySolar         = 11,
+    ReplayTslMag        = 12,
+    ReplayRefreshed     = 13,
+    SIM_REPLAY_FIELD_COUNT
+} SimReplayField;
+
+extern const char* const simReplayFieldNames[SIM_REPLAY_FIELD_COUNT];
+
+
+/*!
+ * @brief   Model inputs that reproduce one recorded frame
+ */
+typedef struct
+{
+    SimQuaternion   orientation;        ///< BNO055 quaternion
+    SimVector3      bnoField;           ///< BNO055 field (µT, BNO055 axes)
+    uint8_t         bnoCalibration;     ///< BNO055 CALIB_STAT
+    SimBmp280Raw    bmp;                ///< BMP280 ADC codes
+    SimVector3      tslField;           ///< AK8963 field (µT)
+    SimVector3      angularRate;        ///< MPU-9250 rate (dps), estimated
+    uint16_t        analog[4];          ///< TempExt, Voltage, Current, Solar ADC counts
+    uint32_t        unreachable;        ///< Bit per SimReplayField no input reproduces
+} SimReplayInputs;
+
+
+class SimReplay
+{
+    
+public:
+    SimReplay(SimTslpbBoard& board, SimBNO055& bno, SimBMP280& bmp);
+    
+    void     attach();
+    void     setFrame(const ground::ScienceRecord& record);
+    
+    const SimReplayInputs& getInputs() { return inputs; }
+    
+private:
+    
+    void     findBmpCodes(int16_t temperature, uint32_t pressure);
+    void     estimateRate(const ground::ScienceRecord& record);
+    
+    SimTslpbBoard&  board;
+    SimBNO055&      bno;
+    SimBMP280&      bmp;
+    
+    SimReplayInputs inputs          = {};
+    int16_t         attitude[4]     = {};       ///< Last recorded quaternion
+    uint32_t        attitudeMet     = 0;        ///< MET of the frame it first appeared in
+    bool            haveAttitude    = false;
+    
+};
+
+
+uint32_t    diffFrames(const uint8_t* original, const uint8_t* replayed);
+
+
+} /* namespace sim */
+
+
+#endif /* SimReplay_h */
@@ -0,0 +1,90 @@
+/**
+ *  @file   SimTslpbBoard.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  The simulated TSL Payload Board
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "SimTslpbBoard.h"
+
+
+namespace sim {
+
+
+const uint8_t SimTslpbBoard::dtAddress[SIM_TSLPB_DT_COUNT] = {
+    DT1_ADDRESS, DT2_ADDRESS, DT3_ADDRESS, DT4_ADDRESS, DT5_ADDRESS, DT6_ADDRESS
+};
+
+
+SimTslpbBoard::SimTslpbBoard() : imu(&mag)
+{
+    for (int channel = 0; channel < SIM_TSLPB_MUX_CHANNELS; channel++) {
+        setAnalogSensor((TSLPB_AnalogSensor_t)channel, 0);
+    }
+}
+
+/*!
+ * @brief Attaches the board's devices to the host HAL. Call after
+ * hal::reset(), which detaches everything.
+ */
+void SimTslpbBoard::attach()
+{
+    for (int i = 0; i < SIM_TSLPB_DT_COUNT; i++) {
+        hal::attachI2cDevice(dtAddress[i], &dt[i]);
+    }
+    hal::attachI2cDevice(IMU_ADDRESS, &imu);
+    if (imu.isBypassEnabled()) {
+        hal::attachI2cDevice(MAG_ADDRESS, &mag);
+    }
+    
+    hal::setAnalogInputProvider([this](uint8_t pin, uint64_t timeUs) {
+        return readMux(pin, timeUs);
+    });
+}
+
+/*!
+ * @brief Sets a constant ADC reading (0 - 1023) for one mux input
+ */
+void SimTslpbBoard::setAnalogSensor(TSLPB_AnalogSensor_t sensor, uint16_t value)
+{
+    analog[sensor & 0x07] = [value](uint64_t) { return (double)value; };
+}
+
+/*!
+ * @brief Sets a function of virtual time that gives the ADC reading of one
+ * mux input
+ */
+void SimTslpbBoard::setAnalogSensorProvider(TSLPB_AnalogSensor_t sensor, ScalarProvider provider)
+{
+    analog[sensor & 0x07] = provider;
+}
+
+/*!
+ * @brief Returns the mux channel selected by the TSL_MUX_A/B/C outputs.
+ * MUX_A is the most significant select bit, as in TSLPB::readAnalogSensor().
+ */
+uint8_t SimTslpbBoard::getSelectedChannel()
+{
+    return (hal::getDigitalOutput(TSL_MUX_A) << 2) |
+           (hal::getDigitalOutput(TSL_MUX_B) << 1) |
+            hal::getDigitalOutput(TSL_MUX_C);
+}
+
+uint16_t SimTslpbBoard::readMux(uint8_t pin, uint64_t timeUs)
+{
+    if (pin != TSL_ADC) {
+        return 0;
+    }
+    
+    double value = analog[getSelectedChannel()](timeUs) + 0.5;
+    
+    if (value < 0)    return 0;
+    if (value > 1023) return 1023;
+    return (uint16_t)value;
+}
+
+
+} /* namespace sim */
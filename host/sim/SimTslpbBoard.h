@@ -0,0 +1,72 @@
+/**
+ *  @file   SimTslpbBoard.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  The simulated TSL Payload Board: one model for every device in
+ *          TSLPB_I2CAddress_t and the analog sensor mux.
+ *
+ * @code
+ *  sim::SimTslpbBoard board;
+ *
+ *  hal::reset();
+ *  board.attach();
+ *  board.dt[0].setTemperature(31.5);
+ *  board.mag.setField(20, -5, 42);
+ *  board.setAnalogSensor(Solar, 512);
+ *
+ *  setup();
+ *  loop();
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimTslpbBoard_h
+#define SimTslpbBoard_h
+
+#include "TSLPB.h"
+#include "SimLM75A.h"
+#include "SimMPU9250.h"
+#include "SimAK8963.h"
+
+
+namespace sim {
+
+
+#define SIM_TSLPB_DT_COUNT          6       ///< LM75A sensors DT1 - DT6
+#define SIM_TSLPB_MUX_CHANNELS      8       ///< Inputs of the analog mux
+
+
+class SimTslpbBoard
+{
+    
+public:
+    SimTslpbBoard();
+    
+    void     attach();
+    
+    void     setAnalogSensor(TSLPB_AnalogSensor_t sensor, uint16_t value);
+    void     setAnalogSensorProvider(TSLPB_AnalogSensor_t sensor, ScalarProvider provider);
+    uint8_t  getSelectedChannel();
+    
+    SimLM75A    dt[SIM_TSLPB_DT_COUNT];     ///< DT1 - DT6, in TSLPB_DigitalSensor_t order
+    SimAK8963   mag;                        ///< AK8963, behind the MPU-9250 bypass switch
+    SimMPU9250  imu;                        ///< MPU-9250
+    
+    static const uint8_t dtAddress[SIM_TSLPB_DT_COUNT];
+    
+private:
+    
+    uint16_t readMux(uint8_t pin, uint64_t timeUs);
+    
+    ScalarProvider  analog[SIM_TSLPB_MUX_CHANNELS];
+    
+};
+
+
+} /* namespace sim */
+
+
+#endif /* SimTslpbBoard_h */
@@ -0,0 +1,92 @@
+/**
+ *  @file   SimTypes.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Common types of the host device models. Physical inputs are given
+ *          as functions of virtual time so that a model samples its
+ *          environment at the moment a conversion completes.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef SimTypes_h
+#define SimTypes_h
+
+#include <stdint.h>
+#include <functional>
+
+
+namespace sim {
+
+
+/*!
+ * @brief   A three-axis physical quantity in the sensor's frame
+ */
+typedef struct
+{
+    double  x;
+    double  y;
+    double  z;
+} SimVector3;
+
+/*!
+ * @brief   An orientation as a unit quaternion
+ */
+typedef struct
+{
+    double  w;
+    double  x;
+    double  y;
+    double  z;
+} SimQuaternion;
+
+typedef std::function<double(uint64_t timeUs)>          ScalarProvider;     ///< Scalar input at a virtual time (µs)
+typedef std::function<SimVector3(uint64_t timeUs)>      VectorProvider;     ///< Vector input at a virtual time (µs)
+typedef std::function<SimQuaternion(uint64_t timeUs)>   QuaternionProvider; ///< Orientation at a virtual time (µs)
+
+
+/*!
+ * @brief   Rounds a physical value to the nearest register count and clamps it
+ *          to the register's range.
+ */
+inline int16_t simQuantize(double value, double countsPerUnit, int16_t minCount, int16_t maxCount)
+{
+    double counts = value * countsPerUnit;
+    counts += (counts < 0) ? -0.5 : 0.5;
+    
+    if (counts <= minCount) return minCount;
+    if (counts >= maxCount) return maxCount;
+    return (int16_t)counts;
+}
+
+/*!
+ * @brief   Rotates v by the unit quaternion q: from the body frame into the
+ *          frame q is relative to.
+ */
+inline SimVector3 simRotate(const SimQuaternion& q, const SimVector3& v)
+{
+    // v' = v + 2 r x (r x v + w v), r = (x, y, z)
+    double tx = q.y * v.z - q.z * v.y + q.w * v.x;
+    double ty = q.z * v.x - q.x * v.z + q.w * v.y;
+    double tz = q.x * v.y - q.y * v.x + q.w * v.z;
+    
+    return { v.x + 2 * (q.y * tz - q.z * ty),
+             v.y + 2 * (q.z * tx - q.x * tz),
+             v.z + 2 * (q.x * ty - q.y * tx) };
+}
+
+/*!
+ * @brief   Rotates v by the conjugate of q: into the body frame
+ */
+inline SimVector3 simRotateInverse(const SimQuaternion& q, const SimVector3& v)
+{
+    return simRotate({ q.w, -q.x, -q.y, -q.z }, v);
+}
+
+
+} /* namespace sim */
+
+
+#endif /* SimTypes_h */
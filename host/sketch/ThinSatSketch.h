@@ -0,0 +1,24 @@
+/**
+ *  @file   ThinSatSketch.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Declarations of the VCSFA_ThinSat sketch entry points and globals
+ *          for host programs that drive the sketch.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatSketch_h
+#define ThinSatSketch_h
+
+#include "TSLPB.h"
+
+void setup();
+void loop();
+
+extern TSLPB            tslpb;
+extern ThinsatPacket_t  missionData;
+
+#endif /* ThinSatSketch_h */
@@ -0,0 +1,13 @@
+/**
+ *  @file   VCSFA_ThinSat_sketch.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Compiles the unmodified VCSFA_ThinSat sketch as a C++ translation
+ *          unit for the host build. The sketch's setup() and loop() are called
+ *          by the host programs.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include "VCSFA_ThinSat.ino"
@@ -0,0 +1,93 @@
+/**
+ *  @file   ThinSatTest.h
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Checks shared by the host unit tests.
+ *
+ *          Each test is a plain executable registered with ctest. A failed
+ *          check prints its file, line and expression and the test carries
+ *          on; testResult() prints the totals and returns the exit status.
+ *
+ * @code
+ *  int main()
+ *  {
+ *      TEST_EQUAL(ground::readU16(bytes), 0x1234);
+ *      return test::testResult("decoder_test");
+ *  }
+ * @endcode
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+
+#ifndef ThinSatTest_h
+#define ThinSatTest_h
+
+#include <stdio.h>
+
+
+namespace test {
+
+
+/*!
+ * @brief   Check counters of the running test
+ */
+typedef struct
+{
+    unsigned    checks;
+    unsigned    failures;
+} TestCounts;
+
+
+inline TestCounts& getCounts()
+{
+    static TestCounts counts = {};
+    return counts;
+}
+
+
+inline bool check(bool passed, const char* expression, const char* file, int line)
+{
+    getCounts().checks++;
+    if (!passed) {
+        getCounts().failures++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    }
+    return passed;
+}
+
+
+inline bool checkEqual(long long actual, long long expected, const char* expression, const char* file, int line)
+{
+    getCounts().checks++;
+    if (actual != expected) {
+        getCounts().failures++;
+        fprintf(stderr, "%s:%d: check failed: %s is %lld, expected %lld\n", file, line, expression,
+                actual, expected);
+    }
+    return actual == expected;
+}
+
+
+/*!
+ * @brief   Prints the totals and returns the exit status of the test
+ */
+inline int testResult(const char* name)
+{
+    const TestCounts& counts = getCounts();
+    
+    printf("%s: %u checks, %u failed\n", name, counts.checks, counts.failures);
+    return counts.failures ? 1 : 0;
+}
+
+
+} /* namespace test */
+
+
+#define TEST_CHECK(expression)          test::check((expression), #expression, __FILE__, __LINE__)
+#define TEST_EQUAL(actual, expected)    test::checkEqual((long long)(actual), (long long)(expected), \
+                                                         #actual, __FILE__, __LINE__)
+
+
+#endif /* ThinSatTest_h */
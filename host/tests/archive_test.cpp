@@ -0,0 +1,203 @@
+/**
+ *  @file   archive_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Archive time index search against a plain search of the times
+ *          written.
+ *
+ *          An archive is written with a small index stride and receive times
+ *          that repeat across stride boundaries and jump over gaps. Every
+ *          written time, its neighbours and both ends of the archive are
+ *          looked up with lowerBound(), and random windows with
+ *          findRange(), through the index file, through an index rebuilt
+ *          after the file is deleted or cut short, and after a crash leaves a
+ *          partial record behind.
+ *
+ *          usage: archive_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ThinSatArchive.h"
+#include "ThinSatTest.h"
+
+
+#define ARCHIVE_TEST_RECORDS    5000        ///< Records in the archive
+#define ARCHIVE_TEST_STRIDE     64          ///< Records per index entry
+#define ARCHIVE_TEST_WINDOWS    2000        ///< Random findRange() windows
+
+
+/*!
+ * @brief   Receive times in runs of three equal times, with a gap every
+ *          500 records
+ */
+static std::vector<uint64_t> makeTimes(size_t count)
+{
+    std::vector<uint64_t> times;
+    
+    for (size_t i = 0; i < count; i++) {
+        times.push_back(1000000 + (i / 3) * 100 + (i / 500) * 50000);
+    }
+    return times;
+}
+
+
+static void makeFrame(uint64_t sequence, uint8_t frame[NSL_PACKET_SIZE])
+{
+    memset(frame, 0, NSL_PACKET_SIZE);
+    memset(frame, GROUND_HEADER_BYTE, NSL_PACKET_HEADER_LENGTH);
+    memcpy(&frame[GROUND_OFFSET_MET], &sequence, 3);
+}
+
+
+static bool writeArchive(const std::string& path, const std::vector<uint64_t>& times, size_t from, size_t to)
+{
+    ground::ArchiveWriter writer;
+    uint8_t               frame[NSL_PACKET_SIZE];
+    bool                  ok = writer.open(path, ARCHIVE_TEST_STRIDE);
+    
+    for (size_t i = from; ok && i < to; i++) {
+        makeFrame(i, frame);
+        ok = writer.append(frame, times[i]);
+    }
+    return ok && writer.flush();
+}
+
+
+static uint64_t expectedLowerBound(const std::vector<uint64_t>& times, uint64_t time)
+{
+    return std::lower_bound(times.begin(), times.end(), time) - times.begin();
+}
+
+
+/*!
+ * @brief   Checks every lookup on an open reader against the times written
+ */
+static void checkSearch(const ground::ArchiveReader& archive, const std::vector<uint64_t>& times,
+                        const char* how)
+{
+    bool ok = TEST_EQUAL(archive.size(), times.size());
+    
+    for (uint64_t i = 0; ok && i < archive.size(); i++) {
+        uint64_t sequence = 0;
+        memcpy(&sequence, &archive[i].frame[GROUND_OFFSET_MET], 3);
+        ok = TEST_EQUAL(archive[i].receiveTime, times[i]) && TEST_EQUAL(sequence, i);
+    }
+    
+    std::vector<uint64_t> queries = {0, times.front(), times.back(), times.back() + 1, UINT64_MAX};
+    for (uint64_t time : times) {
+        queries.push_back(time - 1);
+        queries.push_back(time);
+        queries.push_back(time + 1);
+    }
+    for (size_t i = 0; ok && i < queries.size(); i++) {
+        ok = TEST_EQUAL(archive.lowerBound(queries[i]), expectedLowerBound(times, queries[i]));
+    }
+    
+    std::mt19937_64 random(7);
+    std::uniform_int_distribution<uint64_t> pick(times.front() - 1000, times.back() + 1000);
+    for (int i = 0; ok && i < ARCHIVE_TEST_WINDOWS; i++) {
+        uint64_t from = pick(random);
+        uint64_t to   = pick(random);
+        uint64_t first, last;
+        
+        archive.findRange(from, to, first, last);
+        ok = TEST_EQUAL(first, expectedLowerBound(times, from));
+        ok = TEST_EQUAL(last, to > from ? expectedLowerBound(times, to) : first) && ok;
+    }
+    if (!ok) {
+        fprintf(stderr, "  %s\n", how);
+    }
+}
+
+
+int main()
+{
+    char directory[] = "/tmp/archive_testXXXXXX";
+    if (!TEST_CHECK(mkdtemp(directory) != nullptr)) {
+        return test::testResult("archive_test");
+    }
+    std::string path      = std::string(directory) + "/mission.tsa";
+    std::string indexPath = path + ARCHIVE_INDEX_SUFFIX;
+    
+    std::vector<uint64_t> times = makeTimes(ARCHIVE_TEST_RECORDS);
+    std::vector<uint64_t> half(times.begin(), times.begin() + ARCHIVE_TEST_RECORDS / 2);
+    
+    // Written in two sessions, the second reopening the first
+    TEST_CHECK(writeArchive(path, times, 0, half.size()));
+    TEST_CHECK(writeArchive(path, times, half.size(), times.size()));
+    
+    ground::ArchiveReader archive;
+    if (TEST_CHECK(archive.open(path))) {
+        TEST_EQUAL(archive.getIndexStride(), ARCHIVE_TEST_STRIDE);
+        TEST_EQUAL(archive.getIndexSize(), (ARCHIVE_TEST_RECORDS + ARCHIVE_TEST_STRIDE - 1) / ARCHIVE_TEST_STRIDE);
+        TEST_CHECK(!archive.isIndexRebuilt());
+        checkSearch(archive, times, "with the index file");
+    }
+    archive.close();
+    
+    // Times must not run backwards
+    {
+        ground::ArchiveWriter writer;
+        uint8_t               frame[NSL_PACKET_SIZE];
+        
+        makeFrame(0, frame);
+        TEST_CHECK(writer.open(path, ARCHIVE_TEST_STRIDE));
+        TEST_CHECK(!writer.append(frame, times.back() - 1));
+        TEST_EQUAL(errno, EINVAL);
+        TEST_EQUAL(writer.getRecordCount(), times.size());
+    }
+    
+    // A short index, then a missing one, is rebuilt by the reader
+    TEST_EQUAL(truncate(indexPath.c_str(), sizeof(ground::ArchiveIndexHeader) + 10 * sizeof(ground::ArchiveIndexEntry)), 0);
+    if (TEST_CHECK(archive.open(path))) {
+        TEST_CHECK(archive.isIndexRebuilt());
+        checkSearch(archive, times, "with a short index");
+    }
+    archive.close();
+    
+    TEST_EQUAL(unlink(indexPath.c_str()), 0);
+    if (TEST_CHECK(archive.open(path))) {
+        TEST_CHECK(archive.isIndexRebuilt());
+        checkSearch(archive, times, "with a missing index");
+    }
+    archive.close();
+    
+    // A partial record is ignored by readers and cut off by the next writer,
+    // which also restores the index
+    FILE* file = fopen(path.c_str(), "ab");
+    if (TEST_CHECK(file != nullptr)) {
+        fwrite("partial record", 1, 14, file);
+        fclose(file);
+    }
+    if (TEST_CHECK(archive.open(path))) {
+        checkSearch(archive, times, "with a partial record");
+    }
+    archive.close();
+    
+    std::vector<uint64_t> more = makeTimes(ARCHIVE_TEST_RECORDS + 100);
+    TEST_CHECK(writeArchive(path, more, times.size(), more.size()));
+    if (TEST_CHECK(archive.open(path))) {
+        TEST_CHECK(!archive.isIndexRebuilt());
+        checkSearch(archive, more, "after appending past a partial record");
+    }
+    archive.close();
+    
+    unlink(indexPath.c_str());
+    unlink(path.c_str());
+    rmdir(directory);
+    
+    return test::testResult("archive_test");
+}
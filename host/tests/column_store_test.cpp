@@ -0,0 +1,171 @@
+/**
+ *  @file   column_store_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Column store codecs round trip every value of every column.
+ *
+ *          Three and a bit blocks of rows are written with columns chosen
+ *          to land on each codec: constants (width 0), trends and a met that
+ *          rolls over (delta), noise and full-range int16_t values (pack),
+ *          and slow steps (run-length). Every column of every block is
+ *          decoded on the scalar and the AVX2 path and must give back the
+ *          values written, inside the zone map. A store that was never
+ *          closed must be rejected.
+ *
+ *          usage: column_store_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ThinSatColumnStore.h"
+#include "ThinSatTest.h"
+
+
+#define STORE_TEST_ROWS         (3 * STORE_BLOCK_ROWS + 13)     ///< Ends on a partial, unaligned block
+
+
+static std::vector<ground::ScienceRecord> makeRecords()
+{
+    std::vector<ground::ScienceRecord> records(STORE_TEST_ROWS);
+    std::mt19937                       random(11);
+    
+    for (size_t i = 0; i < records.size(); i++) {
+        ground::ScienceRecord& r     = records[i];
+        size_t                 block = i / STORE_BLOCK_ROWS;
+        double                 angle = i * 0.01;
+        
+        memset(&r, 0, sizeof(r));
+        r.met        = (0xFFFC00 + 5 * i) & 0xFFFFFF;
+        r.sampleAge  = block == 0 ? 3 : random() % 240;
+        r.quat[0]    = (int16_t)lround(16384 * cos(angle));
+        r.quat[1]    = (int16_t)lround(16384 * sin(angle));
+        r.quat[2]    = (int16_t)(random() % 64 - 32);
+        r.quat[3]    = 0;
+        for (int k = 0; k < 3; k++) {
+            r.bnomag[k] = (int16_t)(random() % 40951 - 20480);
+            r.tslMag[k] = block == 1 ? ((i + k) % 2 ? 32767 : -32768) : (int16_t)(k * 1000 - (int)i);
+        }
+        r.bnoCal     = (uint8_t)(0x55 + i / 300);
+        r.bmePres    = block == 2 ? random() & 0xFFFFFF : 1010000 - 7 * i;
+        r.bmeTemp    = (int16_t)(-1000 + i / 2);
+        r.tslTempExt = random() & 0x3FF;
+        r.tslVolts   = block == 3 ? 0x3FF : 512 + i % 3;
+        r.tslCurrent = random() & 0x3FF;
+        r.solar      = i % 1024;
+    }
+    return records;
+}
+
+
+static bool writeStore(const std::string& path, const std::vector<ground::ScienceRecord>& records)
+{
+    ground::ColumnStoreWriter writer;
+    bool                      ok = writer.open(path);
+    
+    for (size_t i = 0; ok && i < records.size(); i++) {
+        ok = writer.append(records[i]);
+    }
+    return writer.close() && ok;
+}
+
+
+/*!
+ * @brief   Decodes every column of every block on one path
+ */
+static void checkDecode(const ground::ColumnStoreReader& store, const std::vector<ground::ScienceRecord>& records,
+                        ground::DecodePath path, int codecs[3])
+{
+    int32_t values[STORE_BLOCK_ROWS];
+    
+    for (uint32_t b = 0; b < store.getBlockCount(); b++) {
+        const ground::StoreBlock& block = store.getBlock(b);
+        size_t                    first = (size_t)b * STORE_BLOCK_ROWS;
+        
+        TEST_EQUAL(block.rows, std::min((size_t)STORE_BLOCK_ROWS, records.size() - first));
+        
+        for (int f = 0; f < ground::STORE_FIELD_COUNT; f++) {
+            ground::StoreField         field  = (ground::StoreField)f;
+            const ground::StoreColumn& column = block.columns[f];
+            bool                       ok     = true;
+            
+            codecs[column.codec]++;
+            store.decodeColumn(b, field, values, path);
+            for (uint32_t i = 0; ok && i < block.rows; i++) {
+                int32_t expected = ground::getField(records[first + i], field);
+                ok = TEST_EQUAL(values[i], expected) &&
+                     TEST_CHECK(column.min <= expected && expected <= column.max);
+            }
+            if (!ok) {
+                fprintf(stderr, "  block %u, column %s, codec %u, width %u, %s path\n", b,
+                        ground::getFieldName(field), column.codec, column.width, ground::getDecodePathName(path));
+            }
+        }
+    }
+}
+
+
+int main()
+{
+    char directory[] = "/tmp/column_store_testXXXXXX";
+    if (!TEST_CHECK(mkdtemp(directory) != nullptr)) {
+        return test::testResult("column_store_test");
+    }
+    std::string path = std::string(directory) + "/mission.tsc";
+    
+    std::vector<ground::ScienceRecord> records = makeRecords();
+    TEST_CHECK(writeStore(path, records));
+    
+    ground::ColumnStoreReader store;
+    if (TEST_CHECK(store.open(path))) {
+        TEST_EQUAL(store.getRowCount(), records.size());
+        TEST_EQUAL(store.getBlockCount(), (records.size() + STORE_BLOCK_ROWS - 1) / STORE_BLOCK_ROWS);
+        
+        int codecs[3] = {};
+        checkDecode(store, records, ground::DecodeScalar, codecs);
+        checkDecode(store, records, ground::DecodeAVX2, codecs);
+        
+        // Each codec must have been exercised
+        TEST_CHECK(codecs[ground::StoreCodecPack]  > 0);
+        TEST_CHECK(codecs[ground::StoreCodecDelta] > 0);
+        TEST_CHECK(codecs[ground::StoreCodecRun]   > 0);
+        
+        // A column that never changes takes no space
+        const ground::StoreColumn& constant = store.getBlock(0).columns[ground::FieldSampleAge];
+        TEST_EQUAL(constant.width,  0);
+        TEST_EQUAL(constant.length, 0);
+        
+        TEST_CHECK(!store.mayContain(0, ground::FieldSampleAge, 4, 239));
+        TEST_CHECK(store.mayContain(0, ground::FieldSampleAge, 0, 3));
+    }
+    store.close();
+    
+    // The header has no directory until the writer is closed
+    {
+        ground::ColumnStoreWriter writer;
+        
+        TEST_CHECK(writer.open(path));
+        TEST_CHECK(writer.append(records[0]));
+        TEST_CHECK(!store.open(path));
+        TEST_CHECK(writer.close());
+        TEST_CHECK(store.open(path));
+        TEST_EQUAL(store.getRowCount(), 1);
+        store.close();
+    }
+    
+    unlink(path.c_str());
+    rmdir(directory);
+    
+    return test::testResult("column_store_test");
+}
@@ -0,0 +1,150 @@
+/**
+ *  @file   columns_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Batch column decoding: every path gives the scalar path's bits.
+ *
+ *          Random science frames are given quaternion words that step through
+ *          the whole 32-bit range, plus every dropped index with the zero,
+ *          end and unused codes, so the vector paths' square root meets
+ *          every case of its fix-up. Each path the CPU supports must decode
+ *          every column to the same bits as the scalar path, and the scalar
+ *          path's quaternions must be unpackQuaternion()'s. The frame count
+ *          leaves a tail for the vector paths' scalar finish.
+ *
+ *          usage: columns_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include "ThinSatColumns.h"
+#include "ThinSatTest.h"
+
+
+#define COLUMNS_TEST_CODE_STRIDE    4099    ///< Odd stride through the 32-bit quaternion words
+
+
+static std::vector<uint32_t> makeQuaternionWords()
+{
+    const uint32_t        edges[] = {0, 1, GROUND_QUAT_CODE_ZERO, GROUND_QUAT_CODE_ZERO + 1,
+                                     GROUND_QUAT_CODE_MAX - 1, GROUND_QUAT_CODE_MAX};
+    std::vector<uint32_t> words;
+    
+    for (uint32_t largest = 0; largest < 4; largest++) {
+        for (uint32_t a : edges) {
+            for (uint32_t b : edges) {
+                for (uint32_t c : edges) {
+                    words.push_back(largest << GROUND_QUAT_INDEX_SHIFT | a << (2 * GROUND_QUAT_BITS) |
+                                    b << GROUND_QUAT_BITS | c);
+                }
+            }
+        }
+    }
+    for (uint64_t word = 0; word < (1ULL << 32); word += COLUMNS_TEST_CODE_STRIDE) {
+        words.push_back((uint32_t)word);
+    }
+    if (words.size() % 8 == 0) {
+        words.push_back(0xFFFFFFFF);
+    }
+    return words;
+}
+
+
+static std::vector<uint8_t> makeFrames(const std::vector<uint32_t>& words)
+{
+    std::vector<uint8_t> frames(words.size() * NSL_PACKET_SIZE);
+    std::mt19937         random(13);
+    
+    for (size_t i = 0; i < words.size(); i++) {
+        uint8_t* f = &frames[i * NSL_PACKET_SIZE];
+        for (size_t b = 0; b < NSL_PACKET_SIZE; b++) {
+            f[b] = random();
+        }
+        memset(f, GROUND_HEADER_BYTE, NSL_PACKET_HEADER_LENGTH);
+        f[GROUND_OFFSET_AGE] = random() % (GROUND_SAMPLE_AGE_MAX + 1);
+        memcpy(&f[GROUND_OFFSET_QUAT], &words[i], 4);
+    }
+    return frames;
+}
+
+
+template <typename T>
+static bool sameColumn(const std::vector<T>& a, const std::vector<T>& b, const char* name)
+{
+    if (a.size() == b.size() && !memcmp(a.data(), b.data(), a.size() * sizeof(T))) {
+        return true;
+    }
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        if (memcmp(&a[i], &b[i], sizeof(T))) {
+            fprintf(stderr, "  column %s differs first at row %zu\n", name, i);
+            break;
+        }
+    }
+    return false;
+}
+
+
+static bool sameColumns(const ground::ScienceColumns& a, const ground::ScienceColumns& b)
+{
+    const char* quatNames[]   = {"quat w", "quat x", "quat y", "quat z"};
+    const char* bnomagNames[] = {"bnomag x", "bnomag y", "bnomag z"};
+    const char* tslMagNames[] = {"tslMag x", "tslMag y", "tslMag z"};
+    bool        same          = sameColumn(a.met, b.met, "met") & sameColumn(a.sampleAge, b.sampleAge, "sampleAge") &
+                                sameColumn(a.bnoCal, b.bnoCal, "bnoCal") & sameColumn(a.pressure, b.pressure, "pressure") &
+                                sameColumn(a.temperature, b.temperature, "temperature") &
+                                sameColumn(a.tslTempExt, b.tslTempExt, "tslTempExt") &
+                                sameColumn(a.tslVolts, b.tslVolts, "tslVolts") &
+                                sameColumn(a.tslCurrent, b.tslCurrent, "tslCurrent") & sameColumn(a.solar, b.solar, "solar");
+    
+    for (int k = 0; k < 4; k++) {
+        same = sameColumn(a.quat[k], b.quat[k], quatNames[k]) && same;
+    }
+    for (int k = 0; k < 3; k++) {
+        same = sameColumn(a.bnomag[k], b.bnomag[k], bnomagNames[k]) && same;
+        same = sameColumn(a.tslMag[k], b.tslMag[k], tslMagNames[k]) && same;
+    }
+    return same;
+}
+
+
+int main()
+{
+    std::vector<uint32_t> words  = makeQuaternionWords();
+    std::vector<uint8_t>  frames = makeFrames(words);
+    
+    ground::ScienceColumns reference;
+    reference.resize(words.size());
+    ground::decodeColumns(frames.data(), words.size(), reference, 0, ground::DecodeScalar);
+    
+    unsigned differing = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+        int16_t q[4];
+        ground::unpackQuaternion(words[i], q);
+        for (int k = 0; k < 4; k++) {
+            differing += reference.quat[k][i] != (float)q[k] * GROUND_QUAT_PER_COUNT;
+        }
+    }
+    TEST_EQUAL(differing, 0);
+    
+    for (ground::DecodePath path : {ground::DecodeSSE41, ground::DecodeAVX2}) {
+        if (path > ground::getBestDecodePath()) {
+            printf("%s not supported\n", ground::getDecodePathName(path));
+            continue;
+        }
+        ground::ScienceColumns columns;
+        columns.resize(words.size());
+        ground::decodeColumns(frames.data(), words.size(), columns, 0, path);
+        if (!TEST_CHECK(sameColumns(columns, reference))) {
+            fprintf(stderr, "  %s path\n", ground::getDecodePathName(path));
+        }
+    }
+    
+    return test::testResult("columns_test");
+}
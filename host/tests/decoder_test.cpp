@@ -0,0 +1,302 @@
+/**
+ *  @file   decoder_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Ground decoder against frames laid out by the firmware's structs.
+ *
+ *          Each frame type is filled through ThinSat_DataPacket.h with
+ *          values that use every bit of the narrow fields (the 24-bit met
+ *          and bmePres, the 10-bit ADC fields) and decoded from the wire
+ *          offsets in ThinSatDecoder.h, which must give back every field.
+ *          The scanner is then fed a stream with noise and a cut frame in
+ *          pieces of every size from 1 byte to the whole stream.
+ *
+ *          usage: decoder_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Arduino.h"
+#include "NSL_ThinSat.h"
+#include "ThinSat_DataPacket.h"
+#include "TSLPB_AdaptiveRate.h"
+#include "ThinSatDecoder.h"
+#include "TSLPB_Quaternion.h"
+#include "ThinSatTest.h"
+
+
+/*!
+ * @brief   A zeroed frame with the NSL header
+ */
+static ThinsatPacket_t makeFrame()
+{
+    ThinsatPacket_t frame;
+    uint8_t         header[] = NSL_PACKET_HEADER;
+    
+    memset(&frame, 0, sizeof(frame));
+    memcpy(frame.payloadData.header, header, NSL_PACKET_HEADER_LENGTH);
+    return frame;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                    Frame Types                   │
+ *  └──────────────────────────────────────────────────┘ */
+
+static void testScience()
+{
+    const int16_t    quat[4] = {8192, -8192, 8192, 8192};  // 60° about (-1, 1, 1)
+    ThinsatPacket_t  frame   = makeFrame();
+    UserDataStruct_t& data   = frame.payloadData;
+    
+    data.met        = 0xABCDEF;
+    data.sampleAge  = TSL_SAMPLE_AGE_MAX;
+    data.refreshed  = (1 << RateGyro) | (1 << RateHousekeeping);
+    data.quat       = tslPackQuaternion(quat);
+    data.bnomagx    = -20480;
+    data.bnomagy    = 1234;
+    data.bnomagz    = 20470;
+    data.bnoCal     = 0x6C;     // sys 1, gyro 2, accel 3, mag 0
+    data.bmePres    = 0xFEDCBA;
+    data.bmeTemp    = -1000;
+    data.tslTempExt = 0x3FF;
+    data.tslVolts   = 0x155;
+    data.tslCurrent = 0x2AA;
+    data.solar      = 0x201;
+    data.tslMagXraw = -0x7FF8;
+    data.tslMagYraw = 0x7FF8;
+    data.tslMagZraw = -1;
+    
+    ground::ScienceRecord record;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameScience);
+    ground::decodeScience(frame.NSLPacket, record);
+    
+    TEST_EQUAL(record.met,        0xABCDEF);
+    TEST_EQUAL(record.sampleAge,  TSL_SAMPLE_AGE_MAX);
+    TEST_EQUAL(record.refreshed,  GROUND_REFRESHED_ATTITUDE | GROUND_REFRESHED_HOUSEKEEPING);
+    TEST_EQUAL(record.quatPacked, data.quat);
+    // Stored components are within half a step (11 counts); the rebuilt
+    // one takes the other three's errors
+    for (int i = 0; i < 4; i++) {
+        TEST_CHECK(abs(record.quat[i] - quat[i]) <= 34);
+    }
+    TEST_EQUAL(record.bnomag[0],  -20480);
+    TEST_EQUAL(record.bnomag[1],  1234);
+    TEST_EQUAL(record.bnomag[2],  20470);
+    TEST_EQUAL(record.bnoCal,     0x6C);
+    TEST_EQUAL(record.bmePres,    0xFEDCBA);
+    TEST_EQUAL(record.bmeTemp,    -1000);
+    TEST_EQUAL(record.tslTempExt, 0x3FF);
+    TEST_EQUAL(record.tslVolts,   0x155);
+    TEST_EQUAL(record.tslCurrent, 0x2AA);
+    TEST_EQUAL(record.solar,      0x201);
+    TEST_EQUAL(record.tslMag[0],  -0x7FF8);
+    TEST_EQUAL(record.tslMag[1],  0x7FF8);
+    TEST_EQUAL(record.tslMag[2],  -1);
+    
+    ground::ScienceValues values;
+    ground::scaleScience(record, values);
+    TEST_EQUAL(values.calSystem, 1);
+    TEST_EQUAL(values.calGyro,   2);
+    TEST_EQUAL(values.calAccel,  3);
+    TEST_EQUAL(values.calMag,    0);
+    TEST_EQUAL(values.refreshed, record.refreshed);
+    TEST_CHECK(values.acquisitionTime == 0xABCDEF * GROUND_MET_TICK_S);
+    TEST_CHECK(values.temperature == -100.0);
+}
+
+
+static void testProfile()
+{
+    ThinsatPacket_t      frame = makeFrame();
+    ProfileDataStruct_t& data  = frame.profileData;
+    
+    data.met       = 0x123456;
+    data.frameType = TSL_FRAME_TYPE_PROFILE;
+    data.phase     = 3;
+    data.count     = 0xBEEF;
+    data.minTime   = 17;
+    data.maxTime   = 0xFEDCBA98;
+    data.meanTime  = 0x01020304;
+    for (int i = 0; i < 16; i++) {
+        data.histogram[i] = 16 * i + 1;
+    }
+    
+    ground::ProfileRecord record;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameProfile);
+    ground::decodeProfile(frame.NSLPacket, record);
+    
+    TEST_EQUAL(record.met,      0x123456);
+    TEST_EQUAL(record.phase,    3);
+    TEST_EQUAL(record.count,    0xBEEF);
+    TEST_EQUAL(record.minTime,  17);
+    TEST_EQUAL(record.maxTime,  0xFEDCBA98);
+    TEST_EQUAL(record.meanTime, 0x01020304);
+    TEST_CHECK(!memcmp(record.histogram, data.histogram, sizeof(record.histogram)));
+}
+
+
+static void testEnergy()
+{
+    ThinsatPacket_t     frame = makeFrame();
+    EnergyDataStruct_t& data  = frame.energyData;
+    
+    data.met          = 0xFFFFFF;
+    data.frameType    = TSL_FRAME_TYPE_ENERGY;
+    data.orbit        = 0x8001;
+    data.orbitSeconds = 5520;
+    for (int i = 0; i < 4; i++) {
+        data.phaseCharge[i] = 0x11111111u * (i + 1);
+    }
+    data.orbitCharge  = 0xFFFFFFFF;
+    data.busVolts     = 0x3FF;
+    
+    ground::EnergyRecord record;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameEnergy);
+    ground::decodeEnergy(frame.NSLPacket, record);
+    
+    TEST_EQUAL(record.met,          0xFFFFFF);
+    TEST_EQUAL(record.orbit,        0x8001);
+    TEST_EQUAL(record.orbitSeconds, 5520);
+    for (int i = 0; i < 4; i++) {
+        TEST_EQUAL(record.phaseCharge[i], 0x11111111u * (i + 1));
+    }
+    TEST_EQUAL(record.orbitCharge,  0xFFFFFFFF);
+    TEST_EQUAL(record.busVolts,     0x3FF);
+}
+
+
+static void testStats()
+{
+    ThinsatPacket_t    frame = makeFrame();
+    StatsDataStruct_t& data  = frame.statsData;
+    
+    data.met          = 42;
+    data.frameType    = TSL_FRAME_TYPE_STATS;
+    data.firstChannel = 2;
+    data.count[0]     = 1;
+    data.count[1]     = 0xFFFF;
+    data.minimum[0]   = -32768;
+    data.minimum[1]   = -5;
+    data.maximum[0]   = 32767;
+    data.maximum[1]   = 5;
+    data.mean[0]      = -0x7FFFFF00;
+    data.mean[1]      = 256;
+    data.variance[0]  = 0xFFFFFFFF;
+    data.variance[1]  = 0;
+    data.seconds      = 600;
+    
+    ground::StatsRecord record;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameStats);
+    ground::decodeStats(frame.NSLPacket, record);
+    
+    TEST_EQUAL(record.met,          42);
+    TEST_EQUAL(record.firstChannel, 2);
+    TEST_EQUAL(record.count[0],     1);
+    TEST_EQUAL(record.count[1],     0xFFFF);
+    TEST_EQUAL(record.minimum[0],   -32768);
+    TEST_EQUAL(record.minimum[1],   -5);
+    TEST_EQUAL(record.maximum[0],   32767);
+    TEST_EQUAL(record.maximum[1],   5);
+    TEST_EQUAL(record.mean[0],      -0x7FFFFF00);
+    TEST_EQUAL(record.mean[1],      256);
+    TEST_EQUAL(record.variance[0],  0xFFFFFFFF);
+    TEST_EQUAL(record.variance[1],  0);
+    TEST_EQUAL(record.seconds,      600);
+}
+
+
+static void testFrameKinds()
+{
+    ThinsatPacket_t frame = makeFrame();
+    
+    frame.payloadData.sampleAge = 0;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameScience);
+    frame.seriesData.frameType  = TSL_FRAME_TYPE_SERIES;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameSeries);
+    frame.traceData.frameType   = TSL_FRAME_TYPE_I2C_TRACE;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameI2CTrace);
+    frame.traceData.frameType   = 0xFF;
+    TEST_EQUAL(ground::getFrameKind(frame.NSLPacket), ground::FrameUnknown);
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                  Stream Scanner                  │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   Eight science frames numbered by met, with two bytes of noise
+ *          after frame 2 and frame 5 cut to 20 bytes
+ */
+static std::vector<uint8_t> makeStream()
+{
+    std::vector<uint8_t> stream;
+    
+    for (int i = 0; i < 8; i++) {
+        ThinsatPacket_t frame = makeFrame();
+        frame.payloadData.met = i + 1;
+        
+        size_t length = i == 5 ? 20 : NSL_PACKET_SIZE;
+        stream.insert(stream.end(), frame.NSLPacket, frame.NSLPacket + length);
+        if (i == 2) {
+            stream.push_back(0xA5);
+            stream.push_back(0x5A);
+        }
+    }
+    return stream;
+}
+
+
+static void testScanner()
+{
+    const std::vector<uint8_t> stream = makeStream();
+    const uint32_t expected[] = {1, 2, 3, 4, 5, 7, 8};
+    
+    for (size_t piece = 1; piece <= stream.size(); piece++) {
+        ground::FrameScanner  scanner;
+        std::vector<uint32_t> mets;
+        auto handler = [&](const uint8_t* frame) {
+            mets.push_back(ground::readU24(&frame[GROUND_OFFSET_MET]));
+        };
+        
+        for (size_t pos = 0; pos < stream.size(); pos += piece) {
+            scanner.scan(&stream[pos], std::min(piece, stream.size() - pos), handler);
+        }
+        scanner.finish(handler);
+        
+        const ground::ScannerStats& stats = scanner.getStats();
+        bool ok = TEST_EQUAL(mets.size(), 7);
+        for (size_t i = 0; ok && i < mets.size(); i++) {
+            ok = TEST_EQUAL(mets[i], expected[i]);
+        }
+        ok = TEST_EQUAL(stats.frames, 7) && ok;
+        ok = TEST_EQUAL(stats.shortFrames, 1) && ok;
+        ok = TEST_EQUAL(stats.bytesSkipped, 2 + 20) && ok;
+        ok = TEST_EQUAL(stats.bytesScanned, stream.size()) && ok;
+        if (!ok) {
+            fprintf(stderr, "  with pieces of %zu bytes\n", piece);
+            break;
+        }
+    }
+}
+
+
+int main()
+{
+    testScience();
+    testProfile();
+    testEnergy();
+    testStats();
+    testFrameKinds();
+    testScanner();
+    
+    return test::testResult("decoder_test");
+}
@@ -0,0 +1,173 @@
+/**
+ *  @file   quat_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Smallest-three quaternion packing: firmware and ground agreement
+ *          and the documented precision.
+ *
+ *          The ground decoder's unpackQuaternion() must give exactly the
+ *          firmware's tslUnpackQuaternion() result for every dropped index
+ *          with every component at its end and middle codes, and for a
+ *          spread of codes across the whole 32-bit range (quat_bench
+ *          --exhaustive checks all of them). The identity and rotations
+ *          about each axis must come back with their zero components exactly
+ *          zero. Random unit quaternions, and their negations, must pack to
+ *          the same code and unpack within the 0.28 degree bound of
+ *          TSLPB_Quaternion.h with the rebuilt component positive.
+ *
+ *          usage: quat_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+
+#include "ThinSatDecoder.h"
+#include "TSLPB_Quaternion.h"
+#include "ThinSatTest.h"
+
+
+#define QUAT_TEST_SAMPLES       100000      ///< Random quaternions packed
+#define QUAT_TEST_CODE_STRIDE   4099        ///< Odd stride through the 32-bit codes
+#define QUAT_TEST_MAX_DEG       0.28        ///< Angle bound of TSLPB_Quaternion.h
+
+
+static bool unpackAgrees(uint32_t code)
+{
+    int16_t firmware[4], ground[4];
+    
+    tslUnpackQuaternion(code, firmware);
+    ground::unpackQuaternion(code, ground);
+    if (memcmp(firmware, ground, sizeof(firmware))) {
+        fprintf(stderr, "  code 0x%08X: firmware %d %d %d %d, ground %d %d %d %d\n", code,
+                firmware[0], firmware[1], firmware[2], firmware[3], ground[0], ground[1], ground[2], ground[3]);
+        return false;
+    }
+    return true;
+}
+
+
+static void testUnpackAgreement()
+{
+    const uint32_t edges[] = {0, 1, TSL_QUAT_CODE_ZERO, TSL_QUAT_CODE_ZERO + 1,
+                              TSL_QUAT_CODE_MAX - 1, TSL_QUAT_CODE_MAX};
+    unsigned differing = 0;
+    
+    for (uint32_t largest = 0; largest < 4; largest++) {
+        for (uint32_t a : edges) {
+            for (uint32_t b : edges) {
+                for (uint32_t c : edges) {
+                    uint32_t code = largest << TSL_QUAT_INDEX_SHIFT | a << (2 * TSL_QUAT_BITS) |
+                                    b << TSL_QUAT_BITS | c;
+                    differing += !unpackAgrees(code);
+                }
+            }
+        }
+    }
+    for (uint64_t code = 0; code < (1ULL << 32); code += QUAT_TEST_CODE_STRIDE) {
+        differing += !unpackAgrees((uint32_t)code);
+    }
+    TEST_EQUAL(differing, 0);
+}
+
+
+/*!
+ * @brief   The identity, and rotations by several angles about each axis,
+ *          in both directions
+ */
+static void testExactZeros()
+{
+    const double angles[] = {M_PI / 2, M_PI, 0.3, 2.5, 3 * M_PI / 2};
+    int16_t      identity[4] = {TSL_QUAT_ONE, 0, 0, 0};
+    int16_t      unpacked[4];
+    
+    ground::unpackQuaternion(tslPackQuaternion(identity), unpacked);
+    TEST_CHECK(!memcmp(unpacked, identity, sizeof(identity)));
+    
+    for (int axis = 1; axis < 4; axis++) {
+        for (double angle : angles) {
+            for (int direction : {1, -1}) {
+                int16_t counts[4] = {};
+                counts[0]    = (int16_t)lround(cos(angle / 2) * TSL_QUAT_ONE);
+                counts[axis] = (int16_t)lround(direction * sin(angle / 2) * TSL_QUAT_ONE);
+                
+                ground::unpackQuaternion(tslPackQuaternion(counts), unpacked);
+                bool ok = true;
+                for (int i = 1; i < 4; i++) {
+                    if (i != axis) {
+                        ok = TEST_EQUAL(unpacked[i], 0) && ok;
+                    }
+                }
+                if (!ok) {
+                    fprintf(stderr, "  axis %d, angle %.3f, direction %d\n", axis, angle, direction);
+                }
+            }
+        }
+    }
+}
+
+
+static double angleDeg(const double a[4], const int16_t b[4])
+{
+    double dot = 0, normB = 0;
+    
+    for (int i = 0; i < 4; i++) {
+        dot   += a[i] * b[i];
+        normB += (double)b[i] * b[i];
+    }
+    return 2 * acos(std::min(1.0, fabs(dot) / sqrt(normB))) * 180 / M_PI;
+}
+
+
+static void testPrecision()
+{
+    std::mt19937_64                  random(3);
+    std::normal_distribution<double> normal;
+    double                           maxDeg   = 0;
+    unsigned                         negative = 0;
+    unsigned                         flipped  = 0;
+    
+    for (int n = 0; n < QUAT_TEST_SAMPLES; n++) {
+        double  truth[4], length = 0;
+        int16_t counts[4], negated[4], unpacked[4];
+        
+        for (int i = 0; i < 4; i++) {
+            truth[i] = normal(random);
+            length  += truth[i] * truth[i];
+        }
+        for (int i = 0; i < 4; i++) {
+            truth[i]  /= sqrt(length);
+            counts[i]  = (int16_t)lround(truth[i] * TSL_QUAT_ONE);
+            negated[i] = -counts[i];
+        }
+        
+        uint32_t code    = tslPackQuaternion(counts);
+        int      largest = code >> TSL_QUAT_INDEX_SHIFT;
+        
+        ground::unpackQuaternion(code, unpacked);
+        maxDeg    = std::max(maxDeg, angleDeg(truth, unpacked));
+        negative += unpacked[largest] < 0;
+        flipped  += tslPackQuaternion(negated) != code;
+    }
+    
+    TEST_CHECK(maxDeg < QUAT_TEST_MAX_DEG);
+    TEST_EQUAL(negative, 0);
+    TEST_EQUAL(flipped, 0);
+    printf("max error %.4f deg over %d quaternions\n", maxDeg, QUAT_TEST_SAMPLES);
+}
+
+
+int main()
+{
+    testUnpackAgreement();
+    testExactZeros();
+    testPrecision();
+    
+    return test::testResult("quat_test");
+}
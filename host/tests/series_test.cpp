@@ -0,0 +1,285 @@
+/**
+ *  @file   series_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Series codec: the firmware encoder and the ground decoder must
+ *          agree on every bit.
+ *
+ *          Series chosen to reach every path of the coding are encoded by
+ *          TSLPB_SeriesEncoder into frames, and each frame is decoded on its
+ *          own by ground::decodeSeries(). Every sample must come back
+ *          exactly, once, in order. The series are a smooth field (coded
+ *          frames of many samples), white noise over the full int16_t range
+ *          and alternating extremes (raw frames), spikes (escaped residuals
+ *          in coded frames), a sine clipped at the int16_t limits (clamped
+ *          predictions), a constant, and noise bursts inside the smooth
+ *          field (raw frames recoded from history, then coded frames again).
+ *          Frames with an impossible count must be rejected.
+ *
+ *          usage: series_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "TSLPB_SeriesCodec.h"
+#include "ThinSatDecoder.h"
+#include "ThinSatTest.h"
+
+
+#define SERIES_TEST_SAMPLES     3000        ///< Samples in each series
+
+
+typedef struct
+{
+    int16_t     axis[TSL_SERIES_AXES];
+} Sample;
+
+
+/*!
+ * @brief   Codes samples with a bare encoder, as the capture does
+ */
+static void encode(const std::vector<Sample>& samples, std::vector<ThinsatPacket_t>& frames)
+{
+    TSLPB_SeriesEncoder encoder;
+    ThinsatPacket_t     frame;
+    uint8_t             header[] = NSL_PACKET_HEADER;
+    size_t              first    = 0;
+    
+    frames.clear();
+    encoder.reset();
+    memset(&frame, 0, sizeof(frame));
+    encoder.openFrame(frame);
+    
+    for (size_t i = 0; i <= samples.size(); i++) {
+        if (i < samples.size() && encoder.add(frame, samples[i].axis)) {
+            continue;
+        }
+        memcpy(frame.seriesData.header, header, NSL_PACKET_HEADER_LENGTH);
+        frame.seriesData.sequence = first;
+        frames.push_back(frame);
+        if (i < samples.size()) {
+            first = i;
+            encoder.openFrame(frame);
+            encoder.add(frame, samples[i].axis);
+        }
+    }
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Series                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+static std::vector<Sample> smooth()
+{
+    std::vector<Sample> series(SERIES_TEST_SAMPLES);
+    
+    for (size_t i = 0; i < series.size(); i++) {
+        for (int axis = 0; axis < TSL_SERIES_AXES; axis++) {
+            series[i].axis[axis] = (int16_t)lround(8000 * sin(0.002 * i + 2 * axis) + 3 * sin(0.7 * i));
+        }
+    }
+    return series;
+}
+
+
+static std::vector<Sample> whiteNoise()
+{
+    std::vector<Sample> series(SERIES_TEST_SAMPLES);
+    std::mt19937        random(5);
+    
+    for (Sample& sample : series) {
+        for (int axis = 0; axis < TSL_SERIES_AXES; axis++) {
+            sample.axis[axis] = (int16_t)random();
+        }
+    }
+    return series;
+}
+
+
+static std::vector<Sample> extremes()
+{
+    std::vector<Sample> series(SERIES_TEST_SAMPLES);
+    
+    for (size_t i = 0; i < series.size(); i++) {
+        for (int axis = 0; axis < TSL_SERIES_AXES; axis++) {
+            series[i].axis[axis] = ((i / (axis + 1)) % 2) ? INT16_MAX : INT16_MIN;
+        }
+    }
+    return series;
+}
+
+
+/*!
+ * @brief   The smooth series with a full-scale spike every 50 samples
+ */
+static std::vector<Sample> spikes()
+{
+    std::vector<Sample> series = smooth();
+    
+    for (size_t i = 25; i < series.size(); i += 50) {
+        for (int axis = 0; axis < TSL_SERIES_AXES; axis++) {
+            series[i].axis[axis] = (i / 50) % 2 ? 30000 : -30000;
+        }
+    }
+    return series;
+}
+
+
+static std::vector<Sample> clipped()
+{
+    std::vector<Sample> series(SERIES_TEST_SAMPLES);
+    
+    for (size_t i = 0; i < series.size(); i++) {
+        for (int axis = 0; axis < TSL_SERIES_AXES; axis++) {
+            long value = lround(40000 * sin(0.01 * i + axis));
+            series[i].axis[axis] = (int16_t)std::max((long)INT16_MIN, std::min((long)INT16_MAX, value));
+        }
+    }
+    return series;
+}
+
+
+static std::vector<Sample> constant()
+{
+    return std::vector<Sample>(SERIES_TEST_SAMPLES, Sample{{-7, 0, 32767}});
+}
+
+
+/*!
+ * @brief   The smooth series with 30-sample bursts of noise every 400
+ */
+static std::vector<Sample> bursts()
+{
+    std::vector<Sample> series = smooth();
+    std::vector<Sample> noise  = whiteNoise();
+    
+    for (size_t i = 0; i < series.size(); i++) {
+        if (i % 400 >= 200 && i % 400 < 230) {
+            series[i] = noise[i];
+        }
+    }
+    return series;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Checks                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+typedef struct
+{
+    size_t      frames;
+    size_t      rawFrames;
+} SeriesResult;
+
+
+static SeriesResult checkRoundTrip(const char* name, const std::vector<Sample>& samples)
+{
+    std::vector<ThinsatPacket_t> frames;
+    SeriesResult                 result = {};
+    size_t                       next   = 0;
+    bool                         ok     = true;
+    
+    encode(samples, frames);
+    result.frames = frames.size();
+    
+    for (size_t f = 0; ok && f < frames.size(); f++) {
+        const uint8_t*       frame = frames[f].NSLPacket;
+        ground::SeriesRecord record;
+        
+        ok = TEST_EQUAL(ground::getFrameKind(frame), ground::FrameSeries) &&
+             TEST_CHECK(ground::decodeSeries(frame, record)) &&
+             TEST_EQUAL(record.sequence, next);
+        
+        bool raw = (frame[GROUND_OFFSET_SERIES_BITS] >> 6) == GROUND_SERIES_RAW_ORDER;
+        result.rawFrames += raw;
+        if (raw) {
+            ok = TEST_CHECK(record.count <= GROUND_SERIES_RAW_SAMPLES) && ok;
+        }
+        for (int i = 0; ok && i < record.count; i++) {
+            ok = TEST_CHECK(next < samples.size()) &&
+                 TEST_CHECK(!memcmp(record.samples[i], samples[next].axis, sizeof(Sample)));
+            next++;
+        }
+        if (!ok) {
+            fprintf(stderr, "  series %s, frame %zu\n", name, f);
+        }
+    }
+    if (ok) {
+        TEST_EQUAL(next, samples.size());
+    }
+    
+    // Never more frames than the samples sent verbatim would take
+    TEST_CHECK(result.frames <= (samples.size() + GROUND_SERIES_RAW_SAMPLES - 1) / GROUND_SERIES_RAW_SAMPLES);
+    printf("%-12s %6zu samples %5zu frames %5zu raw\n", name, samples.size(), result.frames, result.rawFrames);
+    return result;
+}
+
+
+/*!
+ * @brief   A frame that claims more samples than its bits hold, or none,
+ *          must fail
+ */
+static void checkRejects()
+{
+    std::vector<ThinsatPacket_t> frames;
+    ground::SeriesRecord         record;
+    
+    encode(whiteNoise(), frames);
+    ThinsatPacket_t frame = frames.front();
+    frame.seriesData.count = TSL_SERIES_SAMPLES_MAX;
+    TEST_CHECK(!ground::decodeSeries(frame.NSLPacket, record));
+    frame.seriesData.count = 0;
+    TEST_CHECK(!ground::decodeSeries(frame.NSLPacket, record));
+    
+    encode(smooth(), frames);
+    frame = frames.front();
+    frame.seriesData.count = TSL_SERIES_SAMPLES_MAX + 1;
+    TEST_CHECK(!ground::decodeSeries(frame.NSLPacket, record));
+}
+
+
+int main()
+{
+    SeriesResult result;
+    SeriesResult reference = checkRoundTrip("smooth", smooth());
+    
+    TEST_EQUAL(reference.rawFrames, 0);
+    TEST_CHECK(reference.frames * GROUND_SERIES_RAW_SAMPLES * 2 < SERIES_TEST_SAMPLES);
+    
+    result = checkRoundTrip("white noise", whiteNoise());
+    TEST_EQUAL(result.rawFrames, result.frames);
+    
+    result = checkRoundTrip("extremes", extremes());
+    TEST_EQUAL(result.rawFrames, result.frames);
+    
+    result = checkRoundTrip("spikes", spikes());
+    TEST_CHECK(result.rawFrames < result.frames / 2);
+    
+    result = checkRoundTrip("clipped", clipped());
+    TEST_CHECK(result.rawFrames < result.frames / 2);
+    
+    result = checkRoundTrip("constant", constant());
+    TEST_EQUAL(result.rawFrames, 0);
+    
+    // 30 samples of noise take 8 raw frames. Coding must resume at the
+    // smooth series' rate after each burst rather than stay raw or at a
+    // high Rice parameter.
+    result = checkRoundTrip("bursts", bursts());
+    TEST_CHECK(result.rawFrames > 0 && result.rawFrames <= 8 * 8);
+    TEST_CHECK(result.frames <= reference.frames + 8 * 8);
+    
+    checkRejects();
+    
+    return test::testResult("series_test");
+}
@@ -0,0 +1,246 @@
+/**
+ *  @file   sync_test.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  FrameSynchronizer on streams with one kind of damage each.
+ *
+ *          Every stream is ten numbered frames: clean, with noise holding a
+ *          false header in front, with one or two bad header bytes, with a
+ *          corrupted header on two frames in a row, and with a byte dropped
+ *          from or inserted into one frame. The frames delivered, the sync
+ *          counters and the recovery length must match what ThinSatSync.h
+ *          promises, whether the stream is passed to process() whole or in
+ *          pieces, or through read() from a file.
+ *
+ *          usage: sync_test
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ThinSatSync.h"
+#include "ThinSatTest.h"
+
+
+#define SYNC_TEST_FRAMES        10          ///< Frames in each stream
+
+
+/*!
+ * @brief   Frame n of a stream: met n, and payload bytes that never form
+ *          a header
+ */
+static std::vector<uint8_t> makeFrame(int n)
+{
+    std::vector<uint8_t> frame(NSL_PACKET_SIZE);
+    
+    for (int i = 0; i < NSL_PACKET_SIZE; i++) {
+        frame[i] = (uint8_t)(0x80 | ((n * 7 + i) & 0x3F));
+    }
+    memset(&frame[0], GROUND_HEADER_BYTE, NSL_PACKET_HEADER_LENGTH);
+    frame[GROUND_OFFSET_MET]     = (uint8_t)n;
+    frame[GROUND_OFFSET_MET + 1] = 0;
+    frame[GROUND_OFFSET_MET + 2] = 0;
+    return frame;
+}
+
+
+/*!
+ * @brief   A damaged stream and what the synchronizer must make of it
+ */
+typedef struct
+{
+    const char*             name;
+    std::vector<uint8_t>    stream;
+    std::vector<int>        frames;             ///< mets delivered, in order
+    uint64_t                syncLosses;
+    uint64_t                acquisitions;
+    uint64_t                headersRepaired;
+    uint64_t                falseCandidates;
+} SyncCase;
+
+
+/*!
+ * @brief   Frames 1 to SYNC_TEST_FRAMES, with edit() applied to each frame
+ *          before it is appended
+ */
+template <typename Edit>
+static std::vector<uint8_t> makeStream(Edit edit)
+{
+    std::vector<uint8_t> stream;
+    
+    for (int n = 1; n <= SYNC_TEST_FRAMES; n++) {
+        std::vector<uint8_t> frame = makeFrame(n);
+        edit(n, frame);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    return stream;
+}
+
+
+static std::vector<int> allFramesBut(std::vector<int> lost)
+{
+    std::vector<int> frames;
+    
+    for (int n = 1; n <= SYNC_TEST_FRAMES; n++) {
+        if (std::find(lost.begin(), lost.end(), n) == lost.end()) {
+            frames.push_back(n);
+        }
+    }
+    return frames;
+}
+
+
+static std::vector<SyncCase> makeCases()
+{
+    std::vector<SyncCase> cases;
+    
+    cases.push_back({"clean", makeStream([](int, std::vector<uint8_t>&) {}),
+                     allFramesBut({}), 0, 1, 0, 0});
+    
+    // A header 28 bytes into noise has no header NSL_PACKET_SIZE behind it
+    SyncCase noise = {"false header", makeStream([](int, std::vector<uint8_t>&) {}),
+                      allFramesBut({}), 0, 1, 0, 1};
+    std::vector<uint8_t> junk = {0x11, 0x50, 0x50, 0x50, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+    noise.stream.insert(noise.stream.begin(), junk.begin(), junk.end());
+    cases.push_back(noise);
+    
+    cases.push_back({"repaired header", makeStream([](int n, std::vector<uint8_t>& frame) {
+                         if (n == 4) frame[1] = 0x51;
+                     }),
+                     allFramesBut({}), 0, 1, 1, 0});
+    
+    // Two bad bytes exceed the default tolerance; hunting resumes one byte
+    // into frame 3 and the exact header of frame 5 is the next candidate
+    cases.push_back({"bad header", makeStream([](int n, std::vector<uint8_t>& frame) {
+                         if (n == 4) frame[0] = frame[2] = 0x00;
+                     }),
+                     allFramesBut({3, 4}), 1, 2, 0, 0});
+    
+    // A repair is never made on two headers in a row
+    cases.push_back({"two repairs", makeStream([](int n, std::vector<uint8_t>& frame) {
+                         if (n == 4 || n == 5) frame[2] = 0x00;
+                     }),
+                     allFramesBut({4, 5}), 1, 2, 1, 0});
+    
+    cases.push_back({"dropped byte", makeStream([](int n, std::vector<uint8_t>& frame) {
+                         if (n == 5) frame.erase(frame.begin() + 20);
+                     }),
+                     allFramesBut({5}), 1, 2, 0, 0});
+    
+    cases.push_back({"inserted byte", makeStream([](int n, std::vector<uint8_t>& frame) {
+                         if (n == 5) frame.insert(frame.begin() + 20, 0x99);
+                     }),
+                     allFramesBut({5}), 1, 2, 0, 0});
+    
+    return cases;
+}
+
+
+/*  ┌──────────────────────────────────────────────────┐
+ *  │                      Checks                      │
+ *  └──────────────────────────────────────────────────┘ */
+
+/*!
+ * @brief   Checks one run of a case. Every delivered frame must be the
+ *          original frame, with its header repaired if it was damaged.
+ */
+static void checkRun(const SyncCase& test, const char* how, ground::FrameSynchronizer& sync,
+                     const std::vector<std::vector<uint8_t>>& delivered)
+{
+    const ground::SyncStats& stats = sync.getStats();
+    bool ok = TEST_EQUAL(delivered.size(), test.frames.size());
+    
+    for (size_t i = 0; ok && i < delivered.size(); i++) {
+        ok = TEST_CHECK(delivered[i] == makeFrame(test.frames[i]));
+    }
+    ok = TEST_EQUAL(stats.frames,          test.frames.size())  && ok;
+    ok = TEST_EQUAL(stats.syncLosses,      test.syncLosses)     && ok;
+    ok = TEST_EQUAL(stats.acquisitions,    test.acquisitions)   && ok;
+    ok = TEST_EQUAL(stats.headersRepaired, test.headersRepaired) && ok;
+    ok = TEST_EQUAL(stats.falseCandidates, test.falseCandidates) && ok;
+    ok = TEST_EQUAL(stats.bytesIn,         test.stream.size())  && ok;
+    ok = TEST_EQUAL(stats.bytesDiscarded,  test.stream.size() - NSL_PACKET_SIZE * test.frames.size()) && ok;
+    
+    // Lock is regained within two clean frames of the damage
+    ok = TEST_CHECK(stats.maxRecoveryBytes <= 2 * NSL_PACKET_SIZE) && ok;
+    if (!ok) {
+        fprintf(stderr, "  in case \"%s\", %s\n", test.name, how);
+    }
+}
+
+
+/*!
+ * @brief   Passes the stream to process() in pieces, keeping the bytes each
+ *          call leaves for the next as the caller must
+ */
+static void runPieces(const SyncCase& test, size_t piece)
+{
+    ground::FrameSynchronizer         sync;
+    std::vector<std::vector<uint8_t>> delivered;
+    std::vector<uint8_t>              pending;
+    auto handler = [&](const uint8_t* frame) {
+        delivered.emplace_back(frame, frame + NSL_PACKET_SIZE);
+    };
+    
+    for (size_t pos = 0; pos < test.stream.size(); pos += piece) {
+        size_t end   = std::min(pos + piece, test.stream.size());
+        bool   final = end == test.stream.size();
+        
+        pending.insert(pending.end(), test.stream.begin() + pos, test.stream.begin() + end);
+        size_t used = sync.process(pending.data(), pending.size(), final, handler);
+        pending.erase(pending.begin(), pending.begin() + used);
+    }
+    TEST_CHECK(pending.empty());
+    
+    char how[48];
+    snprintf(how, sizeof(how), "in pieces of %zu bytes", piece);
+    checkRun(test, how, sync, delivered);
+}
+
+
+/*!
+ * @brief   Reads the stream from a file through the ring buffer
+ */
+static void runRead(const SyncCase& test)
+{
+    FILE* file = tmpfile();
+    if (!TEST_CHECK(file != nullptr)) {
+        return;
+    }
+    fwrite(test.stream.data(), 1, test.stream.size(), file);
+    fflush(file);
+    rewind(file);
+    
+    ground::FrameSynchronizer         sync;
+    std::vector<std::vector<uint8_t>> delivered;
+    auto handler = [&](const uint8_t* frame) {
+        delivered.emplace_back(frame, frame + NSL_PACKET_SIZE);
+    };
+    
+    while (sync.read(fileno(file), handler)) {
+    }
+    TEST_EQUAL(errno, 0);
+    fclose(file);
+    checkRun(test, "through read()", sync, delivered);
+}
+
+
+int main()
+{
+    for (const SyncCase& test : makeCases()) {
+        for (size_t piece : {(size_t)1, (size_t)7, (size_t)NSL_PACKET_SIZE, (size_t)NSL_PACKET_SIZE + 1,
+                             test.stream.size()}) {
+            runPieces(test, piece);
+        }
+        runRead(test);
+    }
+    
+    return test::testResult("sync_test");
+}
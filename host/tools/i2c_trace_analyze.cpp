@@ -0,0 +1,106 @@
+/**
+ *  @file   i2c_trace_analyze.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Reports redundant TSLPB I2C traffic and the bus time that removing
+ *          it would save.
+ *
+ *          By default the sketch is run on the simulated TSLPB with the
+ *          tracer enabled and every access is analyzed. With --capture the
+ *          TSL_FRAME_TYPE_I2C_TRACE frames in a file of downlinked packets are
+ *          analyzed instead.
+ *
+ *          usage: i2c_trace_analyze [--seconds S] [--capture FILE]
+ *                                   [--clock HZ] [--poll-threshold N]
+ *                                   [--merge-window US] [--top N]
+ *
+ *  @note   Only accesses made through the TSLPB I2C helpers are traced. The
+ *          Adafruit BNO055 and BMP280 libraries use Wire directly.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "SimTslpbBoard.h"
+#include "SimMothership.h"
+#include "I2cTraceAnalyzer.h"
+
+
+static std::vector<TSLPB_I2CTraceEntry_t> trace;
+
+static void collect(const TSLPB_I2CTraceEntry_t& entry)
+{
+    trace.push_back(entry);
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--seconds S] [--capture FILE] [--clock HZ]\n"
+                    "       [--poll-threshold N] [--merge-window US] [--top N]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    double                    seconds     = 60;
+    const char*               capturePath = NULL;
+    size_t                    top         = 20;
+    analysis::AnalyzerOptions options;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--capture") && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (!strcmp(argv[i], "--clock") && i + 1 < argc) {
+            options.clockHz = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--poll-threshold") && i + 1 < argc) {
+            options.pollThreshold = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--merge-window") && i + 1 < argc) {
+            options.mergeWindowUs = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--top") && i + 1 < argc) {
+            top = strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (options.clockHz == 0 || options.pollThreshold < 2) {
+        usage(argv[0]);
+    }
+    
+    if (capturePath) {
+        FILE* input = fopen(capturePath, "rb");
+        if (!input) {
+            perror(capturePath);
+            return 1;
+        }
+        size_t frames = analysis::readTraceFrames(input, trace);
+        fclose(input);
+        printf("trace frames        %zu\n", frames);
+    } else {
+        sim::SimTslpbBoard  board;
+        sim::SimMothership  nsl;
+        
+        hal::reset();
+        board.attach();
+        nsl.attach();
+        tslI2CTrace.setSink(collect);
+        
+        setup();
+        while (hal::now() < (uint64_t)(seconds * 1e6)) {
+            loop();
+        }
+        printf("virtual time        %.3f s\n", hal::now() / 1e6);
+    }
+    
+    analysis::printReport(stdout, analysis::analyzeTrace(trace, options), top);
+    return 0;
+}
@@ -0,0 +1,295 @@
+/**
+ *  @file   thinsat_archive.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Creates and queries ThinSat frame archives.
+ *
+ *          usage: thinsat_archive import ARCHIVE [--epoch S] [FILE...]
+ *                 thinsat_archive info ARCHIVE
+ *                 thinsat_archive query ARCHIVE FROM TO [--output FILE]
+ *                 thinsat_archive aggregate ARCHIVE FIELD FROM TO WINDOW [--scan]
+ *
+ *          import  appends the frames found in raw captures (stdin if no
+ *                  FILE). Captures carry no receive times, so each frame
+ *                  is stamped --epoch (Unix seconds, default 0) plus its
+ *                  transmission MET (met + sampleAge) and flagged
+ *                  ARCHIVE_FLAG_TIME_ESTIMATED. Times that would run
+ *                  backwards (MET rollover or a reboot) repeat the last one.
+ *          info    prints the record count, time span and index state.
+ *          query   finds the records received in [FROM, TO) (Unix seconds)
+ *                  and reports the lookup time. --output writes their frames
+ *                  as a raw capture ("-" for stdout), ready for
+ *                  thinsat_decode.
+ *          aggregate
+ *                  prints count, min, max, mean and standard deviation of
+ *                  FIELD (a column store field name) for each WINDOW
+ *                  seconds from FROM to TO, in engineering units, as CSV.
+ *                  Answers come from ARCHIVE.sum, which is created or
+ *                  extended first; --scan decodes every record instead,
+ *                  for comparison.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatArchive.h"
+#include "ThinSatSummary.h"
+
+
+#define IMPORT_CHUNK_SIZE   (1 << 20)
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s import ARCHIVE [--epoch S] [FILE...]\n"
+                    "       %s info ARCHIVE\n"
+                    "       %s query ARCHIVE FROM TO [--output FILE]\n"
+                    "       %s aggregate ARCHIVE FIELD FROM TO WINDOW [--scan]\n", program, program, program, program);
+    exit(2);
+}
+
+static uint64_t toMicros(double seconds)
+{
+    return seconds > 0 ? (uint64_t)(seconds * 1e6 + 0.5) : 0;
+}
+
+static int importCaptures(const char* archivePath, int argc, char** argv)
+{
+    double                   epoch = 0;
+    std::vector<const char*> paths;
+    
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--epoch") && i + 1 < argc) {
+            epoch = atof(argv[++i]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back("-");
+    }
+    
+    ground::ArchiveWriter archive;
+    if (!archive.open(archivePath)) {
+        perror(archivePath);
+        return 1;
+    }
+    
+    ground::FrameScanner  scanner;
+    std::vector<uint8_t>  buffer(IMPORT_CHUNK_SIZE);
+    uint64_t              base    = toMicros(epoch);
+    uint64_t              before  = archive.getRecordCount();
+    bool                  ok      = true;
+    
+    auto append = [&](const uint8_t* frame) {
+        uint64_t time = std::max(ground::estimateReceiveTime(frame, base), archive.getLastTime());
+        if (!archive.append(frame, time, ARCHIVE_FLAG_TIME_ESTIMATED)) {
+            ok = false;
+        }
+    };
+    
+    for (const char* path : paths) {
+        bool  useStdin = !strcmp(path, "-");
+        FILE* input    = useStdin ? stdin : fopen(path, "rb");
+        size_t length;
+        
+        if (!input) {
+            perror(path);
+            return 1;
+        }
+        while ((length = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+            scanner.scan(buffer.data(), length, append);
+        }
+        if (!useStdin) {
+            fclose(input);
+        }
+    }
+    scanner.finish(append);
+    
+    if (!ok || !archive.flush()) {
+        perror(archivePath);
+        return 1;
+    }
+    printf("imported            %llu frames (%llu records)\n",
+           (unsigned long long)(archive.getRecordCount() - before),
+           (unsigned long long)archive.getRecordCount());
+    printf("bytes skipped       %llu\n", (unsigned long long)scanner.getStats().bytesSkipped);
+    return 0;
+}
+
+static int printInfo(const char* archivePath)
+{
+    ground::ArchiveReader archive;
+    
+    if (!archive.open(archivePath)) {
+        perror(archivePath);
+        return 1;
+    }
+    printf("records             %llu\n", (unsigned long long)archive.size());
+    if (archive.size() > 0) {
+        printf("first receive time  %.6f\n", archive[0].receiveTime / 1e6);
+        printf("last receive time   %.6f\n", archive[archive.size() - 1].receiveTime / 1e6);
+    }
+    printf("index               %llu entries, stride %u%s\n", (unsigned long long)archive.getIndexSize(),
+           archive.getIndexStride(), archive.isIndexRebuilt() ? " (rebuilt in memory)" : "");
+    return 0;
+}
+
+static int query(const char* archivePath, int argc, char** argv)
+{
+    const char* outputPath = NULL;
+    
+    if (argc < 2) {
+        return -1;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            return -1;
+        }
+    }
+    
+    ground::ArchiveReader archive;
+    if (!archive.open(archivePath)) {
+        perror(archivePath);
+        return 1;
+    }
+    
+    uint64_t first, last;
+    auto     start = std::chrono::steady_clock::now();
+    archive.findRange(toMicros(atof(argv[0])), toMicros(atof(argv[1])), first, last);
+    double   lookup = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    
+    fprintf(stderr, "records             %llu (sequence %llu to %llu)\n", (unsigned long long)(last - first),
+            (unsigned long long)first, (unsigned long long)last);
+    fprintf(stderr, "lookup time         %.1f us\n", lookup);
+    
+    if (outputPath) {
+        bool  useStdout = !strcmp(outputPath, "-");
+        FILE* output    = useStdout ? stdout : fopen(outputPath, "wb");
+        if (!output) {
+            perror(outputPath);
+            return 1;
+        }
+        for (uint64_t i = first; i < last; i++) {
+            fwrite(archive[i].frame, 1, NSL_PACKET_SIZE, output);
+        }
+        if (ferror(output) || (!useStdout && fclose(output) != 0)) {
+            perror(outputPath);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int aggregate(const char* archivePath, int argc, char** argv)
+{
+    bool               scan = false;
+    ground::StoreField field;
+    
+    if (argc < 4 || !ground::findField(argv[0], field)) {
+        return -1;
+    }
+    for (int i = 4; i < argc; i++) {
+        if (!strcmp(argv[i], "--scan")) {
+            scan = true;
+        } else {
+            return -1;
+        }
+    }
+    
+    uint64_t from   = toMicros(atof(argv[1]));
+    uint64_t to     = toMicros(atof(argv[2]));
+    uint64_t window = toMicros(atof(argv[3]));
+    if (window == 0) {
+        return -1;
+    }
+    
+    ground::ArchiveReader archive;
+    if (!archive.open(archivePath)) {
+        perror(archivePath);
+        return 1;
+    }
+    
+    std::string            summaryPath = std::string(archivePath) + SUMMARY_SUFFIX;
+    ground::ArchiveSummary summary;
+    auto                   start       = std::chrono::steady_clock::now();
+    
+    if (!scan && !summary.open(archive, summaryPath)) {
+        perror(summaryPath.c_str());
+        return 1;
+    }
+    double build = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    double   scale   = ground::getFieldScale(field);
+    uint64_t windows = 0, blocks = 0, decoded = 0;
+    
+    printf("window_start_s,count,min,max,mean,stddev\n");
+    start = std::chrono::steady_clock::now();
+    for (uint64_t begin = from; begin < to; begin += window) {
+        ground::Aggregate result;
+        uint64_t          first, last;
+        
+        ground::clearAggregate(result);
+        archive.findRange(begin, std::min(begin + window, to), first, last);
+        if (scan) {
+            ground::scanAggregate(archive, field, first, last, result);
+        } else {
+            summary.aggregate(archive, field, first, last, result);
+        }
+        
+        windows++;
+        blocks  += result.blocksSummarized;
+        decoded += result.recordsDecoded;
+        if (result.count == 0) {
+            printf("%.3f,0,,,,\n", begin / 1e6);
+            continue;
+        }
+        printf("%.3f,%llu,%.6g,%.6g,%.6g,%.6g\n", begin / 1e6, (unsigned long long)result.count,
+               result.min * scale, result.max * scale, result.mean * scale, sqrt(result.variance()) * scale);
+    }
+    double query = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    if (!scan) {
+        fprintf(stderr, "summary             %llu blocks (%llu new, %.1f ms)\n",
+                (unsigned long long)summary.getBlockCount(), (unsigned long long)summary.getBlocksBuilt(), build);
+    }
+    fprintf(stderr, "windows             %llu\n", (unsigned long long)windows);
+    fprintf(stderr, "blocks summarized   %llu\n", (unsigned long long)blocks);
+    fprintf(stderr, "records decoded     %llu\n", (unsigned long long)decoded);
+    fprintf(stderr, "query time          %.3f ms\n", query);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        usage(argv[0]);
+    }
+    
+    int result = -1;
+    if (!strcmp(argv[1], "import")) {
+        result = importCaptures(argv[2], argc - 3, argv + 3);
+    } else if (!strcmp(argv[1], "info") && argc == 3) {
+        result = printInfo(argv[2]);
+    } else if (!strcmp(argv[1], "query")) {
+        result = query(argv[2], argc - 3, argv + 3);
+    } else if (!strcmp(argv[1], "aggregate")) {
+        result = aggregate(argv[2], argc - 3, argv + 3);
+    }
+    if (result < 0) {
+        usage(argv[0]);
+    }
+    return result;
+}
@@ -0,0 +1,227 @@
+/**
+ *  @file   thinsat_columns.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Builds, describes and scans compressed columnar stores.
+ *
+ *          usage: thinsat_columns build STORE INPUT...
+ *                 thinsat_columns info STORE
+ *                 thinsat_columns scan STORE FIELD LOW HIGH [--no-zone-maps] [--scalar]
+ *
+ *          build   stores the science frames of raw captures or archives
+ *                  (see thinsat_archive) in order
+ *          info    prints the size and codecs of each column
+ *          scan    counts rows with LOW <= FIELD <= HIGH (raw values, as
+ *                  sent). Blocks whose zone map rules them out are skipped
+ *                  unless --no-zone-maps is given. --scalar forces the
+ *                  scalar unpacker.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatArchive.h"
+#include "ThinSatColumnStore.h"
+
+
+#define BUILD_CHUNK_SIZE    (1 << 20)
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s build STORE INPUT...\n"
+                    "       %s info STORE\n"
+                    "       %s scan STORE FIELD LOW HIGH [--no-zone-maps] [--scalar]\n",
+                    program, program, program);
+    exit(2);
+}
+
+static bool isArchive(const char* path)
+{
+    char  magic[8];
+    FILE* input = fopen(path, "rb");
+    bool  found = input && fread(magic, 1, sizeof(magic), input) == sizeof(magic) &&
+                  !memcmp(magic, ARCHIVE_MAGIC, sizeof(magic));
+    
+    if (input) {
+        fclose(input);
+    }
+    return found;
+}
+
+static int build(const char* storePath, int count, char** inputs)
+{
+    ground::ColumnStoreWriter store;
+    ground::ScienceRecord     record;
+    uint64_t                  frames = 0;
+    bool                      ok     = true;
+    
+    if (count < 1) {
+        return -1;
+    }
+    if (!store.open(storePath)) {
+        perror(storePath);
+        return 1;
+    }
+    
+    auto add = [&](const uint8_t* frame) {
+        frames++;
+        if (ground::getFrameKind(frame) == ground::FrameScience) {
+            ground::decodeScience(frame, record);
+            ok = store.append(record) && ok;
+        }
+    };
+    
+    for (int i = 0; i < count; i++) {
+        if (isArchive(inputs[i])) {
+            ground::ArchiveReader archive;
+            if (!archive.open(inputs[i])) {
+                perror(inputs[i]);
+                return 1;
+            }
+            for (uint64_t r = 0; r < archive.size(); r++) {
+                add(archive[r].frame);
+            }
+            continue;
+        }
+        
+        FILE* input = fopen(inputs[i], "rb");
+        if (!input) {
+            perror(inputs[i]);
+            return 1;
+        }
+        ground::FrameScanner scanner;
+        std::vector<uint8_t> buffer(BUILD_CHUNK_SIZE);
+        size_t               length;
+        while ((length = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+            scanner.scan(buffer.data(), length, add);
+        }
+        scanner.finish(add);
+        fclose(input);
+    }
+    
+    uint64_t rows = store.getRowCount();
+    if (!store.close() || !ok) {
+        perror(storePath);
+        return 1;
+    }
+    printf("frames              %llu (science %llu)\n", (unsigned long long)frames, (unsigned long long)rows);
+    printf("store size          %llu bytes (%.1fx smaller than %llu bytes of frames)\n",
+           (unsigned long long)store.getBytesWritten(),
+           store.getBytesWritten() ? (double)rows * NSL_PACKET_SIZE / store.getBytesWritten() : 0.0,
+           (unsigned long long)(rows * NSL_PACKET_SIZE));
+    return 0;
+}
+
+static int printInfo(const char* storePath)
+{
+    ground::ColumnStoreReader store;
+    
+    if (!store.open(storePath)) {
+        perror(storePath);
+        return 1;
+    }
+    
+    uint64_t rows = store.getRowCount();
+    printf("rows                %llu in %u blocks\n", (unsigned long long)rows, store.getBlockCount());
+    printf("file size           %llu bytes (%.1fx smaller than the frames)\n\n",
+           (unsigned long long)store.getFileSize(),
+           store.getFileSize() ? (double)rows * NSL_PACKET_SIZE / store.getFileSize() : 0.0);
+    printf("%-12s %12s %10s %8s %8s %8s\n", "field", "bytes", "bits/row", "pack", "delta", "run");
+    
+    for (int f = 0; f < ground::STORE_FIELD_COUNT; f++) {
+        uint64_t bytes     = 0;
+        uint32_t codecs[3] = {0, 0, 0};
+        for (uint32_t b = 0; b < store.getBlockCount(); b++) {
+            const ground::StoreColumn& column = store.getBlock(b).columns[f];
+            bytes += column.length;
+            codecs[column.codec]++;
+        }
+        printf("%-12s %12llu %10.2f %8u %8u %8u\n", ground::getFieldName((ground::StoreField)f),
+               (unsigned long long)bytes, rows ? bytes * 8.0 / rows : 0.0, codecs[0], codecs[1], codecs[2]);
+    }
+    return 0;
+}
+
+static int scan(const char* storePath, int argc, char** argv)
+{
+    ground::StoreField field;
+    ground::DecodePath path     = ground::DecodeAuto;
+    bool               useZones = true;
+    
+    if (argc < 3 || !ground::findField(argv[0], field)) {
+        return -1;
+    }
+    int32_t low  = strtol(argv[1], NULL, 0);
+    int32_t high = strtol(argv[2], NULL, 0);
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--no-zone-maps")) {
+            useZones = false;
+        } else if (!strcmp(argv[i], "--scalar")) {
+            path = ground::DecodeScalar;
+        } else {
+            return -1;
+        }
+    }
+    
+    ground::ColumnStoreReader store;
+    if (!store.open(storePath)) {
+        perror(storePath);
+        return 1;
+    }
+    
+    std::vector<int32_t> values(STORE_BLOCK_ROWS);
+    uint64_t             matches = 0;
+    uint64_t             decoded = 0;
+    uint32_t             skipped = 0;
+    auto                 start   = std::chrono::steady_clock::now();
+    
+    for (uint32_t b = 0; b < store.getBlockCount(); b++) {
+        if (useZones && !store.mayContain(b, field, low, high)) {
+            skipped++;
+            continue;
+        }
+        store.decodeColumn(b, field, values.data(), path);
+        
+        uint32_t rows = store.getBlock(b).rows;
+        for (uint32_t i = 0; i < rows; i++) {
+            matches += (values[i] >= low && values[i] <= high);
+        }
+        decoded += rows;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    printf("matching rows       %llu of %llu\n", (unsigned long long)matches, (unsigned long long)store.getRowCount());
+    printf("blocks skipped      %u of %u\n", skipped, store.getBlockCount());
+    printf("scan time           %.3f ms (%.0f M rows/s decoded)\n", seconds * 1e3,
+           seconds > 0 ? decoded / seconds / 1e6 : 0.0);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        usage(argv[0]);
+    }
+    
+    int result = -1;
+    if (!strcmp(argv[1], "build")) {
+        result = build(argv[2], argc - 3, argv + 3);
+    } else if (!strcmp(argv[1], "info") && argc == 3) {
+        result = printInfo(argv[2]);
+    } else if (!strcmp(argv[1], "scan")) {
+        result = scan(argv[2], argc - 3, argv + 3);
+    }
+    if (result < 0) {
+        usage(argv[0]);
+    }
+    return result;
+}
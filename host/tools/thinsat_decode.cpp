@@ -0,0 +1,220 @@
+/**
+ *  @file   thinsat_decode.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Decodes captured ThinsatPacket_t downlink streams to CSV.
+ *
+ *          Science frames are written to stdout, one row per frame, in
+ *          engineering units (or as sent with --raw). Frame counts, sync
+ *          losses and the decode rate go to stderr. Input files are scanned
+ *          as one continuous stream, so a capture split across files keeps
+ *          the frame that straddles the split. --quiet decodes without
+ *          printing, to measure the decoder alone. --stats writes the
+ *          channel statistics reports instead, one row per channel, with the
+ *          mean, variance and standard deviation in the channel's units.
+ *          --series writes the samples of the high-rate captures, one row
+ *          per sample in raw counts; frames that fail to decode are counted
+ *          on stderr.
+ *
+ *          usage: thinsat_decode [--raw] [--quiet] [--stats] [--series] [FILE...]
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+
+
+#define DECODE_CHUNK_SIZE   (1 << 20)
+
+
+static bool     raw          = false;
+static bool     quiet        = false;
+static bool     channelStats = false;
+static bool     series       = false;
+static uint64_t badSeries    = 0;
+static uint64_t kinds[ground::FrameUnknown + 1];
+static volatile double checksum;     ///< Keeps --quiet decoding from being optimized away
+
+
+static void printHeader()
+{
+    if (channelStats) {
+        puts("time_s,channel,interval_s,count,min,max,mean,variance,stddev");
+    } else if (series) {
+        puts("time_s,capture,source,index,x,y,z");
+    } else if (raw) {
+        puts("met,sampleAge,refreshed,quat,bnomagx,bnomagy,bnomagz,bnoCal,"
+             "bmePres,bmeTemp,tslTempExt,tslVolts,tslCurrent,solar,tslMagXraw,tslMagYraw,tslMagZraw");
+    } else {
+        puts(GROUND_CSV_HEADER);
+    }
+}
+
+static void printStats(const uint8_t* frame)
+{
+    ground::StatsRecord r;
+    ground::decodeStats(frame, r);
+    
+    for (int i = 0; i < 2; i++) {
+        if (r.count[i] == 0) {
+            continue;
+        }
+        double variance = r.variance[i] / GROUND_STATS_SCALE;
+        printf("%.1f,%u,%u,%u,%d,%d,%.3f,%.3f,%.3f\n", r.met * GROUND_MET_TICK_S, r.firstChannel + i,
+               r.seconds, r.count[i], r.minimum[i], r.maximum[i], r.mean[i] / GROUND_STATS_SCALE,
+               variance, sqrt(variance));
+    }
+}
+
+static void printSeries(const uint8_t* frame)
+{
+    ground::SeriesRecord r;
+    
+    if (!ground::decodeSeries(frame, r)) {
+        badSeries++;
+    }
+    if (quiet) {
+        return;
+    }
+    for (int i = 0; i < r.count; i++) {
+        printf("%.3f,%u,%u,%u,%d,%d,%d\n", r.met * GROUND_MET_TICK_S + i * r.period / 1000.0, r.capture,
+               r.source, r.sequence + i, r.samples[i][0], r.samples[i][1], r.samples[i][2]);
+    }
+}
+
+static void printFrame(const uint8_t* frame)
+{
+    ground::FrameKind kind = ground::getFrameKind(frame);
+    
+    kinds[kind]++;
+    if (channelStats) {
+        if (kind == ground::FrameStats && !quiet) {
+            printStats(frame);
+        }
+        return;
+    }
+    if (series) {
+        if (kind == ground::FrameSeries) {
+            printSeries(frame);
+        }
+        return;
+    }
+    if (kind != ground::FrameScience) {
+        return;
+    }
+    
+    ground::ScienceRecord r;
+    ground::decodeScience(frame, r);
+    
+    if (quiet) {
+        ground::ScienceValues v;
+        ground::scaleScience(r, v);
+        checksum = v.acquisitionTime;
+        return;
+    }
+    if (raw) {
+        printf("%u,%u,%u,%u,%d,%d,%d,%u,%u,%d,%u,%u,%u,%u,%d,%d,%d\n",
+               r.met, r.sampleAge, r.refreshed, r.quatPacked,
+               r.bnomag[0], r.bnomag[1], r.bnomag[2], r.bnoCal, r.bmePres, r.bmeTemp,
+               r.tslTempExt, r.tslVolts, r.tslCurrent, r.solar,
+               r.tslMag[0], r.tslMag[1], r.tslMag[2]);
+        return;
+    }
+    
+    ground::ScienceValues v;
+    char                  row[GROUND_CSV_ROW_MAX];
+    
+    ground::scaleScience(r, v);
+    fwrite(row, 1, ground::formatScienceCsv(v, row, sizeof(row)), stdout);
+}
+
+static bool decodeFile(FILE* input, const char* name, ground::FrameScanner& scanner,
+                       std::vector<uint8_t>& buffer)
+{
+    size_t length;
+    
+    while ((length = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+        scanner.scan(buffer.data(), length, printFrame);
+    }
+    if (ferror(input)) {
+        perror(name);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> paths;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--raw")) {
+            raw = true;
+        } else if (!strcmp(argv[i], "--quiet")) {
+            quiet = true;
+        } else if (!strcmp(argv[i], "--stats")) {
+            channelStats = true;
+        } else if (!strcmp(argv[i], "--series")) {
+            series = true;
+        } else if (argv[i][0] == '-' && argv[i][1]) {
+            fprintf(stderr, "usage: %s [--raw] [--quiet] [--stats] [--series] [FILE...]\n", argv[0]);
+            return 2;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back("-");
+    }
+    
+    ground::FrameScanner  scanner;
+    std::vector<uint8_t>  buffer(DECODE_CHUNK_SIZE);
+    bool                  ok     = true;
+    auto                  start  = std::chrono::steady_clock::now();
+    
+    if (!quiet) {
+        printHeader();
+    }
+    for (const char* path : paths) {
+        bool  useStdin = !strcmp(path, "-");
+        FILE* input    = useStdin ? stdin : fopen(path, "rb");
+        if (!input) {
+            perror(path);
+            ok = false;
+            continue;
+        }
+        ok &= decodeFile(input, path, scanner, buffer);
+        if (!useStdin) {
+            fclose(input);
+        }
+    }
+    scanner.finish(printFrame);
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const ground::ScannerStats& stats = scanner.getStats();
+    
+    fprintf(stderr, "bytes               %llu\n", (unsigned long long)stats.bytesScanned);
+    fprintf(stderr, "frames              %llu (science %llu, profile %llu, energy %llu, trace %llu, stats %llu, series %llu, unknown %llu)\n",
+            (unsigned long long)stats.frames,
+            (unsigned long long)kinds[ground::FrameScience], (unsigned long long)kinds[ground::FrameProfile],
+            (unsigned long long)kinds[ground::FrameEnergy], (unsigned long long)kinds[ground::FrameI2CTrace],
+            (unsigned long long)kinds[ground::FrameStats], (unsigned long long)kinds[ground::FrameSeries],
+            (unsigned long long)kinds[ground::FrameUnknown]);
+    if (series) {
+        fprintf(stderr, "bad series frames   %llu\n", (unsigned long long)badSeries);
+    }
+    fprintf(stderr, "bytes skipped       %llu\n", (unsigned long long)stats.bytesSkipped);
+    fprintf(stderr, "short frames        %llu\n", (unsigned long long)stats.shortFrames);
+    fprintf(stderr, "decode time         %.3f s (%.1f MB/s)\n", seconds,
+            seconds > 0 ? stats.bytesScanned / seconds / 1e6 : 0.0);
+    
+    return ok ? 0 : 1;
+}
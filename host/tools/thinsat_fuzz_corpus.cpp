@@ -0,0 +1,140 @@
+/**
+ *  @file   thinsat_fuzz_corpus.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Writes a seed corpus for thinsat_fuzz_parser.
+ *
+ *          usage: thinsat_fuzz_corpus [--count N] [--frames N] [--seed N] DIR
+ *
+ *          Writes --count inputs (default 70) of --frames frames (default
+ *          100, which keeps inputs under libFuzzer's -max_len=4096) to DIR,
+ *          creating it if needed. Inputs cycle through clean frames, frames
+ *          with bit flips, with dropped and inserted bytes, with false
+ *          0x50 0x50 0x50 preambles, with all of these, receiver noise and
+ *          header floods. Each starts with a random parse selector byte, as
+ *          thinsat_fuzz_parser expects.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ThinSatDecoder.h"
+#include "ThinSatFuzzStreams.h"
+
+
+typedef enum
+{
+    InputClean      = 0,
+    InputBitFlips   = 1,
+    InputSlips      = 2,
+    InputPreambles  = 3,
+    InputMixed      = 4,
+    InputNoise      = 5,
+    InputFlood      = 6,
+    INPUT_KIND_COUNT
+} InputKind;
+
+static const char* const inputKindNames[INPUT_KIND_COUNT] = {
+    "clean", "bitflip", "slip", "preamble", "mixed", "noise", "flood"
+};
+
+
+static std::vector<uint8_t> makeInput(InputKind kind, size_t frames, std::mt19937_64& rng)
+{
+    // The library's damage rates are meant for long benchmark streams and
+    // would leave most short inputs untouched
+    fuzz::CorruptionConfig heavy[INPUT_KIND_COUNT] = {};
+    heavy[InputBitFlips]  = { 1e-2, 0,    0,    0   };
+    heavy[InputSlips]     = { 0,    1e-2, 1e-2, 0   };
+    heavy[InputPreambles] = { 0,    0,    0,    0.5 };
+    heavy[InputMixed]     = { 5e-3, 5e-3, 5e-3, 0.2 };
+    
+    size_t               length = frames * NSL_PACKET_SIZE;
+    std::vector<uint8_t> stream;
+    
+    switch (kind) {
+    case InputNoise:
+        stream = fuzz::makeNoise(length, rng());
+        break;
+    case InputFlood:
+        stream = fuzz::makeHeaderFlood(length, 1 + rng() % (2 * NSL_PACKET_SIZE));
+        break;
+    default:
+        stream = fuzz::corrupt(fuzz::makeFrames(frames, rng()), heavy[kind], rng());
+        break;
+    }
+    
+    stream.insert(stream.begin(), (uint8_t)rng());
+    return stream;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--count N] [--frames N] [--seed N] DIR\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    size_t      count  = 70;
+    size_t      frames = 100;
+    uint64_t    seed   = 1;
+    const char* dir    = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+            count = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !dir) {
+            dir = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!dir || frames == 0) {
+        usage(argv[0]);
+    }
+    
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        perror(dir);
+        return 1;
+    }
+    
+    std::mt19937_64 rng(seed);
+    
+    for (size_t i = 0; i < count; i++) {
+        InputKind            kind  = (InputKind)(i % INPUT_KIND_COUNT);
+        std::vector<uint8_t> input = makeInput(kind, frames, rng);
+        
+        char name[64];
+        snprintf(name, sizeof(name), "/%s-%04zu", inputKindNames[kind], i);
+        std::string path = std::string(dir) + name;
+        
+        FILE* output = fopen(path.c_str(), "wb");
+        if (!output) {
+            perror(path.c_str());
+            return 1;
+        }
+        bool failed = fwrite(input.data(), 1, input.size(), output) != input.size();
+        if (fclose(output) != 0 || failed) {
+            perror(path.c_str());
+            return 1;
+        }
+    }
+    
+    printf("%zu inputs written to %s\n", count, dir);
+    return 0;
+}
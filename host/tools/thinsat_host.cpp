@@ -0,0 +1,166 @@
+/**
+ *  @file   thinsat_host.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Runs the VCSFA_ThinSat sketch as a native program on the virtual
+ *          clock, with the simulated TSLPB, BNO055, BMP280 and NSL
+ *          Mothership attached, and reports what it sent and how long it
+ *          took.
+ *
+ *          usage: thinsat_host [--seconds S] [--loops N] [--output FILE]
+ *                              [--cts READY_MS:BUSY_MS] [--post-busy MS] [--ack]
+ *                              [--orbit]
+ *
+ *          --seconds   virtual mission time to run (default 60)
+ *          --loops     stop after N passes of loop() (default: no limit)
+ *          --output    write every packet the mothership received to FILE
+ *          --cts       periodic mothership busy/ready schedule
+ *          --post-busy mothership busy time after each packet
+ *          --ack       reply to each packet with NSL_SERIAL_ACK/NAK
+ *          --orbit     drive the sensors from the default orbit, attitude and
+ *                      thermal model instead of their fixed readings
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "SimTslpbBoard.h"
+#include "SimBNO055.h"
+#include "SimBMP280.h"
+#include "SimMothership.h"
+#include "SimOrbit.h"
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--seconds S] [--loops N] [--output FILE]\n"
+                    "       [--cts READY_MS:BUSY_MS] [--post-busy MS] [--ack] [--orbit]\n", program);
+    exit(2);
+}
+
+static void printLatency(const char* name, const sim::SimLatencyStats& latency)
+{
+    if (latency.count == 0) {
+        printf("%-17s -\n", name);
+        return;
+    }
+    printf("%-17s mean %.3f ms, min %.3f ms, max %.3f ms\n", name,
+           latency.total / 1e3 / latency.count, latency.min / 1e3, latency.max / 1e3);
+}
+
+int main(int argc, char** argv)
+{
+    double      seconds     = 60;
+    uint64_t    maxLoops    = 0;
+    const char* outputPath  = NULL;
+    uint64_t    readyMs     = 0;
+    uint64_t    busyMs      = 0;
+    uint64_t    postBusyMs  = 0;
+    bool        ack         = false;
+    bool        orbitModel  = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+            maxLoops = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (!strcmp(argv[i], "--cts") && i + 1 < argc) {
+            unsigned long long ready, busy;
+            if (sscanf(argv[++i], "%llu:%llu", &ready, &busy) != 2) {
+                usage(argv[0]);
+            }
+            readyMs = ready;
+            busyMs  = busy;
+        } else if (!strcmp(argv[i], "--post-busy") && i + 1 < argc) {
+            postBusyMs = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--ack")) {
+            ack = true;
+        } else if (!strcmp(argv[i], "--orbit")) {
+            orbitModel = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    
+    sim::SimTslpbBoard  board;
+    sim::SimBNO055      bno;
+    sim::SimBMP280      bmp;
+    sim::SimMothership  nsl;
+    sim::SimOrbit       orbit;
+    
+    if (orbitModel) {
+        orbit.attach(board, &bno, &bmp);
+    }
+    
+    hal::reset();
+    board.attach();
+    hal::attachI2cDevice(BNO055_ADDRESS_A, &bno);
+    hal::attachI2cDevice(BMP280_ADDRESS, &bmp);
+    nsl.attach();
+    if (readyMs) {
+        nsl.setPeriodicSchedule(readyMs * 1000, busyMs * 1000);
+    }
+    nsl.setPostFrameBusy(postBusyMs * 1000);
+    nsl.setAckEnabled(ack);
+    
+    clock_t  cpuStart = clock();
+    uint64_t endUs    = (uint64_t)(seconds * 1e6);
+    uint64_t loops    = 0;
+    
+    // TSLPB::begin() starts the MET at the beginning of setup()
+    nsl.setMetEpoch(hal::now());
+    setup();
+    while (hal::now() < endUs && (maxLoops == 0 || loops < maxLoops)) {
+        loop();
+        loops++;
+    }
+    
+    double cpuSeconds = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+    
+    if (outputPath) {
+        FILE* output = fopen(outputPath, "wb");
+        if (!output) {
+            perror(outputPath);
+            return 1;
+        }
+        for (const sim::SimNslFrame& frame : nsl.getFrames()) {
+            fwrite(frame.bytes, 1, NSL_PACKET_SIZE, output);
+        }
+        fclose(output);
+    }
+    
+    const hal::I2cStats&            i2c      = hal::i2cStats();
+    const hal::SerialStats&         serial   = hal::serialStats();
+    const hal::BlockingStats&       blocking = hal::blockingStats();
+    const sim::SimMothershipStats&  link     = nsl.getStats();
+    
+    printf("virtual time      %.3f s\n", hal::now() / 1e6);
+    printf("host cpu time     %.3f s\n", cpuSeconds);
+    printf("loop passes       %llu\n", (unsigned long long)loops);
+    printf("serial bytes      %llu (%.3f s blocked)\n",
+           (unsigned long long)serial.bytesWritten, serial.txBlockedUs / 1e6);
+    printf("packets           %llu received, %llu accepted, %llu bad header, %llu sent while busy, %llu partial\n",
+           (unsigned long long)link.framesReceived, (unsigned long long)link.framesAccepted,
+           (unsigned long long)link.headerErrors, (unsigned long long)link.busyViolations,
+           (unsigned long long)link.timeouts);
+    printLatency("queueing", link.queueing);
+    printLatency("uart buffering", link.buffering);
+    printLatency("delivery", link.delivery);
+    printf("i2c transactions  %llu (%llu NACK)\n",
+           (unsigned long long)i2c.transactions, (unsigned long long)i2c.nacks);
+    printf("i2c bytes         %llu written, %llu read\n",
+           (unsigned long long)i2c.bytesWritten, (unsigned long long)i2c.bytesRead);
+    printf("i2c bus time      %.3f s\n", i2c.busTimeUs / 1e6);
+    printf("delay time        %.3f s\n", blocking.delayTimeUs / 1e6);
+    
+    return 0;
+}
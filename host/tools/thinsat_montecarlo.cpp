@@ -0,0 +1,463 @@
+/**
+ *  @file   thinsat_montecarlo.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Runs many independent randomized missions of one firmware
+ *          configuration in parallel and reports the distribution of their
+ *          outcomes.
+ *
+ *          usage: thinsat_montecarlo [--missions N] [--seconds S] [--jobs J]
+ *                                    [--seed S] [--bus-errors P]
+ *                                    [--sensor-faults P] [--fault-device NAME]
+ *                                    [--outages PER_HOUR] [--timeout S]
+ *                                    [--summary FILE]
+ *
+ *          --missions      number of missions (default 200)
+ *          --seconds       virtual duration of each mission (default 3600)
+ *          --jobs          worker processes (default: one per online CPU)
+ *          --seed          seed of mission 0; mission i uses seed + i
+ *          --bus-errors    highest per-transaction I2C failure probability
+ *          --sensor-faults share of missions with a sensor fault
+ *          --fault-device  fault only this device: bno055, bmp280, imu,
+ *                          magnetometer or analog (default: drawn)
+ *          --outages       mean unscheduled mothership outages per hour
+ *          --timeout       host seconds before a mission counts as hung
+ *          --summary       append one tab-separated line of results to FILE
+ *
+ *          The sketch keeps its state in globals, so every mission runs in a
+ *          process of its own, forked from a worker that never ran the
+ *          firmware. Workers start with equal blocks of mission indices and
+ *          steal the back half of the fullest block when theirs runs out.
+ *          The blocks and the results live in shared memory.
+ *
+ *          Results depend only on the seeds, not on the number of workers or
+ *          the order missions ran in. Each firmware configuration is its own
+ *          executable (see add_thinsat_montecarlo() in CMakeLists.txt); run
+ *          them with the same arguments and --summary to compare them.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "SimMission.h"
+
+
+#ifndef THINSAT_MC_CONFIG
+#define THINSAT_MC_CONFIG   "default"
+#endif
+
+#ifndef THINSAT_MC_DEFINES
+#define THINSAT_MC_DEFINES  ""
+#endif
+
+
+/*!
+ * @brief   One worker's block of mission indices, [begin, end) packed as
+ *          begin << 32 | end so the owner and thieves update it with one
+ *          compare-and-swap. Indices are never handed out twice, so a packed
+ *          value never comes back (no ABA).
+ */
+typedef struct alignas(64)
+{
+    std::atomic<uint64_t>   range;
+    uint64_t                executed;   ///< Missions this worker ran
+    uint64_t                steals;     ///< Blocks it stole
+} WorkQueue;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "process-shared atomics must be lock free");
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--missions N] [--seconds S] [--jobs J] [--seed S]\n"
+                    "       [--bus-errors P] [--sensor-faults P] [--fault-device NAME]\n"
+                    "       [--outages PER_HOUR] [--timeout S] [--summary FILE]\n", program);
+    exit(2);
+}
+
+static inline uint64_t pack(uint32_t begin, uint32_t end)
+{
+    return ((uint64_t)begin << 32) | end;
+}
+
+/*!
+ * @brief Takes the next mission: from the front of the worker's own block, or
+ * else by moving the back half of the fullest other block into its own.
+ *
+ * @return false when every block is empty
+ */
+static bool takeMission(WorkQueue* queues, int jobs, int self, uint32_t& mission)
+{
+    WorkQueue& own   = queues[self];
+    uint64_t   range = own.range.load();
+    
+    while ((uint32_t)(range >> 32) < (uint32_t)range) {
+        if (own.range.compare_exchange_weak(range, range + (1ULL << 32))) {
+            mission = (uint32_t)(range >> 32);
+            return true;
+        }
+    }
+    
+    for (;;) {
+        int      victim = -1;
+        uint32_t most   = 0;
+        uint64_t seen   = 0;
+        
+        for (int i = 0; i < jobs; i++) {
+            uint64_t other = queues[i].range.load();
+            uint32_t left  = (uint32_t)other - (uint32_t)(other >> 32);
+            if (i != self && (uint32_t)(other >> 32) < (uint32_t)other && left > most) {
+                victim = i;
+                most   = left;
+                seen   = other;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+        
+        uint32_t begin = (uint32_t)(seen >> 32);
+        uint32_t end   = (uint32_t)seen;
+        uint32_t split = end - (most + 1) / 2;
+        
+        if (queues[victim].range.compare_exchange_strong(seen, pack(begin, split))) {
+            // Nobody writes an empty block, so the stolen one can be stored
+            own.range.store(pack(split + 1, end));
+            own.steals++;
+            mission = split;
+            return true;
+        }
+    }
+}
+
+/*!
+ * @brief Runs one mission in a child process and records how it ended
+ */
+static void runIsolated(const sim::SimMissionConfig& config, uint64_t seed, unsigned timeout,
+                        sim::SimMissionResult& result)
+{
+    pid_t child = fork();
+    
+    if (child == 0) {
+        alarm(timeout);
+        sim::runMission(config, seed, result);
+        _exit(0);
+    }
+    
+    int status = 0;
+    if (child < 0 || waitpid(child, &status, 0) < 0) {
+        result.status = sim::MissionCrashed;
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        result.status = sim::MissionCompleted;
+    } else {
+        result.status = (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) ? sim::MissionHung : sim::MissionCrashed;
+    }
+    result.seed = seed;
+}
+
+static void worker(const sim::SimMissionConfig& config, uint64_t seed, unsigned timeout,
+                   WorkQueue* queues, int jobs, int self, sim::SimMissionResult* results)
+{
+    uint32_t mission;
+    
+    while (takeMission(queues, jobs, self, mission)) {
+        runIsolated(config, seed + mission, timeout, results[mission]);
+        queues[self].executed++;
+    }
+}
+
+/*!
+ * @brief Value at fraction q of sorted values
+ */
+static double quantile(const std::vector<double>& sorted, double q)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[(size_t)(q * (sorted.size() - 1) + 0.5)];
+}
+
+static void printDistribution(const char* name, std::vector<double>& values, double scale, const char* unit)
+{
+    std::sort(values.begin(), values.end());
+    printf("%-17s p5 %.3f  p50 %.3f  p95 %.3f  max %.3f %s\n", name,
+           quantile(values, 0.05) * scale, quantile(values, 0.5) * scale,
+           quantile(values, 0.95) * scale, quantile(values, 1) * scale, unit);
+}
+
+/*!
+ * @brief Start of the histogram bucket that holds fraction q of the counts
+ */
+static uint64_t latencyQuantile(const uint64_t* histogram, uint64_t total, double q)
+{
+    uint64_t rank = std::min((uint64_t)(q * total), total ? total - 1 : 0);
+    uint64_t seen = 0;
+    
+    for (int bucket = 0; bucket < SIM_LATENCY_BUCKETS; bucket++) {
+        seen += histogram[bucket];
+        if (seen > rank) {
+            return sim::simLatencyBucketStart(bucket);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    sim::SimMissionConfig config      = sim::simDefaultMissionConfig;
+    uint32_t              missions    = 200;
+    long                  jobs        = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t              seed        = 1;
+    unsigned              timeout     = 60;
+    const char*           summaryPath = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--missions") && i + 1 < argc) {
+            missions = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            config.seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--jobs") && i + 1 < argc) {
+            jobs = strtol(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--bus-errors") && i + 1 < argc) {
+            config.busErrorMax = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--sensor-faults") && i + 1 < argc) {
+            config.sensorFaultProbability = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--fault-device") && i + 1 < argc) {
+            const char* name = argv[++i];
+            config.faultDevice = -1;
+            for (int device = 0; device < sim::SIM_FAULT_DEVICE_COUNT; device++) {
+                if (!strcmp(name, sim::simFaultDeviceNames[device])) {
+                    config.faultDevice = device;
+                }
+            }
+            if (config.faultDevice < 0) {
+                usage(argv[0]);
+            }
+        } else if (!strcmp(argv[i], "--outages") && i + 1 < argc) {
+            config.outagesPerHour = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+            timeout = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--summary") && i + 1 < argc) {
+            summaryPath = argv[++i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (missions == 0 || config.seconds <= 0) {
+        usage(argv[0]);
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+    if (jobs > (long)missions) {
+        jobs = missions;
+    }
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │            Shared Queues and Results             │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    size_t queueBytes  = sizeof(WorkQueue) * jobs;
+    size_t resultBytes = sizeof(sim::SimMissionResult) * missions;
+    void*  shared      = mmap(NULL, queueBytes + resultBytes, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+    
+    WorkQueue*             queues  = (WorkQueue*)shared;
+    sim::SimMissionResult* results = (sim::SimMissionResult*)((uint8_t*)shared + queueBytes);
+    
+    for (long i = 0; i < jobs; i++) {
+        new (&queues[i]) WorkQueue();
+        queues[i].range.store(pack((uint32_t)(missions * i / jobs), (uint32_t)(missions * (i + 1) / jobs)));
+    }
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                     Workers                      │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    struct timespec wallStart, wallEnd;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    fflush(stdout);
+    
+    std::vector<pid_t> workers;
+    for (long i = 0; i < jobs; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            worker(config, seed, timeout, queues, (int)jobs, (int)i, results);
+            _exit(0);
+        }
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        workers.push_back(pid);
+    }
+    for (pid_t pid : workers) {
+        waitpid(pid, NULL, 0);
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    
+    double        wallSeconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+    struct rusage children;
+    getrusage(RUSAGE_CHILDREN, &children);
+    double        cpuSeconds  = children.ru_utime.tv_sec + children.ru_utime.tv_usec / 1e6 +
+                                children.ru_stime.tv_sec + children.ru_stime.tv_usec / 1e6;
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                    Aggregate                     │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    uint64_t statuses[4] = {};
+    uint64_t sent = 0, accepted = 0, busy = 0, header = 0, partial = 0;
+    uint64_t transactions = 0, nacks = 0, faults = 0;
+    double   virtualSeconds = 0;
+    uint64_t latency[SIM_LATENCY_BUCKETS] = {};
+    uint64_t latencyCount = 0;
+    uint64_t faultMissions[sim::SIM_FAULT_DEVICE_COUNT][sim::SIM_FAULT_KIND_COUNT] = {};
+    double   faultDelivered[sim::SIM_FAULT_DEVICE_COUNT][sim::SIM_FAULT_KIND_COUNT] = {};
+    double   faultSeconds[sim::SIM_FAULT_DEVICE_COUNT][sim::SIM_FAULT_KIND_COUNT] = {};
+    uint64_t faultTransactions[sim::SIM_FAULT_DEVICE_COUNT][sim::SIM_FAULT_KIND_COUNT] = {};
+    
+    std::vector<double> delivered, framesPerHour, energy, energyPerFrame;
+    
+    for (uint32_t i = 0; i < missions; i++) {
+        const sim::SimMissionResult& r = results[i];
+        
+        statuses[r.status & 3]++;
+        if (r.status != sim::MissionCompleted) {
+            continue;
+        }
+        
+        double hours = r.virtualUs / 3.6e9;
+        double ratio = r.framesSent ? (double)r.framesAccepted / r.framesSent : 0;
+        
+        sent           += r.framesSent;
+        accepted       += r.framesAccepted;
+        busy           += r.busyViolations;
+        header         += r.headerErrors;
+        partial        += r.partialFrames;
+        transactions   += r.i2cTransactions;
+        nacks          += r.i2cNacks;
+        faults         += r.i2cFaults;
+        virtualSeconds += r.virtualUs / 1e6;
+        
+        delivered.push_back(ratio);
+        framesPerHour.push_back(r.framesAccepted / hours);
+        energy.push_back(r.energyJoules);
+        if (r.framesAccepted) {
+            energyPerFrame.push_back(r.energyJoules / r.framesAccepted);
+        }
+        for (int bucket = 0; bucket < SIM_LATENCY_BUCKETS; bucket++) {
+            latency[bucket] += r.latency[bucket];
+            latencyCount    += r.latency[bucket];
+        }
+        
+        int device = r.faultKind == sim::FaultNone ? 0 : r.faultDevice % sim::SIM_FAULT_DEVICE_COUNT;
+        int kind   = r.faultKind % sim::SIM_FAULT_KIND_COUNT;
+        faultMissions[device][kind]++;
+        faultDelivered[device][kind] += ratio;
+        faultSeconds[device][kind]      += r.virtualUs / 1e6;
+        faultTransactions[device][kind] += r.i2cTransactions;
+    }
+    
+    /*  ┌──────────────────────────────────────────────────┐
+     *  │                      Report                      │
+     *  └──────────────────────────────────────────────────┘ */
+    
+    uint64_t completed = statuses[sim::MissionCompleted];
+    
+    printf("configuration     %s%s%s\n", THINSAT_MC_CONFIG, *THINSAT_MC_DEFINES ? ": " : "", THINSAT_MC_DEFINES);
+    printf("missions          %u of %.0f s: %llu completed, %llu hung, %llu crashed\n", missions, config.seconds,
+           (unsigned long long)completed, (unsigned long long)statuses[sim::MissionHung],
+           (unsigned long long)statuses[sim::MissionCrashed]);
+    printf("workers           %ld:", jobs);
+    for (long i = 0; i < jobs; i++) {
+        printf(" %llu", (unsigned long long)queues[i].executed);
+    }
+    uint64_t steals = 0;
+    for (long i = 0; i < jobs; i++) {
+        steals += queues[i].steals;
+    }
+    printf(" missions, %llu steals\n", (unsigned long long)steals);
+    printf("wall time         %.3f s (%.1f missions/s, %.0fx real time)\n", wallSeconds,
+           missions / wallSeconds, virtualSeconds / wallSeconds);
+    printf("host cpu time     %.3f s\n", cpuSeconds);
+    
+    if (completed == 0) {
+        munmap(shared, queueBytes + resultBytes);
+        return 1;
+    }
+    
+    printf("frames            %llu sent, %llu accepted, %llu sent while busy, %llu bad header, %llu partial\n",
+           (unsigned long long)sent, (unsigned long long)accepted, (unsigned long long)busy,
+           (unsigned long long)header, (unsigned long long)partial);
+    printf("delivered ratio   %.4f overall\n", sent ? (double)accepted / sent : 0.0);
+    printDistribution("  per mission", delivered, 1, "");
+    printDistribution("frames per hour", framesPerHour, 1, "");
+    printf("latency           p50 %.3f s  p90 %.3f s  p99 %.3f s  max %.3f s (acquisition to delivery)\n",
+           latencyQuantile(latency, latencyCount, 0.5) / 1e6, latencyQuantile(latency, latencyCount, 0.9) / 1e6,
+           latencyQuantile(latency, latencyCount, 0.99) / 1e6, latencyQuantile(latency, latencyCount, 1) / 1e6);
+    printDistribution("energy", energy, 1, "J");
+    printDistribution("energy per frame", energyPerFrame, 1e3, "mJ");
+    printf("i2c               %llu transactions, %llu NACK, %llu injected\n",
+           (unsigned long long)transactions, (unsigned long long)nacks, (unsigned long long)faults);
+    
+    // A sensor that fails its reads must not make the loop poll it flat out
+    printf("%-13s %-8s %9s %10s %9s\n", "fault", "kind", "missions", "delivered", "i2c/s");
+    for (int device = 0; device < sim::SIM_FAULT_DEVICE_COUNT; device++) {
+        for (int kind = 0; kind < sim::SIM_FAULT_KIND_COUNT; kind++) {
+            if (faultMissions[device][kind]) {
+                printf("%-13s %-8s %9llu %10.4f %9.2f\n", kind ? sim::simFaultDeviceNames[device] : "-",
+                       sim::simFaultKindNames[kind], (unsigned long long)faultMissions[device][kind],
+                       faultDelivered[device][kind] / faultMissions[device][kind],
+                       faultSeconds[device][kind] ? faultTransactions[device][kind] / faultSeconds[device][kind] : 0.0);
+            }
+        }
+    }
+    
+    if (summaryPath) {
+        FILE* summary = fopen(summaryPath, "a");
+        if (!summary) {
+            perror(summaryPath);
+            return 2;
+        }
+        if (ftell(summary) == 0) {
+            fprintf(summary, "config\tmissions\tcompleted\thung\tcrashed\tmissions_per_s\tdelivered"
+                             "\tframes_per_hour_p50\tlatency_p50_s\tlatency_p99_s\tenergy_p50_j\n");
+        }
+        std::sort(energy.begin(), energy.end());
+        std::sort(framesPerHour.begin(), framesPerHour.end());
+        fprintf(summary, "%s\t%u\t%llu\t%llu\t%llu\t%.2f\t%.4f\t%.1f\t%.3f\t%.3f\t%.3f\n", THINSAT_MC_CONFIG, missions,
+                (unsigned long long)completed, (unsigned long long)statuses[sim::MissionHung],
+                (unsigned long long)statuses[sim::MissionCrashed], missions / wallSeconds,
+                sent ? (double)accepted / sent : 0.0, quantile(framesPerHour, 0.5),
+                latencyQuantile(latency, latencyCount, 0.5) / 1e6, latencyQuantile(latency, latencyCount, 0.99) / 1e6,
+                quantile(energy, 0.5));
+        fclose(summary);
+    }
+    
+    munmap(shared, queueBytes + resultBytes);
+    return (completed == missions) ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/**
+ *  @file   thinsat_pipeline.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Runs raw captures through the multi-threaded ground pipeline.
+ *
+ *          usage: thinsat_pipeline [options] FILE...
+ *
+ *          --passes N      replay every input N times (default 1), for
+ *                          sustained-throughput runs
+ *          --archive P     append every frame to archive P
+ *          --columns P     write science frames to column store P
+ *          --csv P         write science frames as CSV ("-" for stdout)
+ *          --epoch S       archive receive time base (Unix seconds)
+ *          --pin R,F,D,W   pin reader, framer, decoder and writer to these
+ *                          cores (-1 leaves a stage unpinned)
+ *          --batch N       frames per batch (default 1024)
+ *          --chunks N      reader chunks in flight (default 8)
+ *          --batches N     batches in flight (default 16)
+ *
+ *          Per-stage throughput, busy/starved/blocked time and the frame
+ *          totals are printed to stderr.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ThinSatPipeline.h"
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--passes N] [--archive P] [--columns P] [--csv P] [--epoch S]\n"
+                    "          [--pin R,F,D,W] [--batch N] [--chunks N] [--batches N] FILE...\n", program);
+    exit(2);
+}
+
+static std::vector<int> parseCores(const char* list)
+{
+    std::vector<int> cores;
+    
+    while (*list) {
+        char* end;
+        cores.push_back((int)strtol(list, &end, 10));
+        if (end == list) {
+            break;
+        }
+        list = (*end == ',') ? end + 1 : end;
+    }
+    return cores;
+}
+
+int main(int argc, char** argv)
+{
+    ground::PipelineOptions options;
+    
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        
+        if (!strcmp(argv[i], "--passes") && hasValue) {
+            options.passes = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--archive") && hasValue) {
+            options.archivePath = argv[++i];
+        } else if (!strcmp(argv[i], "--columns") && hasValue) {
+            options.columnPath = argv[++i];
+        } else if (!strcmp(argv[i], "--csv") && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (!strcmp(argv[i], "--epoch") && hasValue) {
+            options.epoch = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--pin") && hasValue) {
+            options.cores = parseCores(argv[++i]);
+        } else if (!strcmp(argv[i], "--batch") && hasValue) {
+            options.batchFrames = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--chunks") && hasValue) {
+            options.chunks = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--batches") && hasValue) {
+            options.batches = (uint32_t)atoi(argv[++i]);
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+        } else {
+            options.inputs.push_back(argv[i]);
+        }
+    }
+    
+    if (options.inputs.empty() || options.passes == 0) {
+        usage(argv[0]);
+    }
+    
+    ground::Pipeline pipeline(options);
+    bool ok = pipeline.run();
+    pipeline.printStats(stderr);
+    
+    return ok ? 0 : 1;
+}
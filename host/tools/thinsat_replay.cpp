@@ -0,0 +1,302 @@
+/**
+ *  @file   thinsat_replay.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Re-runs the VCSFA_ThinSat sketch against the readings of a
+ *          recorded mission and diffs the frames it sends against the
+ *          recorded ones, byte for byte.
+ *
+ *          usage: thinsat_replay [--capture] [--output FILE] [--show N]
+ *                                [--cts READY_MS:BUSY_MS] [--post-busy MS]
+ *                                INPUT
+ *
+ *          INPUT       a frame archive, or a raw capture with --capture
+ *          --output    write the regenerated frames to FILE
+ *          --show      print the first N differing frames (default 10)
+ *          --cts       mothership busy/ready schedule of the original run
+ *          --post-busy mothership busy time after each packet
+ *
+ *          Recorded science frames are replayed in order, one pass of loop()
+ *          each, on the virtual clock and with the BNO055 and BMP280 models
+ *          attached (see SimReplay). The replay is exact from a payload
+ *          boot onwards when the recording came from the same firmware;
+ *          timing fields (met, sampleAge) show where a recording's
+ *          mothership schedule or attitude rates were not reproduced.
+ *
+ *          Exits 0 if every frame matched, 1 if any differed.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "HostHal.h"
+#include "ThinSatSketch.h"
+#include "SimTslpbBoard.h"
+#include "SimBNO055.h"
+#include "SimBMP280.h"
+#include "SimMothership.h"
+#include "SimReplay.h"
+#include "ThinSatArchive.h"
+#include "ThinSatSync.h"
+
+
+#define REPLAY_IDLE_LOOPS   1000    ///< Passes of loop() without a frame before giving up
+
+
+typedef struct
+{
+    uint8_t bytes[NSL_PACKET_SIZE];
+} Frame;
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--capture] [--output FILE] [--show N]\n"
+                    "       [--cts READY_MS:BUSY_MS] [--post-busy MS] INPUT\n", program);
+    exit(2);
+}
+
+static bool loadArchive(const char* path, std::vector<Frame>& frames)
+{
+    ground::ArchiveReader archive;
+    
+    if (!archive.open(path)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < archive.size(); i++) {
+        Frame frame;
+        memcpy(frame.bytes, archive[i].frame, NSL_PACKET_SIZE);
+        frames.push_back(frame);
+    }
+    return true;
+}
+
+static bool loadCapture(const char* path, std::vector<Frame>& frames)
+{
+    ground::FrameSynchronizer sync;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    while (sync.read(fd, [&frames](const uint8_t* bytes) {
+        Frame frame;
+        memcpy(frame.bytes, bytes, NSL_PACKET_SIZE);
+        frames.push_back(frame);
+    })) {
+    }
+    
+    int error = errno;
+    close(fd);
+    errno = error;
+    return error == 0;
+}
+
+/*!
+ * @brief Formats one field of a science record
+ */
+static void formatField(const ground::ScienceRecord& r, const uint8_t* frame, int field, char* text, size_t size)
+{
+    switch (field) {
+        case sim::ReplayHeader:
+            snprintf(text, size, "%02X%02X%02X", frame[0], frame[1], frame[2]);
+            break;
+        case sim::ReplayMet:        snprintf(text, size, "%u", r.met);          break;
+        case sim::ReplaySampleAge:  snprintf(text, size, "%u", r.sampleAge);    break;
+        case sim::ReplayQuat:
+            snprintf(text, size, "%d,%d,%d,%d", r.quat[0], r.quat[1], r.quat[2], r.quat[3]);
+            break;
+        case sim::ReplayBnoMag:
+            snprintf(text, size, "%d,%d,%d", r.bnomag[0], r.bnomag[1], r.bnomag[2]);
+            break;
+        case sim::ReplayBnoCal:     snprintf(text, size, "0x%02X", r.bnoCal);   break;
+        case sim::ReplayBmePres:    snprintf(text, size, "%u", r.bmePres);      break;
+        case sim::ReplayBmeTemp:    snprintf(text, size, "%d", r.bmeTemp);      break;
+        case sim::ReplayTempExt:    snprintf(text, size, "%u", r.tslTempExt);   break;
+        case sim::ReplayVolts:      snprintf(text, size, "%u", r.tslVolts);     break;
+        case sim::ReplayCurrent:    snprintf(text, size, "%u", r.tslCurrent);   break;
+        case sim::ReplaySolar:      snprintf(text, size, "%u", r.solar);        break;
+        case sim::ReplayTslMag:
+            snprintf(text, size, "%d,%d,%d", r.tslMag[0], r.tslMag[1], r.tslMag[2]);
+            break;
+        case sim::ReplayRefreshed:  snprintf(text, size, "0x%02X", r.refreshed); break;
+    }
+}
+
+static void printDifference(uint64_t index, const uint8_t* original, const uint8_t* replayed, uint32_t fields)
+{
+    ground::ScienceRecord a, b;
+    char                  was[48], now[48];
+    
+    ground::decodeScience(original, a);
+    ground::decodeScience(replayed, b);
+    
+    printf("frame %llu (met %u):", (unsigned long long)index, a.met);
+    for (int field = 0; field < sim::SIM_REPLAY_FIELD_COUNT; field++) {
+        if (fields & (1 << field)) {
+            formatField(a, original, field, was, sizeof(was));
+            formatField(b, replayed, field, now, sizeof(now));
+            printf(" %s %s -> %s", sim::simReplayFieldNames[field], was, now);
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool        capture     = false;
+    const char* inputPath   = NULL;
+    const char* outputPath  = NULL;
+    uint64_t    show        = 10;
+    uint64_t    readyMs     = 0;
+    uint64_t    busyMs      = 0;
+    uint64_t    postBusyMs  = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--capture")) {
+            capture = true;
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (!strcmp(argv[i], "--show") && i + 1 < argc) {
+            show = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--cts") && i + 1 < argc) {
+            unsigned long long ready, busy;
+            if (sscanf(argv[++i], "%llu:%llu", &ready, &busy) != 2) {
+                usage(argv[0]);
+            }
+            readyMs = ready;
+            busyMs  = busy;
+        } else if (!strcmp(argv[i], "--post-busy") && i + 1 < argc) {
+            postBusyMs = strtoull(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !inputPath) {
+            inputPath = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!inputPath) {
+        usage(argv[0]);
+    }
+    
+    std::vector<Frame> loaded;
+    if (!(capture ? loadCapture(inputPath, loaded) : loadArchive(inputPath, loaded))) {
+        perror(inputPath);
+        return 2;
+    }
+    
+    // Diagnostic frames come from optional firmware features; only science
+    // frames are replayed
+    std::vector<Frame>                  original;
+    std::vector<ground::ScienceRecord>  records;
+    for (const Frame& frame : loaded) {
+        if (ground::getFrameKind(frame.bytes) == ground::FrameScience) {
+            ground::ScienceRecord record;
+            ground::decodeScience(frame.bytes, record);
+            original.push_back(frame);
+            records.push_back(record);
+        }
+    }
+    if (records.empty()) {
+        fprintf(stderr, "%s: no science frames\n", inputPath);
+        return 2;
+    }
+    
+    sim::SimTslpbBoard  board;
+    sim::SimBNO055      bno;
+    sim::SimBMP280      bmp;
+    sim::SimMothership  nsl;
+    sim::SimReplay      replay(board, bno, bmp);
+    
+    hal::reset();
+    board.attach();
+    replay.attach();
+    nsl.attach();
+    if (readyMs) {
+        nsl.setPeriodicSchedule(readyMs * 1000, busyMs * 1000);
+    }
+    nsl.setPostFrameBusy(postBusyMs * 1000);
+    
+    uint64_t unreachable[sim::SIM_REPLAY_FIELD_COUNT] = {};
+    uint64_t loops     = 0;
+    clock_t  cpuStart  = clock();
+    
+    nsl.setMetEpoch(hal::now());
+    replay.setFrame(records[0]);
+    setup();
+    
+    for (size_t i = 0; i < records.size(); i++) {
+        replay.setFrame(records[i]);
+        for (int field = 0; field < sim::SIM_REPLAY_FIELD_COUNT; field++) {
+            unreachable[field] += (replay.getInputs().unreachable >> field) & 1;
+        }
+        
+        uint64_t idle = 0;
+        while (nsl.getFrames().size() <= i && idle++ < REPLAY_IDLE_LOOPS) {
+            loop();
+            loops++;
+        }
+        if (nsl.getFrames().size() <= i) {
+            fprintf(stderr, "the firmware stopped sending at frame %zu\n", i);
+            break;
+        }
+    }
+    
+    double cpuSeconds = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+    
+    const std::vector<sim::SimNslFrame>& replayed = nsl.getFrames();
+    
+    uint64_t compared  = std::min(replayed.size(), original.size());
+    uint64_t identical = 0;
+    uint64_t shown     = 0;
+    uint64_t differing[sim::SIM_REPLAY_FIELD_COUNT] = {};
+    
+    for (uint64_t i = 0; i < compared; i++) {
+        uint32_t fields = sim::diffFrames(original[i].bytes, replayed[i].bytes);
+        if (fields == 0) {
+            identical++;
+            continue;
+        }
+        for (int field = 0; field < sim::SIM_REPLAY_FIELD_COUNT; field++) {
+            differing[field] += (fields >> field) & 1;
+        }
+        if (shown++ < show) {
+            printDifference(i, original[i].bytes, replayed[i].bytes, fields);
+        }
+    }
+    
+    if (outputPath) {
+        FILE* output = fopen(outputPath, "wb");
+        if (!output) {
+            perror(outputPath);
+            return 2;
+        }
+        for (const sim::SimNslFrame& frame : replayed) {
+            fwrite(frame.bytes, 1, NSL_PACKET_SIZE, output);
+        }
+        fclose(output);
+    }
+    
+    printf("recorded frames   %zu science, %zu other\n", original.size(), loaded.size() - original.size());
+    printf("replayed frames   %zu in %llu loop passes\n", replayed.size(), (unsigned long long)loops);
+    printf("identical         %llu of %llu\n", (unsigned long long)identical, (unsigned long long)compared);
+    printf("virtual time      %.3f s\n", hal::now() / 1e6);
+    printf("host cpu time     %.3f s (%.0fx real time)\n", cpuSeconds,
+           cpuSeconds > 0 ? hal::now() / 1e6 / cpuSeconds : 0.0);
+    printf("%-17s %10s %12s\n", "field", "differing", "unreachable");
+    for (int field = 0; field < sim::SIM_REPLAY_FIELD_COUNT; field++) {
+        printf("%-17s %10llu %12llu\n", sim::simReplayFieldNames[field],
+               (unsigned long long)differing[field], (unsigned long long)unreachable[field]);
+    }
+    
+    return (identical == original.size()) ? 0 : 1;
+}
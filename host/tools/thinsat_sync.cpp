@@ -0,0 +1,125 @@
+/**
+ *  @file   thinsat_sync.cpp
+ *  @author Nicholas Counts
+ *  @date   10/18/26
+ *  @brief  Recovers clean frames from a noisy downlink stream.
+ *
+ *          usage: thinsat_sync [--output FILE] [--tolerance N] [--ring KB] [FILE]
+ *
+ *          Reads a raw capture, or stdin, through the FrameSynchronizer.
+ *          --output writes the synchronized frames as a clean capture ("-"
+ *          for stdout) for thinsat_decode or thinsat_archive. --tolerance
+ *          sets the bad header bytes accepted while locked (0-2, default 1).
+ *          Sync statistics are printed to stderr.
+ *
+ */
+
+ /* 2018 Counts Engineering */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include "ThinSatSync.h"
+
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--output FILE] [--tolerance N] [--ring KB] [FILE]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* inputPath  = nullptr;
+    const char* outputPath = nullptr;
+    int         tolerance  = SYNC_HEADER_TOLERANCE;
+    size_t      ringSize   = SYNC_RING_SIZE;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) {
+            tolerance = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--ring") && i + 1 < argc) {
+            ringSize = (size_t)atoi(argv[++i]) * 1024;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (tolerance < 0 || tolerance >= NSL_PACKET_HEADER_LENGTH) {
+        usage(argv[0]);
+    }
+    
+    int fd = (!inputPath || !strcmp(inputPath, "-")) ? STDIN_FILENO : open(inputPath, O_RDONLY);
+    if (fd < 0) {
+        perror(inputPath);
+        return 1;
+    }
+    
+    FILE* output = nullptr;
+    if (outputPath) {
+        output = strcmp(outputPath, "-") ? fopen(outputPath, "wb") : stdout;
+        if (!output) {
+            perror(outputPath);
+            return 1;
+        }
+    }
+    
+    ground::FrameSynchronizer sync((uint8_t)tolerance, ringSize);
+    bool writeFailed = false;
+    
+    auto handler = [&](const uint8_t* frame) {
+        if (output && fwrite(frame, 1, NSL_PACKET_SIZE, output) != NSL_PACKET_SIZE) {
+            writeFailed = true;
+        }
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    while (sync.read(fd, handler)) {
+    }
+    int readError = errno;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    if (readError) {
+        errno = readError;
+        perror(inputPath ? inputPath : "stdin");
+    }
+    if (output && (fflush(output) != 0 || writeFailed)) {
+        perror(outputPath);
+        writeFailed = true;
+    }
+    if (output && output != stdout) {
+        fclose(output);
+    }
+    
+    const ground::SyncStats& stats = sync.getStats();
+    fprintf(stderr, "bytes               %llu\n", (unsigned long long)stats.bytesIn);
+    fprintf(stderr, "frames              %llu\n", (unsigned long long)stats.frames);
+    fprintf(stderr, "bytes discarded     %llu (%.3f%%)\n", (unsigned long long)stats.bytesDiscarded,
+            stats.bytesIn ? 100.0 * stats.bytesDiscarded / stats.bytesIn : 0.0);
+    fprintf(stderr, "candidates          %llu (%llu false)\n", (unsigned long long)stats.candidates,
+            (unsigned long long)stats.falseCandidates);
+    fprintf(stderr, "acquisitions        %llu\n", (unsigned long long)stats.acquisitions);
+    fprintf(stderr, "sync losses         %llu\n", (unsigned long long)stats.syncLosses);
+    fprintf(stderr, "headers repaired    %llu\n", (unsigned long long)stats.headersRepaired);
+    fprintf(stderr, "recovery            %.1f bytes mean, %llu max\n",
+            stats.acquisitions > 1 ? (double)stats.recoveryBytes / (stats.acquisitions - 1) : 0.0,
+            (unsigned long long)stats.maxRecoveryBytes);
+    fprintf(stderr, "sync time           %.3f s (%.1f MB/s)\n", seconds,
+            seconds > 0 ? stats.bytesIn / seconds / 1e6 : 0.0);
+    
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return (readError || writeFailed) ? 1 : 0;
+}